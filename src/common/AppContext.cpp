@@ -1,5 +1,6 @@
 ﻿#include "AppContext.h"
 #include <sstream>
+#include <wx/app.h>
 AppContext * AppContext::theInstance = nullptr;
 
 AppContext * AppContext::getInstance()
@@ -104,6 +105,33 @@ uint64_t AppContext::dispatchForResponse(uint64_t msgId, uint64_t wParam /*= NUL
 	return msgDispatcher.dispatchForResponse(msgId, wParam, lParam);
 }
 
+/**
+ * 消息分发（可在工作线程调用，在UI线程中分发）.
+ * 
+ * @param msgId 消息ID
+ * @param wParam 参数1
+ * @param lParam 参数2
+ */
+void AppContext::dispatchAsync(uint64_t msgId, uint64_t wParam /*= NULL*/, uint64_t lParam /*= NULL*/)
+{
+	runInUiThread([this, msgId, wParam, lParam]() {
+		msgDispatcher.dispatch(msgId, wParam, lParam);
+	});
+}
+
+/**
+ * 在UI线程中执行（可在工作线程调用）.
+ * 
+ * @param fn 执行函数
+ */
+void AppContext::runInUiThread(std::function<void()> fn)
+{
+	if (wxTheApp == nullptr) {
+		return;
+	}
+	wxTheApp->CallAfter(fn);
+}
+
 /**
  * 消息订阅者.
  * 
@@ -9,6 +9,7 @@
 #pragma once
 #include <wx/window.h>
 #include <string>
+#include <functional>
 #include <unordered_map>
 #include "MsgDispatcher.h"
 
@@ -40,6 +41,10 @@ public:
 	void dispatch(uint64_t msgId, uint64_t wParam = NULL, uint64_t lParam = NULL);
 	// 消息分发(有返回，等待完成)
 	uint64_t dispatchForResponse(uint64_t msgId, uint64_t wParam = NULL, uint64_t lParam = NULL);
+	// 消息分发(可在工作线程调用, 在UI线程中分发, wParam/lParam须在分发时仍有效)
+	void dispatchAsync(uint64_t msgId, uint64_t wParam = NULL, uint64_t lParam = NULL);
+	// 在UI线程中执行(可在工作线程调用)
+	void runInUiThread(std::function<void()> fn);
 
 	// 消息订阅
 	void subscribe(wxWindow * hwnd, uint64_t msgId);
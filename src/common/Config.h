@@ -89,6 +89,7 @@ typedef enum {
 	DATABASE_EXEC_SQL_BUTTON_ID = CONFIG_USER + 60,
 	DATABASE_EXEC_ALL_BUTTON_ID,
 	DATABASE_EXPLAIN_SQL_BUTTON_ID,
+	DATABASE_CANCEL_SQL_BUTTON_ID,
 	DATABASE_EXPLAIN_QUREY_PLAN_BUTTON_ID,
 	DATABASE_QUERY_BUTTON_ID,
 	DATABASE_OBJECTS_BUTTON_ID,
@@ -122,8 +123,12 @@ typedef enum {
 	LISTVIEW_SAVE_BUTTON_ID,
 	LISTVIEW_DELETE_BUTTON_ID,
 	LISTVIEW_CANCEL_BUTTON_ID,
+	// the ids after LISTVIEW_CANCEL_BUTTON_ID are taken by QDIALOG_*, the newer buttons use the free ids before ANALYSIS_*
+	LISTVIEW_STOP_BUTTON_ID = CONFIG_USER + 146,
+	LISTVIEW_PREV_PAGE_BUTTON_ID,
+	LISTVIEW_NEXT_PAGE_BUTTON_ID,
 
-	QDIALOG_CLEAR_BUTTON_ID,
+	QDIALOG_CLEAR_BUTTON_ID = CONFIG_USER + 99,
 	QDIALOG_YES_BUTTON_ID = CONFIG_USER + 101,
 	QDIALOG_NO_BUTTON_ID,
 
@@ -238,6 +243,9 @@ typedef enum {
 	OBJECTS_TRIGGER_BUTTON_ID,
 	OBJECTS_EVENT_BUTTON_ID,
 	OBJECTS_INDEX_BUTTON_ID,
+
+	// DIALOG - ExportSqlDialog
+	EXPORT_SQL_BROWSE_BUTTON_ID,
 } ButtonId;
 
 // TabView id
@@ -291,6 +299,9 @@ typedef enum {
 	DUPLICATE_TARGET_CONNECT_COMBOBOX_ID,
 	DUPLICATE_TARGET_DATABASE_COMBOBOX_ID,
 	DUPLICATE_TARGET_TABLE_COMBOBOX_ID,
+	// DIALOG - ExportSqlDialog
+	EXPORT_SQL_COMPRESSION_COMBOBOX_ID,
+	EXPORT_SQL_FORMAT_COMBOBOX_ID,
 
 	// QUERY PAGE
 	QUERY_PAGE_CONNECT_COMBOBOX_ID,
@@ -399,6 +410,11 @@ typedef enum {
 	DUPLICATE_TARGET_TABLE_EDIT_ID,
 	DUPLICATE_TARGET_OBJECT_EDIT_ID,
 	DUPLICATE_DDL_PREVIEW_EDIT_ID,
+	// DIALOG - ExportSqlDialog
+	EXPORT_SQL_PATH_EDIT_ID,
+	// QUERY PAGE
+	QUERY_PAGE_TIMEOUT_EDIT_ID,
+	QUERY_PAGE_FETCH_SIZE_EDIT_ID,
 } EditorId;
 
 typedef enum 
@@ -475,6 +491,10 @@ typedef enum {
 	STRUCTURE_DATA_CHECKBOX_ID,
 	// LOCK TABLES
 	LOCK_TABLES_CHECKBOX_ID,
+	// DIALOG - ExportSqlDialog
+	EXPORT_MERGE_PARTS_CHECKBOX_ID,
+	// QUERY PAGE
+	QUERY_PAGE_SESSION_STATUS_CHECKBOX_ID,
 } CheckBoxId;
 
 typedef enum {
@@ -751,6 +771,7 @@ typedef enum {
 	MSG_DB_PRAGMA_PARAMS_ID,  // When the tree item(iImage=9) has double clicked in the LeftNavigation, send this msg to RightAnalysisView for open DbPragmaParamsPage, wParam=userDbId, lParam = NULL
 	MSG_DB_QUICK_CONFIG_PARAMS_ID,  // When the tree item(iImage=10) has double clicked in the LeftNavigation, send this msg to RightAnalysisView for open DbQuickConfigParamsPage, wParam=userDbId, lParam = NULL
 	MSG_QPARAMELEM_VAL_CHANGE_ID, // When the QParamElem value has change, send this msg to parent window for setting data dirty. wParam=QParamElem.m_hWnd, lParam=NULL
+	MSG_EXEC_SQL_PROGRESS_ID, // Send this msg in the UI thread when the async statement of ExecutorService starts or ends, wParam=ExecuteResult pointer, lParam=sessionKey
 	
 }MessageId;
 
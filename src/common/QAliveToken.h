@@ -0,0 +1,44 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com) 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @file   QAliveToken.h
+ * @brief  The alive flag of an UI object for the callbacks of the worker threads
+ * 
+ * @author Xuehan Qin (qinxuehan2018@gmail.com) 
+ * @date   2024-12-20
+ *********************************************************************/
+#pragma once
+#include <atomic>
+#include <memory>
+
+// The flag is shared by the owner and the callbacks, it is false after the owner is destroyed
+typedef std::shared_ptr<std::atomic<bool>> QAliveFlag;
+
+/**
+ * QAliveToken - the member of a window or a delegate, the async callbacks capture its flag instead of wxWeakRef.
+ * The callbacks are copied and destroyed in the worker threads, copying or destroying a wxWeakRef there 
+ * races with the UI thread, copying the flag is thread-safe.
+ * Usage: 
+ *   auto alive = aliveToken.flag(); 
+ *   service->xxxAsync(..., [this, alive](...) { if (!*alive) return; ... });
+ */
+class QAliveToken {
+public:
+	QAliveToken() : alive(std::make_shared<std::atomic<bool>>(true)) {}
+	~QAliveToken() { *alive = false; }
+	QAliveToken(const QAliveToken &) = delete;
+	QAliveToken & operator=(const QAliveToken &) = delete;
+
+	QAliveFlag flag() const { return alive; }
+private:
+	QAliveFlag alive;
+};
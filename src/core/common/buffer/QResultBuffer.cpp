@@ -0,0 +1,692 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QResultBuffer.cpp
+ * @brief  QResultBuffer - The columnar store of the query result rows.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-26
+ *********************************************************************/
+#include "QResultBuffer.h"
+#include <cassert>
+#include <cstring>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+
+namespace {
+	/**
+	 * Parse the whole text to the 8 bytes value of the numeric cell type.
+	 *
+	 * @param type - CELL_INT/CELL_UINT/CELL_DOUBLE
+	 * @param val
+	 * @param bits [out]
+	 * @return false if the text is not a number
+	 */
+	bool parseNumber(QCellType type, const std::string & val, int64_t & bits)
+	{
+		if (val.empty()) {
+			return false;
+		}
+		char * end = nullptr;
+		const char * begin = val.c_str();
+		if (type == CELL_INT) {
+			bits = std::strtoll(begin, &end, 10);
+		} else if (type == CELL_UINT) {
+			if (val.find('-') != std::string::npos) {
+				return false;
+			}
+			uint64_t uval = std::strtoull(begin, &end, 10);
+			std::memcpy(&bits, &uval, sizeof(bits));
+		} else {
+			double dval = std::strtod(begin, &end);
+			std::memcpy(&bits, &dval, sizeof(bits));
+		}
+		return end && *end == '\0';
+	}
+}
+
+const char * QResultBuffer::NULL_TEXT = "< NULL >";
+
+size_t QResultRowView::size() const
+{
+	return buffer->getColumnCount();
+}
+
+bool QResultRowView::isNull(size_t col) const
+{
+	return buffer->isNull(row, col);
+}
+
+std::string QResultRowView::at(size_t col) const
+{
+	return buffer->getString(row, col);
+}
+
+RowItem QResultRowView::toRowItem() const
+{
+	return buffer->getRow(row);
+}
+
+QResultBuffer::QResultBuffer(size_t blockSize) : blockSize(blockSize)
+{
+}
+
+QResultBuffer::QResultBuffer(QResultBuffer && other) noexcept : blockSize(other.blockSize)
+{
+	*this = std::move(other);
+}
+
+/**
+ * Move the columns, rows and arena of other buffer, other buffer is left empty with the same block size.
+ */
+QResultBuffer & QResultBuffer::operator=(QResultBuffer && other) noexcept
+{
+	if (this == &other) {
+		return *this;
+	}
+	columns = std::move(other.columns);
+	columnDatas = std::move(other.columnDatas);
+	rowCount = other.rowCount;
+	blockSize = other.blockSize;
+	blocks = std::move(other.blocks);
+	blockSizes = std::move(other.blockSizes);
+	blockUsed = other.blockUsed;
+	arenaBytes = other.arenaBytes;
+	// the moved-from vectors are unspecified, clear() leaves other buffer consistent
+	other.clear();
+	return *this;
+}
+
+/**
+ * Clear the rows and set the columns.
+ *
+ * @param columns
+ * @param types - the storage types of columns, CELL_TEXT if it is empty
+ */
+void QResultBuffer::reset(const Columns & columns, const QCellTypes & types)
+{
+	clear();
+	this->columns = columns;
+	columnDatas.resize(columns.size());
+	for (size_t i = 0; i < types.size() && i < columnDatas.size(); i++) {
+		columnDatas[i].type = types.at(i);
+	}
+}
+
+/**
+ * Clear the rows and set the columns and the storage types from the meta data of result set.
+ *
+ * @param resultSet
+ */
+void QResultBuffer::reset(sql::ResultSet * resultSet)
+{
+	auto metaData = resultSet->getMetaData();
+	unsigned int n = metaData->getColumnCount();
+	Columns names;
+	QCellTypes types;
+	for (unsigned int i = 1; i <= n; i++) {
+		names.push_back(metaData->getColumnName(i).asStdString());
+		types.push_back(toCellType(metaData->getColumnType(i), metaData->isSigned(i)));
+	}
+	reset(names, types);
+}
+
+void QResultBuffer::clear()
+{
+	columns.clear();
+	columnDatas.clear();
+	rowCount = 0;
+	blocks.clear();
+	blockSizes.clear();
+	blockUsed = 0;
+	arenaBytes = 0;
+}
+
+QCellTypes QResultBuffer::getColumnTypes() const
+{
+	QCellTypes types;
+	for (auto & columnData : columnDatas) {
+		types.push_back(columnData.type);
+	}
+	return types;
+}
+
+bool QResultBuffer::isNumericColumn(size_t col) const
+{
+	QCellType type = columnDatas[col].type;
+	return type == CELL_INT || type == CELL_UINT || type == CELL_DOUBLE || type == CELL_DECIMAL;
+}
+
+void QResultBuffer::appendCell(size_t col, const char * data, size_t len)
+{
+	assert(col < columnDatas.size());
+	auto & columnData = columnDatas[col];
+	if (!isArenaType(columnData.type)) {
+		convertToText(col);
+	}
+	columnData.cells.push_back(allocCell(data, len));
+	setNullBit(columnData.nulls, columnData.cells.size() - 1, false);
+}
+
+void QResultBuffer::appendInt(size_t col, int64_t val)
+{
+	assert(col < columnDatas.size() && columnDatas[col].type == CELL_INT);
+	auto & columnData = columnDatas[col];
+	columnData.values.push_back(val);
+	setNullBit(columnData.nulls, columnData.values.size() - 1, false);
+}
+
+void QResultBuffer::appendUInt(size_t col, uint64_t val)
+{
+	assert(col < columnDatas.size() && columnDatas[col].type == CELL_UINT);
+	auto & columnData = columnDatas[col];
+	int64_t bits = 0;
+	std::memcpy(&bits, &val, sizeof(bits));
+	columnData.values.push_back(bits);
+	setNullBit(columnData.nulls, columnData.values.size() - 1, false);
+}
+
+void QResultBuffer::appendDouble(size_t col, double val)
+{
+	assert(col < columnDatas.size() && columnDatas[col].type == CELL_DOUBLE);
+	auto & columnData = columnDatas[col];
+	int64_t bits = 0;
+	std::memcpy(&bits, &val, sizeof(bits));
+	columnData.values.push_back(bits);
+	setNullBit(columnData.nulls, columnData.values.size() - 1, false);
+}
+
+void QResultBuffer::appendNull(size_t col)
+{
+	assert(col < columnDatas.size());
+	auto & columnData = columnDatas[col];
+	if (isArenaType(columnData.type)) {
+		columnData.cells.push_back(nullptr);
+	} else {
+		columnData.values.push_back(0);
+	}
+	setNullBit(columnData.nulls, getCellCount(columnData) - 1, true);
+}
+
+void QResultBuffer::endRow()
+{
+	rowCount++;
+	for (size_t i = 0; i < columnDatas.size(); i++) {
+		// the missing cells of the row are null
+		while (getCellCount(columnDatas[i]) < rowCount) {
+			appendNull(i);
+		}
+		assert(getCellCount(columnDatas[i]) == rowCount);
+	}
+}
+
+/**
+ * Read the current row of the result set, the numeric cells keep the native values,
+ * the text cells keep the UTF-8 bytes, they are converted when they are drawn or copied.
+ *
+ * @param resultSet
+ */
+void QResultBuffer::appendRow(sql::ResultSet * resultSet)
+{
+	size_t n = columnDatas.size();
+	for (size_t i = 0; i < n; i++) {
+		unsigned int idx = static_cast<unsigned int>(i + 1);
+		if (resultSet->isNull(idx)) {
+			appendNull(i);
+			continue;
+		}
+		switch (columnDatas[i].type) {
+		case CELL_INT:
+			appendInt(i, resultSet->getInt64(idx));
+			break;
+		case CELL_UINT:
+			appendUInt(i, resultSet->getUInt64(idx));
+			break;
+		case CELL_DOUBLE:
+			appendDouble(i, static_cast<double>(resultSet->getDouble(idx)));
+			break;
+		default: {
+			sql::SQLString val = resultSet->getString(idx);
+			appendCell(i, val.c_str(), val.length());
+			break;
+		}
+		}
+	}
+	endRow();
+}
+
+void QResultBuffer::appendRow(const RowItem & rowItem)
+{
+	size_t n = (std::min)(rowItem.size(), columnDatas.size());
+	for (size_t i = 0; i < n; i++) {
+		if (rowItem.at(i) == NULL_TEXT) {
+			appendNull(i);
+			continue;
+		}
+		if (isArenaType(columnDatas[i].type)) {
+			appendCell(i, rowItem.at(i));
+			continue;
+		}
+		int64_t bits = 0;
+		if (!parseNumber(columnDatas[i].type, rowItem.at(i), bits)) {
+			convertToText(i);
+			appendCell(i, rowItem.at(i));
+			continue;
+		}
+		columnDatas[i].values.push_back(bits);
+		setNullBit(columnDatas[i].nulls, columnDatas[i].values.size() - 1, false);
+	}
+	endRow();
+}
+
+/**
+ * Move the rows of other buffer to the end of this buffer, the arena blocks of other buffer are moved too.
+ *
+ * @param other - it has the same columns, and it is empty after appending
+ */
+void QResultBuffer::append(QResultBuffer & other)
+{
+	if (columns.empty() && rowCount == 0) {
+		columns = other.columns;
+		columnDatas.resize(columns.size());
+		for (size_t i = 0; i < columnDatas.size(); i++) {
+			columnDatas[i].type = other.columnDatas[i].type;
+		}
+	}
+	assert(other.columnDatas.size() == columnDatas.size());
+	size_t n = columnDatas.size();
+	for (size_t i = 0; i < n; i++) {
+		auto & columnData = columnDatas[i];
+		auto & otherData = other.columnDatas[i];
+		if (columnData.type != otherData.type) {
+			convertToText(i);
+			other.convertToText(i);
+		}
+		columnData.cells.insert(columnData.cells.end(), otherData.cells.begin(), otherData.cells.end());
+		columnData.values.insert(columnData.values.end(), otherData.values.begin(), otherData.values.end());
+		for (size_t row = 0; row < other.rowCount; row++) {
+			setNullBit(columnData.nulls, rowCount + row, getNullBit(otherData.nulls, row));
+		}
+	}
+	rowCount += other.rowCount;
+
+	// keep the current block of this buffer as the last block for the next allocation
+	if (blocks.empty()) {
+		blocks = std::move(other.blocks);
+		blockSizes = std::move(other.blockSizes);
+		blockUsed = other.blockUsed;
+	} else {
+		auto pos = blocks.size() - 1;
+		for (size_t i = 0; i < other.blocks.size(); i++) {
+			blocks.insert(blocks.begin() + pos + i, std::move(other.blocks[i]));
+			blockSizes.insert(blockSizes.begin() + pos + i, other.blockSizes[i]);
+		}
+	}
+	arenaBytes += other.arenaBytes;
+
+	other.blocks.clear();
+	other.blockSizes.clear();
+	other.blockUsed = 0;
+	other.arenaBytes = 0;
+	other.rowCount = 0;
+	for (auto & otherData : other.columnDatas) {
+		otherData.cells.clear();
+		otherData.values.clear();
+		otherData.nulls.clear();
+	}
+}
+
+bool QResultBuffer::isNull(size_t row, size_t col) const
+{
+	assert(row < rowCount && col < columnDatas.size());
+	return getNullBit(columnDatas[col].nulls, row);
+}
+
+const char * QResultBuffer::getBytes(size_t row, size_t col, size_t * len) const
+{
+	assert(row < rowCount && col < columnDatas.size());
+	auto & columnData = columnDatas[col];
+	const char * cell = isArenaType(columnData.type) ? columnData.cells[row] : nullptr;
+	if (len) {
+		uint32_t len32 = 0;
+		if (cell) {
+			std::memcpy(&len32, cell - sizeof(uint32_t), sizeof(uint32_t));
+		}
+		*len = len32;
+	}
+	return cell;
+}
+
+int64_t QResultBuffer::getInt(size_t row, size_t col) const
+{
+	assert(row < rowCount && col < columnDatas.size() && columnDatas[col].type == CELL_INT);
+	return columnDatas[col].values[row];
+}
+
+uint64_t QResultBuffer::getUInt(size_t row, size_t col) const
+{
+	assert(row < rowCount && col < columnDatas.size() && columnDatas[col].type == CELL_UINT);
+	uint64_t val = 0;
+	std::memcpy(&val, &columnDatas[col].values[row], sizeof(val));
+	return val;
+}
+
+double QResultBuffer::getDouble(size_t row, size_t col) const
+{
+	assert(row < rowCount && col < columnDatas.size() && columnDatas[col].type == CELL_DOUBLE);
+	double val = 0;
+	std::memcpy(&val, &columnDatas[col].values[row], sizeof(val));
+	return val;
+}
+
+long double QResultBuffer::getNumber(size_t row, size_t col) const
+{
+	if (isNull(row, col)) {
+		return 0;
+	}
+	switch (columnDatas[col].type) {
+	case CELL_INT:
+		return static_cast<long double>(getInt(row, col));
+	case CELL_UINT:
+		return static_cast<long double>(getUInt(row, col));
+	case CELL_DOUBLE:
+		return getDouble(row, col);
+	case CELL_DECIMAL: {
+		const char * bytes = getBytes(row, col);
+		return bytes ? std::strtold(bytes, nullptr) : 0;
+	}
+	default:
+		return 0;
+	}
+}
+
+std::string QResultBuffer::getString(size_t row, size_t col) const
+{
+	if (isNull(row, col)) {
+		return NULL_TEXT;
+	}
+	switch (columnDatas[col].type) {
+	case CELL_INT:
+		return std::to_string(getInt(row, col));
+	case CELL_UINT:
+		return std::to_string(getUInt(row, col));
+	case CELL_DOUBLE:
+		return formatDouble(getDouble(row, col));
+	default: {
+		size_t len = 0;
+		const char * bytes = getBytes(row, col, &len);
+		return std::string(bytes, len);
+	}
+	}
+}
+
+/**
+ * Replace the cell value, the numeric column parses the text, and it is changed to CELL_TEXT if the text is not a number.
+ * The new bytes are allocated in the arena, the old bytes are released with the buffer.
+ *
+ * @param row
+ * @param col
+ * @param val
+ */
+void QResultBuffer::setText(size_t row, size_t col, const std::string & val)
+{
+	assert(row < rowCount && col < columnDatas.size());
+	if (val == NULL_TEXT) {
+		setNull(row, col);
+		return;
+	}
+	auto & columnData = columnDatas[col];
+	if (!isArenaType(columnData.type)) {
+		int64_t bits = 0;
+		if (parseNumber(columnData.type, val, bits)) {
+			columnData.values[row] = bits;
+			setNullBit(columnData.nulls, row, false);
+			return;
+		}
+		convertToText(col);
+	}
+	columnData.cells[row] = allocCell(val.c_str(), val.size());
+	setNullBit(columnData.nulls, row, false);
+}
+
+void QResultBuffer::setNull(size_t row, size_t col)
+{
+	assert(row < rowCount && col < columnDatas.size());
+	auto & columnData = columnDatas[col];
+	if (isArenaType(columnData.type)) {
+		columnData.cells[row] = nullptr;
+	} else {
+		columnData.values[row] = 0;
+	}
+	setNullBit(columnData.nulls, row, true);
+}
+
+RowItem QResultBuffer::getRow(size_t row) const
+{
+	RowItem rowItem;
+	size_t n = columnDatas.size();
+	rowItem.reserve(n);
+	for (size_t i = 0; i < n; i++) {
+		rowItem.push_back(getString(row, i));
+	}
+	return rowItem;
+}
+
+void QResultBuffer::removeRow(size_t row)
+{
+	assert(row < rowCount);
+	for (auto & columnData : columnDatas) {
+		if (isArenaType(columnData.type)) {
+			columnData.cells.erase(columnData.cells.begin() + row);
+		} else {
+			columnData.values.erase(columnData.values.begin() + row);
+		}
+		for (size_t i = row; i + 1 < rowCount; i++) {
+			setNullBit(columnData.nulls, i, getNullBit(columnData.nulls, i + 1));
+		}
+		setNullBit(columnData.nulls, rowCount - 1, false);
+	}
+	rowCount--;
+}
+
+/**
+ * Reorder the rows, only the cells (pointers or values) and the null bits are moved.
+ *
+ * @param order - order[i] is the old row index of the new row i
+ */
+void QResultBuffer::reorder(const std::vector<size_t> & order)
+{
+	assert(order.size() == rowCount);
+	for (auto & columnData : columnDatas) {
+		std::vector<uint64_t> nulls((rowCount + 63) / 64, 0);
+		if (isArenaType(columnData.type)) {
+			std::vector<const char *> cells(rowCount);
+			for (size_t i = 0; i < rowCount; i++) {
+				cells[i] = columnData.cells[order[i]];
+			}
+			columnData.cells.swap(cells);
+		} else {
+			std::vector<int64_t> values(rowCount);
+			for (size_t i = 0; i < rowCount; i++) {
+				values[i] = columnData.values[order[i]];
+			}
+			columnData.values.swap(values);
+		}
+		for (size_t i = 0; i < rowCount; i++) {
+			setNullBit(nulls, i, getNullBit(columnData.nulls, order[i]));
+		}
+		columnData.nulls.swap(nulls);
+	}
+}
+
+size_t QResultBuffer::getMemoryBytes() const
+{
+	size_t bytes = arenaBytes;
+	for (auto & columnData : columnDatas) {
+		bytes += columnData.cells.capacity() * sizeof(const char *);
+		bytes += columnData.values.capacity() * sizeof(int64_t);
+		bytes += columnData.nulls.capacity() * sizeof(uint64_t);
+	}
+	return bytes;
+}
+
+/**
+ * The storage type of the sql::DataType.
+ *
+ * @param dataType - ResultSetMetaData::getColumnType(...)
+ * @param isSigned - ResultSetMetaData::isSigned(...)
+ * @return
+ */
+QCellType QResultBuffer::toCellType(int dataType, bool isSigned)
+{
+	switch (dataType) {
+	case sql::DataType::TINYINT:
+	case sql::DataType::SMALLINT:
+	case sql::DataType::MEDIUMINT:
+	case sql::DataType::INTEGER:
+	case sql::DataType::BIGINT:
+	case sql::DataType::YEAR:
+		return isSigned ? CELL_INT : CELL_UINT;
+	case sql::DataType::REAL: // FLOAT, the server sends the shortest text of the float, it parses to the double that formats back to it
+	case sql::DataType::DOUBLE:
+		return CELL_DOUBLE;
+	case sql::DataType::DECIMAL:
+	case sql::DataType::NUMERIC:
+		return CELL_DECIMAL;
+	case sql::DataType::BINARY:
+	case sql::DataType::VARBINARY:
+	case sql::DataType::LONGVARBINARY:
+	case sql::DataType::GEOMETRY:
+		return CELL_BLOB;
+	default:
+		return CELL_TEXT;
+	}
+}
+
+/**
+ * The shortest text that converts back to the same double.
+ *
+ * @param val
+ * @return
+ */
+std::string QResultBuffer::formatDouble(double val)
+{
+	char buf[32];
+	for (int precision = 15; precision <= 17; precision++) {
+		std::snprintf(buf, sizeof(buf), "%.*g", precision, val);
+		if (std::strtod(buf, nullptr) == val) {
+			break;
+		}
+	}
+	return buf;
+}
+
+/**
+ * Change the numeric column to CELL_TEXT, such as a cell of the column is edited as a text that is not a number.
+ *
+ * @param col
+ */
+void QResultBuffer::convertToText(size_t col)
+{
+	auto & columnData = columnDatas[col];
+	if (isArenaType(columnData.type)) {
+		return;
+	}
+	size_t n = columnData.values.size();
+	std::vector<const char *> cells(n, nullptr);
+	for (size_t row = 0; row < n; row++) {
+		if (getNullBit(columnData.nulls, row)) {
+			continue;
+		}
+		std::string val;
+		if (columnData.type == CELL_INT) {
+			val = std::to_string(columnData.values[row]);
+		} else if (columnData.type == CELL_UINT) {
+			uint64_t uval = 0;
+			std::memcpy(&uval, &columnData.values[row], sizeof(uval));
+			val = std::to_string(uval);
+		} else {
+			double dval = 0;
+			std::memcpy(&dval, &columnData.values[row], sizeof(dval));
+			val = formatDouble(dval);
+		}
+		cells[row] = allocCell(val.c_str(), val.size());
+	}
+	columnData.cells.swap(cells);
+	columnData.values.clear();
+	columnData.values.shrink_to_fit();
+	columnData.type = CELL_TEXT;
+}
+
+bool QResultBuffer::isArenaType(QCellType type)
+{
+	return type == CELL_TEXT || type == CELL_DECIMAL || type == CELL_BLOB;
+}
+
+size_t QResultBuffer::getCellCount(const ColumnData & columnData)
+{
+	return isArenaType(columnData.type) ? columnData.cells.size() : columnData.values.size();
+}
+
+/**
+ * Copy the cell bytes to the arena: [uint32_t length][bytes]['\0'].
+ *
+ * @param data
+ * @param len
+ * @return the pointer of bytes
+ */
+const char * QResultBuffer::allocCell(const char * data, size_t len)
+{
+	size_t need = sizeof(uint32_t) + len + 1;
+	if (blocks.empty() || blockUsed + need > blockSizes.back()) {
+		// the blocks grow from 4KB to blockSize, so a small buffer (such as a streaming batch) does not waste memory
+		size_t size = (std::max)(need, (std::min)(blockSize, (std::max)(size_t(4096), arenaBytes)));
+		blocks.emplace_back(new char[size]);
+		blockSizes.push_back(size);
+		blockUsed = 0;
+		arenaBytes += size;
+	}
+	char * ptr = blocks.back().get() + blockUsed;
+	uint32_t len32 = static_cast<uint32_t>(len);
+	std::memcpy(ptr, &len32, sizeof(uint32_t));
+	if (len) {
+		std::memcpy(ptr + sizeof(uint32_t), data, len);
+	}
+	ptr[sizeof(uint32_t) + len] = '\0';
+	blockUsed += need;
+	return ptr + sizeof(uint32_t);
+}
+
+void QResultBuffer::setNullBit(std::vector<uint64_t> & nulls, size_t row, bool isNull)
+{
+	size_t word = row / 64;
+	if (word >= nulls.size()) {
+		if (!isNull) {
+			return; // the bits out of the bitmap are 0
+		}
+		nulls.resize(word + 1, 0);
+	}
+	uint64_t mask = uint64_t(1) << (row % 64);
+	if (isNull) {
+		nulls[word] |= mask;
+	} else {
+		nulls[word] &= ~mask;
+	}
+}
+
+bool QResultBuffer::getNullBit(const std::vector<uint64_t> & nulls, size_t row)
+{
+	size_t word = row / 64;
+	return word < nulls.size() && (nulls[word] & (uint64_t(1) << (row % 64))) != 0;
+}
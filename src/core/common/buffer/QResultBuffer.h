@@ -0,0 +1,155 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QResultBuffer.h
+ * @brief  QResultBuffer - The columnar store of the query result rows.
+ *         The numeric columns keep the native values, the other cell bytes are allocated in arena blocks,
+ *         every column has a contiguous array of cells and a null bitmap, so a cell is accessed by (row, col) in constant time.
+ *         The cells are formatted to text only when they are drawn or copied.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-26
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <memory>
+#include <mysql/jdbc.h>
+#include "core/entity/Entity.h"
+
+// The storage type of a column
+typedef enum {
+	CELL_TEXT = 0, // the UTF-8 bytes in the arena
+	CELL_INT,      // int64_t
+	CELL_UINT,     // uint64_t
+	CELL_DOUBLE,   // double
+	CELL_DECIMAL,  // the UTF-8 bytes in the arena, sorted as number
+	CELL_BLOB,     // the binary bytes in the arena
+} QCellType;
+typedef std::vector<QCellType> QCellTypes;
+
+class QResultBuffer;
+
+/**
+ * QResultRowView - the adapter of one row, it is used by the code that reads RowItem.
+ * The view is valid until the buffer is cleared, sorted or the row is removed.
+ */
+class QResultRowView {
+public:
+	QResultRowView(const QResultBuffer * buffer, size_t row) : buffer(buffer), row(row) {}
+
+	size_t size() const;
+	bool empty() const { return size() == 0; }
+	bool isNull(size_t col) const;
+	std::string at(size_t col) const;
+	std::string operator[](size_t col) const { return at(col); }
+	RowItem toRowItem() const;
+private:
+	const QResultBuffer * buffer;
+	size_t row;
+};
+
+class QResultBuffer {
+public:
+	// the display text of the null cell
+	static const char * NULL_TEXT;
+
+	QResultBuffer(size_t blockSize = 256 * 1024);
+	QResultBuffer(QResultBuffer && other) noexcept;
+	QResultBuffer & operator=(QResultBuffer && other) noexcept;
+	QResultBuffer(const QResultBuffer &) = delete;
+	QResultBuffer & operator=(const QResultBuffer &) = delete;
+
+	// the column types are CELL_TEXT if types is empty
+	void reset(const Columns & columns, const QCellTypes & types = QCellTypes());
+	// the columns and types from the meta data of result set
+	void reset(sql::ResultSet * resultSet);
+	void clear();
+
+	const Columns & getColumns() const { return columns; }
+	QCellTypes getColumnTypes() const;
+	QCellType getColumnType(size_t col) const { return columnDatas[col].type; }
+	bool isNumericColumn(size_t col) const;
+	size_t getColumnCount() const { return columns.size(); }
+	size_t getRowCount() const { return rowCount; }
+	bool empty() const { return rowCount == 0; }
+	size_t size() const { return rowCount; }
+
+	// append the cells of a row from the first column to the last column, then call endRow()
+	void appendCell(size_t col, const char * data, size_t len);
+	void appendCell(size_t col, const std::string & val) { appendCell(col, val.c_str(), val.size()); }
+	void appendInt(size_t col, int64_t val);
+	void appendUInt(size_t col, uint64_t val);
+	void appendDouble(size_t col, double val);
+	void appendNull(size_t col);
+	void endRow();
+	// read the current row of result set by the column types, the text is not converted
+	void appendRow(sql::ResultSet * resultSet);
+	// NULL_TEXT is stored as null, the text of numeric column is parsed
+	void appendRow(const RowItem & rowItem);
+	// move the rows of other buffer with the same columns to the end of this buffer, the cell bytes are not copied
+	void append(QResultBuffer & other);
+
+	bool isNull(size_t row, size_t col) const;
+	// the bytes of CELL_TEXT/CELL_DECIMAL/CELL_BLOB cell, nullptr for null or numeric cell
+	const char * getBytes(size_t row, size_t col, size_t * len = nullptr) const;
+	int64_t getInt(size_t row, size_t col) const;
+	uint64_t getUInt(size_t row, size_t col) const;
+	double getDouble(size_t row, size_t col) const;
+	// the number for sorting, 0 for null or not numeric cell
+	long double getNumber(size_t row, size_t col) const;
+	// format the cell to text, NULL_TEXT for the null cell, the text cell is in UTF-8
+	std::string getString(size_t row, size_t col) const;
+
+	void setText(size_t row, size_t col, const std::string & val);
+	void setNull(size_t row, size_t col);
+
+	QResultRowView getRowView(size_t row) const { return QResultRowView(this, row); }
+	RowItem getRow(size_t row) const;
+	void removeRow(size_t row);
+	// reorder the rows, order[i] is the old index of the new row i
+	void reorder(const std::vector<size_t> & order);
+
+	size_t getMemoryBytes() const;
+
+	static QCellType toCellType(int dataType, bool isSigned);
+	static std::string formatDouble(double val);
+private:
+	// the cells of one column,
+	// CELL_TEXT/CELL_DECIMAL/CELL_BLOB: the cell pointer points to the bytes after the 4 bytes length in the arena
+	// CELL_INT/CELL_UINT/CELL_DOUBLE: the 8 bytes value
+	typedef struct {
+		QCellType type = CELL_TEXT;
+		std::vector<const char *> cells;
+		std::vector<int64_t> values;
+		std::vector<uint64_t> nulls; // bitmap, 1 - null
+	} ColumnData;
+
+	Columns columns;
+	std::vector<ColumnData> columnDatas;
+	size_t rowCount = 0;
+
+	// arena
+	size_t blockSize;
+	std::vector<std::unique_ptr<char[]>> blocks;
+	std::vector<size_t> blockSizes;
+	size_t blockUsed = 0;
+	size_t arenaBytes = 0;
+
+	const char * allocCell(const char * data, size_t len);
+	void convertToText(size_t col);
+	static bool isArenaType(QCellType type);
+	static size_t getCellCount(const ColumnData & columnData);
+	static void setNullBit(std::vector<uint64_t> & nulls, size_t row, bool isNull);
+	static bool getNullBit(const std::vector<uint64_t> & nulls, size_t row);
+};
@@ -0,0 +1,155 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QMetadataCache.cpp
+ * @brief  QMetadataCache - The metadata objects keyed by (connectId, schema, object) with TTL and single-flight loading.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-09
+ *********************************************************************/
+#include "QMetadataCache.h"
+
+QMetadataCache::QMetadataCache(uint32_t ttlSeconds) : ttl(ttlSeconds)
+{
+}
+
+/**
+ * The first caller of a missing (or expired) object loads it outside the lock, the callers that come
+ * during the load wait for the same result. If the object is invalidated during the load, 
+ * the result is returned to the waiting callers but not cached.
+ * 
+ * @param key
+ * @param loader
+ * @return 
+ */
+QMetadataCache::Value QMetadataCache::getOrLoad(const Key & key, const Loader & loader)
+{
+	std::promise<Value> promise;
+	uint64_t loadId = 0;
+	{
+		std::unique_lock<std::mutex> lk(mutex);
+		auto iter = entries.find(key);
+		if (iter != entries.end()) {
+			if (iter->second.loadId) {
+				std::shared_future<Value> loading = iter->second.loading;
+				lk.unlock();
+				// throw the error of the load
+				return loading.get();
+			}
+			if (std::chrono::steady_clock::now() - iter->second.loadedAt < ttl) {
+				return iter->second.value;
+			}
+		}
+		loadId = nextLoadId++;
+		Entry & entry = entries[key];
+		entry.loadId = loadId;
+		entry.loading = promise.get_future().share();
+	}
+
+	Value value;
+	try {
+		value = loader();
+	} catch (...) {
+		promise.set_exception(std::current_exception());
+		std::lock_guard<std::mutex> lk(mutex);
+		auto iter = entries.find(key);
+		if (iter != entries.end() && iter->second.loadId == loadId) {
+			entries.erase(iter);
+		}
+		throw;
+	}
+	promise.set_value(value);
+
+	std::lock_guard<std::mutex> lk(mutex);
+	auto iter = entries.find(key);
+	// the entry has been removed or replaced by invalidate(...) during the load
+	if (iter != entries.end() && iter->second.loadId == loadId) {
+		iter->second.value = value;
+		iter->second.loadedAt = std::chrono::steady_clock::now();
+		iter->second.loadId = 0;
+		iter->second.loading = std::shared_future<Value>();
+	}
+	return value;
+}
+
+/**
+ * Replace the object, the running load of the object is not cached, its callers still get its result.
+ * 
+ * @param key
+ * @param value
+ */
+void QMetadataCache::set(const Key & key, const Value & value)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	Entry & entry = entries[key];
+	entry.value = value;
+	entry.loadedAt = std::chrono::steady_clock::now();
+	entry.loadId = 0;
+	entry.loading = std::shared_future<Value>();
+}
+
+void QMetadataCache::invalidate(uint64_t connectId)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	eraseRange(Key(connectId, "", ""), connectId, nullptr);
+}
+
+void QMetadataCache::invalidate(uint64_t connectId, const std::string & schema)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	eraseRange(Key(connectId, schema, ""), connectId, &schema);
+}
+
+void QMetadataCache::invalidate(uint64_t connectId, const std::string & schema, const std::string & object)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	entries.erase(Key(connectId, schema, object));
+}
+
+void QMetadataCache::invalidatePrefix(uint64_t connectId, const std::string & schema, const std::string & prefix)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	auto iter = entries.lower_bound(Key(connectId, schema, prefix));
+	while (iter != entries.end() && std::get<0>(iter->first) == connectId && std::get<1>(iter->first) == schema
+		&& std::get<2>(iter->first).compare(0, prefix.size(), prefix) == 0) {
+		iter = entries.erase(iter);
+	}
+}
+
+void QMetadataCache::clear()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	entries.clear();
+}
+
+void QMetadataCache::setTtl(uint32_t seconds)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	ttl = std::chrono::seconds(seconds);
+}
+
+/**
+ * Erase the entries from the key while they belong to the connection (and the schema), the caller holds the lock.
+ * The waiting callers of the erased loads still get their results by the shared futures.
+ * 
+ * @param from - the first key of the range
+ * @param connectId
+ * @param schema - nullptr for all schemas of the connection
+ */
+void QMetadataCache::eraseRange(const Key & from, uint64_t connectId, const std::string * schema)
+{
+	auto iter = entries.lower_bound(from);
+	while (iter != entries.end() && std::get<0>(iter->first) == connectId
+		&& (!schema || std::get<1>(iter->first) == *schema)) {
+		iter = entries.erase(iter);
+	}
+}
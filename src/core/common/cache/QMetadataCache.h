@@ -0,0 +1,97 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QMetadataCache.h
+ * @brief  QMetadataCache - The metadata objects keyed by (connectId, schema, object), such as the tables of a schema
+ *         or the columns of a table. An object expires after the TTL, and is removed explicitly when our own DDL changes it.
+ *         The concurrent callers of a missing object share one load (single flight), the others wait for its result.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-09
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+class QMetadataCache {
+public:
+	typedef std::shared_ptr<const void> Value;
+	typedef std::function<Value ()> Loader;
+
+	// the objects that are older than TTL are loaded again
+	static const uint32_t DEFAULT_TTL_SECONDS = 300;
+
+	QMetadataCache(uint32_t ttlSeconds = DEFAULT_TTL_SECONDS);
+
+	/**
+	 * Get the cached object, or load it by the loader if it is missing or expired. 
+	 * The loader runs in the calling thread, the errors of the loader are thrown to all waiting callers and not cached.
+	 * 
+	 * @param connectId
+	 * @param schema - empty for the objects of the connection, such as the charsets
+	 * @param object - such as "tables", "columns:<table>"
+	 * @param loader - load the object from the server
+	 * @return the copy of the cached object
+	 */
+	template<typename T>
+	T get(uint64_t connectId, const std::string & schema, const std::string & object, const std::function<T ()> & loader)
+	{
+		Value value = getOrLoad(Key(connectId, schema, object), [&loader]() -> Value {
+			return std::make_shared<const T>(loader());
+		});
+		return *std::static_pointer_cast<const T>(value);
+	}
+
+	// cache the object that is loaded by a bulk load, such as the columns of all tables in a schema, it replaces the running load
+	template<typename T>
+	void put(uint64_t connectId, const std::string & schema, const std::string & object, T && value)
+	{
+		set(Key(connectId, schema, object), std::make_shared<const typename std::decay<T>::type>(std::forward<T>(value)));
+	}
+
+	// remove the objects of the connection, the schema or one object, the running loads of them are not cached
+	void invalidate(uint64_t connectId);
+	void invalidate(uint64_t connectId, const std::string & schema);
+	void invalidate(uint64_t connectId, const std::string & schema, const std::string & object);
+	// remove the objects of the schema that start with the prefix, such as "columns:" for the columns of all tables
+	void invalidatePrefix(uint64_t connectId, const std::string & schema, const std::string & prefix);
+	void clear();
+	void setTtl(uint32_t seconds);
+private:
+	typedef std::tuple<uint64_t, std::string, std::string> Key;
+	typedef struct _Entry {
+		Value value;
+		std::chrono::steady_clock::time_point loadedAt;
+		// the running load of the object, loadId > 0 while loading
+		uint64_t loadId = 0;
+		std::shared_future<Value> loading;
+	} Entry;
+
+	std::mutex mutex;
+	// ordered by the key, so the objects of a connection or a schema are adjacent
+	std::map<Key, Entry> entries;
+	uint64_t nextLoadId = 1;
+	std::chrono::seconds ttl;
+
+	Value getOrLoad(const Key & key, const Loader & loader);
+	void set(const Key & key, const Value & value);
+	void eraseRange(const Key & from, uint64_t connectId, const std::string * schema);
+};
@@ -0,0 +1,1274 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QDbCopier.cpp
+ * @brief  QDbCopier - Duplicate a database from the source connection to the target connection in process.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-30
+ *********************************************************************/
+#include "QDbCopier.h"
+#include <cassert>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <unordered_map>
+#include "utils/Log.h"
+#include "utils/StringUtil.h"
+#include "utils/SqlUtil.h"
+#include "core/common/repository/QConnect.h"
+#include "core/common/exception/QRuntimeException.h"
+#include "core/service/db/MetadataService.h"
+#include "core/service/db/ConnectService.h"
+#include "core/common/copier/QInfilePipe.h"
+
+std::atomic<uint64_t> QDbCopier::nextSessionKey{ 0x100000000000ULL };
+
+QDbCopier::QDbCopier(const DbCopyParams& params) : params(params)
+{
+}
+
+QDbCopier::~QDbCopier()
+{
+}
+
+/**
+ * Copy the database in the order of mysqldump: database, tables, rows, views, routines, triggers and events,
+ * the triggers are created after the rows, so they do not fire for the copied rows.
+ */
+void QDbCopier::run()
+{
+	assert(params.fromConnectId > 0 && !params.fromSchema.empty() && params.toConnectId > 0 && !params.toSchema.empty());
+	Q_INFO("Duplicate database start, from:{}.{}, to:{}.{}", params.fromConnectId, params.fromSchema, params.toConnectId, params.toSchema);
+	beginAt = std::chrono::steady_clock::now();
+	// the objects of the source are read from the server, not from the cache
+	MetadataService::getInstance()->invalidateCache(params.fromConnectId, params.fromSchema);
+	openSessions();
+	try {
+		initProgress();
+		// INSERT ... SELECT does not read the snapshot, the rows are copied in the server only while the tables are locked
+		isSameServer = params.lockTables && detectSameServer();
+		isLoadDataEnabled = !isSameServer && !params.structOnly 
+			&& userDbRepository->getServerVariable(params.toConnectId, "local_infile") == "ON";
+		if (params.createDatabase) {
+			setStep("database");
+			createDatabase();
+		}
+		setStep("tables");
+		createTables();
+		if (!params.structOnly && !params.tables.empty()) {
+			setStep("rows");
+			copyTablesData();
+		}
+		setStep("views");
+		createViews();
+		setStep("objects");
+
+		auto metadataService = MetadataService::getInstance();
+		std::vector<std::string> names;
+		if (params.routines) {
+			for (auto & item : metadataService->getUserProcedures(params.fromConnectId, params.fromSchema)) {
+				names.push_back(item.name);
+			}
+			createObjects("PROCEDURE", names);
+			names.clear();
+			for (auto & item : metadataService->getUserFunctions(params.fromConnectId, params.fromSchema)) {
+				names.push_back(item.name);
+			}
+			createObjects("FUNCTION", names);
+			names.clear();
+		}
+		if (params.triggers) {
+			for (auto & item : metadataService->getUserTriggers(params.fromConnectId, params.fromSchema)) {
+				names.push_back(item.name);
+			}
+			createObjects("TRIGGER", names);
+			names.clear();
+		}
+		if (params.events) {
+			for (auto & item : metadataService->getUserEvents(params.fromConnectId, params.fromSchema)) {
+				names.push_back(item.name);
+			}
+			createObjects("EVENT", names);
+		}
+	} catch (QRuntimeException & ex) {
+		Q_ERROR("Duplicate database failed, code:{}, error:{}", ex.getCode(), ex.getMsg());
+		closeSessions();
+		MetadataService::getInstance()->invalidateCache(params.toConnectId, params.toSchema);
+		throw ex;
+	}
+	closeSessions();
+	MetadataService::getInstance()->invalidateCache(params.toConnectId, params.toSchema);
+	Q_INFO("Duplicate database success, from:{}.{}, to:{}.{}", params.fromConnectId, params.fromSchema, params.toConnectId, params.toSchema);
+}
+
+void QDbCopier::cancel()
+{
+	canceled = true;
+}
+
+bool QDbCopier::isCanceled() const
+{
+	return canceled;
+}
+
+void QDbCopier::setProgressCallback(DbCopyProgressCallback callback)
+{
+	progressCallback = callback;
+}
+
+std::string QDbCopier::getJobKey(const DbCopyParams & params, const std::string & tblName)
+{
+	return std::to_string(params.fromConnectId) + ":" + params.fromSchema + "." + tblName + ">"
+		+ std::to_string(params.toConnectId) + ":" + params.toSchema + "." + getTargetTable(params, tblName);
+}
+
+std::string QDbCopier::getTargetTable(const DbCopyParams & params, const std::string & tblName)
+{
+	if (params.toTable.empty() || params.tables.size() != 1) {
+		return tblName;
+	}
+	return params.toTable;
+}
+
+/**
+ * Join the quoted columns by comma, such as `id`,`name`.
+ * 
+ * @param columns
+ * @return empty if no column
+ */
+std::string QDbCopier::joinColumns(const Columns & columns)
+{
+	std::string columnList;
+	for (auto & column : columns) {
+		columnList.append(columnList.empty() ? "" : ",").append(SqlUtil::quoteIdentifier(column));
+	}
+	return columnList;
+}
+
+std::string QDbCopier::getQualifiedSource(const std::string & tblName) const
+{
+	return SqlUtil::quoteIdentifier(params.fromSchema) + "." + SqlUtil::quoteIdentifier(tblName);
+}
+
+std::string QDbCopier::getQualifiedTarget(const std::string & tblName) const
+{
+	return SqlUtil::quoteIdentifier(params.toSchema) + "." + SqlUtil::quoteIdentifier(getTargetTable(params, tblName));
+}
+
+/**
+ * The select of the next chunk: selectPrefix WHERE (keyList) > lastKey ORDER BY keyList LIMIT chunkRows.
+ * 
+ * @param selectPrefix - SELECT ... FROM table
+ * @param keyList - the quoted columns of the primary key
+ * @param lastKey - the key tuple of the last row, empty for the first chunk
+ * @param chunkRows
+ * @return 
+ */
+std::string QDbCopier::makeChunkSelectSql(const std::string & selectPrefix, const std::string & keyList,
+	const std::string & lastKey, uint32_t chunkRows)
+{
+	std::string selectSql = selectPrefix;
+	if (!lastKey.empty()) {
+		selectSql.append(" WHERE (").append(keyList).append(") > ").append(lastKey);
+	}
+	selectSql.append(" ORDER BY ").append(keyList).append(" LIMIT ").append(std::to_string(chunkRows));
+	return selectSql;
+}
+
+/**
+ * Load the checkpoint of the table, or save a new one if the table is copied for the first time.
+ * If the copy resumes, deleteSql removes the rows after the last key from the target, 
+ * because a chunk may be committed without its checkpoint saved.
+ * 
+ * @param tblName
+ * @param toTable - the qualified target table
+ * @param keyList - the quoted columns of the primary key
+ * @param checkpoint [out]
+ * @param deleteSql [out]
+ * @return true if the copy resumes from the checkpoint
+ */
+bool QDbCopier::beginCheckpoint(const std::string & tblName, const std::string & toTable, const std::string & keyList,
+	CopyCheckpoint & checkpoint, std::string & deleteSql)
+{
+	std::string jobKey = getJobKey(params, tblName);
+	if (!copyCheckpointRepository->get(jobKey, checkpoint)) {
+		checkpoint.jobKey = jobKey;
+		copyCheckpointRepository->save(checkpoint);
+		return false;
+	}
+	Q_INFO("Resume copying table, job:{}, lastKey:{}, copiedRows:{}", jobKey, checkpoint.lastKey, checkpoint.copiedRows);
+	deleteSql = "DELETE FROM " + toTable;
+	if (!checkpoint.lastKey.empty()) {
+		deleteSql.append(" WHERE (").append(keyList).append(") > ").append(checkpoint.lastKey);
+	}
+	return true;
+}
+
+/**
+ * Pin the coordinator session of the source and the DDL session of the target.
+ */
+void QDbCopier::openSessions()
+{
+	sourceSessionKey = nextSessionKey++;
+	targetSessionKey = nextSessionKey++;
+	openSourceSession(sourceSessionKey);
+	openTargetSession(targetSessionKey);
+}
+
+/**
+ * Release the table locks, restore the variables of the sessions and return them to the pool.
+ */
+void QDbCopier::closeSessions()
+{
+	bool isUnlocked = true;
+	if (isTablesLocked) {
+		try {
+			userDbRepository->executeInSession(params.fromConnectId, "", "UNLOCK TABLES", sourceSessionKey);
+		} catch (QRuntimeException & ex) {
+			Q_ERROR("Fail to unlock the tables, code:{}, error:{}", ex.getCode(), ex.getMsg());
+			isUnlocked = false;
+		}
+		isTablesLocked = false;
+	}
+	if (isUnlocked) {
+		closeSourceSession(sourceSessionKey);
+	} else {
+		// the locks are held until the session is closed
+		userDbRepository->releaseSession(params.fromConnectId, sourceSessionKey, true);
+	}
+	closeTargetSession(targetSessionKey);
+}
+
+/**
+ * The rows are read with TIME_ZONE '+00:00', so the TIMESTAMP values are not converted,
+ * and without NO_BACKSLASH_ESCAPES, so the key tuples of the chunks are parsed as they are written to the target.
+ * 
+ * @param sessionKey
+ */
+void QDbCopier::openSourceSession(uint64_t sessionKey)
+{
+	userDbRepository->executeInSession(params.fromConnectId, "", "SET NAMES utf8mb4", sessionKey);
+	userDbRepository->executeInSession(params.fromConnectId, "", "SET SESSION TIME_ZONE='+00:00', " 
+		+ SqlUtil::makeSqlModeWithBackslashEscapes(), sessionKey);
+}
+
+/**
+ * The values are written with the backslash escapes, the checks are disabled like mysqldump.
+ * The other modes of the target server, such as the strict mode, are kept, NO_AUTO_VALUE_ON_ZERO is added like mysqldump.
+ * 
+ * @param sessionKey
+ */
+void QDbCopier::openTargetSession(uint64_t sessionKey)
+{
+	userDbRepository->executeInSession(params.toConnectId, "", "SET NAMES utf8mb4", sessionKey);
+	userDbRepository->executeInSession(params.toConnectId, "", "SET SESSION TIME_ZONE='+00:00', FOREIGN_KEY_CHECKS=0, UNIQUE_CHECKS=0, "
+		+ SqlUtil::makeSqlModeWithBackslashEscapes("NO_AUTO_VALUE_ON_ZERO"), sessionKey);
+}
+
+/**
+ * End the snapshot, restore the variables and return the session to the pool, the session is closed instead if it fails.
+ * 
+ * @param sessionKey
+ */
+void QDbCopier::closeSourceSession(uint64_t sessionKey)
+{
+	bool isRestored = false;
+	try {
+		userDbRepository->executeInSession(params.fromConnectId, "", "COMMIT", sessionKey);
+		userDbRepository->executeInSession(params.fromConnectId, "", "SET NAMES utf8", sessionKey);
+		userDbRepository->executeInSession(params.fromConnectId, "", "SET SESSION TIME_ZONE=DEFAULT, SQL_MODE=DEFAULT", sessionKey);
+		isRestored = true;
+	} catch (QRuntimeException & ex) {
+		Q_ERROR("Fail to restore the source session, code:{}, error:{}", ex.getCode(), ex.getMsg());
+	}
+	// the session is closed if it is not restored, the variables must not leak into the pool
+	userDbRepository->releaseSession(params.fromConnectId, sessionKey, !isRestored);
+}
+
+/**
+ * Roll back the chunk that is not committed, restore the variables and return the session to the pool,
+ * the session is closed instead if it fails.
+ * 
+ * @param sessionKey
+ */
+void QDbCopier::closeTargetSession(uint64_t sessionKey)
+{
+	bool isRestored = false;
+	try {
+		userDbRepository->executeInSession(params.toConnectId, "", "ROLLBACK", sessionKey);
+		userDbRepository->executeInSession(params.toConnectId, "", "SET NAMES utf8", sessionKey);
+		userDbRepository->executeInSession(params.toConnectId, "", "SET SESSION TIME_ZONE=DEFAULT, FOREIGN_KEY_CHECKS=1, UNIQUE_CHECKS=1, "
+			"SQL_MODE=DEFAULT", sessionKey);
+		isRestored = true;
+	} catch (QRuntimeException & ex) {
+		Q_ERROR("Fail to restore the target session, code:{}, error:{}", ex.getCode(), ex.getMsg());
+	}
+	userDbRepository->releaseSession(params.toConnectId, sessionKey, !isRestored);
+}
+
+void QDbCopier::createDatabase()
+{
+	checkCanceled();
+	std::string ddl = userDbRepository->getObjectDDL(params.fromConnectId, params.fromSchema, params.fromSchema, "DATABASE");
+	ddl = StringUtil::replace(ddl, "`" + params.fromSchema + "`", "`" + params.toSchema + "`");
+	userDbRepository->executeInSession(params.toConnectId, "", ddl, targetSessionKey);
+}
+
+/**
+ * Create the tables, FOREIGN_KEY_CHECKS=0 of the target session allows the foreign keys to the tables created later.
+ * The table that has a checkpoint is created by the interrupted copy, it is kept for resuming, 
+ * the checkpoint is dropped if the target table does not exist any more.
+ */
+void QDbCopier::createTables()
+{
+	auto metadataService = MetadataService::getInstance();
+	std::string sqlMode;
+	for (auto & tblName : params.tables) {
+		checkCanceled();
+		std::string toTable = getTargetTable(params, tblName);
+		std::string jobKey = getJobKey(params, tblName);
+		CopyCheckpoint checkpoint;
+		if (!params.structOnly && copyCheckpointRepository->get(jobKey, checkpoint)) {
+			if (metadataService->hasUserTable(params.toConnectId, params.toSchema, toTable)) {
+				continue;
+			}
+			copyCheckpointRepository->remove(jobKey);
+		}
+		std::string ddl = userDbRepository->getObjectDDLAndSqlMode(params.fromConnectId, params.fromSchema, tblName, "TABLE", sqlMode);
+		if (toTable != tblName) {
+			// CREATE TABLE `tblName` (..., only the first name is the table name
+			std::string name = "`" + tblName + "`";
+			size_t pos = ddl.find(name);
+			if (pos != std::string::npos) {
+				ddl.replace(pos, name.size(), "`" + toTable + "`");
+			}
+		}
+		userDbRepository->executeInSession(params.toConnectId, params.toSchema, ddl, targetSessionKey);
+	}
+}
+
+/**
+ * Sort the tables by DATA_LENGTH of information_schema.TABLES in descending order, so the largest table starts
+ * first and does not become the tail that runs alone at the end.
+ * 
+ * @return 
+ */
+std::vector<std::string> QDbCopier::getTablesLargestFirst()
+{
+	std::unordered_map<std::string, uint64_t> dataLengths;
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		for (auto & item : progress.tables) {
+			dataLengths[item.name] = item.estimatedBytes;
+		}
+	}
+	std::vector<std::string> tables = params.tables;
+	std::stable_sort(tables.begin(), tables.end(), [&dataLengths](const std::string & a, const std::string & b) {
+		return dataLengths[a] > dataLengths[b];
+	});
+	return tables;
+}
+
+/**
+ * The workers are limited by the tables and the sessions of QUERY_LANE, the coordinator and RESERVED_SESSIONS 
+ * are kept out of the lane, and a worker takes two sessions of the lane if the source and target are the same connection.
+ * 
+ * @param tableCount
+ * @return 
+ */
+uint32_t QDbCopier::getWorkerCount(size_t tableCount) const
+{
+	uint32_t maxSize = QConnect::userConnectPool.getLaneOptions(QUERY_LANE).maxSize;
+	uint32_t freeSessions = maxSize > RESERVED_SESSIONS + 1 ? maxSize - RESERVED_SESSIONS - 1 : 1;
+	uint32_t sessionsPerWorker = params.fromConnectId == params.toConnectId ? 2 : 1;
+	uint32_t count = (std::min)(params.threads, freeSessions / sessionsPerWorker);
+	count = (std::min)(count, static_cast<uint32_t>(tableCount));
+	return (std::max)(count, uint32_t(1));
+}
+
+/**
+ * Copy the rows of the tables by the workers. The coordinator locks the tables, every worker starts
+ * START TRANSACTION WITH CONSISTENT SNAPSHOT in its source session, then the coordinator unlocks the tables,
+ * so the snapshots of all workers are taken at the same point and no write happens between them.
+ * The tables stay locked until the end if params.lockTables, for the tables without MVCC (MyISAM).
+ */
+void QDbCopier::copyTablesData()
+{
+	std::vector<std::string> tables = getTablesLargestFirst();
+	uint32_t workerCount = getWorkerCount(tables.size());
+	std::vector<uint64_t> sourceKeys, targetKeys;
+	for (uint32_t i = 0; i < workerCount; i++) {
+		sourceKeys.push_back(nextSessionKey++);
+		// the first worker writes by the DDL session
+		targetKeys.push_back(i == 0 ? targetSessionKey : nextSessionKey++);
+	}
+	Q_INFO("Duplicate database, tables:{}, workers:{}", tables.size(), workerCount);
+
+	std::string errorCode, errorMsg;
+	try {
+		for (uint32_t i = 0; i < workerCount; i++) {
+			openSourceSession(sourceKeys.at(i));
+			if (i > 0) {
+				openTargetSession(targetKeys.at(i));
+			}
+		}
+
+		std::string sql = "LOCK TABLES ";
+		for (size_t i = 0; i < tables.size(); i++) {
+			sql.append(i ? ", " : "").append("`").append(params.fromSchema).append("`.`").append(tables.at(i)).append("` READ");
+		}
+		userDbRepository->executeInSession(params.fromConnectId, "", sql, sourceSessionKey);
+		isTablesLocked = true;
+		for (auto sourceKey : sourceKeys) {
+			// only for the next transaction, the isolation level of the session is not changed
+			userDbRepository->executeInSession(params.fromConnectId, "", "SET TRANSACTION ISOLATION LEVEL REPEATABLE READ", sourceKey);
+			userDbRepository->executeInSession(params.fromConnectId, "", "START TRANSACTION WITH CONSISTENT SNAPSHOT", sourceKey);
+		}
+		if (!params.lockTables) {
+			userDbRepository->executeInSession(params.fromConnectId, "", "UNLOCK TABLES", sourceSessionKey);
+			isTablesLocked = false;
+		}
+	} catch (QRuntimeException & ex) {
+		failed = true;
+		errorCode = ex.getCode();
+		errorMsg = ex.getMsg();
+	}
+
+	std::mutex errorMutex;
+	std::atomic<size_t> nextTable{ 0 };
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i < workerCount && !failed; i++) {
+		workers.emplace_back([&, i]() {
+			// mysql driver must be initialized in every thread that uses it
+			QConnect::getDriver()->threadInit();
+			while (!isStopped()) {
+				size_t index = nextTable++;
+				if (index >= tables.size()) {
+					break;
+				}
+				try {
+					setTableStatus(tables.at(index), COPY_TABLE_COPYING);
+					copyTableData(tables.at(index), sourceKeys.at(i), targetKeys.at(i));
+					if (!isStopped()) {
+						setTableStatus(tables.at(index), COPY_TABLE_DONE);
+					}
+				} catch (QRuntimeException & ex) {
+					std::lock_guard<std::mutex> lk(errorMutex);
+					if (!failed) {
+						errorCode = ex.getCode();
+						errorMsg = ex.getMsg();
+						failed = true;
+					}
+				}
+			}
+			QConnect::getDriver()->threadEnd();
+		});
+	}
+	for (auto & worker : workers) {
+		worker.join();
+	}
+
+	for (uint32_t i = 0; i < workerCount; i++) {
+		closeSourceSession(sourceKeys.at(i));
+		if (i > 0) {
+			closeTargetSession(targetKeys.at(i));
+		}
+	}
+	if (failed) {
+		throw QRuntimeException(errorCode, errorMsg);
+	}
+	checkCanceled();
+}
+
+/**
+ * Copy the rows of the table. The reader (worker thread) packs the row tuples into INSERT statements of
+ * MAX_BATCH_BYTES and the writer thread executes them in the target session, so reading from the source
+ * and writing to the target overlap, and the reader waits when the writer is QUEUE_CAPACITY batches behind.
+ * The table with the primary key is copied by chunks, its checkpoint is removed after the last chunk.
+ *
+ * @param tblName
+ */
+void QDbCopier::copyTableData(const std::string & tblName, uint64_t sourceKey, uint64_t targetKey)
+{
+	checkCanceled();
+	Columns columns = userDbRepository->getInsertableColumns(params.fromConnectId, params.fromSchema, tblName);
+	if (columns.empty()) {
+		return;
+	}
+	Columns keyColumns = userDbRepository->getPrimaryKeyColumns(params.fromConnectId, params.fromSchema, tblName);
+	if (isSameServer && canSelectInTarget(tblName, targetKey)) {
+		copyTableDataInServer(tblName, columns, keyColumns, sourceKey, targetKey);
+		return;
+	}
+	if (isLoadDataEnabled && !userDbRepository->hasLoadDataUnsafeColumns(params.fromConnectId, params.fromSchema, tblName)) {
+		try {
+			loadTableData(tblName, columns, keyColumns, sourceKey, targetKey);
+			return;
+		} catch (QRuntimeException & ex) {
+			if (!isLoadDataRejected(ex.getCode())) {
+				throw ex;
+			}
+			// the rows are copied by INSERT, it resumes from the checkpoint of LOAD DATA
+			Q_INFO("LOAD DATA LOCAL INFILE is rejected, code:{}, error:{}, the rows are copied by INSERT", ex.getCode(), ex.getMsg());
+			isLoadDataEnabled = false;
+		}
+	}
+	std::string jobKey = getJobKey(params, tblName);
+
+	BatchQueue queue(QUEUE_CAPACITY);
+	bool hasWriteError = false;
+	std::string errorCode, errorMsg;
+	std::thread writer([&]() {
+		// mysql driver must be initialized in every thread that uses it
+		QConnect::getDriver()->threadInit();
+		Batch batch;
+		while (queue.pop(batch)) {
+			try {
+				userDbRepository->executeInSession(params.toConnectId, "", batch.sql, targetKey);
+				if (batch.rows) {
+					addCopied(tblName, batch.rows, batch.sql.size());
+				}
+				if (batch.hasCheckpoint) {
+					CopyCheckpoint checkpoint;
+					checkpoint.jobKey = jobKey;
+					checkpoint.lastKey = batch.lastKey;
+					checkpoint.copiedRows = batch.copiedRows;
+					copyCheckpointRepository->save(checkpoint);
+				}
+			} catch (QRuntimeException & ex) {
+				hasWriteError = true;
+				errorCode = ex.getCode();
+				errorMsg = ex.getMsg();
+				queue.abort();
+				break;
+			}
+		}
+		QConnect::getDriver()->threadEnd();
+	});
+
+	try {
+		if (keyColumns.empty()) {
+			readTableRows(tblName, columns, sourceKey, queue);
+		} else {
+			readTableChunks(tblName, columns, keyColumns, sourceKey, queue);
+		}
+		queue.close();
+	} catch (QRuntimeException & ex) {
+		queue.abort();
+		writer.join();
+		throw ex;
+	}
+	writer.join();
+	if (hasWriteError) {
+		throw QRuntimeException(errorCode, errorMsg);
+	}
+	checkCanceled();
+	if (!keyColumns.empty() && !isStopped()) {
+		copyCheckpointRepository->remove(jobKey);
+	}
+}
+
+/**
+ * Read all rows of the table without the primary key by one SELECT, the batches are committed one by one.
+ * 
+ * @param tblName
+ * @param columns
+ * @param sourceKey
+ * @param queue
+ */
+void QDbCopier::readTableRows(const std::string & tblName, const Columns & columns, uint64_t sourceKey, BatchQueue & queue)
+{
+	std::string columnList = joinColumns(columns);
+	std::string selectSql = "SELECT " + columnList + " FROM " + getQualifiedSource(tblName);
+	std::string insertPrefix = "INSERT INTO " + getQualifiedTarget(tblName) + " (" + columnList + ") VALUES ";
+
+	std::string batch;
+	uint32_t batchRows = 0;
+	userDbRepository->readRowTuples(params.fromConnectId, "", selectSql, sourceKey, [&](const std::string & tuple, const std::string &) -> bool {
+		if (isStopped()) {
+			return false;
+		}
+		if (!batch.empty() && batch.size() + tuple.size() + 1 > MAX_BATCH_BYTES) {
+			if (!queue.push(std::move(batch), batchRows)) {
+				return false;
+			}
+			batch.clear();
+			batchRows = 0;
+		}
+		batch.append(batch.empty() ? insertPrefix : ",").append(tuple);
+		batchRows++;
+		return true;
+	});
+	if (!batch.empty() && !isStopped()) {
+		queue.push(std::move(batch), batchRows);
+	}
+}
+
+/**
+ * Read the rows by the ranges of the primary key: SELECT ... WHERE (pk) > (lastKey) ORDER BY pk LIMIT chunkRows.
+ * The INSERT statements of a chunk are wrapped by START TRANSACTION and COMMIT, the writer saves the last key of
+ * the chunk as the checkpoint after COMMIT. If the copy resumes from a checkpoint, the rows after the last key are
+ * deleted from the target first, because a chunk may be committed without its checkpoint saved.
+ * The reader waits for the writer when the queue is full, so the elapsed time of a chunk covers the reading
+ * and the writing, and the rows of the next chunk are adapted to it.
+ * 
+ * @param tblName
+ * @param columns
+ * @param keyColumns - the columns of the primary key
+ * @param sourceKey
+ * @param queue
+ */
+void QDbCopier::readTableChunks(const std::string & tblName, const Columns & columns, const Columns & keyColumns,
+	uint64_t sourceKey, BatchQueue & queue)
+{
+	std::string columnList = joinColumns(columns), keyList = joinColumns(keyColumns);
+	std::string toTable = getQualifiedTarget(tblName);
+	std::string selectPrefix = "SELECT " + columnList + "," + keyList + " FROM " + getQualifiedSource(tblName);
+	std::string insertPrefix = "INSERT INTO " + toTable + " (" + columnList + ") VALUES ";
+
+	CopyCheckpoint checkpoint;
+	std::string deleteSql;
+	if (beginCheckpoint(tblName, toTable, keyList, checkpoint, deleteSql) && !queue.push(std::move(deleteSql))) {
+		return;
+	}
+
+	std::string lastKey = checkpoint.lastKey;
+	uint64_t copiedRows = checkpoint.copiedRows;
+	uint32_t chunkRows = INIT_CHUNK_ROWS;
+	while (!isStopped()) {
+		std::string selectSql = makeChunkSelectSql(selectPrefix, keyList, lastKey, chunkRows);
+
+		auto begin = std::chrono::steady_clock::now();
+		if (!queue.push(std::string("START TRANSACTION"))) {
+			return;
+		}
+		uint32_t rows = 0, batchRows = 0;
+		std::string batch;
+		userDbRepository->readRowTuples(params.fromConnectId, "", selectSql, sourceKey,
+			[&](const std::string & tuple, const std::string & keyTuple) -> bool {
+			if (isStopped()) {
+				return false;
+			}
+			if (!batch.empty() && batch.size() + tuple.size() + 1 > MAX_BATCH_BYTES) {
+				if (!queue.push(std::move(batch), batchRows)) {
+					return false;
+				}
+				batch.clear();
+				batchRows = 0;
+			}
+			batch.append(batch.empty() ? insertPrefix : ",").append(tuple);
+			lastKey = keyTuple;
+			rows++;
+			batchRows++;
+			return true;
+		}, static_cast<uint32_t>(keyColumns.size()));
+		if (isStopped() || (!batch.empty() && !queue.push(std::move(batch), batchRows))) {
+			return;
+		}
+
+		copiedRows += rows;
+		Batch commit;
+		commit.sql = "COMMIT";
+		commit.hasCheckpoint = rows > 0;
+		commit.lastKey = lastKey;
+		commit.copiedRows = copiedRows;
+		if (!queue.push(std::move(commit)) || rows < chunkRows) {
+			return;
+		}
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+		chunkRows = adaptChunkRows(chunkRows, static_cast<uint64_t>(elapsedMs));
+	}
+}
+
+/**
+ * Double the rows of the chunk if it is fast, halve them if it is slow, so a chunk takes about 0.5 ~ 2 seconds,
+ * a short chunk wastes the round trips and a long chunk loses more work when the copy is interrupted.
+ * 
+ * @param chunkRows
+ * @param elapsedMs - the elapsed milliseconds of the last chunk
+ * @return the rows of the next chunk
+ */
+uint32_t QDbCopier::adaptChunkRows(uint32_t chunkRows, uint64_t elapsedMs)
+{
+	if (elapsedMs < FAST_CHUNK_MS) {
+		return (std::min)(chunkRows * 2, MAX_CHUNK_ROWS);
+	}
+	if (elapsedMs > SLOW_CHUNK_MS) {
+		return (std::max)(chunkRows / 2, MIN_CHUNK_ROWS);
+	}
+	return chunkRows;
+}
+
+/**
+ * Load the rows by LOAD DATA LOCAL INFILE, the table with the primary key is loaded by the chunks of the key, 
+ * every chunk is one LOAD DATA statement, so it is committed by itself and saved as the checkpoint after it.
+ * 
+ * @param tblName
+ * @param columns
+ * @param keyColumns - empty if the table has no primary key
+ * @param sourceKey
+ * @param targetKey
+ */
+void QDbCopier::loadTableData(const std::string & tblName, const Columns & columns, const Columns & keyColumns,
+	uint64_t sourceKey, uint64_t targetKey)
+{
+	std::string columnList = joinColumns(columns), keyList = joinColumns(keyColumns);
+	std::string toTable = getQualifiedTarget(tblName);
+	std::string selectPrefix = "SELECT " + columnList + (keyList.empty() ? "" : "," + keyList) + " FROM " + getQualifiedSource(tblName);
+	// the default FIELDS and LINES options: TERMINATED BY '\t' ESCAPED BY '\\' LINES TERMINATED BY '\n',
+	// the lines are read by the source session with utf8mb4, the server converts them to the charsets of the target columns
+	std::string loadSuffix = " INTO TABLE " + toTable + " CHARACTER SET utf8mb4 (" + columnList + ")";
+	std::string lastKey;
+	if (keyColumns.empty()) {
+		loadRows(tblName, selectPrefix, loadSuffix, 0, sourceKey, targetKey, lastKey);
+		checkCanceled();
+		return;
+	}
+
+	CopyCheckpoint checkpoint;
+	std::string deleteSql;
+	if (beginCheckpoint(tblName, toTable, keyList, checkpoint, deleteSql)) {
+		userDbRepository->executeInSession(params.toConnectId, "", deleteSql, targetKey);
+	}
+
+	uint32_t chunkRows = INIT_CHUNK_ROWS;
+	lastKey = checkpoint.lastKey;
+	while (!isStopped()) {
+		std::string selectSql = makeChunkSelectSql(selectPrefix, keyList, lastKey, chunkRows);
+
+		auto begin = std::chrono::steady_clock::now();
+		uint32_t rows = loadRows(tblName, selectSql, loadSuffix, static_cast<uint32_t>(keyColumns.size()), sourceKey, targetKey, lastKey);
+		if (isStopped()) {
+			break;
+		}
+		if (rows > 0) {
+			checkpoint.lastKey = lastKey;
+			checkpoint.copiedRows += rows;
+			copyCheckpointRepository->save(checkpoint);
+		}
+		if (rows < chunkRows) {
+			break;
+		}
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+		chunkRows = adaptChunkRows(chunkRows, static_cast<uint64_t>(elapsedMs));
+	}
+	checkCanceled();
+	if (!isStopped()) {
+		copyCheckpointRepository->remove(checkpoint.jobKey);
+	}
+}
+
+/**
+ * Load the rows of the SELECT by one LOAD DATA LOCAL INFILE statement. The loader thread executes the statement
+ * in the target session, the client library opens the pipe as the local file, and the calling thread writes 
+ * the lines of the rows into the pipe, so reading the source and loading the target overlap.
+ * 
+ * @param tblName
+ * @param selectSql
+ * @param loadSuffix - " INTO TABLE ..." of the LOAD DATA statement
+ * @param keyColumnCount - the last columns of the SELECT are the primary key
+ * @param sourceKey
+ * @param targetKey
+ * @param lastKey [out] - the key tuple of the last row
+ * @return the rows
+ */
+uint32_t QDbCopier::loadRows(const std::string & tblName, const std::string & selectSql, const std::string & loadSuffix, uint32_t keyColumnCount,
+	uint64_t sourceKey, uint64_t targetKey, std::string & lastKey)
+{
+	QInfilePipe pipe;
+	// the backslashes of the pipe name are escaped, the target session has no NO_BACKSLASH_ESCAPES
+	std::string loadSql = "LOAD DATA LOCAL INFILE '" + StringUtil::replace(pipe.getName(), "\\", "\\\\") + "'" + loadSuffix;
+	bool hasLoadError = false;
+	std::string errorCode, errorMsg;
+	std::thread loader([&]() {
+		// mysql driver must be initialized in every thread that uses it
+		QConnect::getDriver()->threadInit();
+		try {
+			userDbRepository->loadDataInSession(params.toConnectId, loadSql, targetKey);
+		} catch (QRuntimeException & ex) {
+			hasLoadError = true;
+			errorCode = ex.getCode();
+			errorMsg = ex.getMsg();
+			pipe.interrupt();
+		}
+		QConnect::getDriver()->threadEnd();
+	});
+
+	uint32_t rows = 0, blockRows = 0;
+	try {
+		if (pipe.accept()) {
+			std::string block;
+			userDbRepository->readRowTuples(params.fromConnectId, "", selectSql, sourceKey,
+				[&](const std::string & line, const std::string & keyTuple) -> bool {
+				if (isStopped()) {
+					return false;
+				}
+				block.append(line);
+				blockRows++;
+				if (block.size() >= PIPE_BLOCK_BYTES) {
+					if (!pipe.write(block)) {
+						return false;
+					}
+					addCopied(tblName, blockRows, block.size());
+					block.clear();
+					blockRows = 0;
+				}
+				lastKey = keyTuple;
+				rows++;
+				return true;
+			}, keyColumnCount, true);
+			if (!block.empty() && !isStopped() && pipe.write(block)) {
+				addCopied(tblName, blockRows, block.size());
+			}
+		}
+	} catch (QRuntimeException & ex) {
+		pipe.close();
+		loader.join();
+		throw ex;
+	}
+	pipe.close();
+	loader.join();
+	if (hasLoadError) {
+		throw QRuntimeException(errorCode, errorMsg);
+	}
+	return rows;
+}
+
+/**
+ * LOAD DATA LOCAL INFILE is disabled by the server or the client, or the client library can not open the pipe.
+ * 
+ * @param code - the error code
+ * @return 
+ */
+bool QDbCopier::isLoadDataRejected(const std::string & code)
+{
+	// ER_NOT_ALLOWED_COMMAND, ER_CLIENT_LOCAL_FILES_DISABLED, CR_LOAD_DATA_LOCAL_INFILE_REJECTED, EE_FILENOTFOUND
+	return code == "1148" || code == "3948" || code == "2068" || code == "29";
+}
+
+/**
+ * The same connection, the same host and port, or the same @@server_uuid are the same server.
+ * 
+ * @return 
+ */
+bool QDbCopier::detectSameServer()
+{
+	if (params.fromConnectId == params.toConnectId) {
+		return true;
+	}
+	auto connectService = ConnectService::getInstance();
+	UserConnect fromConnect = connectService->getUserConnect(params.fromConnectId);
+	UserConnect toConnect = connectService->getUserConnect(params.toConnectId);
+	if (fromConnect.host == toConnect.host && fromConnect.port == toConnect.port) {
+		return true;
+	}
+	// such as localhost and 127.0.0.1, or a server behind the port forwarding
+	bool result = userDbRepository->getServerId(params.fromConnectId) == userDbRepository->getServerId(params.toConnectId);
+	Q_INFO("Duplicate database, same server:{}", result);
+	return result;
+}
+
+/**
+ * The user of the target connection may have no privilege to read the source table, then the rows are copied through the client.
+ * 
+ * @param tblName
+ * @param targetKey
+ * @return 
+ */
+bool QDbCopier::canSelectInTarget(const std::string & tblName, uint64_t targetKey)
+{
+	if (params.fromConnectId == params.toConnectId) {
+		return true;
+	}
+	try {
+		std::string sql = "SELECT 1 FROM `" + params.fromSchema + "`.`" + tblName + "` LIMIT 0";
+		userDbRepository->readRowTuples(params.toConnectId, "", sql, targetKey, [](const std::string &, const std::string &) -> bool {
+			return true;
+		});
+		return true;
+	} catch (QRuntimeException & ex) {
+		Q_INFO("The target can not read the source table {}, code:{}, error:{}", tblName, ex.getCode(), ex.getMsg());
+		return false;
+	}
+}
+
+/**
+ * Copy the rows in the server by INSERT INTO target SELECT ... FROM source in the target session. The table with the
+ * primary key is copied by the chunks: the source session reads the last key of the next chunk by LIMIT 1 OFFSET chunkRows-1
+ * and the target copies the range (lastKey, upperKey], every chunk is committed by itself and saved as the checkpoint.
+ * INSERT ... SELECT reads the latest committed rows of the source, not the snapshot of the source session,
+ * so it is used only if params.lockTables, the source tables stay locked until the end of the copy.
+ * 
+ * @param tblName
+ * @param columns
+ * @param keyColumns - empty if the table has no primary key
+ * @param sourceKey
+ * @param targetKey
+ */
+void QDbCopier::copyTableDataInServer(const std::string & tblName, const Columns & columns, const Columns & keyColumns,
+	uint64_t sourceKey, uint64_t targetKey)
+{
+	std::string columnList = joinColumns(columns), keyList = joinColumns(keyColumns);
+	std::string fromTable = getQualifiedSource(tblName);
+	std::string toTable = getQualifiedTarget(tblName);
+	std::string insertPrefix = "INSERT INTO " + toTable + " (" + columnList + ") SELECT " + columnList + " FROM " + fromTable;
+	// the rows do not pass the client, the bytes are estimated by the average row length
+	uint64_t rowBytes = getEstimatedRowBytes(tblName);
+	if (keyColumns.empty()) {
+		uint64_t rows = userDbRepository->executeUpdateInSession(params.toConnectId, "", insertPrefix, targetKey);
+		addCopied(tblName, rows, rows * rowBytes);
+		checkCanceled();
+		return;
+	}
+
+	CopyCheckpoint checkpoint;
+	std::string deleteSql;
+	if (beginCheckpoint(tblName, toTable, keyList, checkpoint, deleteSql)) {
+		userDbRepository->executeInSession(params.toConnectId, "", deleteSql, targetKey);
+	}
+
+	uint32_t chunkRows = INIT_CHUNK_ROWS;
+	while (!isStopped()) {
+		std::string lowerCondition = checkpoint.lastKey.empty() ? "" : "(" + keyList + ") > " + checkpoint.lastKey;
+		std::string boundarySql = "SELECT " + keyList + " FROM " + fromTable + (lowerCondition.empty() ? "" : " WHERE " + lowerCondition)
+			+ " ORDER BY " + keyList + " LIMIT 1 OFFSET " + std::to_string(chunkRows - 1);
+		// the tuple of the key columns is the key tuple, empty if the rest rows are less than a chunk
+		std::string upperKey;
+		userDbRepository->readRowTuples(params.fromConnectId, "", boundarySql, sourceKey, [&upperKey](const std::string & tuple, const std::string &) -> bool {
+			upperKey = tuple;
+			return false;
+		});
+
+		std::string insertSql = insertPrefix;
+		if (!lowerCondition.empty()) {
+			insertSql.append(" WHERE ").append(lowerCondition);
+		}
+		if (!upperKey.empty()) {
+			insertSql.append(lowerCondition.empty() ? " WHERE (" : " AND (").append(keyList).append(") <= ").append(upperKey);
+		}
+		auto begin = std::chrono::steady_clock::now();
+		uint64_t rows = userDbRepository->executeUpdateInSession(params.toConnectId, "", insertSql, targetKey);
+		addCopied(tblName, rows, rows * rowBytes);
+		if (upperKey.empty()) {
+			break;
+		}
+		checkpoint.lastKey = upperKey;
+		checkpoint.copiedRows += rows;
+		copyCheckpointRepository->save(checkpoint);
+		auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count();
+		chunkRows = adaptChunkRows(chunkRows, static_cast<uint64_t>(elapsedMs));
+	}
+	checkCanceled();
+	if (!isStopped()) {
+		copyCheckpointRepository->remove(checkpoint.jobKey);
+	}
+}
+
+/**
+ * Create the views, a view that selects from another view fails before the other view is created,
+ * so the failed views are retried until no more view can be created.
+ */
+void QDbCopier::createViews()
+{
+	std::vector<std::string> pendingViews = params.views;
+	std::string sqlMode;
+	while (!pendingViews.empty()) {
+		std::vector<std::string> failedViews;
+		std::string errorCode, errorMsg;
+		for (auto & viewName : pendingViews) {
+			checkCanceled();
+			try {
+				std::string ddl = userDbRepository->getObjectDDLAndSqlMode(params.fromConnectId, params.fromSchema, viewName, "VIEW", sqlMode);
+				userDbRepository->executeInSession(params.toConnectId, params.toSchema, replaceSchema(ddl), targetSessionKey);
+			} catch (QRuntimeException & ex) {
+				failedViews.push_back(viewName);
+				errorCode = ex.getCode();
+				errorMsg = ex.getMsg();
+			}
+		}
+		if (failedViews.size() == pendingViews.size()) {
+			throw QRuntimeException(errorCode, errorMsg);
+		}
+		pendingViews.swap(failedViews);
+	}
+}
+
+/**
+ * Create the routines, triggers or events with the sql_mode of their creation.
+ *
+ * @param objectType - "PROCEDURE", "FUNCTION", "TRIGGER", "EVENT"
+ * @param names
+ */
+void QDbCopier::createObjects(const std::string & objectType, const std::vector<std::string> & names)
+{
+	if (names.empty()) {
+		return;
+	}
+	std::string sqlMode;
+	for (auto & name : names) {
+		checkCanceled();
+		std::string ddl = userDbRepository->getObjectDDLAndSqlMode(params.fromConnectId, params.fromSchema, name, objectType, sqlMode);
+		userDbRepository->executeInSession(params.toConnectId, "", "SET SESSION SQL_MODE='" + sqlMode + "'", targetSessionKey);
+		userDbRepository->executeInSession(params.toConnectId, params.toSchema, replaceSchema(ddl), targetSessionKey);
+	}
+	// the sql_mode of openTargetSession(...) is made from the default mode of the server
+	userDbRepository->executeInSession(params.toConnectId, "", "SET SESSION SQL_MODE=DEFAULT", targetSessionKey);
+	userDbRepository->executeInSession(params.toConnectId, "", "SET SESSION " 
+		+ SqlUtil::makeSqlModeWithBackslashEscapes("NO_AUTO_VALUE_ON_ZERO"), targetSessionKey);
+}
+
+/**
+ * The views and routines may reference the objects by `schema`.`name`, so the source schema is replaced with the target schema.
+ *
+ * @param ddl
+ * @return
+ */
+std::string QDbCopier::replaceSchema(const std::string & ddl) const
+{
+	if (params.fromSchema == params.toSchema) {
+		return ddl;
+	}
+	return StringUtil::replace(ddl, "`" + params.fromSchema + "`.", "`" + params.toSchema + "`.");
+}
+
+/**
+ * Load the estimates of the tables from information_schema.TABLES.
+ */
+void QDbCopier::initProgress()
+{
+	std::unordered_map<std::string, UserTable> detailTables;
+	if (!params.tables.empty()) {
+		for (auto & item : MetadataService::getInstance()->getDetailUserTables(params.fromConnectId, params.fromSchema)) {
+			detailTables[item.name] = item;
+		}
+	}
+	std::lock_guard<std::mutex> lk(progressMutex);
+	progress.tables.clear();
+	progressIndexes.clear();
+	for (auto & tblName : params.tables) {
+		DbCopyTableProgress item;
+		item.name = tblName;
+		auto iter = detailTables.find(tblName);
+		if (iter != detailTables.end() && !params.structOnly) {
+			item.estimatedRows = iter->second.rows;
+			item.estimatedBytes = iter->second.dataLength;
+		}
+		progress.estimatedRows += item.estimatedRows;
+		progress.estimatedBytes += item.estimatedBytes;
+		progressIndexes[tblName] = progress.tables.size();
+		progress.tables.push_back(item);
+	}
+}
+
+void QDbCopier::setStep(const std::string & step)
+{
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress.step = step;
+		if (step == "rows") {
+			rowsBeginAt = std::chrono::steady_clock::now();
+		}
+	}
+	reportProgress(true);
+}
+
+void QDbCopier::setTableStatus(const std::string & tblName, CopyTableStatus status)
+{
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		auto iter = progressIndexes.find(tblName);
+		if (iter == progressIndexes.end()) {
+			return;
+		}
+		progress.tables.at(iter->second).status = status;
+	}
+	reportProgress(status == COPY_TABLE_DONE);
+}
+
+/**
+ * Add the rows and bytes that are written to the target.
+ * 
+ * @param tblName
+ * @param rows
+ * @param bytes
+ */
+void QDbCopier::addCopied(const std::string & tblName, uint64_t rows, uint64_t bytes)
+{
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		auto iter = progressIndexes.find(tblName);
+		if (iter == progressIndexes.end()) {
+			return;
+		}
+		auto & item = progress.tables.at(iter->second);
+		item.copiedRows += rows;
+		item.copiedBytes += bytes;
+	}
+	reportProgress(false);
+}
+
+uint64_t QDbCopier::getEstimatedRowBytes(const std::string & tblName)
+{
+	std::lock_guard<std::mutex> lk(progressMutex);
+	auto iter = progressIndexes.find(tblName);
+	if (iter == progressIndexes.end()) {
+		return 0;
+	}
+	auto & item = progress.tables.at(iter->second);
+	return item.estimatedRows ? item.estimatedBytes / item.estimatedRows : 0;
+}
+
+/**
+ * Call the progress callback with a snapshot of the progress. The reports within REPORT_INTERVAL_MS 
+ * of the last one are dropped unless force, the next report has their counters.
+ * 
+ * @param force - the step or the table is changed
+ */
+void QDbCopier::reportProgress(bool force)
+{
+	if (!progressCallback) {
+		return;
+	}
+	DbCopyProgress snapshot;
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		auto now = std::chrono::steady_clock::now();
+		if (!force && now - lastReportAt < std::chrono::milliseconds(REPORT_INTERVAL_MS)) {
+			return;
+		}
+		lastReportAt = now;
+		updateProgress();
+		snapshot = progress;
+	}
+	progressCallback(snapshot);
+}
+
+/**
+ * Sum the tables, the rows step is 5% ~ 95%. The done fraction of a table is its copied rows to TABLE_ROWS 
+ * (bytes to DATA_LENGTH if TABLE_ROWS is 0), it is at most 99% until the table is done, since TABLE_ROWS of 
+ * InnoDB is an estimate. The tables are weighted by DATA_LENGTH, and the ETA is the elapsed time of the rows step 
+ * scaled by the remaining fraction. Call it with progressMutex locked.
+ */
+void QDbCopier::updateProgress()
+{
+	auto now = std::chrono::steady_clock::now();
+	progress.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - beginAt).count();
+	progress.copiedRows = 0;
+	progress.copiedBytes = 0;
+	progress.doneTables = 0;
+	double totalWeight = 0, doneWeight = 0;
+	for (auto & item : progress.tables) {
+		progress.copiedRows += item.copiedRows;
+		progress.copiedBytes += item.copiedBytes;
+		double fraction = 1.0;
+		if (item.status == COPY_TABLE_DONE) {
+			progress.doneTables++;
+		} else if (item.estimatedRows) {
+			fraction = (std::min)(item.copiedRows * 1.0 / item.estimatedRows, 0.99);
+		} else if (item.estimatedBytes) {
+			fraction = (std::min)(item.copiedBytes * 1.0 / item.estimatedBytes, 0.99);
+		} else {
+			fraction = 0;
+		}
+		double weight = static_cast<double>((std::max)(item.estimatedBytes, uint64_t(1)));
+		totalWeight += weight;
+		doneWeight += weight * fraction;
+	}
+	double doneFraction = totalWeight > 0 ? doneWeight / totalWeight : 1.0;
+
+	progress.rowsPerSecond = 0;
+	progress.bytesPerSecond = 0;
+	progress.etaSeconds = -1;
+	if (progress.step == "rows") {
+		auto rowsMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - rowsBeginAt).count();
+		if (rowsMs > 0) {
+			progress.rowsPerSecond = progress.copiedRows * 1000.0 / rowsMs;
+			progress.bytesPerSecond = progress.copiedBytes * 1000.0 / rowsMs;
+		}
+		if (doneFraction > 0 && rowsMs > 0) {
+			progress.etaSeconds = static_cast<int64_t>(rowsMs * (1.0 - doneFraction) / doneFraction / 1000.0);
+		}
+		progress.percent = 5 + static_cast<int>(90 * doneFraction);
+	} else if (progress.step == "views") {
+		progress.percent = 95;
+	} else if (progress.step == "objects") {
+		progress.percent = 97;
+	} else {
+		progress.percent = 2;
+	}
+}
+
+void QDbCopier::checkCanceled() const
+{
+	if (canceled) {
+		throw QRuntimeException("200029");
+	}
+}
+
+bool QDbCopier::isStopped() const
+{
+	return canceled || failed;
+}
+
+QDbCopier::BatchQueue::BatchQueue(size_t capacity) : capacity(capacity)
+{
+}
+
+bool QDbCopier::BatchQueue::push(std::string && sql, uint32_t rows)
+{
+	Batch batch;
+	batch.sql = std::move(sql);
+	batch.rows = rows;
+	return push(std::move(batch));
+}
+
+bool QDbCopier::BatchQueue::push(Batch && batch)
+{
+	std::unique_lock<std::mutex> lk(mutex);
+	notFull.wait(lk, [this]() { return aborted || batches.size() < capacity; });
+	if (aborted) {
+		return false;
+	}
+	batches.push_back(std::move(batch));
+	notEmpty.notify_one();
+	return true;
+}
+
+bool QDbCopier::BatchQueue::pop(Batch & batch)
+{
+	std::unique_lock<std::mutex> lk(mutex);
+	notEmpty.wait(lk, [this]() { return aborted || closed || !batches.empty(); });
+	if (aborted || batches.empty()) {
+		return false;
+	}
+	batch = std::move(batches.front());
+	batches.pop_front();
+	notFull.notify_one();
+	return true;
+}
+
+void QDbCopier::BatchQueue::close()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	closed = true;
+	notEmpty.notify_all();
+}
+
+void QDbCopier::BatchQueue::abort()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	aborted = true;
+	batches.clear();
+	notFull.notify_all();
+	notEmpty.notify_all();
+}
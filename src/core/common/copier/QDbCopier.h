@@ -0,0 +1,185 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QDbCopier.h
+ * @brief  QDbCopier - Duplicate a database from the source connection to the target connection in process.
+ *         The DDL and rows are read over the source session and written to the target session by
+ *         multi-row INSERT statements, the reader and the writer are pipelined by a bounded queue,
+ *         so the memory is bounded and there is no intermediate file.
+ *         The tables are copied by the workers in parallel (largest first), the source sessions of the workers
+ *         start their snapshots while the tables are locked, so all tables are read at the same point in time.
+ *         A table with the primary key is copied by the ranges of the key, every range (chunk) is committed in the target
+ *         and saved as the checkpoint in the system db, so an interrupted copy resumes from the last committed chunk.
+ *         If the source and the target are the same server, the rows are copied by INSERT ... SELECT in the target
+ *         session, the rows do not leave the server. Otherwise the rows are loaded by LOAD DATA LOCAL INFILE from
+ *         an in-memory pipe if local_infile of the target is ON, and by multi-row INSERT statements if it is OFF.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-30
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <functional>
+#include <unordered_map>
+#include <string>
+#include <vector>
+#include "core/entity/Entity.h"
+#include "core/repository/db/UserDbRepository.h"
+#include "core/repository/system/CopyCheckpointRepository.h"
+
+// The progress of the copy, it is called in the copying threads
+typedef std::function<void (const DbCopyProgress & progress)> DbCopyProgressCallback;
+
+class QDbCopier {
+public:
+	QDbCopier(const DbCopyParams & params);
+	~QDbCopier();
+
+	// run in the calling thread, throw QRuntimeException if failed
+	void run();
+	// stop the copy at the next batch, run() throws QRuntimeException("200029")
+	void cancel();
+	// call it before run(), the progress is reported at most once every REPORT_INTERVAL_MS
+	void setProgressCallback(DbCopyProgressCallback callback);
+	bool isCanceled() const;
+
+	// the key of the checkpoint of copying the table, "fromConnectId:fromSchema.fromTable>toConnectId:toSchema.toTable"
+	static std::string getJobKey(const DbCopyParams & params, const std::string & tblName);
+	// the target table name of the source table, params.toTable is used if only one table is copied
+	static std::string getTargetTable(const DbCopyParams & params, const std::string & tblName);
+private:
+	// The statement of the writer, the checkpoint is saved after the statement (COMMIT of the chunk) if hasCheckpoint
+	typedef struct _Batch {
+		std::string sql;
+		bool hasCheckpoint = false;
+		std::string lastKey;
+		uint64_t copiedRows = 0;
+		uint32_t rows = 0; // the rows of the INSERT statement
+	} Batch;
+
+	// The INSERT statements between the reader and the writer, the reader waits when the queue is full
+	class BatchQueue {
+	public:
+		BatchQueue(size_t capacity);
+		// false if the queue has been aborted
+		bool push(Batch && batch);
+		bool push(std::string && sql, uint32_t rows = 0);
+		// false if the queue is closed and empty, or aborted
+		bool pop(Batch & batch);
+		// no more batches
+		void close();
+		// drop the batches and wake up both sides
+		void abort();
+	private:
+		size_t capacity;
+		std::deque<Batch> batches;
+		bool closed = false;
+		bool aborted = false;
+		std::mutex mutex;
+		std::condition_variable notFull;
+		std::condition_variable notEmpty;
+	};
+
+	// the max bytes of one INSERT statement, it is less than the default max_allowed_packet (4M)
+	static const size_t MAX_BATCH_BYTES = 1024 * 1024;
+	// the batches in the queue, the memory of a table is about (QUEUE_CAPACITY + 2) * MAX_BATCH_BYTES
+	static const size_t QUEUE_CAPACITY = 4;
+	// the session keys of the copier, greater than the session keys of ExecutorService
+	static std::atomic<uint64_t> nextSessionKey;
+
+	// the sessions that are kept for the user sql statements when the workers check out the sessions of QUERY_LANE
+	static const uint32_t RESERVED_SESSIONS = 2;
+
+	// the rows of a chunk are adapted to the elapsed time of the chunk, between MIN_CHUNK_ROWS and MAX_CHUNK_ROWS
+	static const uint32_t INIT_CHUNK_ROWS = 1000;
+	static const uint32_t MIN_CHUNK_ROWS = 100;
+	static const uint32_t MAX_CHUNK_ROWS = 100000;
+	// the min interval of the progress reports
+	static const uint32_t REPORT_INTERVAL_MS = 250;
+
+	// the bytes of the lines that are written to the pipe of LOAD DATA at a time
+	static const size_t PIPE_BLOCK_BYTES = 64 * 1024;
+
+	// the rows are doubled if a chunk is faster than FAST_CHUNK_MS, and halved if it is slower than SLOW_CHUNK_MS
+	static const uint32_t FAST_CHUNK_MS = 500;
+	static const uint32_t SLOW_CHUNK_MS = 2000;
+
+	DbCopyParams params;
+	std::atomic<bool> canceled{ false };
+	std::atomic<bool> failed{ false }; // a worker has failed, the other workers stop at the next batch
+	uint64_t sourceSessionKey = 0; // the coordinator session, it holds the table locks
+	uint64_t targetSessionKey = 0; // the DDL session, it is also the target session of the first worker
+	bool isTablesLocked = false;
+	bool isSameServer = false; // the source and the target connection are the same MySQL server and the tables are locked
+	std::atomic<bool> isLoadDataEnabled{ false }; // local_infile of the target is ON, false after LOAD DATA is rejected
+	UserDbRepository * userDbRepository = UserDbRepository::getInstance();
+	CopyCheckpointRepository * copyCheckpointRepository = CopyCheckpointRepository::getInstance();
+
+	// progress, guarded by progressMutex
+	std::mutex progressMutex;
+	DbCopyProgress progress;
+	std::unordered_map<std::string, size_t> progressIndexes; // table name => index of progress.tables
+	std::chrono::steady_clock::time_point beginAt;
+	std::chrono::steady_clock::time_point rowsBeginAt;
+	std::chrono::steady_clock::time_point lastReportAt;
+	DbCopyProgressCallback progressCallback;
+
+	void openSessions();
+	void closeSessions();
+	void openSourceSession(uint64_t sessionKey);
+	void openTargetSession(uint64_t sessionKey);
+	void closeSourceSession(uint64_t sessionKey);
+	void closeTargetSession(uint64_t sessionKey);
+	void createDatabase();
+	void createTables();
+	std::vector<std::string> getTablesLargestFirst();
+	uint32_t getWorkerCount(size_t tableCount) const;
+	void copyTablesData();
+	void copyTableData(const std::string & tblName, uint64_t sourceKey, uint64_t targetKey);
+	void readTableRows(const std::string & tblName, const Columns & columns, uint64_t sourceKey, BatchQueue & queue);
+	void readTableChunks(const std::string & tblName, const Columns & columns, const Columns & keyColumns, 
+		uint64_t sourceKey, BatchQueue & queue);
+	static uint32_t adaptChunkRows(uint32_t chunkRows, uint64_t elapsedMs);
+	static std::string joinColumns(const Columns & columns);
+	std::string getQualifiedSource(const std::string & tblName) const;
+	std::string getQualifiedTarget(const std::string & tblName) const;
+	static std::string makeChunkSelectSql(const std::string & selectPrefix, const std::string & keyList,
+		const std::string & lastKey, uint32_t chunkRows);
+	bool beginCheckpoint(const std::string & tblName, const std::string & toTable, const std::string & keyList,
+		CopyCheckpoint & checkpoint, std::string & deleteSql);
+	bool detectSameServer();
+	bool canSelectInTarget(const std::string & tblName, uint64_t targetKey);
+	void loadTableData(const std::string & tblName, const Columns & columns, const Columns & keyColumns,
+		uint64_t sourceKey, uint64_t targetKey);
+	uint32_t loadRows(const std::string & tblName, const std::string & selectSql, const std::string & loadSql, uint32_t keyColumnCount,
+		uint64_t sourceKey, uint64_t targetKey, std::string & lastKey);
+	static bool isLoadDataRejected(const std::string & code);
+	void copyTableDataInServer(const std::string & tblName, const Columns & columns, const Columns & keyColumns,
+		uint64_t sourceKey, uint64_t targetKey);
+	void createViews();
+	void createObjects(const std::string & objectType, const std::vector<std::string> & names);
+	std::string replaceSchema(const std::string & ddl) const;
+	void initProgress();
+	void setStep(const std::string & step);
+	void setTableStatus(const std::string & tblName, CopyTableStatus status);
+	void addCopied(const std::string & tblName, uint64_t rows, uint64_t bytes);
+	uint64_t getEstimatedRowBytes(const std::string & tblName);
+	void reportProgress(bool force);
+	void updateProgress();
+	void checkCanceled() const;
+	bool isStopped() const;
+};
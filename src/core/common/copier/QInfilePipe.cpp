@@ -0,0 +1,105 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QInfilePipe.cpp
+ * @brief  QInfilePipe - The in-memory file of LOAD DATA LOCAL INFILE.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-02
+ *********************************************************************/
+#include "QInfilePipe.h"
+#include <windows.h>
+#include "utils/Log.h"
+
+std::atomic<uint64_t> QInfilePipe::nextPipeId{ 1 };
+
+QInfilePipe::QInfilePipe()
+{
+	name = "\\\\.\\pipe\\CuteMySQL-infile-" + std::to_string(GetCurrentProcessId()) + "-" + std::to_string(nextPipeId++);
+	// one instance, the client library is the only reader
+	HANDLE pipe = CreateNamedPipeA(name.c_str(), PIPE_ACCESS_OUTBOUND, PIPE_TYPE_BYTE | PIPE_WAIT, 1, 
+		BUFFER_BYTES, 0, 0, NULL);
+	if (pipe == INVALID_HANDLE_VALUE) {
+		Q_ERROR("Fail to create the pipe:{}, error:{}", name, GetLastError());
+		return;
+	}
+	handle = pipe;
+}
+
+QInfilePipe::~QInfilePipe()
+{
+	if (handle) {
+		CloseHandle(static_cast<HANDLE>(handle));
+		handle = nullptr;
+	}
+}
+
+const std::string & QInfilePipe::getName() const
+{
+	return name;
+}
+
+bool QInfilePipe::accept()
+{
+	if (!handle) {
+		return false;
+	}
+	if (!ConnectNamedPipe(static_cast<HANDLE>(handle), NULL) && GetLastError() != ERROR_PIPE_CONNECTED) {
+		Q_ERROR("Fail to accept the pipe:{}, error:{}", name, GetLastError());
+		return false;
+	}
+	return !interrupted;
+}
+
+bool QInfilePipe::write(const std::string & data)
+{
+	if (!handle || interrupted) {
+		return false;
+	}
+	const char * ptr = data.data();
+	size_t size = data.size();
+	while (size > 0) {
+		DWORD written = 0;
+		if (!WriteFile(static_cast<HANDLE>(handle), ptr, static_cast<DWORD>(size), &written, NULL)) {
+			Q_ERROR("Fail to write the pipe:{}, error:{}", name, GetLastError());
+			return false;
+		}
+		ptr += written;
+		size -= written;
+	}
+	return true;
+}
+
+/**
+ * Closing the handle does not drop the data in the buffer, the client library reads the end of the file after them.
+ */
+void QInfilePipe::close()
+{
+	if (!handle) {
+		return;
+	}
+	FlushFileBuffers(static_cast<HANDLE>(handle));
+	CloseHandle(static_cast<HANDLE>(handle));
+	handle = nullptr;
+}
+
+/**
+ * Connect to the pipe as the client, so ConnectNamedPipe(...) of accept() returns.
+ */
+void QInfilePipe::interrupt()
+{
+	interrupted = true;
+	HANDLE client = CreateFileA(name.c_str(), GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+	if (client != INVALID_HANDLE_VALUE) {
+		CloseHandle(client);
+	}
+}
@@ -0,0 +1,49 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QInfilePipe.h
+ * @brief  QInfilePipe - The in-memory file of LOAD DATA LOCAL INFILE. It is a named pipe (\\.\pipe\...),
+ *         the client library opens it as the local file and reads the lines that the copier writes,
+ *         the buffer of the pipe is the ring buffer between them, so the rows never touch the disk.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-02
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+class QInfilePipe {
+public:
+	QInfilePipe();
+	~QInfilePipe();
+
+	// the file name in LOAD DATA LOCAL INFILE '...'
+	const std::string & getName() const;
+	// wait for the client library to open the pipe, false if the pipe failed or is interrupted
+	bool accept();
+	// false if the client library has closed the pipe
+	bool write(const std::string & data);
+	// wait for the client library to read all data, then it reads the end of the file
+	void close();
+	// wake up accept() if the LOAD DATA statement fails before the client library opens the pipe
+	void interrupt();
+private:
+	// the buffer of the pipe, the writer waits when the client library is BUFFER_BYTES behind
+	static const uint32_t BUFFER_BYTES = 1024 * 1024;
+	static std::atomic<uint64_t> nextPipeId;
+
+	std::string name;
+	void * handle = nullptr; // HANDLE of the pipe
+	std::atomic<bool> interrupted{ false };
+};
@@ -107,7 +107,7 @@ bool QSqlDatabase::open()
 {
 	assert(!databaseName.empty());
 	
-	int ret =  sqlite3_open_v2(databaseName.c_str(), &handle, SQLITE_OPEN_READWRITE, nullptr);
+	int ret =  sqlite3_open_v2(databaseName.c_str(), &handle, SQLITE_OPEN_READWRITE | SQLITE_OPEN_FULLMUTEX, nullptr);
 	isOpenFlag = (SQLITE_OK == ret);
 	if (SQLITE_OK != ret) {
 		setErrorMsg("Open sqlite db raise error. path:" + databaseName);
@@ -190,6 +190,7 @@ void QSqlDatabase::setBusyTimeout(const int aBusyTimeoutMs)
 // Return the number of changes.
 int QSqlDatabase::exec(const char * apQueries)
 {
+    std::lock_guard<std::recursive_mutex> lk(mutex);
     const int ret = tryExec(apQueries);
     check(ret);
 
@@ -199,6 +200,7 @@ int QSqlDatabase::exec(const char * apQueries)
 
 int QSqlDatabase::tryExec(const char* wpQueries) noexcept
 {
+    std::lock_guard<std::recursive_mutex> lk(mutex);
     auto ret = sqlite3_exec(getHandle(), wpQueries, nullptr, nullptr, nullptr);
 	return ret;
 }
@@ -2,6 +2,7 @@
 #include <string>
 #include <memory>
 #include <unordered_map>
+#include <mutex>
 #include "utils/ThreadUtil.h"
 #include <sqlite3/sqlite3.h>
 #include "QSqlStatement.h"
@@ -115,6 +116,8 @@ public:
 	void setPassword(const std::string & password);
 
 	sqlite3 * getHandle() const noexcept;
+	// serializes the statements and the transactions of the threads, QSqlStatement holds it until it is destroyed
+	std::recursive_mutex & getMutex() const noexcept { return mutex; }
 	std::string getActiveName() { return activeName; };
 	std::string getDatabaseName() { return databaseName; };
 	std::string getHostName() { return hostName; };
@@ -183,6 +186,7 @@ private:
 
 	//std::unique_ptr<sqlite3, Deleter> handle;
 	sqlite3 * handle;
+	mutable std::recursive_mutex mutex;
 
 	std::string activeName; //ݿ
 	std::string databaseName; //ݿSQLITEݿ·
@@ -10,6 +10,7 @@ namespace SQLite
 
 
 QSqlStatement::QSqlStatement(const QSqlDatabase* aDatabase, const char* apQuery) :
+    mLock(aDatabase->getMutex()),
     mQuery(apQuery),
     mpSQLite(aDatabase->getHandle()),
     mpPreparedStatement(prepareStatement()) // prepare the SQL query (needs Database friendship)
@@ -18,6 +19,7 @@ QSqlStatement::QSqlStatement(const QSqlDatabase* aDatabase, const char* apQuery)
 }
 
 QSqlStatement::QSqlStatement(QSqlStatement&& aStatement) noexcept :
+    mLock(std::move(aStatement.mLock)),
     mQuery(std::move(aStatement.mQuery)),
     mpSQLite(aStatement.mpSQLite),
     mpPreparedStatement(std::move(aStatement.mpPreparedStatement)),
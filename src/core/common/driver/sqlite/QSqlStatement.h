@@ -4,6 +4,7 @@
 #include <sqlite3/sqlite3.h>
 #include <map>
 #include <memory>
+#include <mutex>
 #include "QSqlDatabase.h"
 #include "QSqlUtil.h"
 #include "QSqlException.h"
@@ -687,6 +688,7 @@ private:
 		*/
 	sqlite3_stmt* getPreparedStatement() const;
 
+	std::unique_lock<std::recursive_mutex> mLock;   //!< QSqlDatabase::getMutex(), held until the statement is finalized
 	std::string            mQuery;                 //!< UTF-8 SQL Query
 	sqlite3*                mpSQLite;               //!< Pointer to SQLite Database Connection Handle
 	TStatementPtr           mpPreparedStatement;    //!< Shared Pointer to the prepared SQLite Statement Object
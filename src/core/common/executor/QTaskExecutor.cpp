@@ -0,0 +1,180 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QTaskExecutor.cpp
+ * @brief  QTaskExecutor - The worker threads for running the background tasks.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-22
+ *********************************************************************/
+#include "QTaskExecutor.h"
+#include <exception>
+#include "utils/Log.h"
+
+QTaskExecutor::QTaskExecutor(size_t threadCount, ThreadHook onThreadStart, ThreadHook onThreadEnd)
+	: onThreadStart(onThreadStart), onThreadEnd(onThreadEnd)
+{
+	if (threadCount == 0) {
+		threadCount = 1;
+	}
+	for (size_t i = 0; i < threadCount; i++) {
+		workers.emplace_back(&QTaskExecutor::run, this);
+	}
+}
+
+QTaskExecutor::~QTaskExecutor()
+{
+	shutdown();
+}
+
+/**
+ * Submit a task.
+ * 
+ * @param serialKey - the tasks with the same serial key run one by one in submitting order
+ * @param task
+ * @return task id
+ */
+uint64_t QTaskExecutor::submit(uint64_t serialKey, Task task)
+{
+	uint64_t taskId = nextTaskId++;
+	QueuedTask item;
+	item.taskId = taskId;
+	item.task = std::move(task);
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		if (stopping) {
+			return 0;
+		}
+		auto & queue = queues[serialKey];
+		bool idle = queue.empty() && runningKeys.find(serialKey) == runningKeys.end();
+		queue.push_back(std::move(item));
+		if (idle) {
+			readyKeys.push_back(serialKey);
+		}
+	}
+	cond.notify_one();
+	return taskId;
+}
+
+/**
+ * Remove the pending tasks of serialKey, the running task is not affected.
+ * 
+ * @param serialKey
+ * @return the count of removed tasks
+ */
+size_t QTaskExecutor::cancel(uint64_t serialKey)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	auto iter = queues.find(serialKey);
+	if (iter == queues.end()) {
+		return 0;
+	}
+	size_t n = iter->second.size();
+	queues.erase(iter);
+	for (auto keyIter = readyKeys.begin(); keyIter != readyKeys.end(); ) {
+		keyIter = *keyIter == serialKey ? readyKeys.erase(keyIter) : keyIter + 1;
+	}
+	return n;
+}
+
+bool QTaskExecutor::isBusy(uint64_t serialKey)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	return runningKeys.find(serialKey) != runningKeys.end() || queues.find(serialKey) != queues.end();
+}
+
+size_t QTaskExecutor::getPendingCount()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	size_t n = 0;
+	for (auto & pair : queues) {
+		n += pair.second.size();
+	}
+	return n;
+}
+
+/**
+ * Stop the worker threads, the pending tasks will be dropped and the running tasks will be waited.
+ * 
+ */
+void QTaskExecutor::shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		if (stopping) {
+			return;
+		}
+		stopping = true;
+		queues.clear();
+		readyKeys.clear();
+	}
+	cond.notify_all();
+	for (auto & worker : workers) {
+		if (worker.joinable()) {
+			worker.join();
+		}
+	}
+	workers.clear();
+}
+
+void QTaskExecutor::run()
+{
+	if (onThreadStart) {
+		onThreadStart();
+	}
+
+	while (true) {
+		uint64_t serialKey = 0;
+		QueuedTask item;
+		{
+			std::unique_lock<std::mutex> lk(mutex);
+			cond.wait(lk, [this] { return stopping || !readyKeys.empty(); });
+			if (stopping) {
+				break;
+			}
+			serialKey = readyKeys.front();
+			readyKeys.pop_front();
+			auto iter = queues.find(serialKey);
+			if (iter == queues.end() || iter->second.empty()) {
+				continue;
+			}
+			item = std::move(iter->second.front());
+			iter->second.pop_front();
+			if (iter->second.empty()) {
+				queues.erase(iter);
+			}
+			runningKeys.insert(serialKey);
+		}
+
+		try {
+			item.task();
+		} catch (std::exception & ex) {
+			Q_ERROR("QTaskExecutor task raise error, taskId:{}, error:{}", item.taskId, ex.what());
+		} catch (...) {
+			Q_ERROR("QTaskExecutor task raise unknown error, taskId:{}", item.taskId);
+		}
+
+		{
+			std::lock_guard<std::mutex> lk(mutex);
+			runningKeys.erase(serialKey);
+			auto iter = queues.find(serialKey);
+			if (!stopping && iter != queues.end() && !iter->second.empty()) {
+				readyKeys.push_back(serialKey);
+				cond.notify_one();
+			}
+		}
+	}
+
+	if (onThreadEnd) {
+		onThreadEnd();
+	}
+}
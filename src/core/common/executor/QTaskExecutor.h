@@ -0,0 +1,74 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QTaskExecutor.h
+ * @brief  QTaskExecutor - The worker threads for running the background tasks.
+ *         The tasks with the same serial key run one by one in submitting order,
+ *         the tasks with different serial keys run concurrently.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-22
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class QTaskExecutor {
+public:
+	typedef std::function<void()> Task;
+	typedef std::function<void()> ThreadHook;
+
+	/**
+	 * @param threadCount - the count of worker threads
+	 * @param onThreadStart - called in the worker thread before running tasks, such as mysql driver threadInit()
+	 * @param onThreadEnd - called in the worker thread before the thread exit, such as mysql driver threadEnd()
+	 */
+	QTaskExecutor(size_t threadCount, ThreadHook onThreadStart = nullptr, ThreadHook onThreadEnd = nullptr);
+	~QTaskExecutor();
+
+	uint64_t submit(uint64_t serialKey, Task task);
+	size_t cancel(uint64_t serialKey);
+	bool isBusy(uint64_t serialKey);
+	size_t getPendingCount();
+	void shutdown();
+private:
+	typedef struct _QueuedTask {
+		uint64_t taskId = 0;
+		Task task;
+	} QueuedTask;
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	bool stopping = false;
+	std::atomic<uint64_t> nextTaskId{ 1 };
+
+	// serial key => tasks
+	std::unordered_map<uint64_t, std::deque<QueuedTask>> queues;
+	// the serial keys which have tasks and no running task
+	std::deque<uint64_t> readyKeys;
+	// the serial keys which have a running task
+	std::unordered_set<uint64_t> runningKeys;
+
+	std::vector<std::thread> workers;
+	ThreadHook onThreadStart;
+	ThreadHook onThreadEnd;
+
+	void run();
+};
@@ -0,0 +1,158 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QCompressWriter.cpp
+ * @brief  QCompressWriter - Write the blocks of a file in its own thread.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-05
+ *********************************************************************/
+#include "QCompressWriter.h"
+#include <wx/filefn.h>
+#include <wx/wfstream.h>
+#include <wx/zstream.h>
+#include "utils/Log.h"
+#include "core/common/exception/QRuntimeException.h"
+
+QCompressWriter::QCompressWriter(const std::string & filePath, SqlExportCompression compression)
+	: filePath(filePath), compression(compression)
+{
+}
+
+QCompressWriter::~QCompressWriter()
+{
+	if (thread.joinable()) {
+		abort();
+	}
+}
+
+void QCompressWriter::open()
+{
+	fileStream.reset(new wxFileOutputStream(wxString::FromUTF8(filePath)));
+	if (!fileStream->IsOk()) {
+		fileStream.reset();
+		Q_ERROR("Fail to create the export file, path:{}", filePath);
+		throw QRuntimeException("200031", "file:" + filePath);
+	}
+	if (compression == SQL_EXPORT_GZIP) {
+		zlibStream.reset(new wxZlibOutputStream(*fileStream, wxZ_DEFAULT_COMPRESSION, wxZLIB_GZIP));
+	}
+	thread = std::thread(&QCompressWriter::writeLoop, this);
+}
+
+void QCompressWriter::write(std::string && block)
+{
+	if (block.empty()) {
+		return;
+	}
+	std::unique_lock<std::mutex> lk(mutex);
+	notFull.wait(lk, [this]() { return blocks.size() < QUEUE_CAPACITY || failed || aborted; });
+	if (failed) {
+		throw QRuntimeException("200031", error);
+	}
+	if (aborted) {
+		return;
+	}
+	blocks.push_back(std::move(block));
+	notEmpty.notify_one();
+}
+
+void QCompressWriter::close()
+{
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		closed = true;
+	}
+	notEmpty.notify_all();
+	if (thread.joinable()) {
+		thread.join();
+	}
+	zlibStream.reset();
+	fileStream.reset();
+	throwIfFailed();
+}
+
+void QCompressWriter::abort()
+{
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		aborted = true;
+		blocks.clear();
+	}
+	notEmpty.notify_all();
+	notFull.notify_all();
+	if (thread.joinable()) {
+		thread.join();
+	}
+	zlibStream.reset();
+	fileStream.reset();
+	if (wxFileExists(wxString::FromUTF8(filePath))) {
+		wxRemoveFile(wxString::FromUTF8(filePath));
+	}
+}
+
+uint64_t QCompressWriter::getFileBytes() const
+{
+	return fileBytes;
+}
+
+/**
+ * Compress and write the queued blocks until close() or abort(), the end of the gzip stream is written at close().
+ */
+void QCompressWriter::writeLoop()
+{
+	wxOutputStream * out = zlibStream ? static_cast<wxOutputStream *>(zlibStream.get()) : fileStream.get();
+	while (true) {
+		std::string block;
+		{
+			std::unique_lock<std::mutex> lk(mutex);
+			notEmpty.wait(lk, [this]() { return !blocks.empty() || closed || aborted; });
+			if (aborted) {
+				return;
+			}
+			if (blocks.empty()) {
+				break; // closed
+			}
+			block = std::move(blocks.front());
+			blocks.pop_front();
+		}
+		notFull.notify_one();
+
+		out->Write(block.data(), block.size());
+		if (out->LastWrite() != block.size()) {
+			std::lock_guard<std::mutex> lk(mutex);
+			failed = true;
+			error = "Fail to write the file:" + filePath;
+			notFull.notify_all();
+			return;
+		}
+		fileBytes = static_cast<uint64_t>(fileStream->TellO());
+	}
+
+	bool isOk = zlibStream ? zlibStream->Close() : true;
+	fileBytes = static_cast<uint64_t>(fileStream->TellO());
+	isOk = fileStream->Close() && isOk;
+	if (!isOk) {
+		std::lock_guard<std::mutex> lk(mutex);
+		failed = true;
+		error = "Fail to close the file:" + filePath;
+	}
+}
+
+void QCompressWriter::throwIfFailed()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	if (failed) {
+		Q_ERROR("Fail to write the export file, error:{}", error);
+		throw QRuntimeException("200031", error);
+	}
+}
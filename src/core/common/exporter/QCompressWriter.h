@@ -0,0 +1,72 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QCompressWriter.h
+ * @brief  QCompressWriter - Write the blocks of a file in its own thread, the blocks are compressed by gzip
+ *         (the zlib of wxWidgets) on the way. The producer only waits when QUEUE_CAPACITY blocks are queued,
+ *         so reading the rows from the network and compressing them run at the same time.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-05
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <memory>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "core/entity/Entity.h"
+
+class wxFileOutputStream;
+class wxZlibOutputStream;
+
+class QCompressWriter {
+public:
+	QCompressWriter(const std::string & filePath, SqlExportCompression compression);
+	// abort() if it is not closed
+	~QCompressWriter();
+
+	// create the file and start the thread, throw QRuntimeException if the file can not be created
+	void open();
+	// queue the block, throw QRuntimeException if the thread has failed to write
+	void write(std::string && block);
+	// write the queued blocks and the end of the stream, throw QRuntimeException if failed
+	void close();
+	// drop the queued blocks and remove the incomplete file
+	void abort();
+	// the bytes that have been written to the file (compressed)
+	uint64_t getFileBytes() const;
+private:
+	// the blocks in the queue, the memory of the writer is about QUEUE_CAPACITY * the block size
+	static const size_t QUEUE_CAPACITY = 8;
+
+	std::string filePath;
+	SqlExportCompression compression;
+	std::thread thread;
+	std::mutex mutex;
+	std::condition_variable notFull;
+	std::condition_variable notEmpty;
+	std::deque<std::string> blocks;
+	bool closed = false;
+	bool aborted = false;
+	bool failed = false;
+	std::string error;
+	std::atomic<uint64_t> fileBytes{ 0 };
+	std::unique_ptr<wxFileOutputStream> fileStream;
+	std::unique_ptr<wxZlibOutputStream> zlibStream; // nullptr if SQL_EXPORT_NONE
+
+	void writeLoop();
+	void throwIfFailed();
+};
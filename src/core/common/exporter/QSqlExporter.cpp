@@ -0,0 +1,503 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QSqlExporter.cpp
+ * @brief  QSqlExporter - Export the databases as a sql script in process.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-05
+ *********************************************************************/
+#include "QSqlExporter.h"
+#include <cassert>
+#include <algorithm>
+#include <unordered_set>
+#include "utils/Log.h"
+#include "utils/DateUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/SqlUtil.h"
+#include "core/common/exception/QRuntimeException.h"
+#include "core/service/db/MetadataService.h"
+
+std::atomic<uint64_t> QSqlExporter::nextSessionKey{ 0x300000000000ULL };
+
+QSqlExporter::QSqlExporter(const SqlExportParams & params) : params(params)
+{
+}
+
+QSqlExporter::~QSqlExporter()
+{
+}
+
+/**
+ * Export the databases, the file is removed if the export fails or is canceled.
+ */
+void QSqlExporter::run()
+{
+	assert(params.connectId > 0 && !params.schemas.empty() && !params.filePath.empty());
+	Q_INFO("Export sql start, connectId:{}, schemas:{}, file:{}", params.connectId, 
+		StringUtil::implode(params.schemas, ","), params.filePath);
+	beginAt = std::chrono::steady_clock::now();
+	lastReportAt = beginAt;
+
+	// the objects are read from the server, not from the cache
+	for (auto & schema : params.schemas) {
+		MetadataService::getInstance()->invalidateCache(params.connectId, schema);
+	}
+	std::unordered_map<std::string, std::vector<std::string>> schemaTables;
+	initProgress(schemaTables);
+	// the INSERT statements can be imported into the server that has the same max_allowed_packet
+	std::string maxPacket = userDbRepository->getServerVariable(params.connectId, "max_allowed_packet");
+	size_t packetBytes = maxPacket.empty() ? 0 : static_cast<size_t>(std::stoull(maxPacket));
+	maxInsertBytes = packetBytes > PACKET_RESERVE_BYTES ? packetBytes - PACKET_RESERVE_BYTES : MIN_INSERT_BYTES;
+	maxInsertBytes = (std::max)(MIN_INSERT_BYTES, (std::min)(maxInsertBytes, MAX_INSERT_BYTES));
+	buffer.reserve(BLOCK_BYTES + MIN_INSERT_BYTES);
+
+	writer.reset(new QCompressWriter(params.filePath, params.compression));
+	writer->open();
+	try {
+		openSession();
+		writeHeader();
+		for (auto & schema : params.schemas) {
+			exportSchema(schema, schemaTables[schema]);
+		}
+		writeFooter();
+		flushBuffer(true);
+		closeSession();
+		writer->close();
+	} catch (QRuntimeException & ex) {
+		closeSession();
+		writer->abort();
+		Q_ERROR("Export sql failed, code:{}, error:{}", ex.getCode(), ex.getMsg());
+		throw;
+	}
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress.percent = 100;
+	}
+	reportProgress(true);
+	auto result = getProgress();
+	Q_INFO("Export sql success, tables:{}, rows:{}, sql bytes:{}, file bytes:{}, elapsed:{}ms", result.doneTables, 
+		result.exportedRows, result.sqlBytes, result.fileBytes, result.elapsedMs);
+}
+
+void QSqlExporter::cancel()
+{
+	canceled = true;
+}
+
+void QSqlExporter::setProgressCallback(SqlExportProgressCallback callback)
+{
+	progressCallback = callback;
+}
+
+bool QSqlExporter::isCanceled() const
+{
+	return canceled;
+}
+
+SqlExportProgress QSqlExporter::getProgress()
+{
+	std::lock_guard<std::mutex> lk(progressMutex);
+	return progress;
+}
+
+/**
+ * The rows of all tables are read in one snapshot, the values are written with the backslash escapes.
+ */
+void QSqlExporter::openSession()
+{
+	sessionKey = nextSessionKey++;
+	userDbRepository->executeInSession(params.connectId, "", "SET NAMES utf8mb4", sessionKey);
+	userDbRepository->executeInSession(params.connectId, "", "SET SESSION TIME_ZONE='+00:00', " 
+		+ SqlUtil::makeSqlModeWithBackslashEscapes(), sessionKey);
+	userDbRepository->executeInSession(params.connectId, "", "SET TRANSACTION ISOLATION LEVEL REPEATABLE READ", sessionKey);
+	userDbRepository->executeInSession(params.connectId, "", "START TRANSACTION WITH CONSISTENT SNAPSHOT", sessionKey);
+}
+
+/**
+ * End the snapshot, restore the variables and return the session to the pool, the session is closed instead if it fails.
+ */
+void QSqlExporter::closeSession()
+{
+	if (!sessionKey) {
+		return;
+	}
+	bool isRestored = false;
+	try {
+		userDbRepository->executeInSession(params.connectId, "", "COMMIT", sessionKey);
+		userDbRepository->executeInSession(params.connectId, "", "SET NAMES utf8", sessionKey);
+		userDbRepository->executeInSession(params.connectId, "", "SET SESSION TIME_ZONE=DEFAULT, SQL_MODE=DEFAULT", sessionKey);
+		isRestored = true;
+	} catch (QRuntimeException & ex) {
+		Q_ERROR("Fail to restore the export session, code:{}, error:{}", ex.getCode(), ex.getMsg());
+	}
+	userDbRepository->releaseSession(params.connectId, sessionKey, !isRestored);
+	sessionKey = 0;
+}
+
+/**
+ * Load the tables of the databases and their estimates from information_schema.TABLES, 
+ * the tables are weighted by DATA_LENGTH in the progress.
+ * 
+ * @param schemaTables - [out] database => the exported tables
+ */
+void QSqlExporter::initProgress(std::unordered_map<std::string, std::vector<std::string>> & schemaTables)
+{
+	auto metadataService = MetadataService::getInstance();
+	uint32_t totalTables = 0;
+	for (auto & schema : params.schemas) {
+		auto & tables = schemaTables[schema];
+		auto detailTables = metadataService->getDetailUserTables(params.connectId, schema);
+		if (isAllObjects()) {
+			for (auto & item : detailTables) {
+				tables.push_back(item.name);
+			}
+		} else {
+			tables = params.tables;
+		}
+		for (auto & item : detailTables) {
+			uint64_t weight = params.structOnly ? 1 : item.dataLength + 1;
+			tableEstimates[schema + "." + item.name] = { weight, item.rows };
+		}
+		for (auto & tblName : tables) {
+			auto iter = tableEstimates.find(schema + "." + tblName);
+			totalWeight += iter == tableEstimates.end() ? 1 : iter->second.first;
+		}
+		totalTables += static_cast<uint32_t>(tables.size());
+	}
+	std::lock_guard<std::mutex> lk(progressMutex);
+	progress = SqlExportProgress();
+	progress.totalTables = totalTables;
+}
+
+/**
+ * All objects of the databases are exported, otherwise only params.tables and their triggers.
+ * 
+ * @return 
+ */
+bool QSqlExporter::isAllObjects() const
+{
+	return params.tables.empty() || params.schemas.size() > 1;
+}
+
+/**
+ * The table DDL of SHOW CREATE TABLE and the values of the rows escape the strings by the backslash, 
+ * so the script runs without NO_BACKSLASH_ESCAPES. The checks are disabled like mysqldump and restored at the end.
+ */
+void QSqlExporter::writeHeader()
+{
+	append("-- CuteMySQL SQL Export\n");
+	append("-- Database: " + StringUtil::implode(params.schemas, ", ") + "\n");
+	append("-- Date: " + DateUtil::getCurrentDateTime() + "\n\n");
+	append("SET NAMES utf8mb4;\n");
+	append("SET @OLD_TIME_ZONE=@@TIME_ZONE, TIME_ZONE='+00:00';\n");
+	append("SET @OLD_FOREIGN_KEY_CHECKS=@@FOREIGN_KEY_CHECKS, FOREIGN_KEY_CHECKS=0;\n");
+	append("SET @OLD_UNIQUE_CHECKS=@@UNIQUE_CHECKS, UNIQUE_CHECKS=0;\n");
+	append("SET @OLD_SQL_MODE=@@SQL_MODE, SQL_MODE='NO_AUTO_VALUE_ON_ZERO';\n");
+}
+
+void QSqlExporter::writeFooter()
+{
+	append("\nSET SQL_MODE=@OLD_SQL_MODE;\n");
+	append("SET UNIQUE_CHECKS=@OLD_UNIQUE_CHECKS;\n");
+	append("SET FOREIGN_KEY_CHECKS=@OLD_FOREIGN_KEY_CHECKS;\n");
+	append("SET TIME_ZONE=@OLD_TIME_ZONE;\n\n");
+	append("-- Export completed: " + DateUtil::getCurrentDateTime() + "\n");
+}
+
+/**
+ * The tables first, then the views, the routines, the triggers and the events, such as mysqldump.
+ * 
+ * @param schema
+ * @param tables
+ */
+void QSqlExporter::exportSchema(const std::string & schema, const std::vector<std::string> & tables)
+{
+	checkCanceled();
+	append("\n--\n-- Database: `" + schema + "`\n--\n\n");
+	if (params.createDatabase) {
+		std::string ddl = userDbRepository->getObjectDDL(params.connectId, schema, schema, "DATABASE");
+		ddl = StringUtil::replace(ddl, "CREATE DATABASE `", "CREATE DATABASE IF NOT EXISTS `");
+		append(ddl + ";\n");
+		append("USE `" + schema + "`;\n");
+	}
+	for (auto & tblName : tables) {
+		exportTable(schema, tblName);
+	}
+
+	auto metadataService = MetadataService::getInstance();
+	std::vector<std::string> names;
+	if (isAllObjects()) {
+		exportViews(schema);
+		for (auto & item : metadataService->getUserProcedures(params.connectId, schema)) {
+			names.push_back(item.name);
+		}
+		exportObjects(schema, "PROCEDURE", names);
+		names.clear();
+		for (auto & item : metadataService->getUserFunctions(params.connectId, schema)) {
+			names.push_back(item.name);
+		}
+		exportObjects(schema, "FUNCTION", names);
+		names.clear();
+	}
+
+	std::unordered_set<std::string> tableSet(tables.begin(), tables.end());
+	for (auto & item : metadataService->getUserTriggers(params.connectId, schema)) {
+		if (isAllObjects() || tableSet.count(item.actionTable)) {
+			names.push_back(item.name);
+		}
+	}
+	exportObjects(schema, "TRIGGER", names);
+	names.clear();
+
+	if (isAllObjects()) {
+		for (auto & item : metadataService->getUserEvents(params.connectId, schema)) {
+			names.push_back(item.name);
+		}
+		exportObjects(schema, "EVENT", names);
+	}
+}
+
+void QSqlExporter::exportTable(const std::string & schema, const std::string & tblName)
+{
+	checkCanceled();
+	beginTable(schema, tblName);
+	std::string ddl = userDbRepository->getObjectDDL(params.connectId, schema, tblName, "TABLE");
+	append("\n--\n-- Table structure for `" + tblName + "`\n--\n\n");
+	append("DROP TABLE IF EXISTS `" + tblName + "`;\n");
+	append(ddl + ";\n");
+	if (!params.structOnly) {
+		exportTableRows(schema, tblName);
+	}
+	endTable(schema, tblName);
+}
+
+/**
+ * Write the rows as multi-row INSERT statements, a statement is closed before it exceeds maxInsertBytes.
+ * 
+ * @param schema
+ * @param tblName
+ */
+void QSqlExporter::exportTableRows(const std::string & schema, const std::string & tblName)
+{
+	Columns columns = userDbRepository->getInsertableColumns(params.connectId, schema, tblName);
+	if (columns.empty()) {
+		return;
+	}
+	std::string columnList;
+	for (auto & column : columns) {
+		if (!columnList.empty()) {
+			columnList.append(",");
+		}
+		columnList.append("`").append(column).append("`");
+	}
+	std::string insertHead = "INSERT INTO `" + tblName + "` (" + columnList + ") VALUES ";
+	std::string selectSql = "SELECT " + columnList + " FROM `" + schema + "`.`" + tblName + "`";
+
+	append("\n--\n-- Dumping data for table `" + tblName + "`\n--\n\n");
+	size_t statementBytes = 0; // the bytes of the open INSERT statement, 0 - no open statement
+	userDbRepository->readRowTuples(params.connectId, schema, selectSql, sessionKey, 
+		[this, &insertHead, &statementBytes](const std::string & tuple, const std::string & keyTuple) {
+		if (canceled) {
+			return false;
+		}
+		// the tuple, the comma and the ";\n" of the end
+		if (statementBytes && statementBytes + tuple.size() + 3 > maxInsertBytes) {
+			append(";\n");
+			statementBytes = 0;
+		}
+		if (!statementBytes) {
+			append(insertHead);
+			statementBytes = insertHead.size();
+		} else {
+			append(",");
+			statementBytes++;
+		}
+		append(tuple);
+		statementBytes += tuple.size();
+		tableRows++;
+		exportedRows++;
+		reportProgress(false);
+		return true;
+	});
+	checkCanceled();
+	if (statementBytes) {
+		append(";\n");
+	}
+}
+
+/**
+ * A view is written after the views that it references, the references are found by the quoted names in the DDL.
+ * 
+ * @param schema
+ */
+void QSqlExporter::exportViews(const std::string & schema)
+{
+	auto views = MetadataService::getInstance()->getUserViews(params.connectId, schema);
+	if (views.empty()) {
+		return;
+	}
+	std::vector<std::string> pendingViews;
+	std::unordered_map<std::string, std::string> ddls;
+	for (auto & item : views) {
+		checkCanceled();
+		pendingViews.push_back(item.name);
+		ddls[item.name] = userDbRepository->getObjectDDL(params.connectId, schema, item.name, "VIEW");
+	}
+
+	std::vector<std::string> orderedViews;
+	while (!pendingViews.empty()) {
+		std::vector<std::string> restViews;
+		for (auto & viewName : pendingViews) {
+			bool isReady = true;
+			for (auto & otherName : pendingViews) {
+				if (otherName != viewName && StringUtil::search(ddls[viewName], "`" + otherName + "`")) {
+					isReady = false;
+					break;
+				}
+			}
+			(isReady ? orderedViews : restViews).push_back(viewName);
+		}
+		if (restViews.size() == pendingViews.size()) {
+			// the circular references, such as the name in a string, keep the order
+			orderedViews.insert(orderedViews.end(), restViews.begin(), restViews.end());
+			break;
+		}
+		pendingViews.swap(restViews);
+	}
+
+	for (auto & viewName : orderedViews) {
+		append("\n--\n-- View structure for `" + viewName + "`\n--\n\n");
+		append("DROP VIEW IF EXISTS `" + viewName + "`;\n");
+		append(ddls[viewName] + ";\n");
+	}
+}
+
+/**
+ * Write the routines, triggers or events with the sql_mode of their creation, the bodies have ';', 
+ * so they are delimited by ";;".
+ * 
+ * @param schema
+ * @param objectType - "PROCEDURE", "FUNCTION", "TRIGGER", "EVENT"
+ * @param names
+ */
+void QSqlExporter::exportObjects(const std::string & schema, const std::string & objectType, const std::vector<std::string> & names)
+{
+	if (names.empty()) {
+		return;
+	}
+	append("\n--\n-- " + StringUtil::tolower(objectType) + "s\n--\n\n");
+	append("DELIMITER ;;\n");
+	std::string sqlMode;
+	for (auto & name : names) {
+		checkCanceled();
+		std::string ddl = userDbRepository->getObjectDDLAndSqlMode(params.connectId, schema, name, objectType, sqlMode);
+		append("SET SESSION SQL_MODE='" + sqlMode + "';;\n");
+		append("DROP " + objectType + " IF EXISTS `" + name + "`;;\n");
+		append(ddl + ";;\n");
+	}
+	append("DELIMITER ;\n");
+	append("SET SESSION SQL_MODE='NO_AUTO_VALUE_ON_ZERO';\n");
+}
+
+void QSqlExporter::append(const std::string & sql)
+{
+	buffer.append(sql);
+	sqlBytes += sql.size();
+	flushBuffer(false);
+}
+
+/**
+ * Hand the buffer to the writer when it is full, the writer compresses it in its own thread.
+ * 
+ * @param force - hand the rest of the buffer
+ */
+void QSqlExporter::flushBuffer(bool force)
+{
+	if (buffer.empty() || (!force && buffer.size() < BLOCK_BYTES)) {
+		return;
+	}
+	writer->write(std::move(buffer));
+	buffer.clear();
+	buffer.reserve(BLOCK_BYTES + MIN_INSERT_BYTES);
+}
+
+void QSqlExporter::beginTable(const std::string & schema, const std::string & tblName)
+{
+	auto iter = tableEstimates.find(schema + "." + tblName);
+	tableWeight = iter == tableEstimates.end() ? 1 : iter->second.first;
+	tableEstimatedRows = iter == tableEstimates.end() ? 0 : iter->second.second;
+	tableRows = 0;
+	currentSchema = schema;
+	currentTable = tblName;
+	reportProgress(false);
+}
+
+void QSqlExporter::endTable(const std::string & schema, const std::string & tblName)
+{
+	doneWeight += tableWeight;
+	tableWeight = 0;
+	doneTables++;
+	reportProgress(false);
+}
+
+/**
+ * The done fraction is the weights of the exported tables and the rows of the exporting table to TABLE_ROWS
+ * (at most 99% until the table is done, since TABLE_ROWS of InnoDB is an estimate), the ETA is the elapsed time 
+ * scaled by the remaining fraction.
+ * 
+ * @param force - report at once, otherwise at most once every REPORT_INTERVAL_MS
+ */
+void QSqlExporter::reportProgress(bool force)
+{
+	if (!progressCallback && !force) {
+		return;
+	}
+	auto now = std::chrono::steady_clock::now();
+	if (!force && now - lastReportAt < std::chrono::milliseconds(REPORT_INTERVAL_MS)) {
+		return;
+	}
+	lastReportAt = now;
+
+	double tableFraction = tableEstimatedRows ? (std::min)(tableRows * 1.0 / tableEstimatedRows, 0.99) : 0;
+	double doneFraction = totalWeight ? (doneWeight + tableWeight * tableFraction) / totalWeight : 1.0;
+	SqlExportProgress snapshot;
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress.schema = currentSchema;
+		progress.table = currentTable;
+		progress.doneTables = doneTables;
+		progress.exportedRows = exportedRows;
+		progress.sqlBytes = sqlBytes;
+		progress.fileBytes = writer ? writer->getFileBytes() : 0;
+		progress.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - beginAt).count();
+		progress.rowsPerSecond = progress.elapsedMs ? exportedRows * 1000.0 / progress.elapsedMs : 0;
+		progress.bytesPerSecond = progress.elapsedMs ? sqlBytes * 1000.0 / progress.elapsedMs : 0;
+		if (progress.percent < 100) {
+			progress.percent = (std::min)(static_cast<int>(100 * doneFraction), 99);
+			progress.etaSeconds = doneFraction > 0 ? static_cast<int64_t>(progress.elapsedMs * (1.0 - doneFraction) / doneFraction / 1000.0) : -1;
+		} else {
+			progress.etaSeconds = 0;
+		}
+		snapshot = progress;
+	}
+	if (progressCallback) {
+		progressCallback(snapshot);
+	}
+}
+
+void QSqlExporter::checkCanceled() const
+{
+	if (canceled) {
+		throw QRuntimeException("200032");
+	}
+}
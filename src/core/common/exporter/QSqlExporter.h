@@ -0,0 +1,109 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QSqlExporter.h
+ * @brief  QSqlExporter - Export the databases as a sql script in process, without mysqldump.exe.
+ *         The DDL of the objects and the rows as multi-row INSERT statements (sized to max_allowed_packet) are
+ *         written to QCompressWriter by blocks, the writer compresses the blocks in its own thread, so the export
+ *         is bounded by reading the rows rather than by the disk. The rows are read in one consistent snapshot.
+ *         The script can be imported by QSqlImporter or mysql client.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-05
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/entity/Entity.h"
+#include "core/repository/db/UserDbRepository.h"
+#include "core/common/exporter/QCompressWriter.h"
+
+// The progress of the export, it is called in the exporting thread
+typedef std::function<void (const SqlExportProgress & progress)> SqlExportProgressCallback;
+
+class QSqlExporter {
+public:
+	QSqlExporter(const SqlExportParams & params);
+	~QSqlExporter();
+
+	// run in the calling thread, throw QRuntimeException if failed, the incomplete file is removed
+	void run();
+	// stop the export at the next row, run() throws QRuntimeException("200032")
+	void cancel();
+	// call it before run(), the progress is reported at most once every REPORT_INTERVAL_MS
+	void setProgressCallback(SqlExportProgressCallback callback);
+	bool isCanceled() const;
+	SqlExportProgress getProgress();
+private:
+	// the sql text is handed to the writer by the blocks of BLOCK_BYTES
+	static const size_t BLOCK_BYTES = 1024 * 1024;
+	// an INSERT statement is at most max_allowed_packet - PACKET_RESERVE_BYTES, between MIN_INSERT_BYTES and MAX_INSERT_BYTES
+	static const size_t PACKET_RESERVE_BYTES = 1024;
+	static const size_t MIN_INSERT_BYTES = 64 * 1024;
+	static const size_t MAX_INSERT_BYTES = 16 * 1024 * 1024;
+	// the min interval of the progress reports
+	static const uint32_t REPORT_INTERVAL_MS = 250;
+	// the session keys of the exporter, greater than the session keys of QSqlImporter
+	static std::atomic<uint64_t> nextSessionKey;
+
+	SqlExportParams params;
+	std::atomic<bool> canceled{ false };
+	uint64_t sessionKey = 0;
+	size_t maxInsertBytes = MIN_INSERT_BYTES;
+	std::string buffer; // the sql text that is not handed to the writer
+	std::unique_ptr<QCompressWriter> writer;
+	UserDbRepository * userDbRepository = UserDbRepository::getInstance();
+
+	// progress, guarded by progressMutex
+	std::mutex progressMutex;
+	SqlExportProgress progress;
+	// the counters of the exporting thread, they are copied to the progress when it is reported
+	std::unordered_map<std::string, std::pair<uint64_t, uint64_t>> tableEstimates; // "schema.table" => (DATA_LENGTH + 1, TABLE_ROWS)
+	uint64_t totalWeight = 0;
+	uint64_t doneWeight = 0; // the weights of the exported tables
+	uint64_t tableWeight = 0; // the weight of the exporting table
+	uint64_t tableEstimatedRows = 0;
+	uint64_t tableRows = 0; // the exported rows of the exporting table
+	uint32_t doneTables = 0;
+	uint64_t exportedRows = 0;
+	uint64_t sqlBytes = 0;
+	std::string currentSchema;
+	std::string currentTable;
+	std::chrono::steady_clock::time_point beginAt;
+	std::chrono::steady_clock::time_point lastReportAt;
+	SqlExportProgressCallback progressCallback;
+
+	void openSession();
+	void closeSession();
+	void initProgress(std::unordered_map<std::string, std::vector<std::string>> & schemaTables);
+	bool isAllObjects() const;
+	void writeHeader();
+	void writeFooter();
+	void exportSchema(const std::string & schema, const std::vector<std::string> & tables);
+	void exportTable(const std::string & schema, const std::string & tblName);
+	void exportTableRows(const std::string & schema, const std::string & tblName);
+	void exportViews(const std::string & schema);
+	void exportObjects(const std::string & schema, const std::string & objectType, const std::vector<std::string> & names);
+	void append(const std::string & sql);
+	void flushBuffer(bool force);
+	void beginTable(const std::string & schema, const std::string & tblName);
+	void endTable(const std::string & schema, const std::string & tblName);
+	void reportProgress(bool force);
+	void checkCanceled() const;
+};
@@ -0,0 +1,842 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QTableExporter.cpp
+ * @brief  QTableExporter - Export one table by the ranges of the primary key in parallel.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-07
+ *********************************************************************/
+#include "QTableExporter.h"
+#include <cassert>
+#include <algorithm>
+#include <thread>
+#include <wx/file.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include "utils/Log.h"
+#include "utils/DateUtil.h"
+#include "utils/StringUtil.h"
+#include "utils/SqlUtil.h"
+#include "core/common/repository/QConnect.h"
+#include "core/common/exception/QRuntimeException.h"
+#include "core/service/db/MetadataService.h"
+
+std::atomic<uint64_t> QTableExporter::nextSessionKey{ 0x400000000000ULL };
+
+QTableExporter::QTableExporter(const TableExportParams & params) : params(params), csv(params.csvParams)
+{
+	if (csv.csvFieldTerminatedBy.empty()) {
+		csv.csvFieldTerminatedBy = ",";
+	}
+	if (csv.csvLineTerminatedBy.empty()) {
+		csv.csvLineTerminatedBy = "\n";
+	}
+}
+
+QTableExporter::~QTableExporter()
+{
+}
+
+/**
+ * Split the table into the ranges of the primary key and export them by the workers, 
+ * the files are removed if the export fails or is canceled.
+ */
+void QTableExporter::run()
+{
+	assert(params.connectId > 0 && !params.schema.empty() && !params.tblName.empty() && !params.filePath.empty());
+	Q_INFO("Export table start, connectId:{}, table:{}.{}, format:{}, file:{}", params.connectId, params.schema, params.tblName,
+		params.format == TABLE_EXPORT_CSV ? "csv" : "sql", params.filePath);
+	beginAt = std::chrono::steady_clock::now();
+	lastReportAt = beginAt;
+
+	// the columns and the rows estimate are read from the server, not from the cache
+	MetadataService::getInstance()->invalidateTableCache(params.connectId, params.schema, params.tblName);
+	initColumns();
+	uint64_t estimatedRows = 0;
+	for (auto & item : MetadataService::getInstance()->getDetailUserTables(params.connectId, params.schema)) {
+		if (item.name == params.tblName) {
+			estimatedRows = item.rows;
+			break;
+		}
+	}
+	// the table without the primary key is read by one session
+	uint32_t workerCount = keyColumns.empty() ? 1 : getWorkerCount();
+	uint64_t rangeCount = keyColumns.empty() ? 1 : (params.ranges ? params.ranges : workerCount * RANGES_PER_THREAD);
+	rangeCount = (std::min)(rangeCount, (std::max)(estimatedRows / MIN_RANGE_ROWS, uint64_t(1)));
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress = TableExportProgress();
+		progress.estimatedRows = estimatedRows;
+	}
+
+	try {
+		openSessions(workerCount);
+		splitRanges(static_cast<uint32_t>(rangeCount), estimatedRows);
+		{
+			std::lock_guard<std::mutex> lk(progressMutex);
+			progress.totalRanges = static_cast<uint32_t>(ranges.size());
+		}
+		Q_INFO("Export table, ranges:{}, workers:{}", ranges.size(), (std::min)(static_cast<size_t>(workerCount), ranges.size()));
+		exportRanges(static_cast<uint32_t>((std::min)(static_cast<size_t>(workerCount), ranges.size())));
+		writeManifest();
+	} catch (QRuntimeException & ex) {
+		closeSessions();
+		removeFiles();
+		Q_ERROR("Export table failed, code:{}, error:{}", ex.getCode(), ex.getMsg());
+		throw;
+	}
+	closeSessions();
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress.percent = 100;
+	}
+	reportProgress(true);
+	Q_INFO("Export table success, table:{}.{}, ranges:{}, rows:{}, bytes:{}", params.schema, params.tblName, 
+		ranges.size(), exportedRows.load(), fileBytes.load());
+}
+
+void QTableExporter::cancel()
+{
+	canceled = true;
+}
+
+void QTableExporter::setProgressCallback(TableExportProgressCallback callback)
+{
+	progressCallback = callback;
+}
+
+bool QTableExporter::isCanceled() const
+{
+	return canceled;
+}
+
+TableExportProgress QTableExporter::getProgress()
+{
+	std::lock_guard<std::mutex> lk(progressMutex);
+	return progress;
+}
+
+std::string QTableExporter::getPartPath(const std::string & filePath, size_t index)
+{
+	char suffix[16] = { 0 };
+	snprintf(suffix, sizeof(suffix), ".part%04zu", index + 1);
+	return filePath + suffix;
+}
+
+std::string QTableExporter::getManifestPath(const std::string & filePath)
+{
+	return filePath + ".manifest.json";
+}
+
+/**
+ * CSV has all columns of the table, the INSERT statements have the columns that can be inserted (not generated).
+ */
+void QTableExporter::initColumns()
+{
+	if (params.format == TABLE_EXPORT_SQL) {
+		columns = userDbRepository->getInsertableColumns(params.connectId, params.schema, params.tblName);
+	} else {
+		for (auto & column : MetadataService::getInstance()->getColumnsOfUserTable(params.connectId, params.schema, params.tblName)) {
+			// the metadata names are converted to the UI charset
+			columns.push_back(StringUtil::converToUtf8(column.name));
+		}
+	}
+	if (columns.empty()) {
+		throw QRuntimeException("200027");
+	}
+	keyColumns = userDbRepository->getPrimaryKeyColumns(params.connectId, params.schema, params.tblName);
+	for (auto & column : columns) {
+		columnList.append(columnList.empty() ? "`" : ",`").append(column).append("`");
+	}
+	for (auto & column : keyColumns) {
+		keyList.append(keyList.empty() ? "`" : ",`").append(column).append("`");
+	}
+}
+
+/**
+ * The workers and the coordinator use the sessions of QUERY_LANE, RESERVED_SESSIONS are kept for the user.
+ * 
+ * @return 
+ */
+uint32_t QTableExporter::getWorkerCount() const
+{
+	uint32_t maxSize = QConnect::userConnectPool.getLaneOptions(QUERY_LANE).maxSize;
+	uint32_t freeSessions = maxSize > RESERVED_SESSIONS + 1 ? maxSize - RESERVED_SESSIONS - 1 : 1;
+	return (std::max)((std::min)(params.threads, freeSessions), uint32_t(1));
+}
+
+/**
+ * The coordinator locks the table, every worker starts START TRANSACTION WITH CONSISTENT SNAPSHOT in its session,
+ * then the coordinator unlocks the table, so the snapshots of all workers are taken at the same point.
+ * The values are read without NO_BACKSLASH_ESCAPES, so the key tuples of the ranges are parsed as they are read,
+ * and with TIME_ZONE '+00:00' for the INSERT statements, so the TIMESTAMP values are not converted.
+ * 
+ * @param workerCount
+ */
+void QTableExporter::openSessions(uint32_t workerCount)
+{
+	coordinatorKey = nextSessionKey++;
+	for (uint32_t i = 0; i < workerCount; i++) {
+		sessionKeys.push_back(nextSessionKey++);
+	}
+	std::string sessionSql = params.format == TABLE_EXPORT_SQL ? "SET SESSION TIME_ZONE='+00:00', " : "SET SESSION ";
+	sessionSql.append(SqlUtil::makeSqlModeWithBackslashEscapes());
+	for (auto sessionKey : sessionKeys) {
+		userDbRepository->executeInSession(params.connectId, "", "SET NAMES utf8mb4", sessionKey);
+		userDbRepository->executeInSession(params.connectId, "", sessionSql, sessionKey);
+	}
+
+	userDbRepository->executeInSession(params.connectId, "", "LOCK TABLES `" + params.schema + "`.`" + params.tblName + "` READ", coordinatorKey);
+	isTableLocked = true;
+	for (auto sessionKey : sessionKeys) {
+		// only for the next transaction, the isolation level of the session is not changed
+		userDbRepository->executeInSession(params.connectId, "", "SET TRANSACTION ISOLATION LEVEL REPEATABLE READ", sessionKey);
+		userDbRepository->executeInSession(params.connectId, "", "START TRANSACTION WITH CONSISTENT SNAPSHOT", sessionKey);
+	}
+	userDbRepository->executeInSession(params.connectId, "", "UNLOCK TABLES", coordinatorKey);
+	isTableLocked = false;
+}
+
+/**
+ * Release the table lock, restore the variables of the sessions and return them to the pool.
+ */
+void QTableExporter::closeSessions()
+{
+	bool isUnlocked = true;
+	if (isTableLocked) {
+		try {
+			userDbRepository->executeInSession(params.connectId, "", "UNLOCK TABLES", coordinatorKey);
+		} catch (QRuntimeException & ex) {
+			Q_ERROR("Fail to unlock the table, code:{}, error:{}", ex.getCode(), ex.getMsg());
+			isUnlocked = false;
+		}
+		isTableLocked = false;
+	}
+	if (coordinatorKey) {
+		// the lock is held until the session is closed
+		userDbRepository->releaseSession(params.connectId, coordinatorKey, !isUnlocked);
+		coordinatorKey = 0;
+	}
+	for (auto sessionKey : sessionKeys) {
+		closeSession(sessionKey);
+	}
+	sessionKeys.clear();
+}
+
+/**
+ * End the snapshot, restore the variables and return the session to the pool, the session is closed instead if it fails.
+ * 
+ * @param sessionKey
+ */
+void QTableExporter::closeSession(uint64_t sessionKey)
+{
+	bool isRestored = false;
+	try {
+		userDbRepository->executeInSession(params.connectId, "", "COMMIT", sessionKey);
+		userDbRepository->executeInSession(params.connectId, "", "SET NAMES utf8", sessionKey);
+		userDbRepository->executeInSession(params.connectId, "", "SET SESSION TIME_ZONE=DEFAULT, SQL_MODE=DEFAULT", sessionKey);
+		isRestored = true;
+	} catch (QRuntimeException & ex) {
+		Q_ERROR("Fail to restore the export session, code:{}, error:{}", ex.getCode(), ex.getMsg());
+	}
+	userDbRepository->releaseSession(params.connectId, sessionKey, !isRestored);
+}
+
+/**
+ * Split the table into rangeCount ranges of the primary key, the table without the primary key is one range.
+ * 
+ * @param rangeCount
+ * @param estimatedRows - TABLE_ROWS of the table
+ */
+void QTableExporter::splitRanges(uint32_t rangeCount, uint64_t estimatedRows)
+{
+	ranges.clear();
+	if (keyColumns.empty() || rangeCount <= 1) {
+		ranges.emplace_back();
+		return;
+	}
+	if (!splitIntegerKeyRanges(rangeCount)) {
+		splitKeyRanges(rangeCount, estimatedRows);
+	}
+}
+
+/**
+ * The primary key of one integer column is split evenly between MIN and MAX of the snapshot, it costs two index lookups.
+ * 
+ * @param rangeCount
+ * @return false if the primary key is not one integer column
+ */
+bool QTableExporter::splitIntegerKeyRanges(uint32_t rangeCount)
+{
+	if (keyColumns.size() != 1) {
+		return false;
+	}
+	bool isInteger = false, isUnsigned = false;
+	for (auto & column : MetadataService::getInstance()->getColumnsOfUserTable(params.connectId, params.schema, params.tblName)) {
+		if (StringUtil::converToUtf8(column.name) != keyColumns.front()) {
+			continue;
+		}
+		std::string type = StringUtil::toupper(column.type);
+		isInteger = type == "TINYINT" || type == "SMALLINT" || type == "MEDIUMINT" || type == "INT" 
+			|| type == "INTEGER" || type == "BIGINT";
+		isUnsigned = column.un;
+		break;
+	}
+	if (!isInteger) {
+		return false;
+	}
+
+	std::string minMaxTuple; // "(1,100)", "(NULL,NULL)" if the table is empty
+	userDbRepository->readRowTuples(params.connectId, "", "SELECT MIN(" + keyList + "),MAX(" + keyList + ") FROM `" 
+		+ params.schema + "`.`" + params.tblName + "`", sessionKeys.front(), [&minMaxTuple](const std::string & tuple, const std::string &) {
+		minMaxTuple = tuple;
+		return false;
+	});
+	auto values = StringUtil::split(minMaxTuple.size() > 2 ? minMaxTuple.substr(1, minMaxTuple.size() - 2) : "", ",");
+	if (values.size() != 2 || values.at(0) == "NULL") {
+		ranges.emplace_back();
+		return true;
+	}
+
+	// the signed values are mapped to the unsigned values of the same order
+	const uint64_t SIGN_BIT = 0x8000000000000000ULL;
+	uint64_t lower = isUnsigned ? std::stoull(values.at(0)) : static_cast<uint64_t>(std::stoll(values.at(0))) ^ SIGN_BIT;
+	uint64_t upper = isUnsigned ? std::stoull(values.at(1)) : static_cast<uint64_t>(std::stoll(values.at(1))) ^ SIGN_BIT;
+	uint64_t step = (upper - lower) / rangeCount + 1;
+	std::vector<std::string> upperKeys;
+	for (uint32_t i = 1; i < rangeCount && i <= (upper - lower) / step; i++) {
+		uint64_t bound = lower + step * i - 1;
+		upperKeys.push_back("(" + (isUnsigned ? std::to_string(bound) : std::to_string(static_cast<int64_t>(bound ^ SIGN_BIT))) + ")");
+	}
+	addRanges(upperKeys);
+	return true;
+}
+
+/**
+ * The composite (or not integer) primary key is split by walking the key in the order of the key, every bound is
+ * the key of the row that is (estimatedRows / rangeCount) rows after the last bound. The walk reads the keys 
+ * of the whole table by one session before the ranges are read in parallel.
+ * 
+ * @param rangeCount
+ * @param estimatedRows
+ */
+void QTableExporter::splitKeyRanges(uint32_t rangeCount, uint64_t estimatedRows)
+{
+	uint64_t rangeRows = (std::max)(estimatedRows / rangeCount, static_cast<uint64_t>(MIN_RANGE_ROWS));
+	std::string fromTable = "`" + params.schema + "`.`" + params.tblName + "`";
+	std::vector<std::string> upperKeys;
+	while (upperKeys.size() + 1 < rangeCount) {
+		checkCanceled();
+		std::string boundarySql = "SELECT " + keyList + " FROM " + fromTable;
+		if (!upperKeys.empty()) {
+			boundarySql.append(" WHERE (").append(keyList).append(") > ").append(upperKeys.back());
+		}
+		boundarySql.append(" ORDER BY ").append(keyList).append(" LIMIT 1 OFFSET ").append(std::to_string(rangeRows - 1));
+		// empty if the rest rows are less than a range
+		std::string upperKey;
+		userDbRepository->readRowTuples(params.connectId, "", boundarySql, sessionKeys.front(), [&upperKey](const std::string & tuple, const std::string &) {
+			upperKey = tuple;
+			return false;
+		});
+		if (upperKey.empty()) {
+			break;
+		}
+		upperKeys.push_back(upperKey);
+	}
+	addRanges(upperKeys);
+}
+
+/**
+ * Add the ranges (lower, upper] of the key, the first range has no lower bound and the last range has no upper bound,
+ * so the rows out of the bounds are not lost.
+ * 
+ * @param upperKeys - the key tuples of the upper bounds in order, such as "(100)", "(3,'a')"
+ */
+void QTableExporter::addRanges(const std::vector<std::string> & upperKeys)
+{
+	std::string keyTuple = "(" + keyList + ")";
+	std::string lowerKey;
+	for (auto & upperKey : upperKeys) {
+		Range range;
+		range.condition = lowerKey.empty() ? "" : keyTuple + " > " + lowerKey + " AND ";
+		range.condition.append(keyTuple).append(" <= ").append(upperKey);
+		ranges.push_back(range);
+		lowerKey = upperKey;
+	}
+	Range lastRange;
+	lastRange.condition = lowerKey.empty() ? "" : keyTuple + " > " + lowerKey;
+	ranges.push_back(lastRange);
+}
+
+/**
+ * Every worker takes the next range until no range is left, the calling thread merges the finished parts in order
+ * meanwhile if mergeParts, so merging overlaps reading.
+ * 
+ * @param workerCount
+ */
+void QTableExporter::exportRanges(uint32_t workerCount)
+{
+	std::unique_ptr<QCompressWriter> mergedWriter;
+	if (params.mergeParts) {
+		mergedWriter.reset(new QCompressWriter(params.filePath, SQL_EXPORT_NONE));
+		mergedWriter->open();
+	}
+
+	std::string errorCode, errorMsg;
+	std::mutex errorMutex;
+	auto setError = [&](const QRuntimeException & ex) {
+		std::lock_guard<std::mutex> lk(errorMutex);
+		if (!failed) {
+			errorCode = ex.getCode();
+			errorMsg = ex.getMsg();
+			failed = true;
+		}
+	};
+	std::atomic<size_t> nextRange{ 0 };
+	std::vector<std::thread> workers;
+	for (uint32_t i = 0; i < workerCount; i++) {
+		workers.emplace_back([&, i]() {
+			// mysql driver must be initialized in every thread that uses it
+			QConnect::getDriver()->threadInit();
+			while (!isStopped()) {
+				size_t index = nextRange++;
+				if (index >= ranges.size()) {
+					break;
+				}
+				try {
+					exportRange(index, sessionKeys.at(i));
+				} catch (QRuntimeException & ex) {
+					setError(ex);
+				}
+			}
+			QConnect::getDriver()->threadEnd();
+		});
+	}
+
+	if (mergedWriter) {
+		try {
+			mergeParts(*mergedWriter);
+		} catch (QRuntimeException & ex) {
+			setError(ex);
+		}
+	}
+	for (auto & worker : workers) {
+		worker.join();
+	}
+	if (mergedWriter) {
+		if (isStopped()) {
+			mergedWriter->abort();
+		} else {
+			try {
+				mergedWriter->close();
+			} catch (QRuntimeException & ex) {
+				setError(ex);
+			}
+		}
+	}
+	if (failed) {
+		throw QRuntimeException(errorCode, errorMsg);
+	}
+	checkCanceled();
+}
+
+/**
+ * Read the rows of the range by the session of the worker and write them to the part file.
+ * 
+ * @param index - the index of the range
+ * @param sessionKey - the session of the worker
+ */
+void QTableExporter::exportRange(size_t index, uint64_t sessionKey)
+{
+	checkCanceled();
+	QCompressWriter writer(getPartPath(params.filePath, index), SQL_EXPORT_NONE);
+	writer.open();
+
+	std::string text;
+	text.reserve(BLOCK_BYTES + MAX_INSERT_BYTES);
+	if (!params.mergeParts) {
+		appendHead(text);
+	}
+	uint64_t rows = 0, bytes = 0;
+	auto flush = [&](bool force) {
+		if (text.empty() || (!force && text.size() < BLOCK_BYTES)) {
+			return;
+		}
+		bytes += text.size();
+		fileBytes += text.size();
+		writer.write(std::move(text));
+		text.clear();
+		text.reserve(BLOCK_BYTES + MAX_INSERT_BYTES);
+	};
+
+	const std::string & condition = ranges.at(index).condition;
+	std::string selectSql = "SELECT " + columnList + " FROM `" + params.schema + "`.`" + params.tblName + "`";
+	if (!condition.empty()) {
+		selectSql.append(" WHERE ").append(condition);
+	}
+	if (params.format == TABLE_EXPORT_CSV) {
+		userDbRepository->readRowValues(params.connectId, selectSql, sessionKey, 
+			[&](const std::vector<std::string> & values, const std::vector<bool> & nulls) {
+			if (isStopped()) {
+				return false;
+			}
+			appendCsvLine(text, values, nulls);
+			rows++;
+			exportedRows++;
+			flush(false);
+			reportProgress(false);
+			return true;
+		});
+	} else {
+		std::string insertHead = "INSERT INTO `" + params.tblName + "` (" + columnList + ") VALUES ";
+		size_t statementBytes = 0; // the bytes of the open INSERT statement, 0 - no open statement
+		userDbRepository->readRowTuples(params.connectId, "", selectSql, sessionKey, 
+			[&](const std::string & tuple, const std::string & keyTuple) {
+			if (isStopped()) {
+				return false;
+			}
+			// the tuple, the comma and the ";\n" of the end
+			if (statementBytes && statementBytes + tuple.size() + 3 > MAX_INSERT_BYTES) {
+				text.append(";\n");
+				statementBytes = 0;
+			}
+			if (!statementBytes) {
+				text.append(insertHead);
+				statementBytes = insertHead.size();
+			} else {
+				text.push_back(',');
+				statementBytes++;
+			}
+			text.append(tuple);
+			statementBytes += tuple.size();
+			rows++;
+			exportedRows++;
+			flush(false);
+			reportProgress(false);
+			return true;
+		});
+		if (statementBytes) {
+			text.append(";\n");
+		}
+	}
+	if (isStopped()) {
+		writer.abort();
+		checkCanceled();
+		return;
+	}
+	if (!params.mergeParts) {
+		appendFoot(text);
+	}
+	flush(true);
+	writer.close();
+
+	{
+		std::lock_guard<std::mutex> lk(rangeMutex);
+		ranges.at(index).rows = rows;
+		ranges.at(index).bytes = bytes;
+		ranges.at(index).done = true;
+	}
+	rangeDone.notify_all();
+	doneRanges++;
+	reportProgress(false);
+}
+
+/**
+ * Append the part files to the merged file in the order of the ranges, a part is appended as soon as it and 
+ * the parts before it are done, then it is removed.
+ * 
+ * @param writer - the writer of the merged file
+ */
+void QTableExporter::mergeParts(QCompressWriter & writer)
+{
+	std::string text;
+	appendHead(text);
+	uint64_t offset = text.size();
+	if (!text.empty()) {
+		writer.write(std::move(text));
+	}
+	for (size_t i = 0; i < ranges.size(); i++) {
+		{
+			std::unique_lock<std::mutex> lk(rangeMutex);
+			while (!ranges.at(i).done && !isStopped()) {
+				// wake up in time to see cancel() that does not notify
+				rangeDone.wait_for(lk, std::chrono::milliseconds(100));
+			}
+			if (!ranges.at(i).done) {
+				return;
+			}
+			ranges.at(i).offset = offset;
+		}
+
+		wxString partPath = wxString::FromUTF8(getPartPath(params.filePath, i));
+		wxFile partFile;
+		if (!partFile.Open(partPath, wxFile::read)) {
+			Q_ERROR("Fail to open the part file:{}", getPartPath(params.filePath, i));
+			throw QRuntimeException("200031");
+		}
+		while (!isStopped()) {
+			std::string block(BLOCK_BYTES, '\0');
+			ssize_t bytes = partFile.Read(&block[0], BLOCK_BYTES);
+			if (bytes == wxInvalidOffset) {
+				Q_ERROR("Fail to read the part file:{}", getPartPath(params.filePath, i));
+				throw QRuntimeException("200031");
+			}
+			if (bytes == 0) {
+				break;
+			}
+			block.resize(static_cast<size_t>(bytes));
+			offset += block.size();
+			writer.write(std::move(block));
+		}
+		partFile.Close();
+		wxRemoveFile(partPath);
+	}
+	text.clear();
+	appendFoot(text);
+	if (!text.empty()) {
+		writer.write(std::move(text));
+	}
+}
+
+/**
+ * The head of the merged file or the part file, it is the column names of CSV (if hasColumnOnTop), or the variables
+ * of the INSERT statements that are restored by appendFoot(...).
+ * 
+ * @param text
+ */
+void QTableExporter::appendHead(std::string & text)
+{
+	if (params.format == TABLE_EXPORT_CSV) {
+		if (csv.hasColumnOnTop) {
+			appendCsvLine(text, columns, std::vector<bool>(columns.size(), false));
+		}
+		return;
+	}
+	text.append("-- CuteMySQL Table Export\n");
+	text.append("-- Table: `" + params.schema + "`.`" + params.tblName + "`\n");
+	text.append("-- Date: " + DateUtil::getCurrentDateTime() + "\n\n");
+	text.append("SET NAMES utf8mb4;\n");
+	text.append("SET @OLD_TIME_ZONE=@@TIME_ZONE, TIME_ZONE='+00:00';\n");
+	text.append("SET @OLD_UNIQUE_CHECKS=@@UNIQUE_CHECKS, UNIQUE_CHECKS=0;\n");
+	text.append("SET @OLD_SQL_MODE=@@SQL_MODE, SQL_MODE='NO_AUTO_VALUE_ON_ZERO';\n\n");
+}
+
+void QTableExporter::appendFoot(std::string & text)
+{
+	if (params.format == TABLE_EXPORT_CSV) {
+		return;
+	}
+	text.append("\nSET SQL_MODE=@OLD_SQL_MODE;\n");
+	text.append("SET UNIQUE_CHECKS=@OLD_UNIQUE_CHECKS;\n");
+	text.append("SET TIME_ZONE=@OLD_TIME_ZONE;\n");
+}
+
+void QTableExporter::appendCsvLine(std::string & text, const std::vector<std::string> & values, const std::vector<bool> & nulls)
+{
+	for (size_t i = 0; i < values.size(); i++) {
+		if (i) {
+			text.append(csv.csvFieldTerminatedBy);
+		}
+		if (nulls.at(i)) {
+			// \N such as SELECT ... INTO OUTFILE, NULL if there is no escape character
+			text.append(csv.csvFieldEscapedBy.empty() ? "NULL" : csv.csvFieldEscapedBy + "N");
+		} else {
+			appendCsvValue(text, values.at(i));
+		}
+	}
+	text.append(csv.csvLineTerminatedBy);
+}
+
+/**
+ * Write the value in the CSV dialect. With the escape character, the escape character, the enclosing character and 
+ * (if not enclosed) the terminators are escaped such as SELECT ... INTO OUTFILE, without it the enclosing character
+ * is doubled such as RFC 4180.
+ * 
+ * @param text
+ * @param value
+ */
+void QTableExporter::appendCsvValue(std::string & text, const std::string & value)
+{
+	const std::string & enclosedBy = csv.csvFieldEnclosedBy;
+	const std::string & escapedBy = csv.csvFieldEscapedBy;
+	text.append(enclosedBy);
+	for (char ch : value) {
+		if (!escapedBy.empty()) {
+			if (ch == escapedBy.front() || (!enclosedBy.empty() && ch == enclosedBy.front())
+				|| (enclosedBy.empty() && (ch == csv.csvFieldTerminatedBy.front() || ch == csv.csvLineTerminatedBy.front()))) {
+				text.append(escapedBy).push_back(ch);
+				continue;
+			}
+			if (ch == '\0') {
+				text.append(escapedBy).push_back('0');
+				continue;
+			}
+		} else if (!enclosedBy.empty() && ch == enclosedBy.front()) {
+			text.push_back(ch);
+		}
+		text.push_back(ch);
+	}
+	text.append(enclosedBy);
+}
+
+/**
+ * Write <filePath>.manifest.json, it lists the ranges in order with their conditions, rows and bytes, 
+ * and the part files or the offsets in the merged file.
+ */
+void QTableExporter::writeManifest()
+{
+	auto fileName = [](const std::string & path) {
+		return std::string(wxFileName(wxString::FromUTF8(path)).GetFullName().ToUTF8().data());
+	};
+	auto jsonArray = [](const Columns & items) {
+		std::string result = "[";
+		for (size_t i = 0; i < items.size(); i++) {
+			result.append(i ? ", \"" : "\"").append(escapeJson(items.at(i))).append("\"");
+		}
+		return result + "]";
+	};
+
+	std::string json = "{\n";
+	json.append("  \"schema\": \"" + escapeJson(params.schema) + "\",\n");
+	json.append("  \"table\": \"" + escapeJson(params.tblName) + "\",\n");
+	json.append("  \"format\": \"" + std::string(params.format == TABLE_EXPORT_CSV ? "csv" : "sql") + "\",\n");
+	json.append("  \"columns\": " + jsonArray(columns) + ",\n");
+	json.append("  \"keyColumns\": " + jsonArray(keyColumns) + ",\n");
+	if (params.format == TABLE_EXPORT_CSV) {
+		json.append("  \"csv\": {\"fieldsTerminatedBy\": \"" + escapeJson(csv.csvFieldTerminatedBy) 
+			+ "\", \"fieldsEnclosedBy\": \"" + escapeJson(csv.csvFieldEnclosedBy)
+			+ "\", \"fieldsEscapedBy\": \"" + escapeJson(csv.csvFieldEscapedBy)
+			+ "\", \"linesTerminatedBy\": \"" + escapeJson(csv.csvLineTerminatedBy)
+			+ "\", \"header\": " + (csv.hasColumnOnTop ? "true" : "false") + "},\n");
+	}
+	json.append("  \"merged\": " + std::string(params.mergeParts ? "true" : "false") + ",\n");
+	if (params.mergeParts) {
+		json.append("  \"file\": \"" + escapeJson(fileName(params.filePath)) + "\",\n");
+	}
+	json.append("  \"rows\": " + std::to_string(exportedRows.load()) + ",\n");
+	json.append("  \"bytes\": " + std::to_string(fileBytes.load()) + ",\n");
+	json.append("  \"createdAt\": \"" + DateUtil::getCurrentDateTime() + "\",\n");
+	json.append("  \"parts\": [");
+	for (size_t i = 0; i < ranges.size(); i++) {
+		auto & range = ranges.at(i);
+		json.append(i ? ",\n" : "\n").append("    {\"index\": ").append(std::to_string(i + 1));
+		if (params.mergeParts) {
+			json.append(", \"offset\": ").append(std::to_string(range.offset));
+		} else {
+			json.append(", \"file\": \"").append(escapeJson(fileName(getPartPath(params.filePath, i)))).append("\"");
+		}
+		json.append(", \"where\": \"").append(escapeJson(range.condition)).append("\"");
+		json.append(", \"rows\": ").append(std::to_string(range.rows));
+		json.append(", \"bytes\": ").append(std::to_string(range.bytes)).append("}");
+	}
+	json.append("\n  ]\n}\n");
+
+	QCompressWriter writer(getManifestPath(params.filePath), SQL_EXPORT_NONE);
+	writer.open();
+	writer.write(std::move(json));
+	writer.close();
+}
+
+/**
+ * Remove the part files and the manifest of the failed export, the merged file is removed by its writer.
+ */
+void QTableExporter::removeFiles()
+{
+	for (size_t i = 0; i < ranges.size(); i++) {
+		wxString partPath = wxString::FromUTF8(getPartPath(params.filePath, i));
+		if (wxFileExists(partPath)) {
+			wxRemoveFile(partPath);
+		}
+	}
+	wxString manifestPath = wxString::FromUTF8(getManifestPath(params.filePath));
+	if (wxFileExists(manifestPath)) {
+		wxRemoveFile(manifestPath);
+	}
+}
+
+std::string QTableExporter::escapeJson(const std::string & str)
+{
+	std::string result;
+	result.reserve(str.size());
+	for (unsigned char ch : str) {
+		switch (ch) {
+		case '"': result.append("\\\""); break;
+		case '\\': result.append("\\\\"); break;
+		case '\n': result.append("\\n"); break;
+		case '\r': result.append("\\r"); break;
+		case '\t': result.append("\\t"); break;
+		default:
+			if (ch < 0x20) {
+				char buf[8] = { 0 };
+				snprintf(buf, sizeof(buf), "\\u%04x", ch);
+				result.append(buf);
+			} else {
+				result.push_back(static_cast<char>(ch));
+			}
+			break;
+		}
+	}
+	return result;
+}
+
+/**
+ * The done fraction is the exported rows to TABLE_ROWS (at most 99%, since TABLE_ROWS of InnoDB is an estimate),
+ * or the done ranges if TABLE_ROWS is 0, the ETA is the elapsed time scaled by the remaining fraction.
+ * 
+ * @param force - report at once, otherwise at most once every REPORT_INTERVAL_MS
+ */
+void QTableExporter::reportProgress(bool force)
+{
+	if (!progressCallback && !force) {
+		return;
+	}
+	TableExportProgress snapshot;
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		auto now = std::chrono::steady_clock::now();
+		if (!force && now - lastReportAt < std::chrono::milliseconds(REPORT_INTERVAL_MS)) {
+			return;
+		}
+		lastReportAt = now;
+		progress.doneRanges = doneRanges;
+		progress.exportedRows = exportedRows;
+		progress.fileBytes = fileBytes;
+		progress.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - beginAt).count();
+		progress.rowsPerSecond = progress.elapsedMs ? progress.exportedRows * 1000.0 / progress.elapsedMs : 0;
+		progress.bytesPerSecond = progress.elapsedMs ? progress.fileBytes * 1000.0 / progress.elapsedMs : 0;
+		if (progress.percent < 100) {
+			double doneFraction = progress.estimatedRows ? (std::min)(progress.exportedRows * 1.0 / progress.estimatedRows, 0.99)
+				: (progress.totalRanges ? progress.doneRanges * 1.0 / progress.totalRanges : 0);
+			progress.percent = (std::min)(static_cast<int>(100 * doneFraction), 99);
+			progress.etaSeconds = doneFraction > 0 ? static_cast<int64_t>(progress.elapsedMs * (1.0 - doneFraction) / doneFraction / 1000.0) : -1;
+		} else {
+			progress.etaSeconds = 0;
+		}
+		snapshot = progress;
+	}
+	if (progressCallback) {
+		progressCallback(snapshot);
+	}
+}
+
+void QTableExporter::checkCanceled() const
+{
+	if (canceled) {
+		throw QRuntimeException("200032");
+	}
+}
+
+bool QTableExporter::isStopped() const
+{
+	return canceled || failed;
+}
@@ -0,0 +1,130 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QTableExporter.h
+ * @brief  QTableExporter - Export one (huge) table as CSV or INSERT statements by the ranges of the primary key.
+ *         The ranges are read by several pinned sessions in parallel, the sessions start their snapshots while
+ *         the table is locked, so all ranges are read at the same point in time. Every range is written to its
+ *         own part file, the parts are merged in order into one file while the rest ranges are being read
+ *         if mergeParts. A manifest (<filePath>.manifest.json) records the ranges, the files, the rows and the bytes.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-07
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "core/entity/Entity.h"
+#include "core/repository/db/UserDbRepository.h"
+#include "core/common/exporter/QCompressWriter.h"
+
+// The progress of the table export, it is called in the exporting threads
+typedef std::function<void (const TableExportProgress & progress)> TableExportProgressCallback;
+
+class QTableExporter {
+public:
+	QTableExporter(const TableExportParams & params);
+	~QTableExporter();
+
+	// run in the calling thread, throw QRuntimeException if failed, the incomplete files are removed
+	void run();
+	// stop the export at the next row, run() throws QRuntimeException("200032")
+	void cancel();
+	// call it before run(), the progress is reported at most once every REPORT_INTERVAL_MS
+	void setProgressCallback(TableExportProgressCallback callback);
+	bool isCanceled() const;
+	TableExportProgress getProgress();
+
+	// the part file of the range, "<filePath>.part0001", index is 0-based
+	static std::string getPartPath(const std::string & filePath, size_t index);
+	static std::string getManifestPath(const std::string & filePath);
+private:
+	// A range of the primary key, it is read by one session and written to one part file
+	typedef struct _Range {
+		std::string condition; // the WHERE condition, empty - the whole table
+		uint64_t rows = 0;
+		uint64_t bytes = 0;
+		uint64_t offset = 0; // the offset in the merged file
+		bool done = false;
+	} Range;
+
+	// the text is handed to the writers by the blocks of BLOCK_BYTES
+	static const size_t BLOCK_BYTES = 1024 * 1024;
+	// the max bytes of one INSERT statement, it is less than the default max_allowed_packet (4M)
+	static const size_t MAX_INSERT_BYTES = 1024 * 1024;
+	// the sessions that are kept for the user sql statements when the workers check out the sessions of QUERY_LANE
+	static const uint32_t RESERVED_SESSIONS = 2;
+	// more ranges than sessions, so a slow (dense) range does not hold up the whole export
+	static const uint32_t RANGES_PER_THREAD = 4;
+	static const uint64_t MIN_RANGE_ROWS = 10000;
+	// the min interval of the progress reports
+	static const uint32_t REPORT_INTERVAL_MS = 250;
+	// the session keys of the table exporter, greater than the session keys of QSqlExporter
+	static std::atomic<uint64_t> nextSessionKey;
+
+	TableExportParams params;
+	ExportCsvParams csv; // params.csvParams with the default terminators
+	std::atomic<bool> canceled{ false };
+	std::atomic<bool> failed{ false }; // a worker has failed, the others stop at the next row
+	uint64_t coordinatorKey = 0; // it locks the table while the sessions of the workers start their snapshots
+	bool isTableLocked = false;
+	std::vector<uint64_t> sessionKeys; // the sessions of the workers
+	Columns columns;
+	Columns keyColumns;
+	std::string columnList;
+	std::string keyList;
+	UserDbRepository * userDbRepository = UserDbRepository::getInstance();
+
+	// ranges, the fields of a range are written by its worker before done is set, guarded by rangeMutex
+	std::vector<Range> ranges;
+	std::mutex rangeMutex;
+	std::condition_variable rangeDone;
+
+	// progress, guarded by progressMutex
+	std::mutex progressMutex;
+	TableExportProgress progress;
+	std::atomic<uint64_t> exportedRows{ 0 };
+	std::atomic<uint64_t> fileBytes{ 0 };
+	std::atomic<uint32_t> doneRanges{ 0 };
+	std::chrono::steady_clock::time_point beginAt;
+	std::chrono::steady_clock::time_point lastReportAt;
+	TableExportProgressCallback progressCallback;
+
+	void initColumns();
+	uint32_t getWorkerCount() const;
+	void openSessions(uint32_t workerCount);
+	void closeSessions();
+	void closeSession(uint64_t sessionKey);
+	void splitRanges(uint32_t rangeCount, uint64_t estimatedRows);
+	bool splitIntegerKeyRanges(uint32_t rangeCount);
+	void splitKeyRanges(uint32_t rangeCount, uint64_t estimatedRows);
+	void addRanges(const std::vector<std::string> & upperKeys);
+	void exportRanges(uint32_t workerCount);
+	void exportRange(size_t index, uint64_t sessionKey);
+	void mergeParts(QCompressWriter & writer);
+	void appendHead(std::string & text);
+	void appendFoot(std::string & text);
+	void appendCsvLine(std::string & text, const std::vector<std::string> & values, const std::vector<bool> & nulls);
+	void appendCsvValue(std::string & text, const std::string & value);
+	void writeManifest();
+	void removeFiles();
+	static std::string escapeJson(const std::string & str);
+	void reportProgress(bool force);
+	void checkCanceled() const;
+	bool isStopped() const;
+};
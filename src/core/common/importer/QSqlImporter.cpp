@@ -0,0 +1,371 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QSqlImporter.cpp
+ * @brief  QSqlImporter - Import a sql script into the database in process.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-04
+ *********************************************************************/
+#include "QSqlImporter.h"
+#include <cassert>
+#include <cctype>
+#include <algorithm>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include "utils/Log.h"
+#include "utils/StringUtil.h"
+#include "core/common/exception/QRuntimeException.h"
+#include "core/service/db/MetadataService.h"
+
+std::atomic<uint64_t> QSqlImporter::nextSessionKey{ 0x200000000000ULL };
+
+QSqlImporter::QSqlImporter(const SqlImportParams & params) : params(params)
+{
+}
+
+QSqlImporter::~QSqlImporter()
+{
+}
+
+/**
+ * Import the script, the statements before params.startOffset are skipped except SET and USE, they are replayed
+ * so the new session has the same variables and the default database as the interrupted one.
+ */
+void QSqlImporter::run()
+{
+	assert(params.connectId > 0);
+	Q_INFO("Import sql start, connectId:{}, schema:{}, file:{}, offset:{}", params.connectId, params.schema, 
+		params.filePath, params.startOffset);
+	beginAt = std::chrono::steady_clock::now();
+	lastReportAt = beginAt;
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress = SqlImportProgress();
+		progress.committedOffset = params.startOffset;
+	}
+	lastOffset = params.startOffset;
+
+	std::unique_ptr<std::istream> in;
+	uint64_t totalBytes = 0;
+	if (params.filePath.empty()) {
+		totalBytes = params.sql.size();
+		in.reset(new std::istringstream(params.sql));
+	} else {
+		// the path is utf8, wchar_t path is used for the non-ascii path on Windows
+		auto file = new std::ifstream(wxString::FromUTF8(params.filePath).wc_str(), std::ios::in | std::ios::binary);
+		in.reset(file);
+		if (!file->is_open()) {
+			Q_ERROR("Fail to open the sql file, path:{}", params.filePath);
+			throw QRuntimeException("200002", "file:" + params.filePath);
+		}
+		file->seekg(0, std::ios::end);
+		totalBytes = static_cast<uint64_t>(file->tellg());
+		file->seekg(0, std::ios::beg);
+	}
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress.totalBytes = totalBytes;
+	}
+
+	openSession();
+	try {
+		importStream(*in);
+		commitBatch(lastOffset);
+	} catch (QRuntimeException & ex) {
+		rollbackBatch();
+		closeSession();
+		// the script may change the objects of any database of the connection
+		MetadataService::getInstance()->invalidateCache(params.connectId);
+		reportProgress(true);
+		Q_ERROR("Import sql failed, code:{}, error:{}, committed offset:{}", ex.getCode(), ex.getMsg(), getProgress().committedOffset);
+		throw;
+	}
+	closeSession();
+	MetadataService::getInstance()->invalidateCache(params.connectId);
+	setReadBytes(totalBytes);
+	reportProgress(true);
+	auto result = getProgress();
+	Q_INFO("Import sql success, statements:{}, failed:{}, elapsed:{}ms", result.statements, result.failedStatements, result.elapsedMs);
+}
+
+void QSqlImporter::cancel()
+{
+	canceled = true;
+}
+
+void QSqlImporter::setProgressCallback(SqlImportProgressCallback callback)
+{
+	progressCallback = callback;
+}
+
+bool QSqlImporter::isCanceled() const
+{
+	return canceled;
+}
+
+SqlImportProgress QSqlImporter::getProgress()
+{
+	std::lock_guard<std::mutex> lk(progressMutex);
+	return progress;
+}
+
+/**
+ * The session is pinned for the whole import, so the SET, USE and LOCK TABLES statements of the script
+ * work as they do in mysql client. autocommit=0 is the way that LOCK TABLES works with the transactions,
+ * COMMIT does not release the table locks.
+ */
+void QSqlImporter::openSession()
+{
+	sessionKey = nextSessionKey++;
+	userDbRepository->executeInSession(params.connectId, params.schema, "SET autocommit=0", sessionKey);
+	updateBackslashEscapes();
+}
+
+/**
+ * The session is closed instead of returning to the pool, the script may have changed its variables.
+ */
+void QSqlImporter::closeSession()
+{
+	if (!sessionKey) {
+		return;
+	}
+	userDbRepository->releaseSession(params.connectId, sessionKey, true);
+	sessionKey = 0;
+}
+
+void QSqlImporter::importStream(std::istream & in)
+{
+	auto handler = [this](const std::string & sql, uint64_t endOffset) {
+		return handleStatement(sql, endOffset);
+	};
+	std::string line;
+	uint64_t lineOffset = 0;
+	while (std::getline(in, line)) {
+		uint64_t lineEnd = lineOffset + line.size() + (in.eof() ? 0 : 1);
+		if (lineOffset == 0 && StringUtil::startWith(line, "\xEF\xBB\xBF")) {
+			// the BOM of utf8
+			line.erase(0, 3);
+			lineOffset += 3;
+		}
+		splitter.feedLine(line, lineOffset, handler);
+		lineOffset = lineEnd;
+		if (lineOffset > params.startOffset) {
+			setReadBytes(lineOffset);
+			reportProgress(false);
+		}
+	}
+	splitter.finish(lineOffset, handler);
+}
+
+/**
+ * @param sql
+ * @param endOffset
+ * @return true - always, the errors are thrown
+ */
+bool QSqlImporter::handleStatement(const std::string & sql, uint64_t endOffset)
+{
+	checkCanceled();
+	std::string keyword = getFirstKeyword(sql);
+	if (endOffset <= params.startOffset) {
+		// before the resume point, only the statements of the session are replayed
+		if (keyword == "SET" || keyword == "USE") {
+			userDbRepository->executeInSession(params.connectId, "", sql, sessionKey);
+			if (keyword == "SET") {
+				updateBackslashEscapes();
+			}
+		}
+		return true;
+	}
+
+	bool isDml = keyword == "INSERT" || keyword == "REPLACE" || keyword == "UPDATE" || keyword == "DELETE";
+	if (!isDml && batchStatements > 0) {
+		// DDL commits implicitly, the pending batch is committed first, so the committed offset is exact
+		commitBatch(lastOffset);
+	}
+	executeStatement(sql, endOffset);
+	lastOffset = endOffset;
+	if (!isDml) {
+		commitBatch(endOffset);
+		if (keyword == "SET" && StringUtil::search(sql, "sql_mode", true)) {
+			updateBackslashEscapes();
+		}
+		return true;
+	}
+
+	batchStatements++;
+	batchBytes += sql.size();
+	if (batchStatements >= MAX_BATCH_STATEMENTS || batchBytes >= MAX_BATCH_BYTES) {
+		commitBatch(endOffset);
+	}
+	return true;
+}
+
+/**
+ * Execute the statement, if continueOnError the error is kept in the progress and the statement is skipped.
+ * 
+ * @param sql
+ * @param endOffset
+ */
+void QSqlImporter::executeStatement(const std::string & sql, uint64_t endOffset)
+{
+	try {
+		userDbRepository->executeInSession(params.connectId, "", sql, sessionKey);
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress.statements++;
+	} catch (QRuntimeException & ex) {
+		if (!params.continueOnError || isFatalError(ex.getCode())) {
+			throw;
+		}
+		std::lock_guard<std::mutex> lk(progressMutex);
+		progress.statements++;
+		progress.failedStatements++;
+		if (progress.errors.size() < MAX_KEPT_ERRORS) {
+			SqlImportError error;
+			error.offset = endOffset;
+			error.code = ex.getCode();
+			error.message = ex.getMsg();
+			error.sql = sql.substr(0, MAX_ERROR_SQL_BYTES);
+			progress.errors.push_back(error);
+		}
+	}
+}
+
+/**
+ * Commit the pending statements, the import resumes from endOffset after it.
+ * 
+ * @param endOffset - the end of the last statement of the batch
+ */
+void QSqlImporter::commitBatch(uint64_t endOffset)
+{
+	userDbRepository->executeInSession(params.connectId, "", "COMMIT", sessionKey);
+	batchStatements = 0;
+	batchBytes = 0;
+	std::lock_guard<std::mutex> lk(progressMutex);
+	progress.committedOffset = endOffset;
+}
+
+void QSqlImporter::rollbackBatch()
+{
+	if (!sessionKey) {
+		return;
+	}
+	try {
+		userDbRepository->executeInSession(params.connectId, "", "ROLLBACK", sessionKey);
+	} catch (QRuntimeException & ex) {
+		Q_ERROR("Fail to rollback the import, code:{}, error:{}", ex.getCode(), ex.getMsg());
+	}
+	batchStatements = 0;
+	batchBytes = 0;
+}
+
+/**
+ * The backslash is an escape char in the strings unless NO_BACKSLASH_ESCAPES is in the sql_mode of the session,
+ * the splitter follows it, such as the script of mysqldump that sets sql_mode at the head.
+ */
+void QSqlImporter::updateBackslashEscapes()
+{
+	auto sqlMode = userDbRepository->getSessionSqlMode(params.connectId, sessionKey);
+	splitter.setBackslashEscapes(!StringUtil::search(sqlMode, "NO_BACKSLASH_ESCAPES", true));
+}
+
+/**
+ * The first keyword of the statement in upper case, the keyword in the executable comment is used, 
+ * such as "/ *!40101 SET NAMES utf8 * /" is SET.
+ * 
+ * @param sql
+ * @return 
+ */
+std::string QSqlImporter::getFirstKeyword(const std::string & sql)
+{
+	size_t len = sql.size();
+	size_t i = 0;
+	while (i < len) {
+		if (std::isspace(static_cast<unsigned char>(sql[i]))) {
+			i++;
+		} else if (sql.compare(i, 3, "/*!") == 0) {
+			i += 3;
+			while (i < len && std::isdigit(static_cast<unsigned char>(sql[i]))) {
+				i++;
+			}
+		} else if (sql.compare(i, 2, "/*") == 0) {
+			size_t end = sql.find("*/", i + 2);
+			i = end == std::string::npos ? len : end + 2;
+		} else {
+			break;
+		}
+	}
+	std::string keyword;
+	while (i < len && std::isalpha(static_cast<unsigned char>(sql[i]))) {
+		keyword.push_back(static_cast<char>(std::toupper(static_cast<unsigned char>(sql[i]))));
+		i++;
+	}
+	return keyword;
+}
+
+/**
+ * The errors that the import can not continue after, the transaction is rolled back or the session is lost.
+ * 
+ * @param code
+ * @return 
+ */
+bool QSqlImporter::isFatalError(const std::string & code)
+{
+	// 1213: deadlock, 2006: server has gone away, 2013: lost connection
+	return code == "1213" || code == "2006" || code == "2013";
+}
+
+void QSqlImporter::setReadBytes(uint64_t readBytes)
+{
+	std::lock_guard<std::mutex> lk(progressMutex);
+	progress.readBytes = readBytes;
+}
+
+/**
+ * The speed is measured from the resume point, the ETA is the remaining bytes at the speed.
+ * 
+ * @param force - report at once, otherwise at most once every REPORT_INTERVAL_MS
+ */
+void QSqlImporter::reportProgress(bool force)
+{
+	if (!progressCallback) {
+		return;
+	}
+	SqlImportProgress snapshot;
+	{
+		std::lock_guard<std::mutex> lk(progressMutex);
+		auto now = std::chrono::steady_clock::now();
+		if (!force && now - lastReportAt < std::chrono::milliseconds(REPORT_INTERVAL_MS)) {
+			return;
+		}
+		lastReportAt = now;
+		progress.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(now - beginAt).count();
+		uint64_t readBytes = progress.readBytes > params.startOffset ? progress.readBytes - params.startOffset : 0;
+		progress.statementsPerSecond = progress.elapsedMs ? progress.statements * 1000.0 / progress.elapsedMs : 0;
+		progress.bytesPerSecond = progress.elapsedMs ? readBytes * 1000.0 / progress.elapsedMs : 0;
+		progress.percent = progress.totalBytes ? static_cast<int>(progress.readBytes * 100 / progress.totalBytes) : 100;
+		progress.etaSeconds = -1;
+		if (progress.bytesPerSecond > 0 && progress.totalBytes >= progress.readBytes) {
+			progress.etaSeconds = static_cast<int64_t>((progress.totalBytes - progress.readBytes) / progress.bytesPerSecond);
+		}
+		snapshot = progress;
+	}
+	progressCallback(snapshot);
+}
+
+void QSqlImporter::checkCanceled()
+{
+	if (canceled) {
+		throw QRuntimeException("200030");
+	}
+}
@@ -0,0 +1,91 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QSqlImporter.h
+ * @brief  QSqlImporter - Import a sql script into the database in process, instead of mysql.exe and the temp file.
+ *         The file is streamed line by line and split into the statements by QSqlSplitter, so the memory is bounded
+ *         by the longest statement. The statements run in a pinned session with autocommit=0, the DML statements are
+ *         committed in batches, and the offset after the last committed statement is the point to resume from.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-04
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <istream>
+#include <mutex>
+#include <string>
+#include "core/entity/Entity.h"
+#include "core/repository/db/UserDbRepository.h"
+#include "core/common/importer/QSqlSplitter.h"
+
+// The progress of the import, it is called in the importing thread
+typedef std::function<void (const SqlImportProgress & progress)> SqlImportProgressCallback;
+
+class QSqlImporter {
+public:
+	QSqlImporter(const SqlImportParams & params);
+	~QSqlImporter();
+
+	// run in the calling thread, throw QRuntimeException if failed, the progress has the offset to resume from
+	void run();
+	// stop the import at the next statement, the pending batch is rolled back, run() throws QRuntimeException("200030")
+	void cancel();
+	// call it before run(), the progress is reported at most once every REPORT_INTERVAL_MS
+	void setProgressCallback(SqlImportProgressCallback callback);
+	bool isCanceled() const;
+	SqlImportProgress getProgress();
+private:
+	// the DML statements of a transaction, the batch is committed when one of the limits is reached
+	static const uint32_t MAX_BATCH_STATEMENTS = 100;
+	static const size_t MAX_BATCH_BYTES = 4 * 1024 * 1024;
+	// the min interval of the progress reports
+	static const uint32_t REPORT_INTERVAL_MS = 250;
+	// the errors that are kept in the progress, and the head of the failed statement that is kept
+	static const size_t MAX_KEPT_ERRORS = 100;
+	static const size_t MAX_ERROR_SQL_BYTES = 256;
+	// the session keys of the importer, greater than the session keys of QDbCopier
+	static std::atomic<uint64_t> nextSessionKey;
+
+	SqlImportParams params;
+	std::atomic<bool> canceled{ false };
+	uint64_t sessionKey = 0;
+	QSqlSplitter splitter;
+	uint32_t batchStatements = 0;
+	size_t batchBytes = 0;
+	uint64_t lastOffset = 0; // the end of the last executed statement
+	UserDbRepository * userDbRepository = UserDbRepository::getInstance();
+
+	// progress, guarded by progressMutex
+	std::mutex progressMutex;
+	SqlImportProgress progress;
+	std::chrono::steady_clock::time_point beginAt;
+	std::chrono::steady_clock::time_point lastReportAt;
+	SqlImportProgressCallback progressCallback;
+
+	void openSession();
+	void closeSession();
+	void importStream(std::istream & in);
+	bool handleStatement(const std::string & sql, uint64_t endOffset);
+	void executeStatement(const std::string & sql, uint64_t endOffset);
+	void commitBatch(uint64_t endOffset);
+	void rollbackBatch();
+	void updateBackslashEscapes();
+	static std::string getFirstKeyword(const std::string & sql);
+	static bool isFatalError(const std::string & code);
+	void setReadBytes(uint64_t readBytes);
+	void reportProgress(bool force);
+	void checkCanceled();
+};
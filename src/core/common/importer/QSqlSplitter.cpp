@@ -0,0 +1,195 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QSqlSplitter.cpp
+ * @brief  QSqlSplitter - Split a sql script into the statements.
+ * 
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-04
+ *********************************************************************/
+#include "QSqlSplitter.h"
+#include <cctype>
+#include <algorithm>
+
+QSqlSplitter::QSqlSplitter(const std::string & delimiter) : delimiter(delimiter)
+{
+}
+
+void QSqlSplitter::setBackslashEscapes(bool enabled)
+{
+	backslashEscapes = enabled;
+}
+
+const std::string & QSqlSplitter::getDelimiter() const
+{
+	return delimiter;
+}
+
+/**
+ * Split the line, the handler is called for every statement that ends in the line.
+ * The line comments are dropped, the block comments are kept in the statement, / *! ... * / and / *+ ... * / are the code.
+ * 
+ * @param line - without the line break
+ * @param lineOffset - the byte offset of the line in the script
+ * @param handler
+ * @return false if the handler stops
+ */
+bool QSqlSplitter::feedLine(const std::string & line, uint64_t lineOffset, const SqlStatementHandler & handler)
+{
+	// DELIMITER is a command of the client, it is only recognized at the beginning of a statement
+	if (!quote && !inComment && !hasCode && parseDelimiterCommand(line)) {
+		statement.clear();
+		return true;
+	}
+
+	size_t len = line.size();
+	size_t i = 0, segStart = 0; // the text from segStart to i is appended to the statement at a time
+	while (i < len) {
+		char c = line[i];
+		if (inComment) {
+			if (c == '*' && i + 1 < len && line[i + 1] == '/') {
+				inComment = false;
+				i += 2;
+			} else {
+				i++;
+			}
+			continue;
+		}
+		if (quote) {
+			if (c == '\\' && backslashEscapes && quote != '`') {
+				i += 2; // the escaped char, it is the line break if the backslash is the last char
+			} else if (c == quote) {
+				if (i + 1 < len && line[i + 1] == quote) {
+					i += 2; // the doubled quote
+				} else {
+					quote = 0;
+					i++;
+				}
+			} else {
+				i++;
+			}
+			continue;
+		}
+		if (!delimiter.empty() && line.compare(i, delimiter.size(), delimiter) == 0) {
+			statement.append(line, segStart, i - segStart);
+			i += delimiter.size();
+			segStart = i;
+			if (!flush(lineOffset + i, handler)) {
+				return false;
+			}
+			continue;
+		}
+		if (c == '\'' || c == '"' || c == '`') {
+			quote = c;
+			hasCode = true;
+			i++;
+		} else if (c == '#' || (c == '-' && i + 1 < len && line[i + 1] == '-'
+			&& (i + 2 == len || std::isspace(static_cast<unsigned char>(line[i + 2]))))) {
+			// the line comment, the rest of the line is dropped
+			statement.append(line, segStart, i - segStart);
+			segStart = i = len;
+		} else if (c == '/' && i + 1 < len && line[i + 1] == '*') {
+			if (i + 2 < len && (line[i + 2] == '!' || line[i + 2] == '+')) {
+				hasCode = true; // the executable comment or the optimizer hints
+			}
+			inComment = true;
+			i += 2;
+		} else {
+			if (!std::isspace(static_cast<unsigned char>(c))) {
+				hasCode = true;
+			}
+			i++;
+		}
+	}
+	if (segStart < len) {
+		statement.append(line, segStart, len - segStart);
+	}
+	if (!statement.empty()) {
+		statement.push_back('\n');
+	}
+	return true;
+}
+
+bool QSqlSplitter::finish(uint64_t endOffset, const SqlStatementHandler & handler)
+{
+	quote = 0;
+	inComment = false;
+	return flush(endOffset, handler);
+}
+
+/**
+ * Parse "DELIMITER $$", the delimiter is the first word after DELIMITER, such as mysql client.
+ * 
+ * @param line
+ * @return true if the line is the DELIMITER command
+ */
+bool QSqlSplitter::parseDelimiterCommand(const std::string & line)
+{
+	static const std::string command = "DELIMITER";
+	size_t len = line.size();
+	size_t i = 0;
+	while (i < len && std::isspace(static_cast<unsigned char>(line[i]))) {
+		i++;
+	}
+	if (len - i <= command.size()) {
+		return false;
+	}
+	for (size_t j = 0; j < command.size(); j++) {
+		if (std::toupper(static_cast<unsigned char>(line[i + j])) != command[j]) {
+			return false;
+		}
+	}
+	i += command.size();
+	if (!std::isspace(static_cast<unsigned char>(line[i]))) {
+		return false;
+	}
+	while (i < len && std::isspace(static_cast<unsigned char>(line[i]))) {
+		i++;
+	}
+	size_t begin = i;
+	while (i < len && !std::isspace(static_cast<unsigned char>(line[i]))) {
+		i++;
+	}
+	if (i == begin) {
+		return false;
+	}
+	delimiter = line.substr(begin, i - begin);
+	return true;
+}
+
+/**
+ * Pass the pending statement to the handler, the statement that has only the comments or the blanks is skipped.
+ * 
+ * @param endOffset
+ * @param handler
+ * @return false if the handler stops
+ */
+bool QSqlSplitter::flush(uint64_t endOffset, const SqlStatementHandler & handler)
+{
+	std::string sql;
+	sql.swap(statement);
+	if (!hasCode) {
+		return true;
+	}
+	hasCode = false;
+
+	auto isBlank = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+	auto first = std::find_if_not(sql.begin(), sql.end(), isBlank);
+	auto last = std::find_if_not(sql.rbegin(), sql.rend(), isBlank).base();
+	if (first >= last) {
+		return true;
+	}
+	if (first != sql.begin() || last != sql.end()) {
+		sql = std::string(first, last);
+	}
+	return handler(sql, endOffset);
+}
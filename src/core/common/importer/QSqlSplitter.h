@@ -0,0 +1,51 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QSqlSplitter.h
+ * @brief  QSqlSplitter - Split a sql script into the statements as the mysql client does. The script is fed line by line,
+ *         the quoted strings and identifiers ('', "", ``), the comments (#, -- , / * * /) and the DELIMITER command
+ *         are understood, so a delimiter in a string, a comment or a routine body does not end the statement.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-04
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <string>
+#include <functional>
+
+// The statement without the delimiter, endOffset is the byte offset after the delimiter, return false to stop splitting
+typedef std::function<bool (const std::string & sql, uint64_t endOffset)> SqlStatementHandler;
+
+class QSqlSplitter {
+public:
+	QSqlSplitter(const std::string & delimiter = ";");
+
+	// false - NO_BACKSLASH_ESCAPES is in the sql_mode, the backslash is a normal char in the strings
+	void setBackslashEscapes(bool enabled);
+	const std::string & getDelimiter() const;
+
+	// line is without the line break, lineOffset is the byte offset of the line in the script, return false if the handler stops
+	bool feedLine(const std::string & line, uint64_t lineOffset, const SqlStatementHandler & handler);
+	// the end of the script, the last statement may have no delimiter
+	bool finish(uint64_t endOffset, const SqlStatementHandler & handler);
+private:
+	std::string delimiter;
+	bool backslashEscapes = true;
+	std::string statement; // the text of the pending statement
+	bool hasCode = false; // the pending statement has the text that is not the comment or the blank
+	char quote = 0; // the quote of the pending string or identifier, 0 - not in the quotes
+	bool inComment = false; // in the / * * / comment
+
+	bool parseDelimiterCommand(const std::string & line);
+	bool flush(uint64_t endOffset, const SqlStatementHandler & handler);
+};
@@ -8,6 +8,7 @@
 #include <vector>
 #include <utility>
 #include <cassert>
+#include <mutex>
 #include "utils/Log.h"
 #include "utils/ResourceUtil.h"
 #include "utils/FileUtil.h"
@@ -65,8 +66,11 @@ public:
 	void colseUserConnect();
 protected:
 	static T * theInstance;
+	static std::recursive_mutex instanceMutex;
 	bool isInitConnect = false;
 	
+	// the errors of the threads, guarded by errorMutex
+	std::mutex errorMutex;
     std::unordered_map<uint32_t, std::string> errorCode;
     std::unordered_map<uint32_t, std::string> errorMsg;
 	std::string localDir;
@@ -117,9 +121,14 @@ uint64_t BaseRepository<T>::getLastId(std::string tbl)
 template <typename T>
 T * BaseRepository<T>::theInstance = nullptr;
 
+template <typename T>
+std::recursive_mutex BaseRepository<T>::instanceMutex;
+
+// the repositories are used by the worker threads too, the first call may be in any thread
 template <typename T>
 T * BaseRepository<T>::getInstance()
 {
+	std::lock_guard<std::recursive_mutex> lk(BaseRepository<T>::instanceMutex);
 	if (BaseRepository<T>::theInstance == nullptr) {
 		BaseRepository<T>::theInstance = new T();
 	}
@@ -129,6 +138,7 @@ T * BaseRepository<T>::getInstance()
 template <typename T>
 void BaseRepository<T>::destroyInstance()
 {
+	std::lock_guard<std::recursive_mutex> lk(BaseRepository<T>::instanceMutex);
 	if (BaseRepository<T>::theInstance) {
 		delete BaseRepository<T>::theInstance;
 		BaseRepository<T>::theInstance = nullptr;
@@ -144,6 +154,8 @@ void  BaseRepository<T>::setLocalDir(const std::string & dir)
 template <typename T>
 SQLite::QSqlDatabase * BaseRepository<T>::getSysConnect()
 {
+	// the repositories of the worker threads get it too
+	std::lock_guard<std::mutex> lk(QConnect::sysConnectMutex);
 	if (QConnect::sysConnect == nullptr) {
 		//auto conn = std::make_shared<QSqlDatabase>("HairAnalyzer");
 		//connect = conn.get();
@@ -178,6 +190,7 @@ void BaseRepository<T>::closeConnect()
 template<typename T>
 inline void BaseRepository<T>::colseSysConnect()
 {
+	std::lock_guard<std::mutex> lk(QConnect::sysConnectMutex);
 	if (QConnect::sysConnect == nullptr) {
 		return;
 	}
@@ -197,22 +210,14 @@ inline void BaseRepository<T>::colseUserConnect()
 	if (QConnect::userConnectPool.empty()) {
 		return;
 	}
-	for (auto& pair : QConnect::userConnectPool) {
-		auto ptr = pair.second;
-		if (ptr->isValid() || !ptr->isClosed()) {
-			ptr->close();
-		}
-		delete ptr;
-		ptr = nullptr;
-		pair.second = nullptr;
-	}
-	QConnect::userConnectPool.clear();
+	QConnect::userConnectPool.closeAll();
 }
 
 template <typename T>
 std::string BaseRepository<T>::getErrorMsg()
 {
 	uint32_t threadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
     return errorMsg[threadId];
 }
 
@@ -220,6 +225,7 @@ template <typename T>
 std::string BaseRepository<T>::getErrorCode()
 {
 	uint32_t threadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
     return errorCode[threadId];
 }
 
@@ -228,6 +234,7 @@ template <typename T>
 void BaseRepository<T>::setErrorMsg(std::string msg)
 {
 	uint32_t threadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
     errorMsg[threadId] = msg;
 }
 
@@ -235,6 +242,7 @@ template <typename T>
 void BaseRepository<T>::setErrorCode(std::string code)
 {
 	uint32_t threadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
     errorCode[threadId] = code;
 }
 
@@ -242,6 +250,7 @@ template <typename T>
 void BaseRepository<T>::setError(std::string code, std::string msg)
 {
 	uint32_t threadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
     errorCode[threadId] = code;
     errorMsg[threadId] = msg;
 }
@@ -39,10 +39,11 @@ class BaseUserRepository : public BaseRepository<T>
 public:
 	~BaseUserRepository();
 
-	sql::Connection * getUserConnect(uint64_t userConnectId);
+	QConnectLease getUserConnect(uint64_t userConnectId, QConnectLane lane = METADATA_LANE, uint64_t sessionKey = 0);
 	void testUserConnect(uint64_t userConnectId);	
 	void closeUserConnect(uint64_t userConnectId);	
 	void closeAllUserConnect();	
+	QConnectPoolStats getUserConnectStats(uint64_t userConnectId);
 	// object ddl
 	std::string getObjectDDL(uint64_t connectId, const std::string& schema, const std::string & name, const std::string & objectType);
 	bool hasObject(uint64_t connectId, const std::string& schema, const std::string & name, const std::string & objectType);
@@ -74,6 +75,8 @@ protected:
 
 	UserConnect getUserConnectEntity(uint64_t userConnectId);
 	UserConnect toUserConnect(SQLite::QSqlStatement& query);
+	// the options of the sessions of the user connection: host, account, schema, charset and SSL
+	sql::ConnectOptionsMap getConnectOptions(const UserConnect & userConnEntity);
 
 	RowItem toRowItem(sql::Statement* query);
 };
@@ -86,75 +89,84 @@ BaseUserRepository<T>::~BaseUserRepository()
 }
 
 /**
-* Read dbName and dbPath from the table CuteSqlite.user_db
+* Check out a session of the user connection from QConnect::userConnectPool.
+* The session returns to the pool when the lease is destroyed, so keep the lease until the statements and result sets are finished.
 *
-* @param userDbId The param of CuteSqlite.user_db.id
-* @return QSqlDatabase pointer
+* @param userConnectId The param of CuteSqlite.user_connect.id
+* @param lane METADATA_LANE - metadata statements, QUERY_LANE - user sql statements, PACKET_LANE - multi statements
+* @param sessionKey 0 - any free session, >0 - pinned session (keep the same session for the transaction and the user variables)
+* @return QConnectLease
 */
 template <typename T>
-sql::Connection * BaseUserRepository<T>::getUserConnect(uint64_t userConnectId)
+QConnectLease BaseUserRepository<T>::getUserConnect(uint64_t userConnectId, QConnectLane lane, uint64_t sessionKey)
 {
-	if (QConnect::userConnectPool.empty() && QConnect::driver == nullptr) {
-		QConnect::driver = sql::mysql::get_mysql_driver_instance();
-	}
-
-	if (QConnect::userConnectPool.find(userConnectId) == QConnect::userConnectPool.end()) {
+	auto creator = [this, userConnectId, lane]() -> sql::Connection * {
 		UserConnect userConnEntity = getUserConnectEntity(userConnectId);
 
-		sql::ConnectOptionsMap options;
-		options["hostName"] = userConnEntity.host;
-		options["userName"] = userConnEntity.userName;
-		options["password"] = userConnEntity.password;
-		if (!userConnEntity.databases.empty()) {
-			options["schema"] = userConnEntity.databases;
-		}
-
-		options["port"] = userConnEntity.port;
+		sql::ConnectOptionsMap options = getConnectOptions(userConnEntity);
+		// the pinned sessions do not reconnect, see QConnectPool::setReconnect(...)
 		options["OPT_RECONNECT"] = true;
-		// charset
-		options["OPT_CHARSET_NAME"] = sql::SQLString("utf8");
-		options["characterSetResults"] = sql::SQLString("utf8");
-		options["characterSetConnection"] = sql::SQLString("utf8");
-		options["characterSetClient"] = sql::SQLString("utf8");
-
-		try {
-			QConnect::userConnectPool[userConnectId] = QConnect::driver->connect(options);
-		} catch (sql::SQLException& ex) {
-			BaseRepository<T>::setError(std::to_string(ex.getErrorCode()), ex.what());
-			Q_ERROR("Fail to connect the mysql. hostName:{}, port:{},error:{}", userConnEntity.host, ex.what());
-			throw QRuntimeException(std::to_string(ex.getErrorCode()), ex.what());
+		if (lane == PACKET_LANE) {
+			// only these sessions can send more statements in one round trip, see UserSqlExecutorRepository::executePacket(...),
+			// the other sessions reject the stacked statements
+			options["CLIENT_MULTI_STATEMENTS"] = true;
 		}
-		
+
+		Q_INFO("BaseUserRepository::getConnect(connectId), connectId:{}, lane:{} connect...", userConnectId, (int)lane);
+		return QConnect::getDriver()->connect(options);
+	};
+
+	try {
+		return QConnect::userConnectPool.acquire(userConnectId, lane, creator, sessionKey);
+	} catch (sql::SQLException& ex) {
+		BaseRepository<T>::setError(std::to_string(ex.getErrorCode()), ex.what());
+		Q_ERROR("Fail to connect the mysql. connectId:{}, lane:{}, error:{}", userConnectId, (int)lane, ex.what());
+		throw QRuntimeException(std::to_string(ex.getErrorCode()), ex.what());
 	}
+}
 
-	Q_INFO("BaseUserRepository::getConnect(connectId), connectId:{} connect...", userConnectId);
-	Q_INFO("BaseUserRepository::getConnect(connectId), connectId:{}, connect.isValid():{}",
-		userConnectId, QConnect::userConnectPool[userConnectId]->isValid());
-
-	if (!QConnect::userConnectPool[userConnectId]->isValid()) {
-		try {
-			if (!QConnect::userConnectPool[userConnectId]->reconnect()) {
-				throw(sql::SQLException("Fail to reconnect the mysql."));
-			}
-		} catch (sql::SQLException& ex) {
-			BaseRepository<T>::setError(std::to_string(ex.getErrorCode()), ex.what());
-			Q_ERROR("Open mysql db raise error. connectId:{}, error:{}", userConnectId, ex.what());
-			throw QRuntimeException(std::to_string(ex.getErrorCode()), ex.what());
+/**
+ * The options of the sessions of the user connection, the pooled sessions and the side sessions use the same options.
+ * 
+ * @param userConnEntity
+ * @return 
+ */
+template <typename T>
+sql::ConnectOptionsMap BaseUserRepository<T>::getConnectOptions(const UserConnect & userConnEntity)
+{
+	sql::ConnectOptionsMap options;
+	options["hostName"] = userConnEntity.host;
+	options["userName"] = userConnEntity.userName;
+	options["password"] = userConnEntity.password;
+	if (!userConnEntity.databases.empty()) {
+		options["schema"] = userConnEntity.databases;
+	}
+	options["port"] = userConnEntity.port;
+	// charset
+	options["OPT_CHARSET_NAME"] = sql::SQLString("utf8");
+	options["characterSetResults"] = sql::SQLString("utf8");
+	options["characterSetConnection"] = sql::SQLString("utf8");
+	options["characterSetClient"] = sql::SQLString("utf8");
+	// ssl
+	if (userConnEntity.isUseSsl) {
+		options["OPT_SSL_MODE"] = static_cast<int>(userConnEntity.sslCaCertificate.empty() ? sql::SSL_MODE_REQUIRED : sql::SSL_MODE_VERIFY_CA);
+		if (!userConnEntity.sslCaCertificate.empty()) {
+			options["sslCA"] = userConnEntity.sslCaCertificate;
+		}
+		if (!userConnEntity.sslCipher.empty()) {
+			options["sslCipher"] = userConnEntity.sslCipher;
+		}
+		if (userConnEntity.isSslAuth) {
+			options["sslKey"] = userConnEntity.sslClientKey;
+			options["sslCert"] = userConnEntity.sslClientCertificate;
 		}
-		
 	}
-
-	return QConnect::userConnectPool[userConnectId];
+	return options;
 }
 
 template <typename T>
 void BaseUserRepository<T>::testUserConnect(uint64_t userConnectId)
 {
-	if (QConnect::userConnectPool.empty() && QConnect::driver == nullptr) {
-		QConnect::driver = sql::mysql::get_mysql_driver_instance();
-	}
-
-	
 	UserConnect userConnEntity = getUserConnectEntity(userConnectId);
 
 	sql::ConnectOptionsMap options;
@@ -168,7 +180,7 @@ void BaseUserRepository<T>::testUserConnect(uint64_t userConnectId)
 	}
 
 	try {
-		boost::scoped_ptr<sql::Connection> conn(QConnect::driver->connect(options));
+		boost::scoped_ptr<sql::Connection> conn(QConnect::getDriver()->connect(options));
 		
 		if (conn.get()->isValid()) {
 			conn.get()->close();
@@ -187,22 +199,7 @@ void BaseUserRepository<T>::testUserConnect(uint64_t userConnectId)
 template <typename T>
 void BaseUserRepository<T>::closeUserConnect(uint64_t userConnectId)
 {
-	if (QConnect::userConnectPool.empty() || QConnect::userConnectPool.find(userConnectId) == QConnect::userConnectPool.end()) {
-		return;
-	}
-	
-	auto tmpConnect = QConnect::userConnectPool.at(userConnectId);	
-	if (tmpConnect) {
-		// 1) close the connect
-		if (tmpConnect->isValid()) {
-			tmpConnect->close();
-		}
-		// 2) delete the ptr
-		delete tmpConnect;
-		tmpConnect = nullptr;
-	}
-	// 3) erase from userConnectPool (map)
-	QConnect::userConnectPool.erase(userConnectId);
+	QConnect::userConnectPool.close(userConnectId);
 }
 
 template <typename T>
@@ -211,21 +208,13 @@ void BaseUserRepository<T>::closeAllUserConnect()
 	if (QConnect::userConnectPool.empty()) {
 		return;
 	}
+	QConnect::userConnectPool.closeAll();
+}
 
-	for (auto pair : QConnect::userConnectPool) {
-		auto tmpConnect = pair.second;
-		// 1) close the connect
-		if (tmpConnect->isValid()) {
-			tmpConnect->close();
-		}
-
-		// 2) delete the ptr
-		delete tmpConnect;
-		tmpConnect = nullptr;
-	}
-
-	// 3) erase all item from userConnectPool (map)
-	QConnect::userConnectPool.clear();
+template <typename T>
+QConnectPoolStats BaseUserRepository<T>::getUserConnectStats(uint64_t userConnectId)
+{
+	return QConnect::userConnectPool.getStats(userConnectId);
 }
 
 template <typename T>
@@ -19,12 +19,25 @@
  * @date   2023-10-25
  *********************************************************************/
 #include "QConnect.h"
+#include <mutex>
 
 // The mysql driver ptr
 sql::mysql::MySQL_Driver * QConnect::driver = nullptr;
 
+sql::mysql::MySQL_Driver * QConnect::getDriver()
+{
+	static std::once_flag driverFlag;
+	std::call_once(driverFlag, []() {
+		if (QConnect::driver == nullptr) {
+			QConnect::driver = sql::mysql::get_mysql_driver_instance();
+		}
+	});
+	return QConnect::driver;
+}
+
 // The user connect pool for connecting user databases(Multiple)
-std::unordered_map<uint64_t, sql::Connection *> QConnect::userConnectPool;
+QConnectPool QConnect::userConnectPool;
 
 // The CuteSqlite system connect for connecting system database of CuteSqlite itself.(Single)
 SQLite::QSqlDatabase * QConnect::sysConnect = nullptr;
+std::mutex QConnect::sysConnectMutex;
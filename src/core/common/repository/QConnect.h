@@ -20,14 +20,20 @@
  *********************************************************************/
 #pragma once
 #include <unordered_map>
+#include <mutex>
 #include <mysql/jdbc.h>
 #include "core/common/driver/sqlite/QSqlDatabase.h"
+#include "core/common/repository/QConnectPool.h"
 
 class QConnect {
 public:
 	static sql::mysql::MySQL_Driver *driver;
+	// Get the mysql driver, thread-safe
+	static sql::mysql::MySQL_Driver * getDriver();
 	// The user connect pool for connecting user databases(Multiple)
-	static std::unordered_map<uint64_t, sql::Connection *> userConnectPool;
+	static QConnectPool userConnectPool;
 	// The CuteSqlite system connect for connecting system database of CuteSqlite itself.(Single)
 	static SQLite::QSqlDatabase * sysConnect; //CuteSqlite use myself
+	// Guard the creation and the close of sysConnect, the statements are serialized by sysConnect->getMutex()
+	static std::mutex sysConnectMutex;
 };
\ No newline at end of file
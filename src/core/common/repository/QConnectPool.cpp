@@ -0,0 +1,608 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QConnectPool.cpp
+ * @brief  QConnectPool - The thread-safe pool of mysql sessions, keyed by user_connect.id.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-20
+ *********************************************************************/
+#include "QConnectPool.h"
+#include <algorithm>
+#include <atomic>
+#include "utils/Log.h"
+#include "utils/ThreadUtil.h"
+
+// idle session
+typedef struct _QConnectIdleItem {
+	sql::Connection * connect = nullptr;
+	std::chrono::steady_clock::time_point idleSince;
+} QConnectIdleItem;
+
+// checked out session (not pinned), refs > 1 when the same thread checks out again
+typedef struct _QConnectBusyItem {
+	uint32_t refs = 0;
+	uint32_t threadId = 0;
+} QConnectBusyItem;
+
+// pinned session, such as the query session of a thread, keep the transaction and the user variables
+typedef struct _QConnectPinnedItem {
+	sql::Connection * connect = nullptr;
+	uint32_t refs = 0;
+	bool released = false;
+	bool discarded = false; // destroy the session when it is released, its state can not be reused
+	uint64_t generation = 0; // unique for every pinning, the freed address of a session may be reused by a new one
+} QConnectPinnedItem;
+
+typedef struct _QConnectLaneSlot {
+	std::deque<QConnectIdleItem> idles;
+	std::unordered_map<sql::Connection *, QConnectBusyItem> busies;
+	std::unordered_map<uint32_t, sql::Connection *> holders; // threadId => connect
+	std::unordered_map<uint64_t, QConnectPinnedItem> pinneds; // sessionKey => pinned session
+	uint32_t creating = 0;
+	QConnectLaneStats stats;
+
+	uint32_t liveSize() const {
+		return static_cast<uint32_t>(idles.size() + busies.size() + pinneds.size()) + creating;
+	}
+} QConnectLaneSlot;
+
+struct QConnectPoolEntry {
+	uint64_t connectId = 0;
+	bool closed = false;
+	std::mutex mutex;
+	std::condition_variable cond;
+	QConnectLaneSlot lanes[LANE_COUNT];
+};
+
+// The idle session will be validated (ping) before checkout if it has been idle longer than this
+static const std::chrono::seconds VALIDATE_IDLE_AFTER(30);
+// The interval of reaping idle sessions
+static const std::chrono::seconds REAP_INTERVAL(60);
+// The generation of the pinned sessions
+static std::atomic<uint64_t> lastGeneration(0);
+
+QConnectLease::QConnectLease(QConnectLease && other) noexcept
+{
+	*this = std::move(other);
+}
+
+QConnectLease & QConnectLease::operator=(QConnectLease && other) noexcept
+{
+	if (this != &other) {
+		release();
+		entry = std::move(other.entry);
+		connect = other.connect;
+		lane = other.lane;
+		sessionKey = other.sessionKey;
+		waitMicroSeconds = other.waitMicroSeconds;
+		generation = other.generation;
+		other.connect = nullptr;
+		other.sessionKey = 0;
+	}
+	return *this;
+}
+
+QConnectLease::~QConnectLease()
+{
+	release();
+}
+
+void QConnectLease::release()
+{
+	if (entry && connect) {
+		QConnectPool::giveBack(entry, lane, connect, sessionKey);
+	}
+	entry.reset();
+	connect = nullptr;
+}
+
+QConnectPool::QConnectPool()
+{
+	laneOptions[METADATA_LANE].minIdle = 1;
+	laneOptions[METADATA_LANE].maxSize = 4;
+	laneOptions[METADATA_LANE].idleTimeout = 300;
+
+	laneOptions[QUERY_LANE].minIdle = 0;
+	laneOptions[QUERY_LANE].maxSize = 8;
+	laneOptions[QUERY_LANE].idleTimeout = 600;
+
+	laneOptions[PACKET_LANE].minIdle = 0;
+	laneOptions[PACKET_LANE].maxSize = 8;
+	laneOptions[PACKET_LANE].idleTimeout = 600;
+
+	lastReapAt = std::chrono::steady_clock::now();
+}
+
+QConnectPool::~QConnectPool()
+{
+	closeAll();
+}
+
+/**
+ * Check out a session from the lane of connectId.
+ *
+ * @param connectId - user_connect.id
+ * @param lane - METADATA_LANE / QUERY_LANE
+ * @param creator - create a new session when the lane has no idle session and is not full
+ * @param sessionKey - 0: normal checkout, the session returns to the idle list when the lease is destroyed;
+ *                     >0: pinned session, all leases with the same key share one session until releaseSession(..)
+ * @return the lease of session
+ */
+QConnectLease QConnectPool::acquire(uint64_t connectId, QConnectLane lane, const ConnectionCreator & creator, uint64_t sessionKey)
+{
+	reapIfDue();
+
+	QConnectLaneOptions options;
+	std::shared_ptr<QConnectPoolEntry> entry;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		options = laneOptions[lane];
+		entry = getOrCreateEntry(connectId);
+	}
+
+	QConnectLease lease;
+	lease.entry = entry;
+	lease.lane = lane;
+	lease.sessionKey = sessionKey;
+
+	uint32_t threadId = ThreadUtil::currentThreadId();
+	auto beginTime = std::chrono::steady_clock::now();
+	auto deadline = beginTime + std::chrono::seconds(options.waitTimeout);
+	bool waited = false;
+
+	std::unique_lock<std::mutex> lk(entry->mutex);
+	auto & slot = entry->lanes[lane];
+
+	// 1) re-entrant checkout, the pinned session or the session already held by current thread
+	if (sessionKey) {
+		auto iter = slot.pinneds.find(sessionKey);
+		if (iter != slot.pinneds.end()) {
+			iter->second.refs++;
+			iter->second.released = false;
+			slot.stats.checkouts++;
+			lease.connect = iter->second.connect;
+			lease.generation = iter->second.generation;
+			return lease;
+		}
+	} else {
+		auto iter = slot.holders.find(threadId);
+		if (iter != slot.holders.end()) {
+			slot.busies[iter->second].refs++;
+			slot.stats.checkouts++;
+			lease.connect = iter->second;
+			return lease;
+		}
+	}
+
+	// 2) take an idle session, or create a new one, or wait for a returned one
+	sql::Connection * connect = nullptr;
+	while (connect == nullptr) {
+		if (entry->closed) {
+			throw sql::SQLException("The connection pool has been closed.");
+		}
+		if (!slot.idles.empty()) {
+			// LIFO, the most recently used session is the warmest one
+			auto item = slot.idles.back();
+			slot.idles.pop_back();
+			if (std::chrono::steady_clock::now() - item.idleSince < VALIDATE_IDLE_AFTER) {
+				connect = item.connect;
+				break;
+			}
+			slot.creating++;
+			lk.unlock();
+			bool valid = validateConnect(item.connect);
+			if (!valid) {
+				destroyConnect(item.connect);
+			}
+			lk.lock();
+			slot.creating--;
+			if (valid) {
+				connect = item.connect;
+			} else {
+				slot.stats.reaped++;
+				entry->cond.notify_one();
+			}
+			continue;
+		}
+
+		if (slot.liveSize() < options.maxSize) {
+			slot.creating++;
+			lk.unlock();
+			try {
+				connect = creator();
+			} catch (...) {
+				lk.lock();
+				slot.creating--;
+				entry->cond.notify_one();
+				throw;
+			}
+			lk.lock();
+			slot.creating--;
+			slot.stats.created++;
+			if (entry->closed) {
+				destroyConnect(connect);
+				throw sql::SQLException("The connection pool has been closed.");
+			}
+			break;
+		}
+
+		waited = true;
+		if (entry->cond.wait_until(lk, deadline) == std::cv_status::timeout
+			&& slot.idles.empty() && slot.liveSize() >= options.maxSize) {
+			slot.stats.timeouts++;
+			Q_ERROR("Wait for a free session timeout, connectId:{}, lane:{}, maxSize:{}", connectId, (int)lane, options.maxSize);
+			throw sql::SQLException("Timeout waiting for a free connection in the pool.");
+		}
+	}
+
+	// 3) register the checked out session
+	if (sessionKey) {
+		// a reconnected session loses the variables and the transaction of the pinned session silently
+		setReconnect(connect, false);
+		QConnectPinnedItem pinned;
+		pinned.connect = connect;
+		pinned.refs = 1;
+		pinned.generation = ++lastGeneration;
+		slot.pinneds[sessionKey] = pinned;
+		lease.generation = pinned.generation;
+	} else {
+		auto & busy = slot.busies[connect];
+		busy.refs = 1;
+		busy.threadId = threadId;
+		slot.holders[threadId] = connect;
+	}
+
+	uint64_t waitUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - beginTime).count();
+	slot.stats.checkouts++;
+	if (waited) {
+		slot.stats.waits++;
+		slot.stats.totalWaitMicroSeconds += waitUs;
+		slot.stats.maxWaitMicroSeconds = std::max(slot.stats.maxWaitMicroSeconds, waitUs);
+	}
+
+	lease.connect = connect;
+	lease.waitMicroSeconds = waitUs;
+	return lease;
+}
+
+/**
+ * Unpin the session of sessionKey, the session returns to the idle list after its last lease released.
+ * If discard, the session is destroyed instead, such as the session that a sql script has changed its variables.
+ *
+ * @param connectId
+ * @param lane
+ * @param sessionKey
+ * @param discard
+ */
+void QConnectPool::releaseSession(uint64_t connectId, QConnectLane lane, uint64_t sessionKey, bool discard)
+{
+	std::shared_ptr<QConnectPoolEntry> entry;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		auto iter = entries.find(connectId);
+		if (iter == entries.end()) {
+			return;
+		}
+		entry = iter->second;
+	}
+
+	std::unique_lock<std::mutex> lk(entry->mutex);
+	auto & slot = entry->lanes[lane];
+	auto iter = slot.pinneds.find(sessionKey);
+	if (iter == slot.pinneds.end()) {
+		return;
+	}
+	if (iter->second.refs > 0) {
+		iter->second.released = true;
+		iter->second.discarded = discard;
+		return;
+	}
+	sql::Connection * connect = iter->second.connect;
+	slot.pinneds.erase(iter);
+	if (discard) {
+		lk.unlock();
+		destroyConnect(connect);
+		entry->cond.notify_one();
+		return;
+	}
+	setReconnect(connect, true);
+	QConnectIdleItem item;
+	item.connect = connect;
+	item.idleSince = std::chrono::steady_clock::now();
+	slot.idles.push_back(item);
+	entry->cond.notify_one();
+}
+
+void QConnectPool::giveBack(const std::shared_ptr<QConnectPoolEntry> & entry, QConnectLane lane, sql::Connection * connect, uint64_t sessionKey)
+{
+	bool destroy = false;
+	{
+		std::lock_guard<std::mutex> lk(entry->mutex);
+		auto & slot = entry->lanes[lane];
+		if (sessionKey) {
+			auto iter = slot.pinneds.find(sessionKey);
+			if (iter == slot.pinneds.end() || --iter->second.refs > 0) {
+				return;
+			}
+			if (entry->closed) {
+				slot.pinneds.erase(iter);
+				destroy = true;
+			} else if (iter->second.released) {
+				destroy = iter->second.discarded;
+				slot.pinneds.erase(iter);
+			} else {
+				return; // keep pinned
+			}
+		} else {
+			auto iter = slot.busies.find(connect);
+			if (iter == slot.busies.end() || --iter->second.refs > 0) {
+				return;
+			}
+			slot.holders.erase(iter->second.threadId);
+			slot.busies.erase(iter);
+			destroy = entry->closed;
+		}
+
+		if (!destroy) {
+			if (sessionKey) {
+				setReconnect(connect, true);
+			}
+			QConnectIdleItem item;
+			item.connect = connect;
+			item.idleSince = std::chrono::steady_clock::now();
+			slot.idles.push_back(item);
+		}
+		entry->cond.notify_one();
+	}
+
+	if (destroy) {
+		destroyConnect(connect);
+	}
+}
+
+/**
+ * Close all the sessions of connectId, the busy sessions will be closed when their leases are released.
+ *
+ * @param connectId
+ */
+void QConnectPool::close(uint64_t connectId)
+{
+	std::shared_ptr<QConnectPoolEntry> entry;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		auto iter = entries.find(connectId);
+		if (iter == entries.end()) {
+			return;
+		}
+		entry = iter->second;
+		entries.erase(iter);
+	}
+
+	std::vector<sql::Connection *> connects;
+	{
+		std::lock_guard<std::mutex> lk(entry->mutex);
+		entry->closed = true;
+		for (auto & slot : entry->lanes) {
+			for (auto & item : slot.idles) {
+				connects.push_back(item.connect);
+			}
+			slot.idles.clear();
+			for (auto iter = slot.pinneds.begin(); iter != slot.pinneds.end(); ) {
+				if (iter->second.refs == 0) {
+					connects.push_back(iter->second.connect);
+					iter = slot.pinneds.erase(iter);
+				} else {
+					++iter;
+				}
+			}
+		}
+		entry->cond.notify_all();
+	}
+
+	for (auto connect : connects) {
+		destroyConnect(connect);
+	}
+}
+
+void QConnectPool::closeAll()
+{
+	std::vector<uint64_t> connectIds;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		for (auto & pair : entries) {
+			connectIds.push_back(pair.first);
+		}
+	}
+	for (auto connectId : connectIds) {
+		close(connectId);
+	}
+}
+
+/**
+ * Close the idle sessions which idle time is longer than QConnectLaneOptions::idleTimeout, keep minIdle sessions at least.
+ *
+ * @return the count of closed sessions
+ */
+size_t QConnectPool::reapIdle()
+{
+	std::vector<std::shared_ptr<QConnectPoolEntry>> list;
+	QConnectLaneOptions options[LANE_COUNT];
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		for (auto & pair : entries) {
+			list.push_back(pair.second);
+		}
+		std::copy(std::begin(laneOptions), std::end(laneOptions), std::begin(options));
+		lastReapAt = std::chrono::steady_clock::now();
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	std::vector<sql::Connection *> connects;
+	for (auto & entry : list) {
+		std::lock_guard<std::mutex> lk(entry->mutex);
+		for (int i = 0; i < LANE_COUNT; i++) {
+			auto & slot = entry->lanes[i];
+			auto idleTimeout = std::chrono::seconds(options[i].idleTimeout);
+			// the front is the oldest idle session
+			while (slot.idles.size() > options[i].minIdle && now - slot.idles.front().idleSince > idleTimeout) {
+				connects.push_back(slot.idles.front().connect);
+				slot.idles.pop_front();
+				slot.stats.reaped++;
+			}
+		}
+	}
+
+	for (auto connect : connects) {
+		destroyConnect(connect);
+	}
+	if (!connects.empty()) {
+		Q_INFO("QConnectPool::reapIdle, reaped {} idle sessions", connects.size());
+	}
+	return connects.size();
+}
+
+bool QConnectPool::empty()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	return entries.empty();
+}
+
+void QConnectPool::setLaneOptions(QConnectLane lane, const QConnectLaneOptions & options)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	laneOptions[lane] = options;
+	if (laneOptions[lane].maxSize == 0) {
+		laneOptions[lane].maxSize = 1;
+	}
+}
+
+const QConnectLaneOptions & QConnectPool::getLaneOptions(QConnectLane lane) const
+{
+	return laneOptions[lane];
+}
+
+QConnectPoolStats QConnectPool::getStats(uint64_t connectId)
+{
+	QConnectPoolStats result;
+	result.connectId = connectId;
+
+	std::shared_ptr<QConnectPoolEntry> entry;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		auto iter = entries.find(connectId);
+		if (iter == entries.end()) {
+			return result;
+		}
+		entry = iter->second;
+	}
+
+	std::lock_guard<std::mutex> lk(entry->mutex);
+	for (int i = 0; i < LANE_COUNT; i++) {
+		auto & slot = entry->lanes[i];
+		auto & stats = result.lanes[i];
+		stats = slot.stats;
+		stats.lane = static_cast<QConnectLane>(i);
+		stats.idleSessions = static_cast<uint32_t>(slot.idles.size());
+		stats.pinnedSessions = static_cast<uint32_t>(slot.pinneds.size());
+		stats.busySessions = static_cast<uint32_t>(slot.busies.size());
+		for (auto & pair : slot.pinneds) {
+			stats.busySessions += pair.second.refs > 0 ? 1 : 0;
+		}
+		stats.liveSessions = slot.liveSize();
+	}
+	return result;
+}
+
+QConnectPoolStatsList QConnectPool::getAllStats()
+{
+	std::vector<uint64_t> connectIds;
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		for (auto & pair : entries) {
+			connectIds.push_back(pair.first);
+		}
+	}
+
+	QConnectPoolStatsList result;
+	for (auto connectId : connectIds) {
+		result.push_back(getStats(connectId));
+	}
+	return result;
+}
+
+std::shared_ptr<QConnectPoolEntry> QConnectPool::getOrCreateEntry(uint64_t connectId)
+{
+	auto iter = entries.find(connectId);
+	if (iter != entries.end()) {
+		return iter->second;
+	}
+	auto entry = std::make_shared<QConnectPoolEntry>();
+	entry->connectId = connectId;
+	entries[connectId] = entry;
+	return entry;
+}
+
+void QConnectPool::destroyConnect(sql::Connection * connect)
+{
+	if (connect == nullptr) {
+		return;
+	}
+	try {
+		if (!connect->isClosed()) {
+			connect->close();
+		}
+	} catch (sql::SQLException& ex) {
+		Q_ERROR("Fail to close the session, error:{}", ex.what());
+	}
+	delete connect;
+}
+
+bool QConnectPool::validateConnect(sql::Connection * connect)
+{
+	try {
+		if (connect->isValid()) {
+			return true;
+		}
+		return connect->reconnect();
+	} catch (sql::SQLException& ex) {
+		Q_ERROR("Fail to validate the idle session, error:{}", ex.what());
+		return false;
+	}
+}
+
+/**
+ * Turn the auto reconnect of the session on or off, it is off while the session is pinned.
+ * 
+ * @param connect
+ * @param reconnect
+ */
+void QConnectPool::setReconnect(sql::Connection * connect, bool reconnect)
+{
+	try {
+		connect->setClientOption("OPT_RECONNECT", &reconnect);
+	} catch (sql::SQLException& ex) {
+		Q_ERROR("Fail to set OPT_RECONNECT of the session, error:{}", ex.what());
+	}
+}
+
+void QConnectPool::reapIfDue()
+{
+	{
+		std::lock_guard<std::mutex> lk(mutex);
+		if (std::chrono::steady_clock::now() - lastReapAt < REAP_INTERVAL) {
+			return;
+		}
+		lastReapAt = std::chrono::steady_clock::now();
+	}
+	reapIdle();
+}
@@ -0,0 +1,145 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QConnectPool.h
+ * @brief  QConnectPool - The thread-safe pool of mysql sessions, keyed by user_connect.id.
+ *         Each connect id has separate lanes (metadata/query), so a slow user query never
+ *         stalls the metadata browsing of the left tree and the objects page.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-20
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <unordered_map>
+#include <vector>
+#include <mysql/jdbc.h>
+
+// The lane of the pool, every lane has its own sessions and limits
+typedef enum {
+	METADATA_LANE = 0, // left tree, objects page, dialogs and other short metadata statements
+	QUERY_LANE,        // user sql statements from query page, table data page
+	PACKET_LANE,       // the sessions that send more statements in one packet (pipeline, status probes), see UserSqlExecutorRepository
+	LANE_COUNT,
+} QConnectLane;
+
+// The limits of one lane
+typedef struct _QConnectLaneOptions {
+	uint32_t minIdle = 1;   // the reaper will keep at least minIdle idle sessions
+	uint32_t maxSize = 4;   // the max live sessions (idle + busy)
+	uint32_t idleTimeout = 300;  // seconds, idle sessions older than it will be reaped
+	uint32_t waitTimeout = 30;   // seconds, max time of waiting for a free session
+} QConnectLaneOptions;
+
+// The statistics of one lane
+typedef struct _QConnectLaneStats {
+	QConnectLane lane = METADATA_LANE;
+	uint32_t liveSessions = 0;
+	uint32_t idleSessions = 0;
+	uint32_t busySessions = 0;
+	uint32_t pinnedSessions = 0;
+	uint64_t checkouts = 0;
+	uint64_t waits = 0;
+	uint64_t timeouts = 0;
+	uint64_t created = 0;
+	uint64_t reaped = 0;
+	uint64_t totalWaitMicroSeconds = 0;
+	uint64_t maxWaitMicroSeconds = 0;
+} QConnectLaneStats;
+
+// The statistics of one connect id
+typedef struct _QConnectPoolStats {
+	uint64_t connectId = 0;
+	QConnectLaneStats lanes[LANE_COUNT];
+} QConnectPoolStats;
+typedef std::vector<QConnectPoolStats> QConnectPoolStatsList;
+
+class QConnectPool;
+struct QConnectPoolEntry;
+
+/**
+ * QConnectLease - a checked out session, it returns the session to the pool when destroyed.
+ * Usage: auto connect = getUserConnect(connectId); connect->createStatement()...
+ */
+class QConnectLease {
+public:
+	QConnectLease() = default;
+	QConnectLease(QConnectLease && other) noexcept;
+	QConnectLease & operator=(QConnectLease && other) noexcept;
+	QConnectLease(const QConnectLease &) = delete;
+	QConnectLease & operator=(const QConnectLease &) = delete;
+	~QConnectLease();
+
+	sql::Connection * get() const { return connect; }
+	sql::Connection * operator->() const { return connect; }
+	operator sql::Connection * () const { return connect; }
+	explicit operator bool() const { return connect != nullptr; }
+
+	QConnectLane getLane() const { return lane; }
+	uint64_t getWaitMicroSeconds() const { return waitMicroSeconds; }
+	// the generation of the pinned session, it changes when the session key is pinned to a new session, 0 - not pinned
+	uint64_t getGeneration() const { return generation; }
+
+	// return the session to the pool before the lease is destroyed
+	void release();
+private:
+	friend class QConnectPool;
+	std::shared_ptr<QConnectPoolEntry> entry;
+	sql::Connection * connect = nullptr;
+	QConnectLane lane = METADATA_LANE;
+	uint64_t sessionKey = 0;
+	uint64_t waitMicroSeconds = 0;
+	uint64_t generation = 0;
+};
+
+class QConnectPool {
+public:
+	// Create a new session, called without holding the pool lock
+	typedef std::function<sql::Connection * ()> ConnectionCreator;
+
+	QConnectPool();
+	~QConnectPool();
+
+	QConnectLease acquire(uint64_t connectId, QConnectLane lane, const ConnectionCreator & creator, uint64_t sessionKey = 0);
+	void releaseSession(uint64_t connectId, QConnectLane lane, uint64_t sessionKey, bool discard = false);
+
+	void close(uint64_t connectId);
+	void closeAll();
+	size_t reapIdle();
+	bool empty();
+
+	void setLaneOptions(QConnectLane lane, const QConnectLaneOptions & options);
+	const QConnectLaneOptions & getLaneOptions(QConnectLane lane) const;
+
+	QConnectPoolStats getStats(uint64_t connectId);
+	QConnectPoolStatsList getAllStats();
+private:
+	friend class QConnectLease;
+
+	std::mutex mutex;
+	std::unordered_map<uint64_t, std::shared_ptr<QConnectPoolEntry>> entries;
+	QConnectLaneOptions laneOptions[LANE_COUNT];
+	std::chrono::steady_clock::time_point lastReapAt;
+
+	std::shared_ptr<QConnectPoolEntry> getOrCreateEntry(uint64_t connectId);
+	static void giveBack(const std::shared_ptr<QConnectPoolEntry> & entry, QConnectLane lane, sql::Connection * connect, uint64_t sessionKey);
+	static void destroyConnect(sql::Connection * connect);
+	static bool validateConnect(sql::Connection * connect);
+	static void setReconnect(sql::Connection * connect, bool reconnect);
+	void reapIfDue();
+};
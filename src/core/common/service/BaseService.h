@@ -2,6 +2,7 @@
 
 #include <unordered_map>
 #include <string>
+#include <mutex>
 #include "utils/ThreadUtil.h"
 
 /**
@@ -28,7 +29,10 @@ public:
 protected:
 	static T * theInstance;
 	static R * theRepository;
+	static std::recursive_mutex instanceMutex; // recursive, the constructor and destructor may call getRepository()
 
+	// the errors of the threads, guarded by errorMutex
+	std::mutex errorMutex;
 	std::unordered_map<unsigned long, std::string> errorCode;
 	std::unordered_map<unsigned long, std::string> errorMsg;
 
@@ -42,10 +46,15 @@ T * BaseService<T, R>::theInstance = nullptr;
 template <typename T, typename R> 
 R * BaseService<T, R>::theRepository = nullptr;
 
+template <typename T, typename R> 
+std::recursive_mutex BaseService<T, R>::instanceMutex;
+
 
 template <typename T, typename R>
 T * BaseService<T, R>::getInstance()
 {
+	// the services are used by the worker threads too, the first call may be in any thread
+	std::lock_guard<std::recursive_mutex> lk(BaseService<T, R>::instanceMutex);
 	if (BaseService<T, R>::theInstance == nullptr) {
 		BaseService<T, R>::theInstance = new T();
 	}
@@ -56,6 +65,7 @@ T * BaseService<T, R>::getInstance()
 template <typename T, typename R>
 R * BaseService<T, R>::getRepository()
 {
+	std::lock_guard<std::recursive_mutex> lk(BaseService<T, R>::instanceMutex);
 	if (BaseService<T, R>::theRepository == nullptr) {
 		BaseService<T, R>::theRepository = R::getInstance();
 	}
@@ -76,6 +86,7 @@ inline BaseService<T, R>::~BaseService()
 template<typename T, typename R>
 void BaseService<T, R>::destroyInstance()
 {
+	std::lock_guard<std::recursive_mutex> lk(BaseService<T, R>::instanceMutex);
 	if (BaseService<T, R>::theInstance != nullptr) {
 		delete BaseService<T, R>::theInstance;
 		BaseService<T, R>::theInstance = nullptr;
@@ -87,6 +98,7 @@ template <typename T, typename R>
 std::string & BaseService<T, R>::getErrorCode()
 {
 	unsigned long theadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
 	return errorCode[theadId];
 }
 
@@ -94,6 +106,7 @@ template <typename T, typename R>
 std::string & BaseService<T, R>::getErrorMsg()
 {
 	unsigned long theadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
 	return errorMsg[theadId];
 }
 
@@ -101,6 +114,7 @@ template <typename T, typename R>
 void BaseService<T, R>::setErrorCode(std::string code)
 {
 	unsigned long theadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
 	errorCode[theadId] = code;
 }
 
@@ -108,6 +122,7 @@ template <typename T, typename R>
 void BaseService<T, R>::setErrorMsg(std::string msg)
 {
 	unsigned long theadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
 	errorMsg[theadId] = msg;
 }
 
@@ -115,6 +130,7 @@ template <typename T, typename R>
 void BaseService<T, R>::setError(std::string code, std::string  msg)
 {
 	unsigned long theadId = ThreadUtil::currentThreadId();
+	std::lock_guard<std::mutex> lk(errorMutex);
 	errorCode[theadId] = code;
 	errorMsg[theadId] = msg;
 }
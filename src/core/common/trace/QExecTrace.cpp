@@ -0,0 +1,193 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QExecTrace.cpp
+ * @brief  QExecTrace - The phase timing of one sql execution.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-28
+ *********************************************************************/
+#include "QExecTrace.h"
+#include <cstdio>
+#include <functional>
+#include <sstream>
+#include <thread>
+
+const char * QExecTrace::CHECKOUT = "checkout";
+const char * QExecTrace::SET_SCHEMA = "schema";
+const char * QExecTrace::EXECUTE = "execute";
+const char * QExecTrace::FIRST_ROW = "first row";
+const char * QExecTrace::FETCH = "fetch";
+const char * QExecTrace::CONVERT = "convert";
+const char * QExecTrace::RENDER = "render";
+
+QExecTrace::QExecTrace(const std::string & sql) : sql(sql), beginAt(std::chrono::steady_clock::now())
+{
+}
+
+void QExecTrace::addSpan(const char * name, TimePoint begin, TimePoint end)
+{
+	addSpan(name, begin, end, end - begin, 1);
+}
+
+void QExecTrace::addSpan(const char * name, TimePoint begin, TimePoint end, std::chrono::steady_clock::duration duration, uint64_t count)
+{
+	if (!count) {
+		return;
+	}
+	int64_t beginUs = std::chrono::duration_cast<std::chrono::microseconds>(begin - beginAt).count();
+	int64_t endUs = std::chrono::duration_cast<std::chrono::microseconds>(end - beginAt).count();
+	int64_t durationUs = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+	uint32_t threadId = static_cast<uint32_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+
+	std::lock_guard<std::mutex> lk(mutex);
+	for (auto & span : spans) {
+		if (span.name == name && span.threadId == threadId) {
+			span.endMicroSeconds = endUs;
+			span.durationMicroSeconds += durationUs;
+			span.count += count;
+			return;
+		}
+	}
+	QTraceSpan span;
+	span.name = name;
+	span.beginMicroSeconds = beginUs;
+	span.endMicroSeconds = endUs;
+	span.durationMicroSeconds = durationUs;
+	span.count = count;
+	span.threadId = threadId;
+	spans.push_back(span);
+}
+
+QTraceSpanList QExecTrace::getSpans()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	return spans;
+}
+
+bool QExecTrace::hasSpan(const char * name)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	for (auto & span : spans) {
+		if (span.name == name) {
+			return true;
+		}
+	}
+	return false;
+}
+
+int64_t QExecTrace::getMicroSeconds(const char * name)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	int64_t microSeconds = 0;
+	for (auto & span : spans) {
+		if (span.name == name) {
+			microSeconds += span.durationMicroSeconds;
+		}
+	}
+	return microSeconds;
+}
+
+/**
+ * The span as PerfTime for the ResultInfo::execTime.
+ * 
+ * @param name
+ * @return 
+ */
+PerfTime QExecTrace::getPerfTime(const char * name)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	PerfTime perfTime;
+	perfTime.begin = beginAt;
+	perfTime.end = beginAt;
+	perfTime.elapsedMicroSeconds = 0;
+	for (auto & span : spans) {
+		if (span.name == name) {
+			perfTime.begin = beginAt + std::chrono::microseconds(span.beginMicroSeconds);
+			perfTime.end = beginAt + std::chrono::microseconds(span.endMicroSeconds);
+			perfTime.elapsedMicroSeconds = span.durationMicroSeconds;
+			break;
+		}
+	}
+	return perfTime;
+}
+
+std::string QExecTrace::toSummary()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	std::string summary;
+	for (auto & span : spans) {
+		if (!summary.empty()) {
+			summary.append(" ");
+		}
+		summary.append(span.name).append(":").append(formatMs(span.durationMicroSeconds));
+	}
+	return summary;
+}
+
+/**
+ * The Chrome trace event format, every span is a complete event ("ph":"X").
+ * The accumulated span begins at its first piece, "dur" is the sum of the pieces, 
+ * "args.wall" is the wall time from the first piece to the last piece.
+ * 
+ * @return JSON text
+ */
+std::string QExecTrace::toChromeTrace()
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	std::ostringstream oss;
+	oss << "{\"traceEvents\":[";
+	for (size_t i = 0; i < spans.size(); i++) {
+		auto & span = spans.at(i);
+		oss << (i ? "," : "") << "\n{\"name\":\"" << escapeJson(span.name) << "\",\"cat\":\"sql\",\"ph\":\"X\""
+			<< ",\"ts\":" << span.beginMicroSeconds << ",\"dur\":" << span.durationMicroSeconds
+			<< ",\"pid\":1,\"tid\":" << span.threadId
+			<< ",\"args\":{\"count\":" << span.count << ",\"wall\":" << (span.endMicroSeconds - span.beginMicroSeconds) << "}}";
+	}
+	oss << "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"sql\":\"" << escapeJson(sql) << "\"}}\n";
+	return oss.str();
+}
+
+std::string QExecTrace::formatMs(int64_t microSeconds)
+{
+	char buf[32];
+	if (microSeconds < 10000) {
+		std::snprintf(buf, sizeof(buf), "%.1fms", microSeconds / 1000.0);
+	} else {
+		std::snprintf(buf, sizeof(buf), "%lldms", static_cast<long long>(microSeconds / 1000));
+	}
+	return buf;
+}
+
+std::string QExecTrace::escapeJson(const std::string & str)
+{
+	std::string result;
+	result.reserve(str.size());
+	for (char ch : str) {
+		switch (ch) {
+		case '"': result.append("\\\""); break;
+		case '\\': result.append("\\\\"); break;
+		case '\n': result.append("\\n"); break;
+		case '\r': result.append("\\r"); break;
+		case '\t': result.append("\\t"); break;
+		default:
+			if (static_cast<unsigned char>(ch) < 0x20) {
+				char buf[8];
+				std::snprintf(buf, sizeof(buf), "\\u%04x", ch);
+				result.append(buf);
+			} else {
+				result.push_back(ch);
+			}
+		}
+	}
+	return result;
+}
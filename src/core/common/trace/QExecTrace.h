@@ -0,0 +1,103 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   QExecTrace.h
+ * @brief  QExecTrace - The phase timing of one sql execution, such as connection checkout, setSchema,
+ *         server execute, first row, fetch, type conversion and grid render.
+ *         The spans are recorded by the worker thread and the UI thread, they can be shown 
+ *         in the status bar or exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-28
+ *********************************************************************/
+#pragma once
+#include <cstdint>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "core/entity/Entity.h"
+
+// The span of one phase, the repeated phase (such as fetch of every row) is accumulated in one span
+typedef struct _QTraceSpan {
+	std::string name;
+	int64_t beginMicroSeconds = 0; // relative to the begin of the trace
+	int64_t endMicroSeconds = 0;   // the end of the last accumulated piece
+	int64_t durationMicroSeconds = 0; // the sum of the accumulated pieces
+	uint64_t count = 0;  // the count of the accumulated pieces
+	uint32_t threadId = 0;
+} QTraceSpan;
+typedef std::vector<QTraceSpan> QTraceSpanList;
+
+class QExecTrace {
+public:
+	// The span names
+	static const char * CHECKOUT;
+	static const char * SET_SCHEMA;
+	static const char * EXECUTE;
+	static const char * FIRST_ROW;
+	static const char * FETCH;
+	static const char * CONVERT;
+	static const char * RENDER;
+
+	typedef std::chrono::steady_clock::time_point TimePoint;
+
+	QExecTrace(const std::string & sql = std::string());
+
+	// record the piece [begin, end) of the span, the pieces with the same name are accumulated
+	void addSpan(const char * name, TimePoint begin, TimePoint end);
+	// record the pieces that have been accumulated by the caller, such as the fetch of the rows of one batch
+	void addSpan(const char * name, TimePoint begin, TimePoint end, std::chrono::steady_clock::duration duration, uint64_t count);
+
+	const std::string & getSql() const { return sql; }
+	TimePoint getBeginAt() const { return beginAt; }
+	QTraceSpanList getSpans();
+	bool hasSpan(const char * name);
+	// the accumulated duration of the span, 0 if it is not recorded
+	int64_t getMicroSeconds(const char * name);
+	PerfTime getPerfTime(const char * name);
+
+	// such as "checkout:0.1ms schema:0.3ms execute:12ms first row:15ms fetch:80ms convert:6ms render:3ms"
+	std::string toSummary();
+	std::string toChromeTrace();
+private:
+	std::mutex mutex;
+	std::string sql;
+	TimePoint beginAt;
+	QTraceSpanList spans;
+
+	static std::string formatMs(int64_t microSeconds);
+	static std::string escapeJson(const std::string & str);
+};
+
+/**
+ * QTraceScope - record the span from the construction to end() or the destruction, trace can be nullptr.
+ */
+class QTraceScope {
+public:
+	QTraceScope(QExecTrace * trace, const char * name) 
+		: trace(trace), name(name), beginAt(trace ? std::chrono::steady_clock::now() : QExecTrace::TimePoint()) {}
+	~QTraceScope() { end(); }
+	QTraceScope(const QTraceScope &) = delete;
+	QTraceScope & operator=(const QTraceScope &) = delete;
+
+	void end() {
+		if (trace) {
+			trace->addSpan(name, beginAt, std::chrono::steady_clock::now());
+			trace = nullptr;
+		}
+	}
+private:
+	QExecTrace * trace;
+	const char * name;
+	QExecTrace::TimePoint beginAt;
+};
@@ -289,6 +289,182 @@ typedef struct {
 	std::string sqlSetting;
 } ExportSqlParams, StructAndDataParams;
 
+// Duplicate database params, the objects are copied from the source schema to the target schema
+typedef struct _DbCopyParams {
+	uint64_t fromConnectId = 0;
+	std::string fromSchema;
+	uint64_t toConnectId = 0;
+	std::string toSchema;
+	std::vector<std::string> tables; // the tables to copy
+	std::vector<std::string> views; // the views to copy
+	bool routines = true; // procedures and functions
+	bool triggers = true;
+	bool events = true;
+	bool structOnly = false; // true - no rows are copied
+	bool lockTables = false; // true - LOCK TABLES ... READ in the source session while the rows are read
+	uint32_t threads = 4; // the tables are copied by the workers in parallel, every worker has a source and a target session
+	bool createDatabase = true; // false - the target database exists, such as duplicating one table
+	std::string toTable; // the target table name when one table is duplicated, empty - the same name as the source table
+} DbCopyParams;
+
+// The status of a table in the copy
+typedef enum {
+	COPY_TABLE_PENDING,
+	COPY_TABLE_COPYING,
+	COPY_TABLE_DONE,
+} CopyTableStatus;
+
+// The progress of a table in the copy, the estimates are TABLE_ROWS and DATA_LENGTH of information_schema.TABLES
+typedef struct _DbCopyTableProgress {
+	std::string name;
+	CopyTableStatus status = COPY_TABLE_PENDING;
+	uint64_t estimatedRows = 0; // approximate for InnoDB
+	uint64_t estimatedBytes = 0;
+	uint64_t copiedRows = 0;
+	uint64_t copiedBytes = 0; // the bytes that are sent to the target
+} DbCopyTableProgress;
+
+// The progress of the copy, it is published by QDbCopier every QDbCopier::REPORT_INTERVAL_MS
+typedef struct _DbCopyProgress {
+	std::string step; // "database", "tables", "rows", "views", "objects"
+	int percent = 0;
+	uint64_t estimatedRows = 0;
+	uint64_t estimatedBytes = 0;
+	uint64_t copiedRows = 0;
+	uint64_t copiedBytes = 0;
+	uint32_t doneTables = 0;
+	uint64_t elapsedMs = 0;
+	double rowsPerSecond = 0;
+	double bytesPerSecond = 0;
+	int64_t etaSeconds = -1; // -1 - unknown
+	std::vector<DbCopyTableProgress> tables;
+} DbCopyProgress;
+
+// The checkpoint of the chunked table copy, it is saved in the system db after every committed chunk
+typedef struct _CopyCheckpoint {
+	std::string jobKey; // the source table and the target table, see QDbCopier::getJobKey(...)
+	std::string lastKey; // the values tuple of the primary key of the last copied row, such as "(100,'a')"
+	uint64_t copiedRows = 0;
+	std::string createdAt;
+	std::string updatedAt;
+} CopyCheckpoint;
+
+// The metadata object of the snapshot in the system db, the tree is shown from the snapshot before the server responds.
+// It has the fields of the object lists that the tree shows, see MetadataService::restoreSnapshot(...)
+typedef struct _MetadataSnapshotItem {
+	uint64_t connectId = 0;
+	std::string schema; // empty for the databases of the connection
+	std::string object; // the cached object list, such as "databases", "tables", "procedures"
+	std::string catalog;
+	std::string name;
+	std::string type;
+	std::string remarks;
+} MetadataSnapshotItem;
+typedef std::vector<MetadataSnapshotItem> MetadataSnapshotItemList;
+
+// The fingerprints of the object lists of a schema, such as "tables" => "count:crc32 of names:max time",
+// a list is loaded again only if its fingerprint is changed, see UserDbRepository::getSchemaFingerprint(...)
+typedef std::map<std::string, std::string> SchemaFingerprint;
+
+// Import a sql script into the database in process, see QSqlImporter
+typedef struct _SqlImportParams {
+	uint64_t connectId = 0;
+	std::string schema; // the default database of the script, empty - the script uses USE or the full names
+	std::string filePath; // the sql file, it is streamed, so it can be larger than the memory
+	std::string sql; // the script text, it is used if filePath is empty
+	bool continueOnError = false; // true - the failed statement is logged and skipped
+	uint64_t startOffset = 0; // resume from SqlImportProgress::committedOffset, the SET and USE statements before it are replayed
+} SqlImportParams;
+
+// A failed statement of the import, it is kept if continueOnError
+typedef struct _SqlImportError {
+	uint64_t offset = 0; // the byte offset of the end of the statement
+	std::string code;
+	std::string message;
+	std::string sql; // the head of the statement
+} SqlImportError;
+
+// The progress of the import, it is published by QSqlImporter every QSqlImporter::REPORT_INTERVAL_MS
+typedef struct _SqlImportProgress {
+	int percent = 0;
+	uint64_t totalBytes = 0; // the size of the file (or the sql text)
+	uint64_t readBytes = 0;
+	uint64_t committedOffset = 0; // the statements before it have been committed, resume from here
+	uint64_t statements = 0; // the executed statements
+	uint64_t failedStatements = 0;
+	uint64_t elapsedMs = 0;
+	double statementsPerSecond = 0;
+	double bytesPerSecond = 0;
+	int64_t etaSeconds = -1; // -1 - unknown
+	std::vector<SqlImportError> errors; // the first QSqlImporter::MAX_KEPT_ERRORS errors
+} SqlImportProgress;
+
+// The compression of the exported sql file
+typedef enum {
+	SQL_EXPORT_GZIP, // .sql.gz
+	SQL_EXPORT_NONE, // .sql
+} SqlExportCompression;
+
+// Export the databases as a sql script, see QSqlExporter
+typedef struct _SqlExportParams {
+	uint64_t connectId = 0;
+	std::vector<std::string> schemas; // the exported databases, all databases of the connection are exported as one script
+	std::vector<std::string> tables; // the tables and their triggers when one database is exported, empty - all objects
+	bool structOnly = false;
+	bool createDatabase = false; // CREATE DATABASE IF NOT EXISTS and USE before the objects of every database
+	SqlExportCompression compression = SQL_EXPORT_GZIP;
+	std::string filePath;
+} SqlExportParams;
+
+// The progress of the export, it is published by QSqlExporter every QSqlExporter::REPORT_INTERVAL_MS
+typedef struct _SqlExportProgress {
+	int percent = 0;
+	std::string schema; // the exporting database and table
+	std::string table;
+	uint32_t doneTables = 0;
+	uint32_t totalTables = 0;
+	uint64_t exportedRows = 0;
+	uint64_t sqlBytes = 0; // the bytes of the sql script before the compression
+	uint64_t fileBytes = 0; // the bytes that are written to the file
+	uint64_t elapsedMs = 0;
+	double rowsPerSecond = 0;
+	double bytesPerSecond = 0; // sqlBytes per second
+	int64_t etaSeconds = -1; // -1 - unknown
+} SqlExportProgress;
+
+// The format of the parallel table export
+typedef enum {
+	TABLE_EXPORT_CSV,
+	TABLE_EXPORT_SQL, // multi-row INSERT statements, the values are escaped by the backslash
+} TableExportFormat;
+
+// Export one table by the ranges of the primary key over several sessions in parallel, see QTableExporter
+typedef struct _TableExportParams {
+	uint64_t connectId = 0;
+	std::string schema;
+	std::string tblName;
+	TableExportFormat format = TABLE_EXPORT_CSV;
+	ExportCsvParams csvParams; // the CSV dialect, the empty terminators are ',' and '\n'
+	std::string filePath; // the merged file, the part files are "<filePath>.part0001"...
+	bool mergeParts = true; // true - the parts are merged in order into filePath, false - one file per range
+	uint32_t threads = 4; // the parallel sessions, limited by the free sessions of the pool
+	uint32_t ranges = 0; // the ranges of the primary key, 0 - threads * 4
+} TableExportParams;
+
+// The progress of the parallel table export
+typedef struct _TableExportProgress {
+	int percent = 0;
+	uint32_t doneRanges = 0;
+	uint32_t totalRanges = 0;
+	uint64_t exportedRows = 0;
+	uint64_t estimatedRows = 0; // TABLE_ROWS of information_schema.TABLES
+	uint64_t fileBytes = 0;
+	uint64_t elapsedMs = 0;
+	double rowsPerSecond = 0;
+	double bytesPerSecond = 0;
+	int64_t etaSeconds = -1; // -1 - unknown
+} TableExportProgress;
+
 typedef std::vector<std::string> ExportSelectedColumns;
 
 // the data structure for show in list view or export
@@ -322,6 +498,13 @@ typedef struct {
 	std::string param;
 } TblStatementParams;
 
+// The delta of a session status variable (SHOW SESSION STATUS) around the execution of a statement
+typedef struct _StatusDelta {
+	std::string name;
+	int64_t delta = 0;
+} StatusDelta;
+typedef std::vector<StatusDelta> StatusDeltas;
+
 // Execute sql result
 typedef struct _ResultInfo {	
 	int effectRows = 0;
@@ -331,6 +514,7 @@ typedef struct _ResultInfo {
 	std::string sql;
 	int code = 0;
 	std::string msg;
+	StatusDeltas statusDeltas; // the changed session status of the statement, empty if it is not captured
 
 	// Extend for sql log
 	uint64_t id = 0;
@@ -46,6 +46,43 @@ ColumnInfoList TableColumnRepository::getAll(uint64_t connectId, const std::stri
     return result;
 }
 
+/**
+ * Get the columns of all tables and views in the schema from information_schema.COLUMNS.
+ * The rows are streamed (mysql_use_result), and the columns are the same as DatabaseMetaData::getColumns of a table.
+ * 
+ * @param connectId
+ * @param schema
+ * @return ColumnInfoList
+ */
+ColumnInfoList TableColumnRepository::getAllOfSchema(uint64_t connectId, const std::string& schema)
+{
+	assert(connectId > 0 && !schema.empty());
+	ColumnInfoList result;
+	try {
+		sql::SQLString sql = "SELECT `TABLE_CATALOG`, `TABLE_SCHEMA`, `TABLE_NAME`, `COLUMN_NAME`, `DATA_TYPE`, `COLUMN_TYPE`, "
+			"COALESCE(`CHARACTER_MAXIMUM_LENGTH`, `NUMERIC_PRECISION`, `DATETIME_PRECISION`, 0) AS `COLUMN_SIZE`, "
+			"`COLUMN_DEFAULT`, `IS_NULLABLE`, `COLUMN_COMMENT`, `EXTRA` "
+			"FROM `information_schema`.`COLUMNS` WHERE `TABLE_SCHEMA`=? ORDER BY `TABLE_NAME`, `ORDINAL_POSITION`";
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement(sql));
+		stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+		stmt->setString(1, schema);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+		while (resultSet->next()) {
+			ColumnInfo item = toSchemaColumnInfo(resultSet.get());
+			result.push_back(item);
+		}
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getAllOfSchema(),code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
 bool TableColumnRepository::remove(uint64_t connectId, const std::string& schema, const std::string& tableName, const std::string& columnName)
 {
 	assert(connectId > 0 && !schema.empty() && !tableName.empty() && !columnName.empty());
@@ -87,3 +124,23 @@ ColumnInfo TableColumnRepository::toColumnInfo(sql::ResultSet* rs)
 	
 	return result;
 }
+
+ColumnInfo TableColumnRepository::toSchemaColumnInfo(sql::ResultSet* rs)
+{
+	ColumnInfo result;
+	result.catalog = rs->getString("TABLE_CATALOG").asStdString();
+	result.schema = StringUtil::converFromUtf8(rs->getString("TABLE_SCHEMA").asStdString());
+	result.table = StringUtil::converFromUtf8(rs->getString("TABLE_NAME").asStdString());
+	result.name = StringUtil::converFromUtf8(rs->getString("COLUMN_NAME").asStdString());
+	// TYPE_NAME of getColumns, such as "INT UNSIGNED"
+	result.type = StringUtil::toupper(rs->getString("DATA_TYPE").asStdString());
+	result.un = (StringUtil::toupper(rs->getString("COLUMN_TYPE").asStdString()).find("UNSIGNED") != std::string::npos) ? 1 : 0;
+	result.fullType = !result.un ? result.type : result.type + " UNSIGNED";
+	result.size = rs->getUInt64("COLUMN_SIZE");
+	result.defVal = rs->getString("COLUMN_DEFAULT").asStdString();
+	result.isNullable = rs->getString("IS_NULLABLE") == "YES";
+	result.remarks = StringUtil::converFromUtf8(rs->getString("COLUMN_COMMENT").asStdString());
+	result.ai = rs->getString("EXTRA").asStdString().find("auto_increment") != std::string::npos;
+
+	return result;
+}
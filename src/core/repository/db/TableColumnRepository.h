@@ -23,8 +23,11 @@ class TableColumnRepository : public BaseUserRepository<TableColumnRepository>
 {
 public:
 	ColumnInfoList getAll(uint64_t connectId, const std::string& schema, const std::string & tableName);
+	// the columns of all tables and views in the schema by one query, ordered by the table and the position
+	ColumnInfoList getAllOfSchema(uint64_t connectId, const std::string& schema);
 	bool remove(uint64_t connectId, const std::string& schema, const std::string& tableName, const std::string& columnName);
 private:
 	ColumnInfo toColumnInfo(sql::ResultSet* rs);
+	ColumnInfo toSchemaColumnInfo(sql::ResultSet* rs);
 };
 
@@ -49,6 +49,46 @@ IndexInfoList TableIndexRepository::getAll(uint64_t connectId, const std::string
     return result;
 }
 
+/**
+ * Get the index columns of all tables in the schema from information_schema.STATISTICS, 
+ * the indexes of the foreign keys are marked by information_schema.KEY_COLUMN_USAGE.
+ * The rows are streamed (mysql_use_result), and the columns are the same as DatabaseMetaData::getIndexInfo of a table.
+ * 
+ * @param connectId
+ * @param schema
+ * @return IndexInfoList
+ */
+IndexInfoList TableIndexRepository::getAllOfSchema(uint64_t connectId, const std::string& schema)
+{
+	assert(connectId > 0 && !schema.empty());
+	IndexInfoList result;
+	try {
+		auto connect = getUserConnect(connectId);
+		std::set<std::string> foreignKeys = getForeignKeysOfSchema(connect.get(), schema);
+
+		sql::SQLString sql = "SELECT `TABLE_CATALOG`, `TABLE_SCHEMA`, `TABLE_NAME`, `INDEX_NAME`, `INDEX_TYPE`, `COLUMN_NAME`, `NON_UNIQUE` "
+			"FROM `information_schema`.`STATISTICS` WHERE `TABLE_SCHEMA`=? "
+			"ORDER BY `TABLE_NAME`, `NON_UNIQUE`, `INDEX_NAME`, `SEQ_IN_INDEX`";
+		std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement(sql));
+		stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+		stmt->setString(1, schema);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+		while (resultSet->next()) {
+			IndexInfo item = toSchemaIndexInfo(resultSet.get());
+			item.fk = foreignKeys.count(item.table + "\n" + item.name) ? 1 : 0;
+			result.push_back(item);
+		}
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getAllOfSchema(),code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
 bool TableIndexRepository::remove(uint64_t connectId, const std::string& schema, const std::string& tableName, const std::string& indexName)
 {
 	assert(connectId > 0 && !schema.empty() && !tableName.empty() && !indexName.empty());
@@ -87,3 +127,44 @@ IndexInfo TableIndexRepository::toIndexInfo(sql::ResultSet* rs)
 	
 	return result;
 }
+
+IndexInfo TableIndexRepository::toSchemaIndexInfo(sql::ResultSet* rs)
+{
+	IndexInfo result;
+	result.catalog = rs->getString("TABLE_CATALOG").asStdString();
+	result.schema = StringUtil::converFromUtf8(rs->getString("TABLE_SCHEMA").asStdString());
+	result.table = StringUtil::converFromUtf8(rs->getString("TABLE_NAME").asStdString());
+	result.name = StringUtil::converFromUtf8(rs->getString("INDEX_NAME").asStdString());
+	// TYPE of getIndexInfo: DatabaseMetaData::tableIndexHashed or tableIndexOther
+	result.type = rs->getString("INDEX_TYPE") == "HASH" ? "2" : "3";
+	result.columns = StringUtil::converFromUtf8(rs->getString("COLUMN_NAME").asStdString());
+	result.un = rs->getString("NON_UNIQUE") == "0";
+	result.pk = result.name == "PRIMARY";
+
+	return result;
+}
+
+/**
+ * The foreign key constraints of the schema, the caller catches sql::SQLException.
+ * 
+ * @param connect
+ * @param schema
+ * @return "table\nconstraint", the names are converted as IndexInfo
+ */
+std::set<std::string> TableIndexRepository::getForeignKeysOfSchema(sql::Connection * connect, const std::string& schema)
+{
+	std::set<std::string> result;
+	sql::SQLString sql = "SELECT DISTINCT `TABLE_NAME`, `CONSTRAINT_NAME` FROM `information_schema`.`KEY_COLUMN_USAGE` "
+		"WHERE `TABLE_SCHEMA`=? AND `REFERENCED_TABLE_NAME` IS NOT NULL";
+	std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement(sql));
+	stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+	stmt->setString(1, schema);
+	std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+	while (resultSet->next()) {
+		result.insert(StringUtil::converFromUtf8(resultSet->getString("TABLE_NAME").asStdString()) + "\n"
+			+ StringUtil::converFromUtf8(resultSet->getString("CONSTRAINT_NAME").asStdString()));
+	}
+	resultSet->close();
+	stmt->close();
+	return result;
+}
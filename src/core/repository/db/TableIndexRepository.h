@@ -18,13 +18,19 @@
  *********************************************************************/
 #pragma once
 #include "core/common/repository/BaseUserRepository.h"
+#include <set>
 #include "core/entity/Entity.h"
 class TableIndexRepository : public BaseUserRepository<TableIndexRepository>
 {
 public:
 	IndexInfoList getAll(uint64_t connectId, const std::string& schema, const std::string & tableName);
+	// the index columns of all tables in the schema by two queries, ordered by the table, the index and the position
+	IndexInfoList getAllOfSchema(uint64_t connectId, const std::string& schema);
 	bool remove(uint64_t connectId, const std::string& schema, const std::string& tableName, const std::string& indexName);
 private:
 	IndexInfo toIndexInfo(sql::ResultSet* rs);
+	IndexInfo toSchemaIndexInfo(sql::ResultSet* rs);
+	// "table\nconstraint" of the foreign keys in the schema
+	std::set<std::string> getForeignKeysOfSchema(sql::Connection * connect, const std::string& schema);
 };
 
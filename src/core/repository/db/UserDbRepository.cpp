@@ -81,7 +81,8 @@ UserDbList UserDbRepository::getAllByConnectId(uint64_t connectId)
 	UserDbList result;
 	
 	try {
-		std::unique_ptr<sql::ResultSet> resultSet(getUserConnect(connectId)->getMetaData()->getSchemas());
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::ResultSet> resultSet(connect->getMetaData()->getSchemas());
 		while (resultSet->next()) {
 			UserDb item = toUserDb(connectId, resultSet.get());
 			result.push_back(item);
@@ -97,6 +98,587 @@ UserDbList UserDbRepository::getAllByConnectId(uint64_t connectId)
 }
 
 
+/**
+ * Execute the statement in the pinned session of QUERY_LANE, the session keeps the variables and locks between the statements.
+ * 
+ * @param connectId
+ * @param schema - empty if the schema of the session is not changed
+ * @param sql
+ * @param sessionKey - the pinned session
+ */
+void UserDbRepository::executeInSession(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey)
+{
+	assert(connectId > 0 && !sql.empty() && sessionKey > 0);
+	try {
+		auto connect = getUserConnect(connectId, QUERY_LANE, sessionKey);
+		if (!schema.empty()) {
+			connect->setSchema(schema);
+		}
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		stmt->execute(sql);
+		stmt->close();
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to executeInSession(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Execute the INSERT, UPDATE or DELETE statement in the pinned session of QUERY_LANE.
+ * 
+ * @param connectId
+ * @param schema - empty if the schema of the session is not changed
+ * @param sql
+ * @param sessionKey - the pinned session
+ * @return the affected rows
+ */
+uint64_t UserDbRepository::executeUpdateInSession(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey)
+{
+	assert(connectId > 0 && !sql.empty() && sessionKey > 0);
+	try {
+		auto connect = getUserConnect(connectId, QUERY_LANE, sessionKey);
+		if (!schema.empty()) {
+			connect->setSchema(schema);
+		}
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		int rows = stmt->executeUpdate(sql);
+		stmt->close();
+		return rows > 0 ? static_cast<uint64_t>(rows) : 0;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to executeUpdateInSession(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Read the rows by an unbuffered, forward-only result set and convert every row to the values tuple of INSERT.
+ * Numbers are kept as the text of the server, binary columns are written as X'..', the other values are quoted 
+ * with the quote doubled and the backslash escaped, so the tuples are parsed by the sessions without NO_BACKSLASH_ESCAPES.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sql - SELECT statement
+ * @param sessionKey - the pinned session
+ * @param reader - return false to stop reading, the unread rows are discarded
+ * @param keyColumnCount - the last columns of the SELECT are the key of the row, they are passed as keyTuple
+ * @param asLoadDataLine - the values are written as a line of LOAD DATA ... CHARACTER SET utf8mb4 with the default
+ *                         FIELDS and LINES options, the key tuple is still the values tuple
+ */
+void UserDbRepository::readRowTuples(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey, 
+	const RowTupleReader& reader, uint32_t keyColumnCount, bool asLoadDataLine)
+{
+	assert(connectId > 0 && !sql.empty() && sessionKey > 0 && reader);
+	static const char * hexDigits = "0123456789ABCDEF";
+	try {
+		auto connect = getUserConnect(connectId, QUERY_LANE, sessionKey);
+		if (!schema.empty()) {
+			connect->setSchema(schema);
+		}
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery(sql));
+
+		auto metaData = resultSet->getMetaData();
+		uint32_t columnCount = metaData->getColumnCount();
+		assert(keyColumnCount < columnCount);
+		uint32_t valueColumnCount = columnCount - keyColumnCount;
+		// 0 - quoted text, 1 - number, 2 - binary
+		std::vector<int> kinds;
+		for (uint32_t i = 1; i <= columnCount; i++) {
+			switch (metaData->getColumnType(i)) {
+			case sql::DataType::TINYINT:
+			case sql::DataType::SMALLINT:
+			case sql::DataType::MEDIUMINT:
+			case sql::DataType::INTEGER:
+			case sql::DataType::BIGINT:
+			case sql::DataType::REAL:
+			case sql::DataType::DOUBLE:
+			case sql::DataType::DECIMAL:
+			case sql::DataType::NUMERIC:
+			case sql::DataType::BIT: // the connector returns the number of BIT, such as "5"
+				kinds.push_back(1);
+				break;
+			case sql::DataType::BINARY:
+			case sql::DataType::VARBINARY:
+			case sql::DataType::LONGVARBINARY:
+			case sql::DataType::GEOMETRY:
+				kinds.push_back(2);
+				break;
+			default:
+				kinds.push_back(0);
+				break;
+			}
+		}
+
+		std::string tuple, keyTuple;
+		while (resultSet->next()) {
+			tuple.clear();
+			keyTuple.clear();
+			for (uint32_t i = 1; i <= columnCount; i++) {
+				std::string & out = i <= valueColumnCount ? tuple : keyTuple;
+				bool isLine = asLoadDataLine && i <= valueColumnCount;
+				if (isLine) {
+					if (i > 1) {
+						out.push_back('\t');
+					}
+				} else {
+					out.push_back(i == 1 || i == valueColumnCount + 1 ? '(' : ',');
+				}
+				if (resultSet->isNull(i)) {
+					out.append(isLine ? "\\N" : "NULL");
+					continue;
+				}
+				sql::SQLString val = resultSet->getString(i);
+				const std::string & bytes = val.asStdString();
+				if (isLine) {
+					for (char ch : bytes) {
+						switch (ch) {
+						case '\\': out.append("\\\\"); break;
+						case '\t': out.append("\\t"); break;
+						case '\n': out.append("\\n"); break;
+						case '\0': out.append("\\0"); break;
+						default: out.push_back(ch); break;
+						}
+					}
+				} else if (kinds[i - 1] == 1) {
+					out.append(bytes);
+				} else if (kinds[i - 1] == 2) {
+					if (bytes.empty()) {
+						out.append("''");
+						continue;
+					}
+					out.append("X'");
+					for (unsigned char ch : bytes) {
+						out.push_back(hexDigits[ch >> 4]);
+						out.push_back(hexDigits[ch & 0x0F]);
+					}
+					out.push_back('\'');
+				} else {
+					out.push_back('\'');
+					for (char ch : bytes) {
+						if (ch == '\'') {
+							out.push_back('\'');
+						} else if (ch == '\\') {
+							out.push_back('\\');
+						}
+						out.push_back(ch);
+					}
+					out.push_back('\'');
+				}
+			}
+			tuple.push_back(asLoadDataLine ? '\n' : ')');
+			if (keyColumnCount) {
+				keyTuple.push_back(')');
+			}
+			if (!reader(tuple, keyTuple)) {
+				break;
+			}
+		}
+		resultSet->close();
+		stmt->close();
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to readRowTuples(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Read the rows of the SELECT in the pinned session one by one as the raw values, for the exports that format 
+ * the values by themselves (such as CSV). The rows are streamed, the result set is not buffered in the client.
+ * 
+ * @param connectId
+ * @param sql - SELECT statement
+ * @param sessionKey
+ * @param reader - called for every row, return false to stop reading
+ */
+void UserDbRepository::readRowValues(uint64_t connectId, const std::string& sql, uint64_t sessionKey, const RowValuesReader& reader)
+{
+	assert(connectId > 0 && !sql.empty() && sessionKey > 0 && reader);
+	try {
+		auto connect = getUserConnect(connectId, QUERY_LANE, sessionKey);
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery(sql));
+
+		uint32_t columnCount = resultSet->getMetaData()->getColumnCount();
+		std::vector<std::string> values(columnCount);
+		std::vector<bool> nulls(columnCount);
+		while (resultSet->next()) {
+			for (uint32_t i = 1; i <= columnCount; i++) {
+				nulls[i - 1] = resultSet->isNull(i);
+				if (nulls[i - 1]) {
+					values[i - 1].clear();
+				} else {
+					values[i - 1] = resultSet->getString(i).asStdString();
+				}
+			}
+			if (!reader(values, nulls)) {
+				break;
+			}
+		}
+		resultSet->close();
+		stmt->close();
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to readRowValues(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Execute LOAD DATA LOCAL INFILE in the pinned session. LOCAL INFILE is enabled for this statement only,
+ * so the server can not read the local files by the other statements of the session.
+ * 
+ * @param connectId
+ * @param sql - LOAD DATA LOCAL INFILE statement
+ * @param sessionKey - the pinned session
+ */
+void UserDbRepository::loadDataInSession(uint64_t connectId, const std::string& sql, uint64_t sessionKey)
+{
+	assert(connectId > 0 && !sql.empty() && sessionKey > 0);
+	int enable = 1, disable = 0;
+	try {
+		auto connect = getUserConnect(connectId, QUERY_LANE, sessionKey);
+		connect->setClientOption("OPT_LOCAL_INFILE", &enable);
+		try {
+			std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+			stmt->execute(sql);
+			stmt->close();
+		} catch (sql::SQLException& ex) {
+			connect->setClientOption("OPT_LOCAL_INFILE", &disable);
+			throw ex;
+		}
+		connect->setClientOption("OPT_LOCAL_INFILE", &disable);
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to loadDataInSession(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Unpin the session, the session returns to the pool.
+ * 
+ * @param connectId
+ * @param sessionKey
+ * @param discard - the session is closed instead, the imported script may have changed its variables
+ */
+void UserDbRepository::releaseSession(uint64_t connectId, uint64_t sessionKey, bool discard)
+{
+	QConnect::userConnectPool.releaseSession(connectId, QUERY_LANE, sessionKey, discard);
+}
+
+/**
+ * The sql_mode of the pinned session, it is changed by SET statements of the imported script.
+ * 
+ * @param connectId
+ * @param sessionKey
+ * @return 
+ */
+std::string UserDbRepository::getSessionSqlMode(uint64_t connectId, uint64_t sessionKey)
+{
+	assert(connectId > 0 && sessionKey > 0);
+	std::string result;
+	try {
+		auto connect = getUserConnect(connectId, QUERY_LANE, sessionKey);
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery("SELECT @@SESSION.sql_mode"));
+		if (resultSet->next()) {
+			result = resultSet->getString(1).asStdString();
+		}
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getSessionSqlMode(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * The columns that accept the values of INSERT, the generated columns are excluded and the invisible columns are included.
+ * 
+ * @param connectId
+ * @param schema
+ * @param tblName
+ * @return the column names in the ordinal position
+ */
+Columns UserDbRepository::getInsertableColumns(uint64_t connectId, const std::string& schema, const std::string& tblName)
+{
+	assert(connectId > 0 && !schema.empty() && !tblName.empty());
+	Columns result;
+	try {
+		sql::SQLString sql = "SELECT `COLUMN_NAME` FROM `information_schema`.`COLUMNS` WHERE `TABLE_SCHEMA`=? AND `TABLE_NAME`=? "
+			"AND `EXTRA` NOT LIKE '%VIRTUAL GENERATED%' AND `EXTRA` NOT LIKE '%STORED GENERATED%' ORDER BY `ORDINAL_POSITION`";
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement(sql));
+		stmt->setString(1, schema);
+		stmt->setString(2, tblName);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+		while (resultSet->next()) {
+			result.push_back(resultSet->getString(1).asStdString());
+		}
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getInsertableColumns(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Get the columns of the primary key in the order of the key, the table copy is split into the ranges of the key.
+ * 
+ * @param connectId
+ * @param schema
+ * @param tblName
+ * @return empty if the table has no primary key
+ */
+Columns UserDbRepository::getPrimaryKeyColumns(uint64_t connectId, const std::string& schema, const std::string& tblName)
+{
+	assert(connectId > 0 && !schema.empty() && !tblName.empty());
+	Columns result;
+	try {
+		sql::SQLString sql = "SELECT `COLUMN_NAME` FROM `information_schema`.`KEY_COLUMN_USAGE` WHERE `TABLE_SCHEMA`=? AND `TABLE_NAME`=? "
+			"AND `CONSTRAINT_NAME`='PRIMARY' ORDER BY `ORDINAL_POSITION`";
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement(sql));
+		stmt->setString(1, schema);
+		stmt->setString(2, tblName);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+		while (resultSet->next()) {
+			result.push_back(resultSet->getString(1).asStdString());
+		}
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getPrimaryKeyColumns(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Get the identity of the MySQL server of the connection, two connections with the same identity are the same server,
+ * the server without @@server_uuid (MySQL 5.5, MariaDB) is identified by @@hostname and @@port.
+ * 
+ * @param connectId
+ * @return server_uuid or "hostname:port"
+ */
+std::string UserDbRepository::getServerId(uint64_t connectId)
+{
+	assert(connectId > 0);
+	try {
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery(
+			"SHOW GLOBAL VARIABLES WHERE `Variable_name` IN ('server_uuid', 'hostname', 'port')"));
+		std::string serverUuid, hostname, port;
+		while (resultSet->next()) {
+			std::string name = resultSet->getString(1).asStdString();
+			std::string value = resultSet->getString(2).asStdString();
+			if (name == "server_uuid") {
+				serverUuid = value;
+			} else if (name == "hostname") {
+				hostname = value;
+			} else if (name == "port") {
+				port = value;
+			}
+		}
+		resultSet->close();
+		stmt->close();
+		return !serverUuid.empty() ? serverUuid : hostname + ":" + port;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getServerId(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Get the global variable of the server, such as "local_infile".
+ * 
+ * @param connectId
+ * @param name - the variable name
+ * @return the value, empty if the variable does not exist
+ */
+std::string UserDbRepository::getServerVariable(uint64_t connectId, const std::string& name)
+{
+	assert(connectId > 0 && !name.empty());
+	std::string result;
+	try {
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement("SHOW GLOBAL VARIABLES WHERE `Variable_name`=?"));
+		stmt->setString(1, name);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+		if (resultSet->next()) {
+			result = resultSet->getString(2).asStdString();
+		}
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getServerVariable(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * The BIT and spatial columns can not be loaded from the text of the connector by LOAD DATA, 
+ * BIT is read as the number text and the spatial value needs ST_GeomFromWKB(...).
+ * 
+ * @param connectId
+ * @param schema
+ * @param tblName
+ * @return 
+ */
+bool UserDbRepository::hasLoadDataUnsafeColumns(uint64_t connectId, const std::string& schema, const std::string& tblName)
+{
+	assert(connectId > 0 && !schema.empty() && !tblName.empty());
+	try {
+		sql::SQLString sql = "SELECT COUNT(*) FROM `information_schema`.`COLUMNS` WHERE `TABLE_SCHEMA`=? AND `TABLE_NAME`=? "
+			"AND `DATA_TYPE` IN ('bit','geometry','point','linestring','polygon','multipoint','multilinestring','multipolygon',"
+			"'geometrycollection','geomcollection')";
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement(sql));
+		stmt->setString(1, schema);
+		stmt->setString(2, tblName);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+		bool result = resultSet->next() && resultSet->getUInt64(1) > 0;
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to hasLoadDataUnsafeColumns(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Get object DDL and the sql_mode that the object was created with, the routines, triggers and events 
+ * run with the sql_mode of their creation, so it must be set before the DDL is executed in the target.
+ * 
+ * @param connectId
+ * @param schema
+ * @param name - object name
+ * @param objectType - "TABLE", "VIEW", "PROCEDURE", "FUNCTION", "TRIGGER", "EVENT"
+ * @param sqlMode [out] - empty for TABLE and VIEW
+ * @return the DDL
+ */
+std::string UserDbRepository::getObjectDDLAndSqlMode(uint64_t connectId, const std::string& schema, const std::string& name, 
+	const std::string& objectType, std::string& sqlMode)
+{
+	assert(connectId > 0 && !schema.empty() && !name.empty() && !objectType.empty());
+	if (objectTypeDDLColumnMap.find(objectType) == objectTypeDDLColumnMap.end()) {
+		Q_ERROR("Invalid params , objectType:{} (code:{})", objectType, "200004");
+		throw QRuntimeException("200004");
+	}
+	bool hasSqlMode = objectType == "PROCEDURE" || objectType == "FUNCTION" || objectType == "TRIGGER" || objectType == "EVENT";
+
+	std::string result;
+	sqlMode.clear();
+	try {
+		sql::SQLString sql = "SHOW CREATE ";
+		sql.append(objectType).append(" `").append(name).append("`");
+
+		auto connect = getUserConnect(connectId);
+		connect->setSchema(schema);
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery(sql));
+		if (resultSet->next()) {
+			result = resultSet->getString(objectTypeDDLColumnMap.at(objectType)).asStdString();
+			if (hasSqlMode) {
+				sqlMode = resultSet->getString("sql_mode").asStdString();
+			}
+		}
+		resultSet->close();
+		stmt->close();
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getObjectDDLAndSqlMode(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Get the fingerprints of the object lists of the schema in one round trip, a list is changed if its fingerprint is changed.
+ * The fingerprint is the count, the sum of CRC32 of the names (for renaming) and the max time of creating/altering,
+ * the UPDATE_TIME of the tables is not in it, it is changed by every INSERT/UPDATE/DELETE,
+ * "columns" and "indexes" are the fingerprints of the columns and indexes of all tables,
+ * "databases" is the fingerprint of the databases of the connection.
+ * 
+ * @param connectId
+ * @param schema
+ * @return object list => fingerprint, the object lists are "tables", "views", "procedures", "functions", "triggers", "events",
+ *         "columns", "indexes" and "databases"
+ */
+SchemaFingerprint UserDbRepository::getSchemaFingerprint(uint64_t connectId, const std::string& schema)
+{
+	assert(connectId > 0 && !schema.empty());
+	SchemaFingerprint result;
+	try {
+		sql::SQLString sql = "SELECT 'tables', CONCAT_WS(':', COUNT(*), SUM(CRC32(`TABLE_NAME`)), MAX(`CREATE_TIME`)) "
+			"FROM `information_schema`.`TABLES` WHERE `TABLE_SCHEMA`=? AND `TABLE_TYPE`<>'VIEW' "
+			"UNION ALL SELECT 'views', CONCAT_WS(':', COUNT(*), SUM(CRC32(`TABLE_NAME`))) "
+			"FROM `information_schema`.`TABLES` WHERE `TABLE_SCHEMA`=? AND `TABLE_TYPE`='VIEW' "
+			"UNION ALL SELECT IF(`ROUTINE_TYPE`='PROCEDURE', 'procedures', 'functions'), "
+			"CONCAT_WS(':', COUNT(*), SUM(CRC32(`ROUTINE_NAME`)), MAX(`LAST_ALTERED`)) "
+			"FROM `information_schema`.`ROUTINES` WHERE `ROUTINE_SCHEMA`=? GROUP BY `ROUTINE_TYPE` "
+			"UNION ALL SELECT 'triggers', CONCAT_WS(':', COUNT(*), SUM(CRC32(`TRIGGER_NAME`)), MAX(`CREATED`)) "
+			"FROM `information_schema`.`TRIGGERS` WHERE `TRIGGER_SCHEMA`=? "
+			"UNION ALL SELECT 'events', CONCAT_WS(':', COUNT(*), SUM(CRC32(`EVENT_NAME`)), MAX(`LAST_ALTERED`)) "
+			"FROM `information_schema`.`EVENTS` WHERE `EVENT_SCHEMA`=? "
+			"UNION ALL SELECT 'columns', CONCAT_WS(':', COUNT(*), SUM(CRC32(CONCAT_WS(' ', `TABLE_NAME`, `COLUMN_NAME`, `COLUMN_TYPE`, `IS_NULLABLE`)))) "
+			"FROM `information_schema`.`COLUMNS` WHERE `TABLE_SCHEMA`=? "
+			"UNION ALL SELECT 'indexes', CONCAT_WS(':', COUNT(*), SUM(CRC32(CONCAT_WS(' ', `TABLE_NAME`, `INDEX_NAME`, `COLUMN_NAME`, `NON_UNIQUE`)))) "
+			"FROM `information_schema`.`STATISTICS` WHERE `TABLE_SCHEMA`=? "
+			"UNION ALL SELECT 'databases', CONCAT_WS(':', COUNT(*), SUM(CRC32(`SCHEMA_NAME`))) "
+			"FROM `information_schema`.`SCHEMATA`";
+		auto connect = getUserConnect(connectId);
+		std::unique_ptr<sql::PreparedStatement> stmt(connect->prepareStatement(sql));
+		for (int i = 1; i <= 7; i++) {
+			stmt->setString(i, schema);
+		}
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery());
+		while (resultSet->next()) {
+			result[resultSet->getString(1).asStdString()] = resultSet->getString(2).asStdString();
+		}
+		resultSet->close();
+		stmt->close();
+		// no routine of the type
+		result.insert({ "procedures", "0" });
+		result.insert({ "functions", "0" });
+		return result;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to getSchemaFingerprint(), code:{}, error:{}", code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
 /**
  * convert to entity.
  * 
@@ -19,9 +19,19 @@
  *********************************************************************/
 #pragma once
 #include <string>
+#include <functional>
 #include "core/entity/Entity.h"
 #include "core/common/repository/BaseUserRepository.h"
 
+// Read one row of the copied table as the values tuple of INSERT, such as "(1,'a',X'0F',NULL)", return false to stop reading,
+// keyTuple is the tuple of the last keyColumnCount columns of the SELECT, such as "(1)", they are not in the tuple,
+// the tuple is a line of LOAD DATA (tab separated, escaped by backslash, such as "1\ta\t\\N\n") if asLoadDataLine
+typedef std::function<bool (const std::string & tuple, const std::string & keyTuple)> RowTupleReader;
+
+// Read one row as the raw values, nulls.at(i) is true if the value i is NULL, return false to stop reading,
+// the vectors are reused for the next row
+typedef std::function<bool (const std::vector<std::string> & values, const std::vector<bool> & nulls)> RowValuesReader;
+
 class UserDbRepository : public BaseUserRepository<UserDbRepository>
 {
 public:
@@ -32,6 +42,25 @@ public:
 	bool remove(uint64_t connectId, const std::string & schema);
 	
 	UserDbList getAllByConnectId(uint64_t connectId);
+
+	// duplicate database, the statements run in the pinned sessions of QUERY_LANE
+	void executeInSession(uint64_t connectId, const std::string & schema, const std::string & sql, uint64_t sessionKey);
+	uint64_t executeUpdateInSession(uint64_t connectId, const std::string & schema, const std::string & sql, uint64_t sessionKey);
+	void readRowTuples(uint64_t connectId, const std::string & schema, const std::string & sql, uint64_t sessionKey, 
+		const RowTupleReader & reader, uint32_t keyColumnCount = 0, bool asLoadDataLine = false);
+	void readRowValues(uint64_t connectId, const std::string & sql, uint64_t sessionKey, const RowValuesReader & reader);
+	void loadDataInSession(uint64_t connectId, const std::string & sql, uint64_t sessionKey);
+	void releaseSession(uint64_t connectId, uint64_t sessionKey, bool discard = false);
+	std::string getSessionSqlMode(uint64_t connectId, uint64_t sessionKey);
+	Columns getInsertableColumns(uint64_t connectId, const std::string & schema, const std::string & tblName);
+	Columns getPrimaryKeyColumns(uint64_t connectId, const std::string & schema, const std::string & tblName);
+	std::string getServerId(uint64_t connectId);
+	std::string getServerVariable(uint64_t connectId, const std::string & name);
+	bool hasLoadDataUnsafeColumns(uint64_t connectId, const std::string & schema, const std::string & tblName);
+	std::string getObjectDDLAndSqlMode(uint64_t connectId, const std::string & schema, const std::string & name, 
+		const std::string & objectType, std::string & sqlMode);
+	// the fingerprints of the object lists and the columns/indexes of the schema by one query
+	SchemaFingerprint getSchemaFingerprint(uint64_t connectId, const std::string & schema);
 private:
 	UserDb toUserDb(uint64_t connectId, sql::ResultSet * res);
 };
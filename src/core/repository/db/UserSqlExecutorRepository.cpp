@@ -18,99 +18,502 @@
  *********************************************************************/
 #include "UserSqlExecutorRepository.h"
 #include <cassert>
+#include <cstdint>
 #include <memory>
+#include "utils/StringUtil.h"
 #include "utils/ThreadUtil.h"
 
-sql::ResultSet * UserSqlExecutorRepository::executeQuery(uint64_t connectId, const std::string& schema, const std::string& sql)
+sql::ResultSet * UserSqlExecutorRepository::executeQuery(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey, 
+	QExecTrace * trace, const SqlProbe * probe)
 {
     assert(connectId > 0  && !sql.empty());
 	try {
-		beginPerfTime(); // for performance - begin
-		auto connect = getUserConnect(connectId);
-		if (!schema.empty()) {
-			connect->setSchema(schema);
-		}
+		auto connect = checkoutSession(connectId, schema, sessionKey, trace);
 		
 		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		if (probe) {
+			// the buffered result set is still valid after the results of the probe are read
+			sql::ResultSet * resultSet = nullptr;
+			executePacket(stmt.get(), { sql }, probe, [&](size_t, bool hasResultSet) {
+				resultSet = hasResultSet ? stmt->getResultSet() : nullptr;
+			}, trace);
+			stmt->close();
+			return resultSet;
+		}
 		//stmt->execute("set names 'utf8'; ");
+		QTraceScope executeScope(trace, QExecTrace::EXECUTE);
 		sql::ResultSet * resultSet = stmt->executeQuery(sql);
+		executeScope.end();
 		stmt->close();
-		endPerfTime(); // for performance - end
 		return resultSet;
 	} catch (sql::SQLException& ex) {
 		auto code = std::to_string(ex.getErrorCode());
 		BaseRepository::setError(code, ex.what());
 		Q_ERROR("Repository Error, code:{}, error:{}", code, ex.what());
-		endPerfTime(); // for performance - end
+		discardLostSession(connectId, sessionKey, ex.getErrorCode());
 		throw ex;
 	}
 }
 
+/**
+ * Execute the query with an unbuffered, forward-only result set, the rows are transferred from the server 
+ * while the reader reads them, so the memory does not grow with the rows count.
+ * The session is held until the reader returns, the unread rows are discarded by the driver when the result set closed.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sql
+ * @param fetchSize - the hint of rows count for one round trip, 0 - the driver default
+ * @param reader - read the result set by resultSet->next()
+ * @param sessionKey - the pinned session, 0 - the session of current thread
+ */
+void UserSqlExecutorRepository::executeQueryStream(uint64_t connectId, const std::string& schema, const std::string& sql, uint32_t fetchSize, 
+	const ResultSetReader & reader, uint64_t sessionKey, QExecTrace * trace, const SqlProbe * probe)
+{
+	assert(connectId > 0 && !sql.empty() && reader);
+	try {
+		auto connect = checkoutSession(connectId, schema, sessionKey, trace);
+
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		// TYPE_FORWARD_ONLY: mysql_use_result() instead of mysql_store_result()
+		stmt->setResultSetType(sql::ResultSet::TYPE_FORWARD_ONLY);
+		if (fetchSize) {
+			try {
+				stmt->setFetchSize(fetchSize);
+			} catch (sql::SQLException&) {
+				// the fetch size is only a hint, some driver versions do not implement it
+			}
+		}
+		if (probe) {
+			// the unread rows must be discarded before the result of the probe after the query
+			executePacket(stmt.get(), { sql }, probe, [&](size_t, bool hasResultSet) {
+				if (hasResultSet) {
+					std::unique_ptr<sql::ResultSet> resultSet(stmt->getResultSet());
+					reader(resultSet.get());
+					resultSet->close();
+				}
+			}, trace);
+			stmt->close();
+			return;
+		}
+		// the time of the first response, the rows are transferred by the reader
+		QTraceScope executeScope(trace, QExecTrace::EXECUTE);
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery(sql));
+		executeScope.end();
+
+		reader(resultSet.get());
+		resultSet->close();
+		stmt->close();
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Repository Error, code:{}, error:{}", code, ex.what());
+		discardLostSession(connectId, sessionKey, ex.getErrorCode());
+		throw ex;
+	}
+}
 
-bool UserSqlExecutorRepository::execute(uint64_t connectId, const std::string& schema, const std::string& sql)
+bool UserSqlExecutorRepository::execute(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey, QExecTrace * trace)
 {
     assert(connectId > 0  && !sql.empty());
 	try {
-		beginPerfTime(); // for performance - begin
-		auto connect = getUserConnect(connectId);
-		if (!schema.empty()) {
-			connect->setSchema(schema);
-		}
+		auto connect = checkoutSession(connectId, schema, sessionKey, trace);
 		
 		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
 
-		bool ret = stmt->execute(sql);
+		QTraceScope executeScope(trace, QExecTrace::EXECUTE);
+		stmt->execute(sql);
+		executeScope.end();
 		stmt->close();
-		endPerfTime(); // for performance - end
 		return true;
 	} catch (sql::SQLException& ex) {
 		auto code = std::to_string(ex.getErrorCode());
 		BaseRepository::setError(code, ex.what());
 		Q_ERROR("Repository Error, code:{}, error:{}", code, ex.what());
-		endPerfTime(); // for performance - end
+		discardLostSession(connectId, sessionKey, ex.getErrorCode());
 		throw ex;
 	}
 
 	return false;
 }
 
+/**
+ * Execute the INSERT/UPDATE/DELETE/DDL statement.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sql
+ * @param sessionKey - the pinned session, 0 - the session of current thread
+ * @return the affected rows, -1 if the statement returns a result set
+ */
+int64_t UserSqlExecutorRepository::executeUpdate(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey, 
+	QExecTrace * trace, const SqlProbe * probe)
+{
+    assert(connectId > 0  && !sql.empty());
+	try {
+		auto connect = checkoutSession(connectId, schema, sessionKey, trace);
+		
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		if (probe) {
+			int64_t effectRows = -1;
+			executePacket(stmt.get(), { sql }, probe, [&](size_t, bool hasResultSet) {
+				if (!hasResultSet) {
+					uint64_t updateCount = stmt->getUpdateCount();
+					effectRows = updateCount == UINT64_MAX ? 0 : static_cast<int64_t>(updateCount);
+				}
+			}, trace);
+			stmt->close();
+			return effectRows;
+		}
+		QTraceScope executeScope(trace, QExecTrace::EXECUTE);
+		bool hasResultSet = stmt->execute(sql);
+		executeScope.end();
+		int64_t effectRows = hasResultSet ? -1 : static_cast<int64_t>(stmt->getUpdateCount());
+		stmt->close();
+		return effectRows;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Repository Error, code:{}, error:{}", code, ex.what());
+		discardLostSession(connectId, sessionKey, ex.getErrorCode());
+		throw ex;
+	}
+}
+
+
+/**
+ * Execute the statements in one round trip, the session must be a packet session, see setPacketSession(...).
+ * The server stops at the first failed statement, so the exception is thrown after the reader has been called 
+ * for the statements before the failed one.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sqls - the statements, every statement returns one result (not CALL)
+ * @param reader - called for every executed statement in order
+ * @param sessionKey
+ * @param trace
+ * @param probe - sent before the first statement and after every statement, see executePacket(...)
+ */
+void UserSqlExecutorRepository::executeMulti(uint64_t connectId, const std::string& schema, const std::vector<std::string>& sqls, 
+	const StatementResultReader& reader, uint64_t sessionKey, QExecTrace * trace, const SqlProbe * probe)
+{
+	assert(connectId > 0 && !sqls.empty() && isPacketSession(sessionKey));
+	try {
+		auto connect = checkoutSession(connectId, schema, sessionKey, trace);
+
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		executePacket(stmt.get(), sqls, probe, [&](size_t index, bool hasResultSet) {
+			int64_t effectRows = -1;
+			if (hasResultSet) {
+				std::unique_ptr<sql::ResultSet> resultSet(stmt->getResultSet());
+			} else {
+				uint64_t updateCount = stmt->getUpdateCount();
+				effectRows = updateCount == UINT64_MAX ? 0 : static_cast<int64_t>(updateCount);
+			}
+			reader(index, effectRows);
+		}, trace);
+		stmt->close();
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Repository Error, code:{}, error:{}", code, ex.what());
+		discardLostSession(connectId, sessionKey, ex.getErrorCode());
+		throw ex;
+	}
+}
+
+/**
+ * The statements of the session can be sent in one packet, the session is pinned in PACKET_LANE whose sessions
+ * are created with CLIENT_MULTI_STATEMENTS, the other sessions reject the stacked statements.
+ * Call it before the first statement of the session.
+ * 
+ * @param sessionKey
+ */
+void UserSqlExecutorRepository::setPacketSession(uint64_t sessionKey)
+{
+	assert(sessionKey > 0);
+	std::lock_guard<std::mutex> lk(sessionMutex);
+	packetSessions.insert(sessionKey);
+}
+
+bool UserSqlExecutorRepository::isPacketSession(uint64_t sessionKey)
+{
+	std::lock_guard<std::mutex> lk(sessionMutex);
+	return packetSessions.count(sessionKey) > 0;
+}
+
+QConnectLane UserSqlExecutorRepository::getSessionLane(uint64_t sessionKey)
+{
+	return isPacketSession(sessionKey) ? PACKET_LANE : QUERY_LANE;
+}
+
+/**
+ * The user sql statements of one thread are executed in the same pinned session of QUERY_LANE,
+ * so "BEGIN;", the statements and "COMMIT;" share the same transaction.
+ * 
+ * @return 
+ */
+uint64_t UserSqlExecutorRepository::getSessionKey() const
+{
+	return static_cast<uint64_t>(ThreadUtil::currentThreadId()) + 1;
+}
 
+/**
+ * Unpin the query session, the session returns to the pool.
+ * 
+ * @param connectId
+ * @param sessionKey - the pinned session, 0 - the session of current thread
+ * @param discard - the session is closed instead, such as it may be in a transaction that is not ended
+ */
+void UserSqlExecutorRepository::releaseSession(uint64_t connectId, uint64_t sessionKey, bool discard)
+{
+	uint64_t key = sessionKey ? sessionKey : getSessionKey();
+	QConnectLane lane = getSessionLane(key);
+	{
+		std::lock_guard<std::mutex> lk(sessionMutex);
+		sessionStates.erase(key);
+		packetSessions.erase(key);
+	}
+	QConnect::userConnectPool.releaseSession(connectId, lane, key, discard);
+}
 
-const PerfTime& UserSqlExecutorRepository::getPerfTime() const
+/**
+ * The pinned sessions do not reconnect by themselves, the session variables and the transaction would be lost silently,
+ * so the lost session is closed and the next statement of the session key pins a new session.
+ * 
+ * @param connectId
+ * @param sessionKey - the pinned session, 0 - the session of current thread
+ * @param errorCode - the error code of the failed statement
+ */
+void UserSqlExecutorRepository::discardLostSession(uint64_t connectId, uint64_t sessionKey, int errorCode)
 {
-	uint32_t threadId = ThreadUtil::currentThreadId();
-	auto iter = perfTimes.find(threadId);
-	assert(iter != perfTimes.end());
+	// 2006: server has gone away, 2013: lost connection
+	if (errorCode != 2006 && errorCode != 2013) {
+		return;
+	}
+	uint64_t key = sessionKey ? sessionKey : getSessionKey();
+	QConnectLane lane = getSessionLane(key);
+	{
+		std::lock_guard<std::mutex> lk(sessionMutex);
+		sessionStates.erase(key);
+	}
+	Q_WARN("The pinned session is lost, connectId:{}, sessionKey:{}", connectId, key);
+	QConnect::userConnectPool.releaseSession(connectId, lane, key, true);
+}
+
+/**
+ * Set the max_execution_time of the session, the statement runs only when the timeout is changed.
+ * The server interrupts the SELECT statements that run longer than the timeout (MySQL 5.7.8+).
+ * 
+ * @param connectId
+ * @param sessionKey - the pinned session, 0 - the session of current thread
+ * @param milliSeconds - 0 - no timeout
+ */
+void UserSqlExecutorRepository::setExecutionTimeout(uint64_t connectId, uint64_t sessionKey, uint32_t milliSeconds)
+{
+	assert(connectId > 0);
+	try {
+		auto connect = checkoutSession(connectId, "", sessionKey, nullptr);
+		uint64_t key = sessionKey ? sessionKey : getSessionKey();
+		{
+			std::lock_guard<std::mutex> lk(sessionMutex);
+			if (sessionStates[key].timeout == milliSeconds) {
+				return;
+			}
+		}
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		stmt->execute("SET SESSION max_execution_time=" + std::to_string(milliSeconds));
+		stmt->close();
 
-	return perfTimes.at(threadId);
+		std::lock_guard<std::mutex> lk(sessionMutex);
+		sessionStates[key].timeout = milliSeconds;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Repository Error, code:{}, error:{}", code, ex.what());
+		discardLostSession(connectId, sessionKey, ex.getErrorCode());
+		throw ex;
+	}
 }
 
-void UserSqlExecutorRepository::endPerfTime()
+uint64_t UserSqlExecutorRepository::getStatementSeq(uint64_t sessionKey)
 {
-	uint32_t threadId = ThreadUtil::currentThreadId();
-	auto iter = perfTimes.find(threadId);
-	if (iter == perfTimes.end()) {
-		PerfTime perfTime;
-		perfTime.begin = std::chrono::high_resolution_clock::now();	
-		perfTimes[threadId] = perfTime;
+	std::lock_guard<std::mutex> lk(sessionMutex);
+	auto iter = sessionStates.find(sessionKey);
+	return iter == sessionStates.end() ? 0 : iter->second.statementSeq;
+}
+
+/**
+ * Kill the running statement of the session by "KILL QUERY connection_id" in a short-lived side session,
+ * the session of the pool is blocked by the running statement. The killed statement fails with ER_QUERY_INTERRUPTED.
+ * The side session is connected later than the cancel, so the statement is checked again before KILL, 
+ * the batch may have moved to the next statement or the session may run the next batch.
+ * 
+ * @param connectId
+ * @param sessionKey - the pinned session
+ * @param statementSeq - getStatementSeq(sessionKey) when the statement is canceled
+ * @return false if the session has not been checked out or another statement has started
+ */
+bool UserSqlExecutorRepository::killQuery(uint64_t connectId, uint64_t sessionKey, uint64_t statementSeq)
+{
+	assert(connectId > 0 && sessionKey > 0);
+	uint64_t connectionId = 0;
+	{
+		std::lock_guard<std::mutex> lk(sessionMutex);
+		auto iter = sessionStates.find(sessionKey);
+		if (iter != sessionStates.end() && iter->second.statementSeq == statementSeq) {
+			connectionId = iter->second.connectionId;
+		}
+	}
+	if (!connectionId || !statementSeq) {
+		return false;
 	}
 
-	auto& ptime = perfTimes[threadId];
-	ptime.end = std::chrono::high_resolution_clock::now();
-	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(ptime.end - ptime.begin);
-	ptime.elapsedMicroSeconds = elapsed.count();
+	// the side session uses the SSL and charset of the pooled sessions, the schema is not needed by KILL
+	sql::ConnectOptionsMap options = getConnectOptions(getUserConnectEntity(connectId));
+	options.erase("schema");
+	try {
+		std::unique_ptr<sql::Connection> connect(QConnect::getDriver()->connect(options));
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		{
+			// the next statement can not be checked out until the KILL is sent, see checkoutSession(...)
+			std::lock_guard<std::mutex> lk(sessionMutex);
+			auto iter = sessionStates.find(sessionKey);
+			if (iter == sessionStates.end() || iter->second.statementSeq != statementSeq 
+				|| iter->second.connectionId != connectionId) {
+				stmt->close();
+				connect->close();
+				return false;
+			}
+			stmt->execute("KILL QUERY " + std::to_string(connectionId));
+		}
+		stmt->close();
+		connect->close();
+		return true;
+	} catch (sql::SQLException& ex) {
+		auto code = std::to_string(ex.getErrorCode());
+		BaseRepository::setError(code, ex.what());
+		Q_ERROR("Fail to kill query, connectionId:{}, code:{}, error:{}", connectionId, code, ex.what());
+		throw QRuntimeException(code, ex.what());
+	}
+}
+
+/**
+ * Check out the session of QUERY_LANE (PACKET_LANE for the packet session) and change the schema, the spans are recorded to the trace.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sessionKey - the pinned session, 0 - the session of current thread
+ * @param trace - nullptr if the execution is not traced
+ * @return 
+ */
+QConnectLease UserSqlExecutorRepository::checkoutSession(uint64_t connectId, const std::string& schema, uint64_t sessionKey, QExecTrace * trace)
+{
+	QTraceScope checkoutScope(trace, QExecTrace::CHECKOUT);
+	uint64_t key = sessionKey ? sessionKey : getSessionKey();
+	auto connect = getUserConnect(connectId, getSessionLane(key), key);
+	bool isNewSession = false;
+	{
+		std::lock_guard<std::mutex> lk(sessionMutex);
+		isNewSession = sessionStates[key].generation != connect.getGeneration();
+	}
+	if (isNewSession) {
+		// once for a new pinned session, the connection id is used by KILL QUERY
+		std::unique_ptr<sql::Statement> stmt(connect->createStatement());
+		std::unique_ptr<sql::ResultSet> resultSet(stmt->executeQuery("SELECT CONNECTION_ID()"));
+		SessionState state;
+		state.generation = connect.getGeneration();
+		state.connectionId = resultSet->next() ? resultSet->getUInt64(1) : 0;
+		std::lock_guard<std::mutex> lk(sessionMutex);
+		sessionStates[key] = state;
+	}
+	{
+		// the statement after the checkout is the running statement of the session, see killQuery(...)
+		std::lock_guard<std::mutex> lk(sessionMutex);
+		sessionStates[key].statementSeq = ++nextStatementSeq;
+	}
+	checkoutScope.end();
+	if (!schema.empty()) {
+		QTraceScope schemaScope(trace, QExecTrace::SET_SCHEMA);
+		connect->setSchema(schema);
+	}
+	return connect;
 }
 
-void UserSqlExecutorRepository::beginPerfTime()
+/**
+ * Send the statements in one packet, the probe is sent twice before the first statement and once after every statement:
+ * "probe; probe; sql0; probe; sql1; probe ...". The results are read in order, the handler reads the result of the 
+ * i-th statement by stmt->getResultSet() or stmt->getUpdateCount(), the probe->reader reads the results of the probe.
+ * The server stops at the first failed statement, the exception is thrown after the results before the failed one are read.
+ * 
+ * @param stmt - the statement of the packet session, the session is created with CLIENT_MULTI_STATEMENTS
+ * @param sqls - every statement returns one result (not CALL)
+ * @param probe - nullptr if there is no probe
+ * @param handler - called for every executed statement in order
+ * @param trace - the execute span includes the time of all results
+ */
+void UserSqlExecutorRepository::executePacket(sql::Statement * stmt, const std::vector<std::string>& sqls, const SqlProbe * probe, 
+	const std::function<void (size_t index, bool hasResultSet)> & handler, QExecTrace * trace)
 {
-	uint32_t threadId = ThreadUtil::currentThreadId();
-	auto iter = perfTimes.find(threadId);
-	if (iter == perfTimes.end()) {
-		PerfTime perfTime;
-		perfTime.begin = std::chrono::high_resolution_clock::now();
-		perfTimes[threadId] = perfTime;
-	} else {
-		iter->second.begin = std::chrono::high_resolution_clock::now();
+	std::vector<std::string> packetSqls;
+	if (probe) {
+		packetSqls.push_back(probe->sql);
+		packetSqls.push_back(probe->sql);
+	}
+	for (auto & sql : sqls) {
+		packetSqls.push_back(sql);
+		if (probe) {
+			packetSqls.push_back(probe->sql);
+		}
+	}
+	std::string multiSql;
+	for (auto & sql : packetSqls) {
+		std::string stmtSql = sql;
+		StringUtil::trim(stmtSql);
+		while (!stmtSql.empty() && stmtSql.back() == ';') {
+			stmtSql.pop_back();
+		}
+		// the new line before ';' keeps it out of the line comment at the end of the statement
+		multiSql.append(stmtSql).append("\n;\n");
 	}
 
+	bool hasResultSet = false;
+	bool isFirst = true;
+	auto nextResult = [&]() {
+		QTraceScope executeScope(trace, QExecTrace::EXECUTE);
+		// it throws the error of the statement
+		hasResultSet = isFirst ? stmt->execute(multiSql) : stmt->getMoreResults();
+		isFirst = false;
+	};
+	auto readProbe = [&]() {
+		nextResult();
+		if (hasResultSet) {
+			std::unique_ptr<sql::ResultSet> resultSet(stmt->getResultSet());
+			probe->reader(resultSet.get());
+			// the forward-only result set must be read to the end before the next result
+			while (resultSet->next()) {}
+		}
+	};
+
+	if (probe) {
+		readProbe();
+		readProbe();
+	}
+	size_t n = sqls.size();
+	for (size_t i = 0; i < n; i++) {
+		nextResult();
+		handler(i, hasResultSet);
+		if (probe) {
+			readProbe();
+		}
+	}
+	// discard the extra results, the session must be clean before it returns to the pool.
+	// getMoreResults() is false for an update count too, the results end when there is no update count either
+	while (true) {
+		if (stmt->getMoreResults()) {
+			std::unique_ptr<sql::ResultSet> resultSet(stmt->getResultSet());
+		} else if (stmt->getUpdateCount() == UINT64_MAX) {
+			break;
+		}
+	}
 }
@@ -17,18 +17,70 @@
  * @date   2024-12-01
  *********************************************************************/
 #pragma once
+#include <functional>
+#include <unordered_set>
+#include <mutex>
+#include <unordered_map>
 #include "core/common/repository/BaseUserRepository.h"
 #include "core/entity/Entity.h"
+#include "core/common/trace/QExecTrace.h"
+
+// Read the forward-only result set, the result set is only valid in the reader
+typedef std::function<void (sql::ResultSet * resultSet)> ResultSetReader;
+// Read the result of one statement of the multi statements, effectRows is -1 if the statement returns a result set
+typedef std::function<void (size_t index, int64_t effectRows)> StatementResultReader;
+
+// The statement that is sent in the same packet with the user statements, such as SHOW SESSION STATUS.
+// The reader is called twice before the first statement, then once after every executed statement, 
+// so the difference of the first two results is the effect of the probe itself.
+typedef struct _SqlProbe {
+	std::string sql;
+	std::function<void (sql::ResultSet * resultSet)> reader;
+} SqlProbe;
 
 class UserSqlExecutorRepository : public BaseUserRepository<UserSqlExecutorRepository>
 {
 public:
-	sql::ResultSet * executeQuery(uint64_t connectId, const std::string & schema, const std::string &sql);
-	bool execute(uint64_t connectId, const std::string & schema, const std::string &sql);
-	const PerfTime & getPerfTime() const;
+	// trace - records the spans of checkout, setSchema and execute, nullptr if the execution is not traced
+	// probe - sent in the same round trip around the statement, nullptr if there is no probe, only for the packet session
+	sql::ResultSet * executeQuery(uint64_t connectId, const std::string & schema, const std::string &sql, uint64_t sessionKey = 0, 
+		QExecTrace * trace = nullptr, const SqlProbe * probe = nullptr);
+	void executeQueryStream(uint64_t connectId, const std::string & schema, const std::string &sql, uint32_t fetchSize, 
+		const ResultSetReader & reader, uint64_t sessionKey = 0, QExecTrace * trace = nullptr, const SqlProbe * probe = nullptr);
+	bool execute(uint64_t connectId, const std::string & schema, const std::string &sql, uint64_t sessionKey = 0, 
+		QExecTrace * trace = nullptr);
+	int64_t executeUpdate(uint64_t connectId, const std::string & schema, const std::string &sql, uint64_t sessionKey = 0, 
+		QExecTrace * trace = nullptr, const SqlProbe * probe = nullptr);
+	void executeMulti(uint64_t connectId, const std::string & schema, const std::vector<std::string> & sqls, 
+		const StatementResultReader & reader, uint64_t sessionKey = 0, QExecTrace * trace = nullptr, const SqlProbe * probe = nullptr);
+	void releaseSession(uint64_t connectId, uint64_t sessionKey = 0, bool discard = false);
+	// the server side timeout of the SELECT statements of the session, 0 - no timeout
+	void setExecutionTimeout(uint64_t connectId, uint64_t sessionKey, uint32_t milliSeconds);
+	// the sequence of the last statement that started in the session, 0 if the session has not been checked out
+	uint64_t getStatementSeq(uint64_t sessionKey);
+	// kill the running statement of the session by a short-lived side session, only if it is still the statement of statementSeq
+	bool killQuery(uint64_t connectId, uint64_t sessionKey, uint64_t statementSeq);
+	// the session sends more statements in one packet (pipeline, status probes), it is pinned in PACKET_LANE
+	void setPacketSession(uint64_t sessionKey);
+	bool isPacketSession(uint64_t sessionKey);
 private:
-	std::unordered_map<uint32_t, PerfTime> perfTimes;
-	void beginPerfTime();
-	void endPerfTime();
+	// The state of the pinned session of QUERY_LANE or PACKET_LANE
+	typedef struct _SessionState {
+		uint64_t generation = 0; // QConnectLease::getGeneration() of the pinned session
+		uint64_t connectionId = 0; // CONNECTION_ID() of the session, for KILL QUERY
+		uint32_t timeout = 0; // max_execution_time of the session, milliseconds
+		uint64_t statementSeq = 0; // from nextStatementSeq when a statement is checked out, KILL QUERY checks it
+	} SessionState;
+	std::mutex sessionMutex;
+	uint64_t nextStatementSeq = 0; // unique in all sessions, guarded by sessionMutex
+	std::unordered_map<uint64_t, SessionState> sessionStates; // sessionKey => state
+	std::unordered_set<uint64_t> packetSessions; // the session keys of PACKET_LANE
+
+	QConnectLease checkoutSession(uint64_t connectId, const std::string & schema, uint64_t sessionKey, QExecTrace * trace);
+	uint64_t getSessionKey() const;
+	QConnectLane getSessionLane(uint64_t sessionKey);
+	void discardLostSession(uint64_t connectId, uint64_t sessionKey, int errorCode);
+	void executePacket(sql::Statement * stmt, const std::vector<std::string> & sqls, const SqlProbe * probe,
+		const std::function<void (size_t index, bool hasResultSet)> & handler, QExecTrace * trace);
 };
 
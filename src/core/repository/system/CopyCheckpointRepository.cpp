@@ -0,0 +1,124 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   CopyCheckpointRepository.cpp
+ * @brief  The checkpoints of the chunked table copy in the system db, an interrupted copy resumes from the checkpoint.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-31
+ *********************************************************************/
+#include "CopyCheckpointRepository.h"
+#include "core/common/driver/sqlite/QSqlException.h"
+#include "core/common/driver/sqlite/QSqlDatabase.h"
+#include "core/common/driver/sqlite/QSqlStatement.h"
+#include "core/common/driver/sqlite/QSqlColumn.h"
+#include "core/common/exception/QRuntimeException.h"
+#include "utils/Log.h"
+
+/**
+ * Get the checkpoint of the copy job.
+ * 
+ * @param jobKey
+ * @param item [out]
+ * @return false if the job has no checkpoint
+ */
+bool CopyCheckpointRepository::get(const std::string & jobKey, CopyCheckpoint & item)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	createTableIfNotExists();
+	std::string sql = "SELECT * FROM copy_checkpoint WHERE job_key=:job_key";
+	try {
+		SQLite::QSqlStatement query(getSysConnect(), sql.c_str());
+		query.bind(":job_key", jobKey);
+		if (!query.executeStep()) {
+			return false;
+		}
+		item.jobKey = query.getColumn("job_key").getText();
+		item.lastKey = query.getColumn("last_key").getText();
+		item.copiedRows = query.getColumn("copied_rows").getUInt64();
+		item.createdAt = query.getColumn("created_at").getText();
+		item.updatedAt = query.getColumn("updated_at").getText();
+		return true;
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("query copy_checkpoint has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000016", "sorry, system has error when we are loading the copy checkpoint.");
+	}
+}
+
+/**
+ * Insert or update the checkpoint of the copy job by one statement, the workers of the copy save their checkpoints
+ * concurrently and the statements of sysConnect are serialized by its mutex.
+ * 
+ * @param item
+ */
+void CopyCheckpointRepository::save(const CopyCheckpoint & item)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	createTableIfNotExists();
+	std::string sql = "INSERT INTO copy_checkpoint (job_key, last_key, copied_rows, created_at, updated_at) \
+		VALUES (:job_key, :last_key, :copied_rows, datetime(), datetime()) \
+		ON CONFLICT(job_key) DO UPDATE SET last_key=excluded.last_key, copied_rows=excluded.copied_rows, updated_at=datetime()";
+	try {
+		SQLite::QSqlStatement query(getSysConnect(), sql.c_str());
+		query.bind(":job_key", item.jobKey);
+		query.bind(":last_key", item.lastKey);
+		query.bind(":copied_rows", item.copiedRows);
+		query.exec();
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("save copy_checkpoint has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000017", "sorry, system has error when we are saving the copy checkpoint.");
+	}
+}
+
+void CopyCheckpointRepository::remove(const std::string & jobKey)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	createTableIfNotExists();
+	std::string sql = "DELETE FROM copy_checkpoint WHERE job_key=:job_key";
+	try {
+		SQLite::QSqlStatement query(getSysConnect(), sql.c_str());
+		query.bind(":job_key", jobKey);
+		query.exec();
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("delete copy_checkpoint has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000018", "sorry, system has error when we are removing the copy checkpoint.");
+	}
+}
+
+/**
+ * The system db of the installed versions has no copy_checkpoint table, so it is created on the first use.
+ */
+void CopyCheckpointRepository::createTableIfNotExists()
+{
+	if (isTableCreated) {
+		return;
+	}
+	std::string sql = "CREATE TABLE IF NOT EXISTS \"copy_checkpoint\" ( \
+		\"id\" INTEGER NOT NULL DEFAULT (0) UNIQUE, \
+		\"job_key\" TEXT NOT NULL DEFAULT ('') UNIQUE, \
+		\"last_key\" TEXT NOT NULL DEFAULT (''), \
+		\"copied_rows\" INTEGER NOT NULL DEFAULT (0), \
+		\"created_at\" datetime NOT NULL DEFAULT (datetime('now', 'localtime')), \
+		\"updated_at\" datetime NOT NULL DEFAULT (datetime('now', 'localtime')), \
+		PRIMARY KEY(\"id\" AUTOINCREMENT))";
+	try {
+		getSysConnect()->exec(sql.c_str());
+		isTableCreated = true;
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("create copy_checkpoint has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000019", "sorry, system has error when we are creating the copy checkpoint table.");
+	}
+}
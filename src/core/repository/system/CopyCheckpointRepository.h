@@ -0,0 +1,38 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   CopyCheckpointRepository.h
+ * @brief  The checkpoints of the chunked table copy in the system db, an interrupted copy resumes from the checkpoint.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2024-12-31
+ *********************************************************************/
+#pragma once
+#include <mutex>
+#include "core/entity/Entity.h"
+#include "core/common/repository/BaseRepository.h"
+
+class CopyCheckpointRepository : public BaseRepository<CopyCheckpointRepository>
+{
+public:
+	CopyCheckpointRepository() {};
+
+	bool get(const std::string & jobKey, CopyCheckpoint & item);
+	void save(const CopyCheckpoint & item);
+	void remove(const std::string & jobKey);
+private:
+	// the checkpoints are saved by the writer threads of the copy, the system connect is shared by all threads
+	std::mutex mutex;
+	bool isTableCreated = false;
+
+	void createTableIfNotExists();
+};
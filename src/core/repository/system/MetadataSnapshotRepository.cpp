@@ -0,0 +1,186 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   MetadataSnapshotRepository.cpp
+ * @brief  The snapshot of the metadata object lists in the system db, the tree is shown from the snapshot
+ *         when the connection is opened, and the snapshot is reconciled against the server in the background.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-10
+ *********************************************************************/
+#include "MetadataSnapshotRepository.h"
+#include "core/common/driver/sqlite/QSqlException.h"
+#include "core/common/driver/sqlite/QSqlDatabase.h"
+#include "core/common/driver/sqlite/QSqlStatement.h"
+#include "core/common/driver/sqlite/QSqlColumn.h"
+#include "core/common/exception/QRuntimeException.h"
+#include "utils/Log.h"
+
+/**
+ * Get all snapshot objects of the connection, ordered by the schema, the object list and the saved order.
+ * 
+ * @param connectId
+ * @return 
+ */
+MetadataSnapshotItemList MetadataSnapshotRepository::getAll(uint64_t connectId)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	createTableIfNotExists();
+	MetadataSnapshotItemList result;
+	std::string sql = "SELECT * FROM metadata_snapshot WHERE connect_id=:connect_id ORDER BY schema_name, object, seq";
+	try {
+		SQLite::QSqlStatement query(getSysConnect(), sql.c_str());
+		query.bind(":connect_id", connectId);
+		while (query.executeStep()) {
+			MetadataSnapshotItem item;
+			item.connectId = query.getColumn("connect_id").getUInt64();
+			item.schema = query.getColumn("schema_name").getText();
+			item.object = query.getColumn("object").getText();
+			item.catalog = query.getColumn("catalog").getText();
+			item.name = query.getColumn("name").getText();
+			item.type = query.getColumn("type").getText();
+			item.remarks = query.getColumn("remarks").getText();
+			result.push_back(item);
+		}
+		return result;
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("query metadata_snapshot has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000025", "sorry, system has error when we are loading the metadata snapshot.");
+	}
+}
+
+/**
+ * Replace the objects of the list in one transaction, an empty list is saved as no objects.
+ * The object list is marked by a row with empty name, so the empty lists (such as no events) are restored too.
+ * 
+ * @param connectId
+ * @param schema
+ * @param object
+ * @param items
+ */
+void MetadataSnapshotRepository::save(uint64_t connectId, const std::string & schema, const std::string & object, 
+	const MetadataSnapshotItemList & items)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	createTableIfNotExists();
+	std::string deleteSql = "DELETE FROM metadata_snapshot WHERE connect_id=:connect_id AND schema_name=:schema_name AND object=:object";
+	std::string insertSql = "INSERT INTO metadata_snapshot (connect_id, schema_name, object, seq, catalog, name, type, remarks, version, updated_at) \
+		VALUES (:connect_id, :schema_name, :object, :seq, :catalog, :name, :type, :remarks, :version, datetime())";
+	auto connect = getSysConnect();
+	// the other threads must not run their statements inside the transaction
+	std::lock_guard<std::recursive_mutex> sysLock(connect->getMutex());
+	try {
+		connect->exec("BEGIN");
+		SQLite::QSqlStatement query(connect, deleteSql.c_str());
+		query.bind(":connect_id", connectId);
+		query.bind(":schema_name", schema);
+		query.bind(":object", object);
+		query.exec();
+
+		SQLite::QSqlStatement insertQuery(connect, insertSql.c_str());
+		// seq 0 is the mark of the list
+		for (size_t i = 0; i <= items.size(); i++) {
+			insertQuery.reset();
+			insertQuery.bind(":connect_id", connectId);
+			insertQuery.bind(":schema_name", schema);
+			insertQuery.bind(":object", object);
+			insertQuery.bind(":seq", static_cast<uint64_t>(i));
+			insertQuery.bind(":catalog", i ? items.at(i - 1).catalog : std::string());
+			insertQuery.bind(":name", i ? items.at(i - 1).name : std::string());
+			insertQuery.bind(":type", i ? items.at(i - 1).type : std::string());
+			insertQuery.bind(":remarks", i ? items.at(i - 1).remarks : std::string());
+			insertQuery.bind(":version", static_cast<uint32_t>(SNAPSHOT_VERSION));
+			insertQuery.exec();
+		}
+		connect->exec("COMMIT");
+	} catch (SQLite::QSqlException &e) {
+		connect->tryExec("ROLLBACK");
+		std::string _err = e.getErrorStr();
+		Q_ERROR("save metadata_snapshot has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000026", "sorry, system has error when we are saving the metadata snapshot.");
+	}
+}
+
+void MetadataSnapshotRepository::remove(uint64_t connectId)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	createTableIfNotExists();
+	std::string sql = "DELETE FROM metadata_snapshot WHERE connect_id=:connect_id";
+	try {
+		SQLite::QSqlStatement query(getSysConnect(), sql.c_str());
+		query.bind(":connect_id", connectId);
+		query.exec();
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("delete metadata_snapshot has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000027", "sorry, system has error when we are removing the metadata snapshot.");
+	}
+}
+
+void MetadataSnapshotRepository::remove(uint64_t connectId, const std::string & schema)
+{
+	std::lock_guard<std::mutex> lk(mutex);
+	createTableIfNotExists();
+	std::string sql = "DELETE FROM metadata_snapshot WHERE connect_id=:connect_id AND schema_name=:schema_name";
+	try {
+		SQLite::QSqlStatement query(getSysConnect(), sql.c_str());
+		query.bind(":connect_id", connectId);
+		query.bind(":schema_name", schema);
+		query.exec();
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("delete metadata_snapshot has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000027", "sorry, system has error when we are removing the metadata snapshot.");
+	}
+}
+
+/**
+ * The system db of the installed versions has no metadata_snapshot table, so it is created on the first use.
+ * If the snapshot is saved by another version of the table, the table is dropped and created again, 
+ * the snapshot is only a copy of the server metadata, it is saved again after the next load.
+ */
+void MetadataSnapshotRepository::createTableIfNotExists()
+{
+	if (isTableCreated) {
+		return;
+	}
+	std::string sql = "CREATE TABLE IF NOT EXISTS \"metadata_snapshot\" ( \
+		\"id\" INTEGER NOT NULL DEFAULT (0) UNIQUE, \
+		\"connect_id\" INTEGER NOT NULL DEFAULT (0), \
+		\"schema_name\" TEXT NOT NULL DEFAULT (''), \
+		\"object\" TEXT NOT NULL DEFAULT (''), \
+		\"seq\" INTEGER NOT NULL DEFAULT (0), \
+		\"catalog\" TEXT NOT NULL DEFAULT (''), \
+		\"name\" TEXT NOT NULL DEFAULT (''), \
+		\"type\" TEXT NOT NULL DEFAULT (''), \
+		\"remarks\" TEXT NOT NULL DEFAULT (''), \
+		\"version\" INTEGER NOT NULL DEFAULT (0), \
+		\"updated_at\" datetime NOT NULL DEFAULT (datetime('now', 'localtime')), \
+		PRIMARY KEY(\"id\" AUTOINCREMENT))";
+	std::string indexSql = "CREATE INDEX IF NOT EXISTS \"metadata_snapshot_object\" ON \"metadata_snapshot\" (\"connect_id\", \"schema_name\", \"object\")";
+	std::string versionSql = "SELECT COUNT(*) FROM metadata_snapshot WHERE version<>" + std::to_string(SNAPSHOT_VERSION);
+	try {
+		auto connect = getSysConnect();
+		if (connect->tableExists("metadata_snapshot") && connect->execAndGet(versionSql.c_str()).getInt64() > 0) {
+			Q_INFO("drop the metadata_snapshot of the other version, version:{}", SNAPSHOT_VERSION);
+			connect->exec("DROP TABLE \"metadata_snapshot\"");
+		}
+		connect->exec(sql.c_str());
+		connect->exec(indexSql.c_str());
+		isTableCreated = true;
+	} catch (SQLite::QSqlException &e) {
+		std::string _err = e.getErrorStr();
+		Q_ERROR("create metadata_snapshot has error:{}, msg:{}", e.getErrorCode(), _err);
+		throw QRuntimeException("000028", "sorry, system has error when we are creating the metadata snapshot table.");
+	}
+}
@@ -0,0 +1,44 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com)
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * @file   MetadataSnapshotRepository.h
+ * @brief  The snapshot of the metadata object lists in the system db, the tree is shown from the snapshot
+ *         when the connection is opened, and the snapshot is reconciled against the server in the background.
+ *
+ * @author Xuehan Qin (qinxuehan2018@gmail.com)
+ * @date   2025-01-10
+ *********************************************************************/
+#pragma once
+#include <mutex>
+#include "core/entity/Entity.h"
+#include "core/common/repository/BaseRepository.h"
+
+class MetadataSnapshotRepository : public BaseRepository<MetadataSnapshotRepository>
+{
+public:
+	// the version of the metadata_snapshot table, the table of the other versions is dropped and created again
+	static const int SNAPSHOT_VERSION = 1;
+
+	MetadataSnapshotRepository() {};
+
+	MetadataSnapshotItemList getAll(uint64_t connectId);
+	// replace the objects of the list (connectId, schema, object)
+	void save(uint64_t connectId, const std::string & schema, const std::string & object, const MetadataSnapshotItemList & items);
+	void remove(uint64_t connectId);
+	void remove(uint64_t connectId, const std::string & schema);
+private:
+	// the snapshot is saved by the reconciling thread and the ui thread, the system connect is shared by all threads
+	std::mutex mutex;
+	bool isTableCreated = false;
+
+	void createTableIfNotExists();
+};
@@ -18,6 +18,7 @@
  *********************************************************************/
 #include "ConnectService.h"
 #include "utils/Log.h"
+#include "core/service/db/MetadataService.h"
 
 UserConnectList ConnectService::getAllUserConnects()
 {
@@ -42,6 +43,10 @@ uint64_t ConnectService::createUserConnect(const UserConnect& userConnect)
 uint64_t ConnectService::updateUserConnect(const UserConnect& userConnect)
 {
 	getRepository()->update(userConnect);
+	// the pooled sessions use the old host/user/password
+	getRepository()->closeUserConnect(userConnect.id);
+	// the metadata may be of another server
+	MetadataService::getInstance()->removeSnapshot(userConnect.id);
 	return userConnect.id;
 }
 
@@ -52,7 +57,9 @@ void ConnectService::updateUserConnectSort(uint64_t userConnectId, uint64_t sort
 
 void ConnectService::removeUserConnect(uint64_t userConnectId)
 {
+	getRepository()->closeUserConnect(userConnectId);
 	getRepository()->remove(userConnectId);
+	MetadataService::getInstance()->removeSnapshot(userConnectId);
 }
 
 void ConnectService::testConnect(int64_t userConnectId)
@@ -64,3 +71,24 @@ void ConnectService::connect(int64_t userConnectId)
 {
 	getRepository()->getUserConnect(userConnectId);
 }
+
+/**
+ * Close all the pooled sessions of the user connection.
+ * 
+ * @param userConnectId
+ */
+void ConnectService::disconnect(uint64_t userConnectId)
+{
+	getRepository()->closeUserConnect(userConnectId);
+}
+
+/**
+ * The statistics of the pooled sessions: live/idle/busy sessions, checkouts and wait time of each lane.
+ * 
+ * @param userConnectId
+ * @return 
+ */
+QConnectPoolStats ConnectService::getConnectPoolStats(uint64_t userConnectId)
+{
+	return getRepository()->getUserConnectStats(userConnectId);
+}
@@ -37,6 +37,8 @@ public:
 
 	void testConnect(int64_t userConnectId);
 	void connect(int64_t userConnectId);
+	void disconnect(uint64_t userConnectId);
+	QConnectPoolStats getConnectPoolStats(uint64_t userConnectId);
 
 };
 
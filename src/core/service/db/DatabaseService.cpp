@@ -20,7 +20,64 @@
 #include "DatabaseService.h"
 #include "utils/DateUtil.h"
 #include "utils/Log.h"
+#include "common/AppContext.h"
+#include "core/common/repository/QConnect.h"
 #include "core/common/exception/QRuntimeException.h"
+#include "core/service/db/MetadataService.h"
+
+/**
+ * Wrap the progress callback that is called in the UI thread, the reports are coalesced while the UI thread is busy,
+ * only the latest progress is delivered, so the UI thread is never flooded.
+ * The callback is shared by the posted reports, it is never copied in the working thread.
+ * 
+ * @param progressCallback
+ * @return the callback for the working thread
+ */
+template <typename Progress>
+static std::function<void (const Progress &)> coalesceInUiThread(std::function<void (const Progress &)> progressCallback)
+{
+	struct PendingProgress {
+		std::mutex mutex;
+		Progress progress;
+		bool isPosted = false; // a report is waiting in the UI thread, it takes the latest progress
+	};
+	auto pending = std::make_shared<PendingProgress>();
+	auto callback = std::make_shared<std::function<void (const Progress &)>>(std::move(progressCallback));
+	return [pending, callback](const Progress & progress) {
+		{
+			std::lock_guard<std::mutex> lk(pending->mutex);
+			pending->progress = progress;
+			if (pending->isPosted) {
+				return;
+			}
+			pending->isPosted = true;
+		}
+		AppContext::getInstance()->runInUiThread([pending, callback]() {
+			Progress latest;
+			{
+				std::lock_guard<std::mutex> lk(pending->mutex);
+				latest = pending->progress;
+				pending->isPosted = false;
+			}
+			(*callback)(latest);
+		});
+	};
+}
+
+DatabaseService::~DatabaseService()
+{
+	if (copyExecutor) {
+		{
+			std::lock_guard<std::mutex> lk(copyMutex);
+			for (auto & pair : jobCancelers) {
+				pair.second();
+			}
+		}
+		copyExecutor->shutdown();
+		delete copyExecutor;
+		copyExecutor = nullptr;
+	}
+}
 
 UserDbList DatabaseService::getAllUserDbs(uint64_t connectId)
 {
@@ -64,6 +121,7 @@ void DatabaseService::removeUserDb(uint64_t connectId, const std::string & schem
 	
 	// 2) Remove from system db.
 	getRepository()->remove(connectId, schema);
+	MetadataService::getInstance()->invalidateCache(connectId, schema);
 
 	// 3) Close from connects.
 	// databaseUserRepository->closeUserConnect(userDbId);
@@ -74,20 +132,287 @@ void DatabaseService::createUserDb(const UserDb& userDb)
 	assert(userDb.connectId > 0 && !userDb.name.empty());
 
 	getRepository()->create(userDb);
+	MetadataService::getInstance()->invalidateCache(userDb.connectId, userDb.name);
 }
 
 /**
- * Copy database from fromUserDbId to toDbPath.
+ * Copy all objects and rows of the database to the target database.
  * 
- * @param fromUserDbId - source database dbId
- * @param toDbPath - target database path
- * @return target database db id 
+ * @param fromConnectId - source connect id
+ * @param fromSchema - source database name
+ * @param toConnectId - target connect id
+ * @param toSchema - target database name, it must not exist
+ * @return true if success, throw QRuntimeException if failed
  */
 bool DatabaseService::copyUserDb(uint64_t fromConnectId, const std::string & fromSchema, uint64_t toConnectId, const std::string & toSchema)
 {
+	assert(fromConnectId > 0 && !fromSchema.empty() && toConnectId > 0 && !toSchema.empty());
+	DbCopyParams params;
+	params.fromConnectId = fromConnectId;
+	params.fromSchema = fromSchema;
+	params.toConnectId = toConnectId;
+	params.toSchema = toSchema;
+
+	auto metadataService = MetadataService::getInstance();
+	for (auto & item : metadataService->getUserTables(fromConnectId, fromSchema)) {
+		params.tables.push_back(item.name);
+	}
+	for (auto & item : metadataService->getUserViews(fromConnectId, fromSchema)) {
+		params.views.push_back(item.name);
+	}
+	return copyUserDb(params);
+}
+
+/**
+ * Copy the selected objects of the database in the calling thread, see QDbCopier.
+ * 
+ * @param params
+ * @return true if success, throw QRuntimeException if failed
+ */
+bool DatabaseService::copyUserDb(const DbCopyParams & params)
+{
+	QDbCopier copier(params);
+	copier.run();
+	return true;
+}
+
+/**
+ * Copy the selected objects of the database in the background thread.
+ * 
+ * @param params
+ * @param callback - called in the UI thread when the copy is finished, failed or canceled
+ * @param progressCallback - called in the UI thread with the latest progress, the reports are coalesced
+ *                           while the UI thread is busy, so the UI thread is never flooded
+ * @return copy id
+ */
+uint64_t DatabaseService::copyUserDbAsync(const DbCopyParams & params, DbCopyFinishCallback callback, 
+	DbCopyProgressCallback progressCallback)
+{
+	return runJobAsync(std::make_shared<QDbCopier>(params), callback, progressCallback);
+}
+
+/**
+ * Cancel the running copy, the callback of copyUserDbAsync(...) is called with the error 200029.
+ * 
+ * @param copyId
+ */
+void DatabaseService::cancelCopyUserDb(uint64_t copyId)
+{
+	cancelJob(copyId);
+}
+
+/**
+ * Whether a table of the copy has the checkpoint of an interrupted copy, the copy resumes from the checkpoint.
+ * 
+ * @param params
+ * @return 
+ */
+bool DatabaseService::hasCopyCheckpoint(const DbCopyParams & params)
+{
+	CopyCheckpoint checkpoint;
+	for (auto & tblName : params.tables) {
+		if (CopyCheckpointRepository::getInstance()->get(QDbCopier::getJobKey(params, tblName), checkpoint)) {
+			return true;
+		}
+	}
 	return false;
 }
 
+/**
+ * Import the sql script in the calling thread, see QSqlImporter.
+ * 
+ * @param params
+ * @param progressCallback - called in the calling thread
+ * @return the final progress, throw QRuntimeException if failed
+ */
+SqlImportProgress DatabaseService::importSql(const SqlImportParams & params, SqlImportProgressCallback progressCallback)
+{
+	QSqlImporter importer(params);
+	if (progressCallback) {
+		importer.setProgressCallback(progressCallback);
+	}
+	importer.run();
+	return importer.getProgress();
+}
+
+/**
+ * Import the sql script in the background thread.
+ * 
+ * @param params
+ * @param callback - called in the UI thread when the import is finished, failed or canceled
+ * @param progressCallback - called in the UI thread with the latest progress, the last report has the committed offset
+ *                           to resume from and the skipped errors
+ * @return import id
+ */
+uint64_t DatabaseService::importSqlAsync(const SqlImportParams & params, DbCopyFinishCallback callback, 
+	SqlImportProgressCallback progressCallback)
+{
+	return runJobAsync(std::make_shared<QSqlImporter>(params), callback, progressCallback);
+}
+
+/**
+ * Cancel the running import, the callback of importSqlAsync(...) is called with the error 200030.
+ * 
+ * @param importId
+ */
+void DatabaseService::cancelImportSql(uint64_t importId)
+{
+	cancelJob(importId);
+}
+
+/**
+ * Export the databases as a sql script in the calling thread, see QSqlExporter.
+ * 
+ * @param params
+ * @param progressCallback - called in the calling thread
+ * @return the final progress, throw QRuntimeException if failed
+ */
+SqlExportProgress DatabaseService::exportSql(const SqlExportParams & params, SqlExportProgressCallback progressCallback)
+{
+	QSqlExporter exporter(params);
+	if (progressCallback) {
+		exporter.setProgressCallback(progressCallback);
+	}
+	exporter.run();
+	return exporter.getProgress();
+}
+
+/**
+ * Export the databases as a sql script in the background thread.
+ * 
+ * @param params
+ * @param callback - called in the UI thread when the export is finished, failed or canceled
+ * @param progressCallback - called in the UI thread with the latest progress
+ * @return export id
+ */
+uint64_t DatabaseService::exportSqlAsync(const SqlExportParams & params, DbCopyFinishCallback callback, 
+	SqlExportProgressCallback progressCallback)
+{
+	return runJobAsync(std::make_shared<QSqlExporter>(params), callback, progressCallback);
+}
+
+/**
+ * Cancel the running export, the callback of exportSqlAsync(...) is called with the error 200032.
+ * 
+ * @param exportId
+ */
+void DatabaseService::cancelExportSql(uint64_t exportId)
+{
+	cancelJob(exportId);
+}
+
+/**
+ * Export one table as CSV or INSERT statements in the calling thread, see QTableExporter.
+ * 
+ * @param params
+ * @param progressCallback - called in the exporting threads
+ * @return the final progress, throw QRuntimeException if failed
+ */
+TableExportProgress DatabaseService::exportTable(const TableExportParams & params, TableExportProgressCallback progressCallback)
+{
+	QTableExporter exporter(params);
+	if (progressCallback) {
+		exporter.setProgressCallback(progressCallback);
+	}
+	exporter.run();
+	return exporter.getProgress();
+}
+
+/**
+ * Export one table in the background thread, the ranges are read by the threads of the exporter.
+ * 
+ * @param params
+ * @param callback - called in the UI thread when the export is finished, failed or canceled
+ * @param progressCallback - called in the UI thread with the latest progress
+ * @return export id
+ */
+uint64_t DatabaseService::exportTableAsync(const TableExportParams & params, DbCopyFinishCallback callback, 
+	TableExportProgressCallback progressCallback)
+{
+	return runJobAsync(std::make_shared<QTableExporter>(params), callback, progressCallback);
+}
+
+/**
+ * Cancel the running table export, the callback of exportTableAsync(...) is called with the error 200032.
+ * 
+ * @param exportId
+ */
+void DatabaseService::cancelExportTable(uint64_t exportId)
+{
+	cancelJob(exportId);
+}
+
+/**
+ * Run the job in the background thread, the copy, import and export jobs share the same flow.
+ * 
+ * @param job - QDbCopier, QSqlImporter, QSqlExporter or QTableExporter, it has run() and cancel()
+ * @param callback - called in the UI thread when the job is finished, failed or canceled
+ * @param progressCallback - called in the UI thread with the latest progress, the reports are coalesced
+ * @return job id for cancelJob(...)
+ */
+template <typename Job, typename Progress>
+uint64_t DatabaseService::runJobAsync(std::shared_ptr<Job> job, DbCopyFinishCallback callback, 
+	std::function<void (const Progress &)> progressCallback)
+{
+	if (progressCallback) {
+		job->setProgressCallback(coalesceInUiThread<Progress>(std::move(progressCallback)));
+	}
+	// the job and the callbacks hold the references of the UI windows, they are released in the UI thread only
+	struct FinishedJob {
+		std::shared_ptr<Job> job;
+		DbCopyFinishCallback callback;
+	};
+	auto finished = std::make_shared<FinishedJob>();
+	finished->job = job;
+	finished->callback = std::move(callback);
+	std::weak_ptr<Job> weakJob = job;
+	job.reset();
+	uint64_t jobId = 0;
+	{
+		std::lock_guard<std::mutex> lk(copyMutex);
+		jobId = nextCopyId++;
+		jobCancelers[jobId] = [weakJob]() {
+			auto job = weakJob.lock();
+			if (job) {
+				job->cancel();
+			}
+		};
+	}
+	getCopyExecutor()->submit(jobId, [this, jobId, finished]() {
+		bool isSuccess = false;
+		std::string code, msg;
+		try {
+			finished->job->run();
+			isSuccess = true;
+		} catch (QRuntimeException & ex) {
+			code = ex.getCode();
+			msg = ex.getMsg();
+		}
+		{
+			std::lock_guard<std::mutex> lk(copyMutex);
+			jobCancelers.erase(jobId);
+		}
+		AppContext::getInstance()->runInUiThread([finished, isSuccess, code, msg]() {
+			// take the job and the callback out, the copies of this lambda may be released in the working thread
+			auto job = std::move(finished->job);
+			auto callback = std::move(finished->callback);
+			if (callback) {
+				callback(isSuccess, code, msg);
+			}
+		});
+	});
+	return jobId;
+}
+
+void DatabaseService::cancelJob(uint64_t jobId)
+{
+	std::lock_guard<std::mutex> lk(copyMutex);
+	auto iter = jobCancelers.find(jobId);
+	if (iter != jobCancelers.end()) {
+		iter->second();
+	}
+}
+
 /**
  * Get system function strings.
  * 
@@ -102,3 +427,12 @@ std::vector<std::string> DatabaseService::getSysFunctionStrings(uint64_t connect
 
 	return result;
 }
+
+QTaskExecutor * DatabaseService::getCopyExecutor()
+{
+	if (copyExecutor == nullptr) {
+		// mysql driver must be initialized in every thread that uses it
+		copyExecutor = new QTaskExecutor(2, []() { QConnect::getDriver()->threadInit(); }, []() { QConnect::getDriver()->threadEnd(); });
+	}
+	return copyExecutor;
+}
@@ -18,12 +18,26 @@
  * @date   2023-05-19
  *********************************************************************/
 #pragma once
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include "core/common/service/BaseService.h"
+#include "core/common/executor/QTaskExecutor.h"
+#include "core/common/copier/QDbCopier.h"
+#include "core/common/importer/QSqlImporter.h"
+#include "core/common/exporter/QSqlExporter.h"
+#include "core/common/exporter/QTableExporter.h"
 #include "core/repository/db/UserDbRepository.h"
 
+// The result of async copy, import or export, it is called in the UI thread, code and msg are the error if failed
+typedef std::function<void (bool isSuccess, const std::string & code, const std::string & msg)> DbCopyFinishCallback;
+
 class DatabaseService : public BaseService<DatabaseService, UserDbRepository>
 {
 public:
+	~DatabaseService();
+
 	// user db operations
 	UserDbList getAllUserDbs(uint64_t connectId);
 	bool hasUserDb(uint64_t connectId, const std::string & schema);
@@ -31,8 +45,37 @@ public:
 	void removeUserDb(uint64_t connectId, const std::string & schema);
 	void createUserDb(const UserDb& userDb);
 	bool copyUserDb(uint64_t fromConnectId, const std::string & fromSchema, uint64_t toConnectId, const std::string & toSchema);
+	bool copyUserDb(const DbCopyParams & params);
+	// copy in the background thread, return the copy id for cancelCopyUserDb(...), progressCallback is called in the UI thread
+	uint64_t copyUserDbAsync(const DbCopyParams & params, DbCopyFinishCallback callback, DbCopyProgressCallback progressCallback = nullptr);
+	void cancelCopyUserDb(uint64_t copyId);
+	bool hasCopyCheckpoint(const DbCopyParams & params);
+	// import the sql script in process, return the progress, it has the errors that are skipped if continueOnError
+	SqlImportProgress importSql(const SqlImportParams & params, SqlImportProgressCallback progressCallback = nullptr);
+	// import in the background thread, return the import id for cancelImportSql(...), progressCallback is called in the UI thread
+	uint64_t importSqlAsync(const SqlImportParams & params, DbCopyFinishCallback callback, SqlImportProgressCallback progressCallback = nullptr);
+	void cancelImportSql(uint64_t importId);
+	// export the databases as a sql script in process, return the final progress
+	SqlExportProgress exportSql(const SqlExportParams & params, SqlExportProgressCallback progressCallback = nullptr);
+	// export in the background thread, return the export id for cancelExportSql(...), progressCallback is called in the UI thread
+	uint64_t exportSqlAsync(const SqlExportParams & params, DbCopyFinishCallback callback, SqlExportProgressCallback progressCallback = nullptr);
+	void cancelExportSql(uint64_t exportId);
+	// export one table as CSV or INSERT statements by the ranges of the primary key in parallel, return the final progress
+	TableExportProgress exportTable(const TableExportParams & params, TableExportProgressCallback progressCallback = nullptr);
+	// export in the background thread, return the export id for cancelExportTable(...), progressCallback is called in the UI thread
+	uint64_t exportTableAsync(const TableExportParams & params, DbCopyFinishCallback callback, TableExportProgressCallback progressCallback = nullptr);
+	void cancelExportTable(uint64_t exportId);
 
 	std::vector<std::string> getSysFunctionStrings(uint64_t connectId, const std::string& schema, bool upcase);
 private:
+	QTaskExecutor * copyExecutor = nullptr;
+	std::mutex copyMutex;
+	uint64_t nextCopyId = 1;
+	// job id => cancel the running copier, importer or exporter, guarded by copyMutex
+	std::unordered_map<uint64_t, std::function<void ()>> jobCancelers;
 
+	QTaskExecutor * getCopyExecutor();
+	template <typename Job, typename Progress>
+	uint64_t runJobAsync(std::shared_ptr<Job> job, DbCopyFinishCallback callback, std::function<void (const Progress &)> progressCallback);
+	void cancelJob(uint64_t jobId);
 };
@@ -1,18 +1,741 @@
 #include "ExecutorService.h"
+#include <algorithm>
+#include <cstdlib>
+#include <thread>
+#include "common/Config.h"
+#include "common/AppContext.h"
+#include "core/common/repository/QConnect.h"
+#include "core/common/exception/QRuntimeException.h"
+#include "core/service/db/MetadataService.h"
+#include "utils/SqlUtil.h"
 
-sql::ResultSet * ExecutorService::executeQuerySql(uint64_t connectId, const std::string& schema, const std::string& sql)
+ExecutorService::ExecutorService()
 {
-     return getRepository()->executeQuery(connectId, schema, sql);
 }
 
-int ExecutorService::executeSql(uint64_t connectId, const std::string& schema, const std::string& sql)
+ExecutorService::~ExecutorService()
 {
-    return getRepository()->execute(connectId, schema, sql);
+	if (taskExecutor) {
+		taskExecutor->shutdown();
+		delete taskExecutor;
+		taskExecutor = nullptr;
+	}
+	if (killExecutor) {
+		killExecutor->shutdown();
+		delete killExecutor;
+		killExecutor = nullptr;
+	}
 }
 
-const PerfTime& ExecutorService::getPerfTime() const
+sql::ResultSet * ExecutorService::executeQuerySql(uint64_t connectId, const std::string& schema, const std::string& sql, QExecTrace * trace)
 {
-     return getRepository()->getPerfTime();
+     return getRepository()->executeQuery(connectId, schema, sql, 0, trace);
 }
 
+int ExecutorService::executeSql(uint64_t connectId, const std::string& schema, const std::string& sql, QExecTrace * trace)
+{
+    int result = getRepository()->execute(connectId, schema, sql, 0, trace);
+    if (SqlUtil::isDdlSql(sql)) {
+        MetadataService::getInstance()->invalidateCache(connectId);
+    }
+    return result;
+}
+
+/**
+ * Open a session for async execution, the statements of the same session run one by one in the same mysql session.
+ * 
+ * @param isPacket - true: the pipelined statements and the status probes are sent in one packet, 
+ *                   the mysql session is created with CLIENT_MULTI_STATEMENTS; false: they are sent one by one
+ * @return session key
+ */
+uint64_t ExecutorService::openSession(bool isPacket)
+{
+	uint64_t sessionKey = nextSessionKey++;
+	if (isPacket) {
+		getRepository()->setPacketSession(sessionKey);
+	}
+	return sessionKey;
+}
+
+/**
+ * Cancel the pending statements of the session and return the pinned mysql session to the pool.
+ * If a batch is running, its statement is killed and the batch does not end its transaction, 
+ * the mysql session is discarded after the batch stops, so the open transaction is rolled back by the server.
+ * 
+ * @param connectId
+ * @param sessionKey
+ */
+void ExecutorService::closeSession(uint64_t connectId, uint64_t sessionKey)
+{
+	if (!sessionKey) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lk(cancelMutex);
+		closedSessions.insert(sessionKey);
+		sessionTimeouts.erase(sessionKey);
+	}
+	cancelAsync(sessionKey);
+	// the pending tasks are canceled, so the session is busy only if a batch is running
+	bool isBusy = isSessionBusy(sessionKey);
+	if (connectId && isBusy) {
+		killQueryAsync(connectId, sessionKey);
+	}
+	// the release runs after the running batch in the same serial, the session is not pooled under the running statement
+	getTaskExecutor()->submit(sessionKey, [this, connectId, sessionKey, isBusy]() {
+		if (connectId) {
+			getRepository()->releaseSession(connectId, sessionKey, isBusy);
+		}
+		std::lock_guard<std::mutex> lk(cancelMutex);
+		closedSessions.erase(sessionKey);
+		cancelGenerations.erase(sessionKey);
+	});
+}
+
+bool ExecutorService::isSessionBusy(uint64_t sessionKey)
+{
+	return getTaskExecutor()->isBusy(sessionKey);
+}
+
+/**
+ * Cancel the pending statements of the session, the running batch stops before its next statement.
+ * 
+ * @param sessionKey
+ * @return the count of canceled tasks
+ */
+size_t ExecutorService::cancelAsync(uint64_t sessionKey)
+{
+	{
+		std::lock_guard<std::mutex> lk(cancelMutex);
+		cancelGenerations[sessionKey]++;
+	}
+	return getTaskExecutor()->cancel(sessionKey);
+}
+
+/**
+ * Execute a query statement in the worker thread.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sql
+ * @param sessionKey - from openSession()
+ * @param callback - called in the UI thread, ExecuteResult::resultSet is the result set of the query
+ * @return task id
+ */
+uint64_t ExecutorService::executeQuerySqlAsync(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey, 
+	ExecuteResultCallback callback)
+{
+	ExecuteStatementList statements;
+	statements.push_back({ sql, true });
+	return executeSqlsAsync(connectId, schema, statements, sessionKey, false, callback);
+}
+
+/**
+ * Execute a query statement in the worker thread with the unbuffered, forward-only result set,
+ * the rows are delivered to batchCallback batch by batch while fetching, so the first rows can be shown at once.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sql
+ * @param sessionKey - from openSession()
+ * @param fetchSize - the rows count of one batch
+ * @param batchCallback - called in the UI thread for each batch of rows
+ * @param callback - called in the UI thread after the fetch finished, failed or stopped
+ * @param captureStatus - capture the session status deltas of the query, see ExecuteResult::statusDeltas
+ * @return task id
+ */
+uint64_t ExecutorService::executeQueryStreamAsync(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey, 
+	uint32_t fetchSize, ExecuteRowBatchCallback batchCallback, ExecuteResultCallback callback, bool captureStatus)
+{
+	ExecuteStatementList statements;
+	statements.push_back({ sql, true, (std::max)(fetchSize, 1U), false, captureStatus });
+	return executeSqlsAsync(connectId, schema, statements, sessionKey, false, callback, nullptr, batchCallback);
+}
+
+/**
+ * Execute a INSERT/UPDATE/DELETE/DDL statement in the worker thread.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sql
+ * @param sessionKey - from openSession()
+ * @param callback - called in the UI thread
+ * @return task id
+ */
+uint64_t ExecutorService::executeSqlAsync(uint64_t connectId, const std::string& schema, const std::string& sql, uint64_t sessionKey, 
+	ExecuteResultCallback callback)
+{
+	ExecuteStatementList statements;
+	statements.push_back({ sql, false });
+	return executeSqlsAsync(connectId, schema, statements, sessionKey, false, callback);
+}
 
+/**
+ * Execute the statements one by one in the worker thread, stop at the first failed statement.
+ * 
+ * @param connectId
+ * @param schema
+ * @param statements
+ * @param sessionKey - from openSession()
+ * @param inTransaction - true: BEGIN before the statements, COMMIT after all success or ROLLBACK when a statement fails
+ * @param callback - called in the UI thread for each statement
+ * @param finishCallback - called in the UI thread after the batch finished
+ * @param batchCallback - called in the UI thread for each batch of rows of the streaming query (ExecuteStatement::fetchSize > 0)
+ * @return task id
+ */
+uint64_t ExecutorService::executeSqlsAsync(uint64_t connectId, const std::string& schema, const ExecuteStatementList& statements, uint64_t sessionKey, 
+	bool inTransaction, ExecuteResultCallback callback, ExecuteFinishCallback finishCallback, ExecuteRowBatchCallback batchCallback)
+{
+	assert(connectId > 0 && sessionKey > 0);
+	uint64_t generation = getCancelGeneration(sessionKey);
+	auto task = [this, connectId, schema, statements, sessionKey, inTransaction, callback, finishCallback, batchCallback, generation]() {
+		bool hasError = false;
+		int total = static_cast<int>(statements.size());
+		// only the packet session sends the pipelined statements and the status probes in one round trip
+		bool isPacket = getRepository()->isPacketSession(sessionKey);
+		try {
+			// it only runs when the timeout of the session is changed
+			getRepository()->setExecutionTimeout(connectId, sessionKey, getSessionTimeout(sessionKey) * 1000);
+		} catch (sql::SQLException& ex) {
+			// such as the server does not support max_execution_time, the statements run without timeout
+			Q_ERROR("Fail to set the execution timeout, code:{}, error:{}", ex.getErrorCode(), ex.what());
+		} catch (QRuntimeException& ex) {
+			Q_ERROR("Fail to set the execution timeout, code:{}, error:{}", ex.getCode(), ex.getMsg());
+		}
+		if (inTransaction) {
+			try {
+				getRepository()->execute(connectId, schema, "BEGIN;", sessionKey);
+			} catch (sql::SQLException& ex) {
+				Q_ERROR("Fail to begin transaction, code:{}, error:{}", ex.getErrorCode(), ex.what());
+				hasError = true;
+			}
+		}
+
+		for (int i = 0, end = 0; i < total; i = end) {
+			// the consecutive pipelined statements [i, end) are executed in one round trip
+			end = isPacket ? getPipelineEnd(statements, i) : i + 1;
+			std::vector<std::shared_ptr<ExecuteResult>> results;
+			for (int j = i; j < end; j++) {
+				auto result = std::make_shared<ExecuteResult>();
+				result->sessionKey = sessionKey;
+				result->connectId = connectId;
+				result->schema = schema;
+				result->sql = statements.at(j).sql;
+				result->isQuery = statements.at(j).isQuery;
+				result->index = j;
+				result->total = total;
+				// the pipelined statements are executed in one round trip, they share the same trace
+				result->trace = j == i ? std::make_shared<QExecTrace>(result->sql) : results.front()->trace;
+				results.push_back(result);
+			}
+			if (hasError || getCancelGeneration(sessionKey) != generation) {
+				for (auto & result : results) {
+					result->status = EXECUTE_SKIPPED;
+					postResult(callback, result);
+				}
+				continue;
+			}
+			for (auto & result : results) {
+				result->status = EXECUTE_RUNNING;
+			}
+			postProgress(*results.front());
+
+			const auto & statement = statements.at(i);
+			bool captureStatus = isPacket && statement.captureStatus;
+			if (results.size() > 1) {
+				executePipeline(results, captureStatus);
+			} else if (statement.isQuery && statement.fetchSize) {
+				fetchStatement(*results.front(), statement.fetchSize, generation, batchCallback, captureStatus);
+			} else {
+				executeStatement(*results.front(), captureStatus);
+			}
+			for (auto & result : results) {
+				hasError = hasError || result->status == EXECUTE_FAILED;
+				// the DDL may qualify the objects of the other databases, so the metadata of the connection is removed
+				if (result->status == EXECUTE_SUCCESS && SqlUtil::isDdlSql(result->sql)) {
+					MetadataService::getInstance()->invalidateCache(connectId);
+				}
+				postResult(callback, result);
+			}
+			postProgress(*results.back());
+		}
+
+		// the closed session is discarded after the batch, the server rolls back its transaction
+		if (inTransaction && !isSessionClosed(sessionKey)) {
+			try {
+				getRepository()->execute(connectId, schema, hasError ? "ROLLBACK;" : "COMMIT;", sessionKey);
+			} catch (sql::SQLException& ex) {
+				Q_ERROR("Fail to end transaction, code:{}, error:{}", ex.getErrorCode(), ex.what());
+				hasError = true;
+			}
+		}
+		
+		if (finishCallback) {
+			AppContext::getInstance()->runInUiThread([finishCallback, hasError]() {
+				finishCallback(hasError);
+			});
+		}
+	};
+	return getTaskExecutor()->submit(sessionKey, task);
+}
+
+/**
+ * Stop the streaming fetch of the session, the rows that have been delivered are kept.
+ * The statements after the stopped query in the same batch are skipped.
+ * The unread rows are not drained when the result set is closed, the query is killed by KILL QUERY.
+ * 
+ * @param connectId
+ * @param sessionKey
+ */
+void ExecutorService::stopFetch(uint64_t connectId, uint64_t sessionKey)
+{
+	cancelQuery(connectId, sessionKey);
+}
+
+/**
+ * Cancel the pending statements of the session, and kill the running statement by KILL QUERY 
+ * in a side session, the running statement fails with ER_QUERY_INTERRUPTED (1317).
+ * The side session is connected in the kill thread, so the UI thread is not blocked, 
+ * and the kill does not wait for a free worker when all the workers run the statements.
+ * 
+ * @param connectId
+ * @param sessionKey
+ */
+void ExecutorService::cancelQuery(uint64_t connectId, uint64_t sessionKey)
+{
+	cancelAsync(sessionKey);
+	if (!connectId || !isSessionBusy(sessionKey)) {
+		return;
+	}
+	killQueryAsync(connectId, sessionKey);
+}
+
+/**
+ * Kill the statement that is running now, the kill is sent later in the kill thread, 
+ * it is dropped if another statement of the session has started.
+ * 
+ * @param connectId
+ * @param sessionKey
+ */
+void ExecutorService::killQueryAsync(uint64_t connectId, uint64_t sessionKey)
+{
+	uint64_t statementSeq = getRepository()->getStatementSeq(sessionKey);
+	getKillExecutor()->submit(sessionKey, [this, connectId, sessionKey, statementSeq]() {
+		try {
+			getRepository()->killQuery(connectId, sessionKey, statementSeq);
+		} catch (QRuntimeException& ex) {
+			Q_ERROR("Fail to cancel the query, code:{}, error:{}", ex.getCode(), ex.getMsg());
+		}
+	});
+}
+
+/**
+ * Set the timeout of the session, it is applied as max_execution_time of the mysql session before the next statements.
+ * 
+ * @param sessionKey
+ * @param seconds - 0 - no timeout
+ */
+void ExecutorService::setSessionTimeout(uint64_t sessionKey, uint32_t seconds)
+{
+	std::lock_guard<std::mutex> lk(cancelMutex);
+	sessionTimeouts[sessionKey] = seconds;
+}
+
+QTaskExecutor * ExecutorService::getTaskExecutor()
+{
+	if (taskExecutor == nullptr) {
+		size_t n = (std::max)(size_t(2), (std::min)(size_t(8), size_t(std::thread::hardware_concurrency())));
+		// mysql driver must be initialized in every thread that uses it
+		taskExecutor = new QTaskExecutor(n, []() { QConnect::getDriver()->threadInit(); }, []() { QConnect::getDriver()->threadEnd(); });
+	}
+	return taskExecutor;
+}
+
+QTaskExecutor * ExecutorService::getKillExecutor()
+{
+	std::lock_guard<std::mutex> lk(cancelMutex);
+	if (killExecutor == nullptr) {
+		killExecutor = new QTaskExecutor(1, []() { QConnect::getDriver()->threadInit(); }, []() { QConnect::getDriver()->threadEnd(); });
+	}
+	return killExecutor;
+}
+
+bool ExecutorService::isSessionClosed(uint64_t sessionKey)
+{
+	std::lock_guard<std::mutex> lk(cancelMutex);
+	return closedSessions.count(sessionKey) > 0;
+}
+
+uint64_t ExecutorService::getCancelGeneration(uint64_t sessionKey)
+{
+	std::lock_guard<std::mutex> lk(cancelMutex);
+	auto iter = cancelGenerations.find(sessionKey);
+	return iter == cancelGenerations.end() ? 0 : iter->second;
+}
+
+uint32_t ExecutorService::getSessionTimeout(uint64_t sessionKey)
+{
+	std::lock_guard<std::mutex> lk(cancelMutex);
+	auto iter = sessionTimeouts.find(sessionKey);
+	return iter == sessionTimeouts.end() ? 0 : iter->second;
+}
+
+namespace {
+	// The session status variables that show how the statement reads the rows, the Handler_read_* are the rows read by
+	// the storage engine (there is no Rows_examined in the session status), the others are the temporary tables, sorts and joins
+	const char * STATUS_PROBE_SQL = "SHOW SESSION STATUS WHERE Variable_name IN ("
+		"'Handler_read_first','Handler_read_key','Handler_read_last','Handler_read_next','Handler_read_prev',"
+		"'Handler_read_rnd','Handler_read_rnd_next','Created_tmp_tables','Created_tmp_disk_tables',"
+		"'Sort_merge_passes','Sort_range','Sort_rows','Sort_scan','Select_full_join','Select_range','Select_scan')";
+
+	typedef std::vector<std::pair<std::string, int64_t>> StatusSnapshot;
+
+	/**
+	 * The probe of the session status, the snapshots are appended in the order of SqlProbe::reader calls:
+	 * two snapshots before the first statement, then one snapshot after every executed statement.
+	 */
+	SqlProbe makeStatusProbe(std::vector<StatusSnapshot> & snapshots)
+	{
+		SqlProbe probe;
+		probe.sql = STATUS_PROBE_SQL;
+		probe.reader = [&snapshots](sql::ResultSet * resultSet) {
+			StatusSnapshot snapshot;
+			while (resultSet->next()) {
+				snapshot.push_back({ resultSet->getString(1).asStdString(), 
+					static_cast<int64_t>(std::strtoll(resultSet->getString(2).c_str(), nullptr, 10)) });
+			}
+			snapshots.push_back(snapshot);
+		};
+		return probe;
+	}
+
+	/**
+	 * The status deltas of the index-th statement, the effect of the probe itself (the delta of the first two snapshots) 
+	 * is subtracted, only the changed variables are returned.
+	 * 
+	 * @param snapshots
+	 * @param index - the statement index in the packet
+	 * @return empty if the statement has not been executed
+	 */
+	StatusDeltas getStatusDeltas(const std::vector<StatusSnapshot> & snapshots, size_t index)
+	{
+		StatusDeltas deltas;
+		if (snapshots.size() < index + 3) {
+			return deltas;
+		}
+		auto & first = snapshots.at(0), & second = snapshots.at(1);
+		auto & before = snapshots.at(index + 1), & after = snapshots.at(index + 2);
+		size_t n = (std::min)({ first.size(), second.size(), before.size(), after.size() });
+		for (size_t i = 0; i < n; i++) {
+			int64_t overhead = second.at(i).second - first.at(i).second;
+			int64_t delta = after.at(i).second - before.at(i).second - overhead;
+			if (delta > 0) {
+				deltas.push_back({ after.at(i).first, delta });
+			}
+		}
+		return deltas;
+	}
+}
+
+void ExecutorService::executeStatement(ExecuteResult & result, bool captureStatus)
+{
+	std::vector<StatusSnapshot> snapshots;
+	SqlProbe probe = makeStatusProbe(snapshots);
+	const SqlProbe * statusProbe = captureStatus ? &probe : nullptr;
+	try {
+		if (result.isQuery) {
+			result.resultSet.reset(getRepository()->executeQuery(result.connectId, result.schema, result.sql, result.sessionKey, 
+				result.trace.get(), statusProbe));
+			result.effectRows = result.resultSet ? static_cast<int64_t>(result.resultSet->rowsCount()) : 0;
+		} else {
+			result.effectRows = getRepository()->executeUpdate(result.connectId, result.schema, result.sql, result.sessionKey, 
+				result.trace.get(), statusProbe);
+		}
+		result.statusDeltas = getStatusDeltas(snapshots, 0);
+		result.status = EXECUTE_SUCCESS;
+	} catch (sql::SQLException& ex) {
+		result.status = EXECUTE_FAILED;
+		result.code = std::to_string(ex.getErrorCode());
+		result.msg = ex.what();
+	} catch (QRuntimeException& ex) {
+		// such as fail to connect the mysql
+		result.status = EXECUTE_FAILED;
+		result.code = ex.getCode();
+		result.msg = ex.getMsg();
+	}
+}
+
+/**
+ * Execute the pipelined statements in one round trip, every statement keeps its own status, rows count and error.
+ * The statements after the failed one are not executed by the server, they are skipped.
+ * 
+ * @param results - the results of the consecutive statements, status is EXECUTE_RUNNING
+ * @param captureStatus - the status probes are sent in the same round trip
+ */
+void ExecutorService::executePipeline(std::vector<std::shared_ptr<ExecuteResult>> & results, bool captureStatus)
+{
+	assert(!results.empty());
+	auto & first = *results.front();
+	std::vector<std::string> sqls;
+	for (auto & result : results) {
+		sqls.push_back(result->sql);
+	}
+	std::vector<StatusSnapshot> snapshots;
+	SqlProbe probe = makeStatusProbe(snapshots);
+	size_t executed = 0;
+	try {
+		getRepository()->executeMulti(first.connectId, first.schema, sqls, [&](size_t index, int64_t effectRows) {
+			results.at(index)->effectRows = effectRows;
+			results.at(index)->status = EXECUTE_SUCCESS;
+			executed = index + 1;
+		}, first.sessionKey, first.trace.get(), captureStatus ? &probe : nullptr);
+	} catch (sql::SQLException& ex) {
+		results.at(executed)->status = EXECUTE_FAILED;
+		results.at(executed)->code = std::to_string(ex.getErrorCode());
+		results.at(executed)->msg = ex.what();
+	} catch (QRuntimeException& ex) {
+		// such as fail to connect the mysql
+		results.at(executed)->status = EXECUTE_FAILED;
+		results.at(executed)->code = ex.getCode();
+		results.at(executed)->msg = ex.getMsg();
+	}
+
+	for (size_t i = 0; i < results.size(); i++) {
+		auto & result = results.at(i);
+		if (result->status == EXECUTE_RUNNING) {
+			result->status = EXECUTE_SKIPPED;
+		} else if (result->status == EXECUTE_SUCCESS) {
+			result->statusDeltas = getStatusDeltas(snapshots, i);
+		}
+	}
+}
+
+/**
+ * The end of the pipeline that begins at statement begin, the pipeline is limited by 
+ * PIPELINE_MAX_STATEMENTS and PIPELINE_MAX_BYTES, so the packet is less than max_allowed_packet.
+ * 
+ * @param statements
+ * @param begin
+ * @return the index after the last statement of the pipeline, begin + 1 if the statement is not pipelined
+ */
+int ExecutorService::getPipelineEnd(const ExecuteStatementList & statements, int begin)
+{
+	const int PIPELINE_MAX_STATEMENTS = 200;
+	const size_t PIPELINE_MAX_BYTES = 512 * 1024;
+	int end = begin + 1;
+	if (!statements.at(begin).pipelined || statements.at(begin).isQuery) {
+		return end;
+	}
+	size_t bytes = statements.at(begin).sql.size();
+	int total = static_cast<int>(statements.size());
+	while (end < total && end - begin < PIPELINE_MAX_STATEMENTS 
+		&& statements.at(end).pipelined && !statements.at(end).isQuery
+		&& bytes + statements.at(end).sql.size() <= PIPELINE_MAX_BYTES) {
+		bytes += statements.at(end).sql.size();
+		end++;
+	}
+	return end;
+}
+
+namespace {
+	/**
+	 * Accumulate the time of ResultSet::next() (fetch) and QResultBuffer::appendRow(...) (convert) of the rows, 
+	 * the first ResultSet::next() is the first row latency. Nothing is timed if the trace is nullptr.
+	 */
+	class FetchTimer {
+	public:
+		FetchTimer(QExecTrace * trace) : trace(trace) {}
+
+		bool next(sql::ResultSet * resultSet) {
+			if (!trace) {
+				return resultSet->next();
+			}
+			auto begin = std::chrono::steady_clock::now();
+			bool hasRow = resultSet->next();
+			auto end = std::chrono::steady_clock::now();
+			if (isFirst) {
+				trace->addSpan(QExecTrace::FIRST_ROW, begin, end);
+				isFirst = false;
+			} else {
+				fetch.add(begin, end);
+			}
+			return hasRow;
+		}
+
+		void appendRow(QResultBuffer & rows, sql::ResultSet * resultSet) {
+			if (!trace) {
+				rows.appendRow(resultSet);
+				return;
+			}
+			auto begin = std::chrono::steady_clock::now();
+			rows.appendRow(resultSet);
+			convert.add(begin, std::chrono::steady_clock::now());
+		}
+
+		void flush() {
+			if (trace) {
+				fetch.flush(trace, QExecTrace::FETCH);
+				convert.flush(trace, QExecTrace::CONVERT);
+			}
+		}
+	private:
+		struct Pieces {
+			QExecTrace::TimePoint begin;
+			QExecTrace::TimePoint end;
+			std::chrono::steady_clock::duration duration = std::chrono::steady_clock::duration::zero();
+			uint64_t count = 0;
+
+			void add(QExecTrace::TimePoint pieceBegin, QExecTrace::TimePoint pieceEnd) {
+				if (!count) {
+					begin = pieceBegin;
+				}
+				end = pieceEnd;
+				duration += pieceEnd - pieceBegin;
+				count++;
+			}
+			void flush(QExecTrace * trace, const char * name) {
+				trace->addSpan(name, begin, end, duration, count);
+				duration = std::chrono::steady_clock::duration::zero();
+				count = 0;
+			}
+		};
+
+		QExecTrace * trace;
+		bool isFirst = true;
+		Pieces fetch;
+		Pieces convert;
+	};
+}
+
+/**
+ * Fetch the rows of the query by the forward-only result set, and deliver them to the UI thread batch by batch.
+ * The first batch is small and a batch is also delivered after 200ms, so the first rows are shown at once.
+ * 
+ * @param result
+ * @param fetchSize - the rows count of one batch
+ * @param generation - the cancel generation of the session when the task was submitted
+ * @param batchCallback
+ * @param captureStatus - the status probes are sent in the same round trip
+ */
+void ExecutorService::fetchStatement(ExecuteResult & result, uint32_t fetchSize, uint64_t generation, ExecuteRowBatchCallback batchCallback, 
+	bool captureStatus)
+{
+	const uint32_t firstBatchRows = (std::min)(fetchSize, 100U);
+	const int maxPendingBatches = 8; // the worker waits if the UI thread is slower than the server
+	auto pendingBatches = std::make_shared<std::atomic<int>>(0);
+
+	auto postBatch = [&](std::shared_ptr<ExecuteRowBatch> batch) {
+		while (pendingBatches->load() >= maxPendingBatches && getCancelGeneration(result.sessionKey) == generation) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		}
+		if (!batchCallback) {
+			return;
+		}
+		(*pendingBatches)++;
+		AppContext::getInstance()->runInUiThread([batchCallback, batch, pendingBatches]() {
+			(*pendingBatches)--;
+			batchCallback(*batch);
+		});
+	};
+
+	std::vector<StatusSnapshot> snapshots;
+	SqlProbe probe = makeStatusProbe(snapshots);
+	try {
+		getRepository()->executeQueryStream(result.connectId, result.schema, result.sql, fetchSize, 
+			[&](sql::ResultSet * resultSet) {
+			auto metaData = resultSet->getMetaData();
+			int n = static_cast<int>(metaData->getColumnCount());
+			auto batch = std::make_shared<ExecuteRowBatch>();
+			batch->sessionKey = result.sessionKey;
+			batch->index = result.index;
+			batch->isFirst = true;
+			batch->trace = result.trace;
+			for (int i = 0; i < n; i++) {
+				batch->columns.push_back(metaData->getColumnName(i + 1).asStdString());
+			}
+			// the numeric cells keep the native values, the text cells keep the UTF-8 bytes until they are drawn
+			batch->rows.reset(resultSet);
+			Columns columns = batch->columns;
+			QCellTypes types = batch->rows.getColumnTypes();
+
+			uint32_t batchRows = firstBatchRows, rows = 0;
+			auto lastPostAt = std::chrono::steady_clock::now();
+			// the fetch and convert time of rows are accumulated, and recorded to the trace when the batch is posted
+			FetchTimer timer(result.trace.get());
+			while (timer.next(resultSet)) {
+				timer.appendRow(batch->rows, resultSet);
+				result.effectRows++;
+				rows++;
+				if (rows < batchRows && (rows & 63) != 0) {
+					continue;
+				}
+				// check the stop and the elapsed time every 64 rows
+				if (getCancelGeneration(result.sessionKey) != generation) {
+					result.isStopped = true;
+					break;
+				}
+				auto now = std::chrono::steady_clock::now();
+				if (rows >= batchRows || now - lastPostAt >= std::chrono::milliseconds(200)) {
+					batch->fetchedRows = result.effectRows;
+					timer.flush();
+					postBatch(batch);
+					batch = std::make_shared<ExecuteRowBatch>();
+					batch->sessionKey = result.sessionKey;
+					batch->index = result.index;
+					batch->trace = result.trace;
+					batch->rows.reset(columns, types);
+					batchRows = fetchSize;
+					rows = 0;
+					lastPostAt = now;
+				}
+			}
+			timer.flush();
+			if (batch->isFirst || !batch->rows.empty()) {
+				batch->fetchedRows = result.effectRows;
+				postBatch(batch);
+			}
+		}, result.sessionKey, result.trace.get(), captureStatus ? &probe : nullptr);
+		// the stopped fetch reads the unread rows before the last probe, the deltas include them
+		result.statusDeltas = getStatusDeltas(snapshots, 0);
+		result.status = EXECUTE_SUCCESS;
+	} catch (sql::SQLException& ex) {
+		if (result.effectRows > 0 && getCancelGeneration(result.sessionKey) != generation) {
+			// the rest rows are interrupted by cancelQuery(...), the delivered rows are kept
+			result.isStopped = true;
+			result.status = EXECUTE_SUCCESS;
+			return;
+		}
+		result.status = EXECUTE_FAILED;
+		result.code = std::to_string(ex.getErrorCode());
+		result.msg = ex.what();
+	} catch (QRuntimeException& ex) {
+		// such as fail to connect the mysql
+		result.status = EXECUTE_FAILED;
+		result.code = ex.getCode();
+		result.msg = ex.getMsg();
+	}
+}
+
+void ExecutorService::postResult(ExecuteResultCallback callback, std::shared_ptr<ExecuteResult> result)
+{
+	if (!callback) {
+		return;
+	}
+	AppContext::getInstance()->runInUiThread([callback, result]() {
+		callback(*result);
+	});
+}
+
+/**
+ * Send Config::MSG_EXEC_SQL_PROGRESS_ID to the subscribers in the UI thread, wParam=ExecuteResult pointer, lParam=sessionKey
+ * 
+ * @param result
+ */
+void ExecutorService::postProgress(const ExecuteResult & result)
+{
+	auto progress = std::make_shared<ExecuteResult>(result);
+	progress->resultSet.reset();
+	AppContext::getInstance()->runInUiThread([progress]() {
+		AppContext::getInstance()->dispatch(Config::MSG_EXEC_SQL_PROGRESS_ID, (uint64_t)progress.get(), progress->sessionKey);
+	});
+}
@@ -1,15 +1,123 @@
 #pragma once
+#include <atomic>
+#include <memory>
+#include <functional>
+#include <unordered_set>
 #include "core/common/service/BaseService.h"
+#include "core/common/executor/QTaskExecutor.h"
+#include "core/common/buffer/QResultBuffer.h"
+#include "core/common/trace/QExecTrace.h"
 #include "core/repository/db/UserSqlExecutorRepository.h"
 #include "core/entity/Entity.h"
 
+// The statement for async execution
+typedef struct _ExecuteStatement {
+	std::string sql;
+	bool isQuery = false; // true - SELECT/SHOW/EXPLAIN..., returns the result set
+	uint32_t fetchSize = 0; // >0 - streaming query, the rows are delivered by ExecuteRowBatch, ExecuteResult::resultSet is null
+	bool pipelined = false; // true - the consecutive pipelined non-query statements are sent in one round trip (packet session only)
+	bool captureStatus = false; // true - capture the session status deltas of the statement (packet session only), see ExecuteResult::statusDeltas
+} ExecuteStatement;
+typedef std::vector<ExecuteStatement> ExecuteStatementList;
+
+// The status of async execution
+typedef enum {
+	EXECUTE_PENDING,
+	EXECUTE_RUNNING,
+	EXECUTE_SUCCESS,
+	EXECUTE_FAILED,
+	EXECUTE_SKIPPED, // the previous statement has failed, or the task has been canceled
+} ExecuteStatus;
+
+// The result of one statement for async execution, it is delivered in the UI thread
+typedef struct _ExecuteResult {
+	uint64_t taskId = 0;
+	uint64_t sessionKey = 0;
+	uint64_t connectId = 0;
+	std::string schema;
+	std::string sql;
+	bool isQuery = false;
+	int index = 0; // statement index in the batch
+	int total = 0; // statement count of the batch
+	ExecuteStatus status = EXECUTE_PENDING;
+	std::shared_ptr<sql::ResultSet> resultSet; // the query result set, the receiver should read it in the UI thread
+	int64_t effectRows = 0;
+	std::string code; // error code
+	std::string msg;  // error message
+	std::shared_ptr<QExecTrace> trace; // the phase timing, the pipelined statements share the same trace
+	bool isStopped = false; // the streaming fetch has been stopped by the user, effectRows is the fetched rows
+	StatusDeltas statusDeltas; // the changed session status of the statement, empty if it is not captured
+} ExecuteResult;
+
+// A batch of rows of the streaming query, it is delivered in the UI thread before the ExecuteResult of the statement
+typedef struct _ExecuteRowBatch {
+	uint64_t sessionKey = 0;
+	int index = 0; // statement index in the batch
+	bool isFirst = false;
+	Columns columns; // the column names, only in the first batch
+	QResultBuffer rows;
+	int64_t fetchedRows = 0; // the fetched rows of the statement so far, including this batch
+	std::shared_ptr<QExecTrace> trace; // the trace of the statement, the receiver records the render span
+} ExecuteRowBatch;
+typedef std::function<void (ExecuteResult & result)> ExecuteResultCallback;
+typedef std::function<void (ExecuteRowBatch & batch)> ExecuteRowBatchCallback;
+typedef std::function<void (bool hasError)> ExecuteFinishCallback;
+
 class ExecutorService :   public BaseService<ExecutorService, UserSqlExecutorRepository>
 {
 public:
-	sql::ResultSet * executeQuerySql(uint64_t connectId, const std::string & schema, const std::string &sql);
+	ExecutorService();
+	~ExecutorService();
 
-	int executeSql(uint64_t connectId, const std::string & schema,  const std::string &sql);
+	// trace - records the phase timing, nullptr if the execution is not traced
+	sql::ResultSet * executeQuerySql(uint64_t connectId, const std::string & schema, const std::string &sql, QExecTrace * trace = nullptr);
 
-	const PerfTime & getPerfTime() const;
-};
+	int executeSql(uint64_t connectId, const std::string & schema,  const std::string &sql, QExecTrace * trace = nullptr);
 
+
+	// async execution, the callbacks are called in the UI thread
+	uint64_t openSession(bool isPacket = false);
+	void closeSession(uint64_t connectId, uint64_t sessionKey);
+	bool isSessionBusy(uint64_t sessionKey);
+	size_t cancelAsync(uint64_t sessionKey);
+
+	uint64_t executeQuerySqlAsync(uint64_t connectId, const std::string & schema, const std::string & sql, uint64_t sessionKey,
+		ExecuteResultCallback callback);
+	uint64_t executeSqlAsync(uint64_t connectId, const std::string & schema, const std::string & sql, uint64_t sessionKey,
+		ExecuteResultCallback callback);
+	uint64_t executeQueryStreamAsync(uint64_t connectId, const std::string & schema, const std::string & sql, uint64_t sessionKey,
+		uint32_t fetchSize, ExecuteRowBatchCallback batchCallback, ExecuteResultCallback callback, bool captureStatus = false);
+	uint64_t executeSqlsAsync(uint64_t connectId, const std::string & schema, const ExecuteStatementList & statements, uint64_t sessionKey,
+		bool inTransaction, ExecuteResultCallback callback, ExecuteFinishCallback finishCallback = nullptr, 
+		ExecuteRowBatchCallback batchCallback = nullptr);
+	// stop the streaming fetch of the session, the fetched rows are kept and the unread rows are killed
+	void stopFetch(uint64_t connectId, uint64_t sessionKey);
+	// cancel the pending statements and kill the running statement of the session
+	void cancelQuery(uint64_t connectId, uint64_t sessionKey);
+	// the server side timeout of the SELECT statements of the session, seconds, 0 - no timeout
+	void setSessionTimeout(uint64_t sessionKey, uint32_t seconds);
+private:
+	// session keys of the async execution, greater than the thread session keys of UserSqlExecutorRepository
+	std::atomic<uint64_t> nextSessionKey{ 0x100000000ULL };
+	// the canceled generation of sessions, the running batch stops at the next statement
+	std::mutex cancelMutex;
+	std::unordered_map<uint64_t, uint64_t> cancelGenerations;
+	std::unordered_map<uint64_t, uint32_t> sessionTimeouts; // sessionKey => seconds, guarded by cancelMutex
+	std::unordered_set<uint64_t> closedSessions; // the closed sessions whose batch is still running, guarded by cancelMutex
+	QTaskExecutor * taskExecutor = nullptr;
+	QTaskExecutor * killExecutor = nullptr; // one thread for KILL QUERY, it is not queued behind the running statements
+
+	QTaskExecutor * getTaskExecutor();
+	QTaskExecutor * getKillExecutor();
+	uint64_t getCancelGeneration(uint64_t sessionKey);
+	bool isSessionClosed(uint64_t sessionKey);
+	void killQueryAsync(uint64_t connectId, uint64_t sessionKey);
+	uint32_t getSessionTimeout(uint64_t sessionKey);
+	void executeStatement(ExecuteResult & result, bool captureStatus);
+	void executePipeline(std::vector<std::shared_ptr<ExecuteResult>> & results, bool captureStatus);
+	static int getPipelineEnd(const ExecuteStatementList & statements, int begin);
+	void fetchStatement(ExecuteResult & result, uint32_t fetchSize, uint64_t generation, ExecuteRowBatchCallback batchCallback, 
+		bool captureStatus);
+	void postResult(ExecuteResultCallback callback, std::shared_ptr<ExecuteResult> result);
+	void postProgress(const ExecuteResult & result);
+};
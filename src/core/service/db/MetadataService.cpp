@@ -17,9 +17,24 @@
  * @date   2024-11-25
  *********************************************************************/
 #include "MetadataService.h"
+#include <map>
+#include "common/AppContext.h"
+#include "core/common/repository/QConnect.h"
 
 MetadataService::~MetadataService()
 {
+    if (snapshotExecutor) {
+        snapshotExecutor->shutdown();
+        delete snapshotExecutor;
+        snapshotExecutor = nullptr;
+    }
+
+    if (loadExecutor) {
+        loadExecutor->shutdown();
+        delete loadExecutor;
+        loadExecutor = nullptr;
+    }
+
     UserViewRepository::destroyInstance();
     userViewRepository = nullptr;
 
@@ -43,95 +58,185 @@ MetadataService::~MetadataService()
 
     CollationRepository::destroyInstance();
     collationRepository = nullptr;
+
+    MetadataSnapshotRepository::destroyInstance();
+    metadataSnapshotRepository = nullptr;
+}
+
+UserDbList MetadataService::getUserDbs(uint64_t connectId)
+{
+    return cache.get<UserDbList>(connectId, "", "databases", [&]() {
+        auto list = userDbRepository->getAllByConnectId(connectId);
+        saveSnapshot(connectId, "", "databases", toSnapshotItems(list));
+        return list;
+    });
 }
 
 UserTableList MetadataService::getUserTables(uint64_t connectId, const std::string& schema)
 {
-    return getRepository()->getAll(connectId, schema);
+    return cache.get<UserTableList>(connectId, schema, "tables", [&]() {
+        auto list = getRepository()->getAll(connectId, schema);
+        saveSnapshot(connectId, schema, "tables", toSnapshotItems(list));
+        return list;
+    });
 }
 
 UserTableList MetadataService::getUserViews(uint64_t connectId, const std::string& schema)
 {
-    return userViewRepository->getAll(connectId, schema);
+    return cache.get<UserViewList>(connectId, schema, "views", [&]() {
+        auto list = userViewRepository->getAll(connectId, schema);
+        saveSnapshot(connectId, schema, "views", toSnapshotItems(list));
+        return list;
+    });
 }
 
 UserProcedureList MetadataService::getUserProcedures(uint64_t connectId, const std::string& schema)
 {
-    return userRoutineRepository->getAllByType(connectId, schema, RoutineType::ROUTINE_PROCEDURE);
+    return cache.get<UserProcedureList>(connectId, schema, "procedures", [&]() {
+        auto list = userRoutineRepository->getAllByType(connectId, schema, RoutineType::ROUTINE_PROCEDURE);
+        saveSnapshot(connectId, schema, "procedures", toSnapshotItems(list));
+        return list;
+    });
 }
 
 UserFunctionList MetadataService::getUserFunctions(uint64_t connectId, const std::string& schema)
 {
-    return userRoutineRepository->getAllByType(connectId, schema, RoutineType::ROUTINE_FUNCTION);
+    return cache.get<UserFunctionList>(connectId, schema, "functions", [&]() {
+        auto list = userRoutineRepository->getAllByType(connectId, schema, RoutineType::ROUTINE_FUNCTION);
+        saveSnapshot(connectId, schema, "functions", toSnapshotItems(list));
+        return list;
+    });
 }
 
 UserTriggerList MetadataService::getUserTriggers(uint64_t connectId, const std::string& schema)
 {
-    auto list = userSchemaObjectRepository->getAllByObjectType(connectId, schema, "trigger");
-    for (auto& item : list) {
-        auto npos = item.name.find_last_of('.');
-        if (npos == std::string::npos) {
-            continue;
-        }
-
-        item.name = item.name.substr(npos + 1);
-    }
-    return list;
+    return cache.get<UserTriggerList>(connectId, schema, "triggers", [&]() {
+        auto list = userSchemaObjectRepository->getAllByObjectType(connectId, schema, "trigger");
+        trimTriggerNames(list);
+        saveSnapshot(connectId, schema, "triggers", toSnapshotItems(list));
+        return list;
+    });
 }
 
 UserEventList MetadataService::getUserEvents(uint64_t connectId, const std::string& schema)
 {
-    return userEventRepository->getAll(connectId, schema);
+    return cache.get<UserEventList>(connectId, schema, "events", [&]() {
+        auto list = userEventRepository->getAll(connectId, schema);
+        saveSnapshot(connectId, schema, "events", toSnapshotItems(list));
+        return list;
+    });
 }
 
 UserTableList MetadataService::getDetailUserTables(uint64_t connectId, const std::string& schema)
 {
-    return getRepository()->getAllDetailList(connectId, schema);
+    return cache.get<UserTableList>(connectId, schema, "tables:detail", [&]() {
+        return getRepository()->getAllDetailList(connectId, schema);
+    });
 }
 
 UserViewList MetadataService::getDetailUserViews(uint64_t connectId, const std::string& schema)
 {
-     return userViewRepository->getAllDetailList(connectId, schema);
+    return cache.get<UserViewList>(connectId, schema, "views:detail", [&]() {
+        return userViewRepository->getAllDetailList(connectId, schema);
+    });
 }
 
 UserProcedureList MetadataService::getDetailUserProcedures(uint64_t connectId, const std::string& schema)
 {
-    return userRoutineRepository->getAllDetailListByType(connectId, schema, RoutineType::ROUTINE_PROCEDURE);
+    return cache.get<UserProcedureList>(connectId, schema, "procedures:detail", [&]() {
+        return userRoutineRepository->getAllDetailListByType(connectId, schema, RoutineType::ROUTINE_PROCEDURE);
+    });
 }
 
 UserFunctionList MetadataService::getDetailUserFunctions(uint64_t connectId, const std::string& schema)
 {
-    return userRoutineRepository->getAllDetailListByType(connectId, schema, RoutineType::ROUTINE_FUNCTION);
+    return cache.get<UserFunctionList>(connectId, schema, "functions:detail", [&]() {
+        return userRoutineRepository->getAllDetailListByType(connectId, schema, RoutineType::ROUTINE_FUNCTION);
+    });
 }
 
 UserTriggerList MetadataService::getDetailUserTriggers(uint64_t connectId, const std::string& schema)
 {
-    return userSchemaObjectRepository->getAllDetailTriggers(connectId, schema);
+    return cache.get<UserTriggerList>(connectId, schema, "triggers:detail", [&]() {
+        return userSchemaObjectRepository->getAllDetailTriggers(connectId, schema);
+    });
 }
 
 UserEventList MetadataService::getDetailUserEvents(uint64_t connectId, const std::string& schema)
 {
-    return userEventRepository->getAllDetailList(connectId, schema);
+    return cache.get<UserEventList>(connectId, schema, "events:detail", [&]() {
+        return userEventRepository->getAllDetailList(connectId, schema);
+    });
 }
 
 ColumnInfoList MetadataService::getColumnsOfUserTable(uint64_t connectId, const std::string& schema, const std::string& tableName)
 {
-    return tableColumnRepository->getAll(connectId, schema, tableName);
+    return cache.get<ColumnInfoList>(connectId, schema, "columns:" + tableName, [&]() {
+        return tableColumnRepository->getAll(connectId, schema, tableName);
+    });
 }
 
 IndexInfoList MetadataService::getIndexesOfUserTable(uint64_t connectId, const std::string& schema, const std::string& tableName)
 {
-    return tableIndexRepository->getAll(connectId, schema, tableName);
+    return cache.get<IndexInfoList>(connectId, schema, "indexes:" + tableName, [&]() {
+        return tableIndexRepository->getAll(connectId, schema, tableName);
+    });
+}
+
+/**
+ * Load the columns and indexes of all tables in the schema from information_schema, and cache them per table,
+ * so the following getColumnsOfUserTable/getIndexesOfUserTable of the schema do not query the server table by table.
+ * The bulk load is cached as the object "columns+indexes", the concurrent callers share one load, and it is loaded
+ * again after TTL or the schema is invalidated. If it fails, the tables are still loaded one by one.
+ * 
+ * @param connectId
+ * @param schema
+ * @return 
+ */
+bool MetadataService::loadTableMetadataOfSchema(uint64_t connectId, const std::string& schema)
+{
+    assert(connectId > 0 && !schema.empty());
+    try {
+        return cache.get<bool>(connectId, schema, "columns+indexes", [&]() {
+            std::map<std::string, ColumnInfoList> tableColumns;
+            std::map<std::string, IndexInfoList> tableIndexes;
+            // the tables without any index
+            for (auto & userTable : getUserTables(connectId, schema)) {
+                tableIndexes[userTable.name];
+            }
+            for (auto & item : tableColumnRepository->getAllOfSchema(connectId, schema)) {
+                tableColumns[item.table].push_back(item);
+            }
+            for (auto & item : tableIndexRepository->getAllOfSchema(connectId, schema)) {
+                tableIndexes[item.table].push_back(item);
+            }
+
+            for (auto & pair : tableColumns) {
+                cache.put(connectId, schema, "columns:" + pair.first, std::move(pair.second));
+            }
+            for (auto & pair : tableIndexes) {
+                cache.put(connectId, schema, "indexes:" + pair.first, std::move(pair.second));
+            }
+            return true;
+        });
+    } catch (QRuntimeException& ex) {
+        Q_ERROR("Fail to load the table metadata of schema:{}, code:{}, error:{}", schema, ex.getCode(), ex.getMsg());
+        return false;
+    }
 }
 
 CharsetInfoList MetadataService::getCharsets(uint64_t connectId)
 {
-    return charsetRepository->getAll(connectId);
+    return cache.get<CharsetInfoList>(connectId, "", "charsets", [&]() {
+        return charsetRepository->getAll(connectId);
+    });
 }
 
 CollationInfoList MetadataService::getCollations(uint64_t connectId, const std::string& charset)
 {
-    return collationRepository->getAll(connectId, charset);
+    return cache.get<CollationInfoList>(connectId, "", "collations:" + charset, [&]() {
+        return collationRepository->getAll(connectId, charset);
+    });
 }
 
 UserTable MetadataService::getUserTable(uint64_t connectId, const std::string& schema, const std::string& name)
@@ -160,42 +265,63 @@ std::string MetadataService::getUserObjectDDL(uint64_t connectId, const std::str
 
 bool MetadataService::removeUserTable(uint64_t connectId, const std::string& schema, const std::string& tableName)
 {
-    return getRepository()->remove(connectId, schema, tableName);
+    bool result = getRepository()->remove(connectId, schema, tableName);
+    // the triggers are dropped with the table, the views may refer to it
+    invalidateCache(connectId, schema);
+    return result;
 }
 
 bool MetadataService::removeUserView(uint64_t connectId, const std::string& schema, const std::string& viewName)
 {
-    return userViewRepository->remove(connectId, schema, viewName);
+    bool result = userViewRepository->remove(connectId, schema, viewName);
+    invalidateCache(connectId, schema);
+    return result;
 }
 
 bool MetadataService::removeUserProcedure(uint64_t connectId, const std::string& schema, const std::string& procedureName)
 {
-    return userRoutineRepository->remove(connectId, schema, procedureName, RoutineType::ROUTINE_PROCEDURE);
+    bool result = userRoutineRepository->remove(connectId, schema, procedureName, RoutineType::ROUTINE_PROCEDURE);
+    cache.invalidate(connectId, schema, "procedures");
+    cache.invalidate(connectId, schema, "procedures:detail");
+    return result;
 }
 
 bool MetadataService::removeUserFunction(uint64_t connectId, const std::string& schema, const std::string& functionName)
 {
-    return userRoutineRepository->remove(connectId, schema, functionName, RoutineType::ROUTINE_FUNCTION);
+    bool result = userRoutineRepository->remove(connectId, schema, functionName, RoutineType::ROUTINE_FUNCTION);
+    cache.invalidate(connectId, schema, "functions");
+    cache.invalidate(connectId, schema, "functions:detail");
+    return result;
 }
 
 bool MetadataService::removeUserTrigger(uint64_t connectId, const std::string& schema, const std::string& triggerName)
 {
-    return userSchemaObjectRepository->remove(connectId, schema, triggerName, "TRIGGER");
+    bool result = userSchemaObjectRepository->remove(connectId, schema, triggerName, "TRIGGER");
+    cache.invalidate(connectId, schema, "triggers");
+    cache.invalidate(connectId, schema, "triggers:detail");
+    return result;
 }
 
 bool MetadataService::removeUserEvent(uint64_t connectId, const std::string& schema, const std::string& eventName)
 {
-    return userEventRepository->remove(connectId, schema, eventName);
+    bool result = userEventRepository->remove(connectId, schema, eventName);
+    cache.invalidate(connectId, schema, "events");
+    cache.invalidate(connectId, schema, "events:detail");
+    return result;
 }
 
 bool MetadataService::removeTableColumn(uint64_t connectId, const std::string& schema, const std::string& tableName, const std::string& columnName)
 {
-    return tableColumnRepository->remove(connectId, schema, tableName, columnName);
+    bool result = tableColumnRepository->remove(connectId, schema, tableName, columnName);
+    invalidateTableCache(connectId, schema, tableName);
+    return result;
 }
 
 bool MetadataService::removeTableIndex(uint64_t connectId, const std::string& schema, const std::string& tableName, const std::string& indexName)
 {
-    return tableIndexRepository->remove(connectId, schema, tableName, indexName);
+    bool result = tableIndexRepository->remove(connectId, schema, tableName, indexName);
+    invalidateTableCache(connectId, schema, tableName);
+    return result;
 }
 
 bool MetadataService::hasUserTable(uint64_t connectId, const std::string& schema, const std::string& tableName)
@@ -215,7 +341,7 @@ UserTableStrings MetadataService::getUserTableStrings(uint64_t connectId, const
      if (schema.empty()) {
         return result;
     }
-	UserTableList userTableList = getRepository()->getAll(connectId, schema);
+	UserTableList userTableList = getUserTables(connectId, schema);
 	for (auto userTable : userTableList) {
 		result.push_back(userTable.name);
 	}
@@ -225,10 +351,593 @@ UserTableStrings MetadataService::getUserTableStrings(uint64_t connectId, const
 Columns MetadataService::getUserColumnStrings(uint64_t connectId, const std::string& schema, const std::string& tblName)
 {
     assert(connectId > 0 && !schema.empty() && !tblName.empty());
-	ColumnInfoList columnInfoList = tableColumnRepository->getAll(connectId, schema, tblName);
+	ColumnInfoList columnInfoList = getColumnsOfUserTable(connectId, schema, tblName);
 	Columns result;
 	for (auto & item : columnInfoList) {
 		result.push_back(item.name);
 	}
 	return result;
 }
+
+/**
+ * Remove the cached metadata of the connection, such as the connection is refreshed or the sql script is imported.
+ * 
+ * @param connectId
+ */
+void MetadataService::invalidateCache(uint64_t connectId)
+{
+    cache.invalidate(connectId);
+}
+
+/**
+ * Remove the cached metadata of the schema, such as the schema is dropped, duplicated or refreshed.
+ * 
+ * @param connectId
+ * @param schema
+ */
+void MetadataService::invalidateCache(uint64_t connectId, const std::string& schema)
+{
+    // the database list of the connection has the schema
+    cache.invalidate(connectId, "", "databases");
+    cache.invalidate(connectId, schema);
+}
+
+/**
+ * Remove the columns and indexes of the table and the table lists of the schema, such as the table is altered.
+ * 
+ * @param connectId
+ * @param schema
+ * @param tableName
+ */
+void MetadataService::invalidateTableCache(uint64_t connectId, const std::string& schema, const std::string& tableName)
+{
+    cache.invalidate(connectId, schema, "columns:" + tableName);
+    cache.invalidate(connectId, schema, "indexes:" + tableName);
+    cache.invalidate(connectId, schema, "tables");
+    cache.invalidate(connectId, schema, "tables:detail");
+}
+
+/**
+ * Detect the changed object lists of the schema by the fingerprint of the schema (one query of information_schema),
+ * the cache of the changed lists is removed, so only the changed lists are loaded again.
+ * The baseline is recorded when a list of the schema is loaded, see recordFingerprint(...), 
+ * if there is no last fingerprint of the schema, all lists are changed.
+ * 
+ * @param connectId
+ * @param schema
+ * @return the changed lists, "columns" and "indexes" are the columns and indexes of all tables, 
+ *         "databases" is the databases of the connection
+ */
+std::vector<std::string> MetadataService::getChangedLists(uint64_t connectId, const std::string& schema)
+{
+    SchemaFingerprint fingerprint;
+    try {
+        fingerprint = userDbRepository->getSchemaFingerprint(connectId, schema);
+    } catch (QRuntimeException& ex) {
+        Q_ERROR("Fail to get the fingerprint of schema:{}, code:{}, error:{}", schema, ex.getCode(), ex.getMsg());
+        {
+            std::lock_guard<std::mutex> lk(fingerprintMutex);
+            fingerprints.erase({ connectId, schema });
+        }
+        invalidateCache(connectId, schema);
+        return { "tables", "views", "procedures", "functions", "triggers", "events", "columns", "indexes", "databases" };
+    }
+
+    std::vector<std::string> changedLists;
+    {
+        std::lock_guard<std::mutex> lk(fingerprintMutex);
+        auto & lastFingerprint = fingerprints[{ connectId, schema }];
+        for (auto& item : fingerprint) {
+            auto iter = lastFingerprint.find(item.first);
+            if (iter == lastFingerprint.end() || iter->second != item.second) {
+                changedLists.push_back(item.first);
+            }
+        }
+        lastFingerprint = std::move(fingerprint);
+    }
+
+    for (auto& object : changedLists) {
+        if (object == "databases") {
+            cache.invalidate(connectId, "", object);
+        } else if (object == "columns" || object == "indexes") {
+            cache.invalidatePrefix(connectId, schema, object + ":");
+            cache.invalidate(connectId, schema, "columns+indexes");
+        } else {
+            cache.invalidate(connectId, schema, object);
+            cache.invalidate(connectId, schema, object + ":detail");
+        }
+    }
+    return changedLists;
+}
+
+/**
+ * Detect the changed lists of the schema and load them into the cache again in a background thread,
+ * such as the sql statements are executed in the query page, so the ui thread does not wait for the server.
+ * 
+ * @param connectId
+ * @param schema
+ * @param callback - called in the ui thread, the changed lists are read from the cache by the getters
+ */
+void MetadataService::loadChangedListsAsync(uint64_t connectId, const std::string& schema, ChangedListsCallback callback)
+{
+    // the callback captures the objects of the ui, it is released in the ui thread, see the lambda below
+    auto sharedCallback = std::make_shared<ChangedListsCallback>(std::move(callback));
+    getLoadExecutor()->submit(nextLoadId++, [this, connectId, schema, sharedCallback]() {
+        std::vector<std::string> loadedLists;
+        for (auto & object : getChangedLists(connectId, schema)) {
+            try {
+                if (object == "databases") {
+                    getUserDbs(connectId);
+                } else if (object == "columns" || object == "indexes") {
+                    loadTableMetadataOfSchema(connectId, schema);
+                } else {
+                    loadList(connectId, schema, object);
+                }
+            } catch (QRuntimeException& ex) {
+                Q_ERROR("Fail to load the changed list, schema:{}, object:{}, code:{}, error:{}", schema, object, ex.getCode(), ex.getMsg());
+                // the lists that are not loaded are loaded when they are read, and detected as changed by the next call
+                std::lock_guard<std::mutex> lk(fingerprintMutex);
+                fingerprints.erase({ connectId, schema });
+                break;
+            }
+            loadedLists.push_back(object);
+        }
+        AppContext::getInstance()->runInUiThread([sharedCallback, loadedLists]() {
+            ChangedListsCallback callback;
+            callback.swap(*sharedCallback);
+            if (callback) {
+                callback(loadedLists);
+            }
+        });
+    });
+}
+
+/**
+ * Record the fingerprint of the schema if there is no last one, it is the baseline of getChangedLists(...),
+ * so the lists that are loaded before the first call are not reported as changed.
+ * It is recorded before the list is loaded, then a change in between is detected by the next call.
+ * 
+ * @param connectId
+ * @param schema
+ */
+void MetadataService::recordFingerprint(uint64_t connectId, const std::string& schema)
+{
+    {
+        std::lock_guard<std::mutex> lk(fingerprintMutex);
+        if (fingerprints.count({ connectId, schema })) {
+            return;
+        }
+    }
+    SchemaFingerprint fingerprint;
+    try {
+        fingerprint = userDbRepository->getSchemaFingerprint(connectId, schema);
+    } catch (QRuntimeException& ex) {
+        Q_WARN("Fail to record the fingerprint of schema:{}, code:{}, error:{}", schema, ex.getCode(), ex.getMsg());
+        return;
+    }
+    std::lock_guard<std::mutex> lk(fingerprintMutex);
+    // a fingerprint recorded by getChangedLists(...) in between is newer
+    fingerprints.insert({ { connectId, schema }, std::move(fingerprint) });
+}
+
+/**
+ * Load the object list into the cache in a background thread, such as the tree item is expanded.
+ * 
+ * @param connectId
+ * @param schema
+ * @param object - "tables", "views", "procedures", "functions", "triggers", "events", 
+ *                 or "columns:<table>" for the columns and indexes of the table
+ * @param callback - called in the ui thread, the list is read from the cache by the getters
+ * @return the load id for cancelLoadAsync(...)
+ */
+uint64_t MetadataService::loadListAsync(uint64_t connectId, const std::string& schema, const std::string& object, MetadataLoadCallback callback)
+{
+    uint64_t loadId = nextLoadId++;
+    // the callback captures the objects of the ui, it is released in the ui thread, see the lambda below
+    auto sharedCallback = std::make_shared<MetadataLoadCallback>(std::move(callback));
+    getLoadExecutor()->submit(loadId, [this, connectId, schema, object, sharedCallback]() {
+        bool isSuccess = true;
+        std::string code, msg;
+        try {
+            loadList(connectId, schema, object);
+        } catch (QRuntimeException& ex) {
+            Q_ERROR("Fail to load the list, schema:{}, object:{}, code:{}, error:{}", schema, object, ex.getCode(), ex.getMsg());
+            isSuccess = false;
+            code = ex.getCode();
+            msg = ex.getMsg();
+        }
+        AppContext::getInstance()->runInUiThread([sharedCallback, isSuccess, code, msg]() {
+            MetadataLoadCallback callback;
+            callback.swap(*sharedCallback);
+            if (callback) {
+                callback(isSuccess, code, msg);
+            }
+        });
+    });
+    return loadId;
+}
+
+void MetadataService::cancelLoadAsync(uint64_t loadId)
+{
+    getLoadExecutor()->cancel(loadId);
+}
+
+QTaskExecutor * MetadataService::getLoadExecutor()
+{
+    std::lock_guard<std::mutex> lk(loadMutex);
+    if (loadExecutor == nullptr) {
+        // mysql driver must be initialized in every thread that uses it
+        loadExecutor = new QTaskExecutor(LOAD_THREAD_COUNT, []() { QConnect::getDriver()->threadInit(); }, []() { QConnect::getDriver()->threadEnd(); });
+    }
+    return loadExecutor;
+}
+
+void MetadataService::loadList(uint64_t connectId, const std::string& schema, const std::string& object)
+{
+    recordFingerprint(connectId, schema);
+    if (object == "tables") {
+        getUserTables(connectId, schema);
+    } else if (object == "views") {
+        getUserViews(connectId, schema);
+    } else if (object == "procedures") {
+        getUserProcedures(connectId, schema);
+    } else if (object == "functions") {
+        getUserFunctions(connectId, schema);
+    } else if (object == "triggers") {
+        getUserTriggers(connectId, schema);
+    } else if (object == "events") {
+        getUserEvents(connectId, schema);
+    } else if (object.compare(0, 8, "columns:") == 0) {
+        auto tableName = object.substr(8);
+        loadTableMetadataOfSchema(connectId, schema);
+        getColumnsOfUserTable(connectId, schema, tableName);
+        getIndexesOfUserTable(connectId, schema, tableName);
+    }
+}
+
+/**
+ * Put the snapshot of the connection into the metadata cache, so the tree is shown without waiting for the server.
+ * The snapshot is restored once a session, before the object lists of the connection are loaded, 
+ * and reconcileSnapshotAsync(...) replaces the restored lists by the lists of the server.
+ * 
+ * @param connectId
+ * @return true if the snapshot is restored
+ */
+bool MetadataService::restoreSnapshot(uint64_t connectId)
+{
+    {
+        std::lock_guard<std::mutex> lk(snapshotMutex);
+        if (!restoredConnects.insert(connectId).second) {
+            return false;
+        }
+    }
+
+    MetadataSnapshotItemList items;
+    try {
+        items = metadataSnapshotRepository->getAll(connectId);
+    } catch (QRuntimeException& ex) {
+        Q_ERROR("Fail to restore the metadata snapshot, connectId:{}, code:{}, error:{}", connectId, ex.getCode(), ex.getMsg());
+        return false;
+    }
+
+    // the row with empty name is the mark of the list, the list may be empty
+    std::map<MetadataListKey, MetadataSnapshotItemList> lists;
+    for (auto & item : items) {
+        auto & list = lists[MetadataListKey(item.schema, item.object)];
+        if (!item.name.empty()) {
+            list.push_back(item);
+        }
+    }
+    if (lists.find(MetadataListKey("", "databases")) == lists.end()) {
+        return false;
+    }
+    for (auto & pair : lists) {
+        putSnapshotList(connectId, pair.first.first, pair.first.second, pair.second);
+    }
+
+    std::lock_guard<std::mutex> lk(snapshotMutex);
+    restoredSnapshots[connectId] = std::move(lists);
+    return true;
+}
+
+/**
+ * Load the restored lists of the connection from the server in the background, the lists replace the cached lists 
+ * and the snapshot. The lists of the dropped databases are removed from the snapshot.
+ * 
+ * @param connectId
+ * @param callback - called in the ui thread if some lists are changed
+ */
+void MetadataService::reconcileSnapshotAsync(uint64_t connectId, SnapshotReconcileCallback callback)
+{
+    std::map<MetadataListKey, MetadataSnapshotItemList> lists;
+    {
+        std::lock_guard<std::mutex> lk(snapshotMutex);
+        auto iter = restoredSnapshots.find(connectId);
+        if (iter == restoredSnapshots.end()) {
+            return;
+        }
+        lists = std::move(iter->second);
+        restoredSnapshots.erase(iter);
+    }
+
+    // the callback captures the objects of the ui, it is released in the ui thread, see the lambda below
+    auto sharedCallback = std::make_shared<SnapshotReconcileCallback>(std::move(callback));
+    getSnapshotExecutor()->submit(connectId, [this, connectId, lists, sharedCallback]() {
+        std::vector<MetadataListKey> changedLists;
+        std::unordered_set<std::string> schemas;
+        // ("", "databases") is the first list
+        for (auto & pair : lists) {
+            const std::string & schema = pair.first.first;
+            const std::string & object = pair.first.second;
+            if (!schema.empty() && !schemas.count(schema)) {
+                // the database has been dropped
+                cache.invalidate(connectId, schema);
+                try {
+                    metadataSnapshotRepository->remove(connectId, schema);
+                } catch (QRuntimeException& ex) {
+                    Q_ERROR("Fail to remove the metadata snapshot, schema:{}, code:{}, error:{}", schema, ex.getCode(), ex.getMsg());
+                }
+                continue;
+            }
+            MetadataSnapshotItemList items;
+            try {
+                items = reloadSnapshotList(connectId, schema, object);
+            } catch (QRuntimeException& ex) {
+                Q_ERROR("Fail to reconcile the metadata snapshot, schema:{}, object:{}, code:{}, error:{}", 
+                    schema, object, ex.getCode(), ex.getMsg());
+                // the databases are unknown, the lists of the schemas are kept
+                if (schema.empty()) {
+                    break;
+                }
+                continue;
+            }
+            if (schema.empty()) {
+                for (auto & item : items) {
+                    schemas.insert(item.name);
+                }
+            }
+            if (!isSameSnapshot(items, pair.second)) {
+                changedLists.push_back(pair.first);
+            }
+        }
+        AppContext::getInstance()->runInUiThread([sharedCallback, changedLists]() {
+            SnapshotReconcileCallback callback;
+            callback.swap(*sharedCallback);
+            if (callback && !changedLists.empty()) {
+                callback(changedLists);
+            }
+        });
+    });
+}
+
+/**
+ * Remove the snapshot and the cached metadata of the connection, such as the connection is removed or changed.
+ * 
+ * @param connectId
+ */
+void MetadataService::removeSnapshot(uint64_t connectId)
+{
+    {
+        std::lock_guard<std::mutex> lk(snapshotMutex);
+        restoredSnapshots.erase(connectId);
+    }
+    {
+        std::lock_guard<std::mutex> lk(fingerprintMutex);
+        auto iter = fingerprints.lower_bound({ connectId, "" });
+        while (iter != fingerprints.end() && iter->first.first == connectId) {
+            iter = fingerprints.erase(iter);
+        }
+    }
+    cache.invalidate(connectId);
+    // after the saves of the connection that are queued
+    getSnapshotExecutor()->submit(connectId, [this, connectId]() {
+        try {
+            metadataSnapshotRepository->remove(connectId);
+        } catch (QRuntimeException& ex) {
+            Q_ERROR("Fail to remove the metadata snapshot, connectId:{}, code:{}, error:{}", connectId, ex.getCode(), ex.getMsg());
+        }
+    });
+}
+
+QTaskExecutor * MetadataService::getSnapshotExecutor()
+{
+    std::lock_guard<std::mutex> lk(snapshotMutex);
+    if (snapshotExecutor == nullptr) {
+        // mysql driver must be initialized in every thread that uses it
+        snapshotExecutor = new QTaskExecutor(1, []() { QConnect::getDriver()->threadInit(); }, []() { QConnect::getDriver()->threadEnd(); });
+    }
+    return snapshotExecutor;
+}
+
+/**
+ * Save the loaded list into the snapshot in the background, the loaders may run in the UI thread.
+ * The snapshot is only a copy of the server metadata, so the error is logged only.
+ */
+void MetadataService::saveSnapshot(uint64_t connectId, const std::string& schema, const std::string& object, const MetadataSnapshotItemList& items)
+{
+    getSnapshotExecutor()->submit(connectId, [this, connectId, schema, object, items]() {
+        try {
+            metadataSnapshotRepository->save(connectId, schema, object, items);
+        } catch (QRuntimeException& ex) {
+            Q_ERROR("Fail to save the metadata snapshot, schema:{}, object:{}, code:{}, error:{}", schema, object, ex.getCode(), ex.getMsg());
+        }
+    });
+}
+
+void MetadataService::putSnapshotList(uint64_t connectId, const std::string& schema, const std::string& object, const MetadataSnapshotItemList& items)
+{
+    if (object == "databases") {
+        UserDbList list;
+        for (auto & item : items) {
+            UserDb userDb;
+            userDb.connectId = connectId;
+            userDb.catalog = item.catalog;
+            userDb.name = item.name;
+            list.push_back(userDb);
+        }
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "tables" || object == "views") {
+        UserTableList list;
+        for (auto & item : items) {
+            UserTable userTable;
+            userTable.catalog = item.catalog;
+            userTable.schema = schema;
+            userTable.name = item.name;
+            userTable.tblName = item.name;
+            userTable.type = item.type;
+            userTable.comment = item.remarks;
+            list.push_back(userTable);
+        }
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "procedures" || object == "functions" || object == "triggers") {
+        UserRoutineList list;
+        for (auto & item : items) {
+            UserRoutine userRoutine;
+            userRoutine.catalog = item.catalog;
+            userRoutine.schema = schema;
+            userRoutine.name = item.name;
+            userRoutine.objectType = item.type;
+            userRoutine.type = 0;
+            userRoutine.remarks = item.remarks;
+            list.push_back(userRoutine);
+        }
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "events") {
+        UserEventList list;
+        for (auto & item : items) {
+            UserEvent userEvent;
+            userEvent.catalog = item.catalog;
+            userEvent.schema = schema;
+            userEvent.name = item.name;
+            userEvent.type = item.type;
+            list.push_back(userEvent);
+        }
+        cache.put(connectId, schema, object, std::move(list));
+    }
+}
+
+/**
+ * Load the list from the server, then replace the cached list and the snapshot. 
+ * The cached list is readable during the load, unlike invalidate(...) and get again.
+ * 
+ * @return the snapshot items of the loaded list
+ */
+MetadataSnapshotItemList MetadataService::reloadSnapshotList(uint64_t connectId, const std::string& schema, const std::string& object)
+{
+    MetadataSnapshotItemList items;
+    if (object == "databases") {
+        auto list = userDbRepository->getAllByConnectId(connectId);
+        items = toSnapshotItems(list);
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "tables") {
+        auto list = getRepository()->getAll(connectId, schema);
+        items = toSnapshotItems(list);
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "views") {
+        auto list = userViewRepository->getAll(connectId, schema);
+        items = toSnapshotItems(list);
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "procedures" || object == "functions") {
+        auto list = userRoutineRepository->getAllByType(connectId, schema, 
+            object == "procedures" ? RoutineType::ROUTINE_PROCEDURE : RoutineType::ROUTINE_FUNCTION);
+        items = toSnapshotItems(list);
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "triggers") {
+        auto list = userSchemaObjectRepository->getAllByObjectType(connectId, schema, "trigger");
+        trimTriggerNames(list);
+        items = toSnapshotItems(list);
+        cache.put(connectId, schema, object, std::move(list));
+    } else if (object == "events") {
+        auto list = userEventRepository->getAll(connectId, schema);
+        items = toSnapshotItems(list);
+        cache.put(connectId, schema, object, std::move(list));
+    } else {
+        return items;
+    }
+    saveSnapshot(connectId, schema, object, items);
+    return items;
+}
+
+/**
+ * The names of the triggers are "schema.trigger", remove the schema.
+ */
+void MetadataService::trimTriggerNames(UserTriggerList& list)
+{
+    for (auto& item : list) {
+        auto npos = item.name.find_last_of('.');
+        if (npos == std::string::npos) {
+            continue;
+        }
+
+        item.name = item.name.substr(npos + 1);
+    }
+}
+
+MetadataSnapshotItemList MetadataService::toSnapshotItems(const UserDbList& list)
+{
+    MetadataSnapshotItemList result;
+    for (auto & userDb : list) {
+        MetadataSnapshotItem item;
+        item.catalog = userDb.catalog;
+        item.name = userDb.name;
+        result.push_back(item);
+    }
+    return result;
+}
+
+MetadataSnapshotItemList MetadataService::toSnapshotItems(const UserTableList& list)
+{
+    MetadataSnapshotItemList result;
+    for (auto & userTable : list) {
+        MetadataSnapshotItem item;
+        item.catalog = userTable.catalog;
+        item.name = userTable.name;
+        item.type = userTable.type;
+        item.remarks = userTable.comment;
+        result.push_back(item);
+    }
+    return result;
+}
+
+MetadataSnapshotItemList MetadataService::toSnapshotItems(const UserRoutineList& list)
+{
+    MetadataSnapshotItemList result;
+    for (auto & userRoutine : list) {
+        MetadataSnapshotItem item;
+        item.catalog = userRoutine.catalog;
+        item.name = userRoutine.name;
+        item.type = userRoutine.objectType;
+        item.remarks = userRoutine.remarks;
+        result.push_back(item);
+    }
+    return result;
+}
+
+MetadataSnapshotItemList MetadataService::toSnapshotItems(const UserEventList& list)
+{
+    MetadataSnapshotItemList result;
+    for (auto & userEvent : list) {
+        MetadataSnapshotItem item;
+        item.catalog = userEvent.catalog;
+        item.name = userEvent.name;
+        item.type = userEvent.type;
+        result.push_back(item);
+    }
+    return result;
+}
+
+bool MetadataService::isSameSnapshot(const MetadataSnapshotItemList& items1, const MetadataSnapshotItemList& items2)
+{
+    if (items1.size() != items2.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < items1.size(); i++) {
+        auto & item1 = items1.at(i);
+        auto & item2 = items2.at(i);
+        if (item1.name != item2.name || item1.type != item2.type 
+            || item1.catalog != item2.catalog || item1.remarks != item2.remarks) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -28,12 +28,34 @@
 #include "core/repository/db/TableIndexRepository.h"
 #include "core/repository/db/CharsetRepository.h"
 #include "core/repository/db/CollationRepository.h"
+#include "core/repository/db/UserDbRepository.h"
+#include "core/repository/system/MetadataSnapshotRepository.h"
+#include "core/common/cache/QMetadataCache.h"
+#include "core/common/executor/QTaskExecutor.h"
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+
+// (schema, object) of a cached object list, such as ("", "databases"), ("db1", "tables")
+typedef std::pair<std::string, std::string> MetadataListKey;
+// called in the ui thread with the object lists that are different from the snapshot
+typedef std::function<void (const std::vector<MetadataListKey> & changedLists)> SnapshotReconcileCallback;
+// called in the ui thread after the object list is loaded into the cache
+typedef std::function<void (bool isSuccess, const std::string & code, const std::string & msg)> MetadataLoadCallback;
+// called in the ui thread after the changed lists of the schema are loaded into the cache again
+typedef std::function<void (const std::vector<std::string> & changedLists)> ChangedListsCallback;
 
 class MetadataService : public BaseService<MetadataService, UserTableRepository>
 {
 public:
 	~MetadataService();
 	// get object list 
+	UserDbList getUserDbs(uint64_t connectId);
 	UserTableList getUserTables(uint64_t connectId, const std::string& schema);
 	UserViewList getUserViews(uint64_t connectId, const std::string& schema);	
 	UserProcedureList getUserProcedures(uint64_t connectId, const std::string& schema);
@@ -50,6 +72,8 @@ public:
 
 	ColumnInfoList getColumnsOfUserTable(uint64_t connectId, const std::string& schema, const std::string& tableName);
 	IndexInfoList getIndexesOfUserTable(uint64_t connectId, const std::string& schema, const std::string& tableName);
+	// cache the columns and indexes of all tables in the schema by a few queries, false if the bulk load failed
+	bool loadTableMetadataOfSchema(uint64_t connectId, const std::string& schema);
 
 	CharsetInfoList getCharsets(uint64_t connectId);
 	CollationInfoList getCollations(uint64_t connectId, const std::string& charset);
@@ -78,7 +102,48 @@ public:
 	// +- user table strings
 	UserTableStrings getUserTableStrings(uint64_t connectId, const std::string & schema);
 	Columns getUserColumnStrings(uint64_t connectId, const std::string & schema, const std::string & tblName);
+
+	// -- Metadata cache, the lists and the columns/indexes above are cached, remove them after our own DDL
+	void invalidateCache(uint64_t connectId);
+	void invalidateCache(uint64_t connectId, const std::string& schema);
+	void invalidateTableCache(uint64_t connectId, const std::string& schema, const std::string& tableName);
+	// compare the fingerprint of the schema with the last one, remove the cache of the changed lists and return them,
+	// such as "tables", "views", "procedures", "functions", "triggers", "events", "columns", "indexes", "databases"
+	std::vector<std::string> getChangedLists(uint64_t connectId, const std::string& schema);
+	// getChangedLists(...) and load the changed lists again in the background, the lists that fail to load are not in the callback
+	void loadChangedListsAsync(uint64_t connectId, const std::string& schema, ChangedListsCallback callback);
+
+	// -- Load the object list into the cache in the background, the getters above read it from the cache in the ui thread.
+	// object: "tables", "views", "procedures", "functions", "triggers", "events", or "columns:<table>" for the columns and indexes of the table,
+	// return the load id for cancelLoadAsync(...), the loads run concurrently
+	uint64_t loadListAsync(uint64_t connectId, const std::string& schema, const std::string& object, MetadataLoadCallback callback);
+	// the load is removed if it is not running, the callback of a running load is still called
+	void cancelLoadAsync(uint64_t loadId);
+
+	// -- Metadata snapshot in the system db, the object lists above are saved after they are loaded from the server
+	bool restoreSnapshot(uint64_t connectId);
+	void reconcileSnapshotAsync(uint64_t connectId, SnapshotReconcileCallback callback);
+	void removeSnapshot(uint64_t connectId);
 private:
+	QMetadataCache cache;
+
+	// the restored snapshot lists of the connections, they are reconciled against the server once
+	std::mutex snapshotMutex;
+	std::unordered_set<uint64_t> restoredConnects;
+	std::unordered_map<uint64_t, std::map<MetadataListKey, MetadataSnapshotItemList>> restoredSnapshots;
+	QTaskExecutor * snapshotExecutor = nullptr;
+
+	// the threads of loadListAsync(...), every load has its own serial key, so the loads run concurrently
+	static const size_t LOAD_THREAD_COUNT = 4;
+	std::mutex loadMutex;
+	QTaskExecutor * loadExecutor = nullptr;
+	std::atomic<uint64_t> nextLoadId{ 1 };
+
+	// the last fingerprints of the schemas, (connectId, schema) => fingerprint, they are kept when the cache is removed
+	std::mutex fingerprintMutex;
+	std::map<std::pair<uint64_t, std::string>, SchemaFingerprint> fingerprints;
+	void recordFingerprint(uint64_t connectId, const std::string& schema);
+
 	UserViewRepository* userViewRepository = UserViewRepository::getInstance();
 	UserRoutineRepository* userRoutineRepository = UserRoutineRepository::getInstance();
 	UserSchemaObjectRepository* userSchemaObjectRepository = UserSchemaObjectRepository::getInstance();
@@ -87,5 +152,21 @@ private:
 	TableIndexRepository* tableIndexRepository = TableIndexRepository::getInstance();
 	CharsetRepository* charsetRepository = CharsetRepository::getInstance();
 	CollationRepository* collationRepository = CollationRepository::getInstance();
+	UserDbRepository* userDbRepository = UserDbRepository::getInstance();
+	MetadataSnapshotRepository* metadataSnapshotRepository = MetadataSnapshotRepository::getInstance();
+
+	QTaskExecutor * getSnapshotExecutor();
+	QTaskExecutor * getLoadExecutor();
+	void loadList(uint64_t connectId, const std::string& schema, const std::string& object);
+	void saveSnapshot(uint64_t connectId, const std::string& schema, const std::string& object, const MetadataSnapshotItemList& items);
+	void putSnapshotList(uint64_t connectId, const std::string& schema, const std::string& object, const MetadataSnapshotItemList& items);
+	MetadataSnapshotItemList reloadSnapshotList(uint64_t connectId, const std::string& schema, const std::string& object);
+
+	static void trimTriggerNames(UserTriggerList& list);
+	static MetadataSnapshotItemList toSnapshotItems(const UserDbList& list);
+	static MetadataSnapshotItemList toSnapshotItems(const UserTableList& list);
+	static MetadataSnapshotItemList toSnapshotItems(const UserRoutineList& list);
+	static MetadataSnapshotItemList toSnapshotItems(const UserEventList& list);
+	static bool isSameSnapshot(const MetadataSnapshotItemList& items1, const MetadataSnapshotItemList& items2);
 };
 
@@ -5,16 +5,15 @@
 QListView::QListView()
 	: wxListView(), rowBkgColor1(30, 31, 34, 30), rowBkgColor2(46, 46, 46, 43), textColor(223, 225, 229, 213)
 {
-	 // Bind(wxEVT_LIST_CACHE_HINT, &QListView::OnListCacheHint, this);
 	 Bind(wxEVT_LIST_ITEM_CHECKED, &QListView::OnListItemChecked, this);
 	 Bind(wxEVT_LIST_ITEM_UNCHECKED, &QListView::OnListItemUnChecked, this);
 }
 
-void QListView::SetDataList(const DataList* dataList)
+void QListView::SetDataList(const QResultBuffer* dataList)
 {
-	cachData.clear();
 	this->dataList = dataList;
-	SetItemCount(dataList->size());
+	SetItemCount(dataList ? static_cast<long>(dataList->getRowCount()) : 0);
+	Refresh();
 }
 
 wxItemAttr* QListView::OnGetItemAttr(long item) const
@@ -59,16 +58,33 @@ wxItemAttr* QListView::OnGetItemColumnAttr(long item, long column) const
 
 wxString QListView::OnGetItemText(long item, long column) const
 {	
-	if (cachData.empty()) {
+	if (dataList == nullptr || item < 0 || column < 0 
+		|| item >= static_cast<long>(dataList->getRowCount()) || column >= static_cast<long>(dataList->getColumnCount())) {
 		return wxEmptyString;
 	}
-	std::pair<uint32_t, uint32_t> pair(item, column);
-	return cachData.at(pair);
+	// the cell is formatted when it is drawn, the text cell is stored in UTF-8
+	if (dataList->isNull(item, column)) {
+		return QResultBuffer::NULL_TEXT;
+	}
+	size_t len = 0;
+	switch (dataList->getColumnType(column)) {
+	case CELL_TEXT:
+	case CELL_DECIMAL: {
+		const char * bytes = dataList->getBytes(item, column, &len);
+		return wxString::FromUTF8(bytes, len);
+	}
+	case CELL_BLOB:
+		dataList->getBytes(item, column, &len);
+		return wxString::Format("(BLOB) %zu %s", len, S("blob-bytes").c_str());
+	default:
+		return dataList->getString(item, column);
+	}
 }
 
-bool QListView::OnGetItemIsChecked(long WXUNUSED(item)) const
+bool QListView::OnGetItemIsChecked(long item) const
 {
-	return false;
+	// the checked item is selected, see OnListItemChecked(...)
+	return IsSelected(item);
 }
 
 int QListView::OnGetItemImage(long WXUNUSED(item)) const
@@ -81,32 +97,6 @@ int QListView::OnGetItemColumnImage(long WXUNUSED(item), long WXUNUSED(column))
 	return -1;
 }
 
-void QListView::OnListCacheHint(wxListEvent& event)
-{
-	Q_INFO("OnListCacheHint: cache items from {} to {}", event.GetCacheFrom(), event.GetCacheTo());
-	
-	if (dataList->empty()) {
-		return ;
-	}
-	long nFrom = event.GetCacheFrom();
-	long nTo = event.GetCacheTo();
-
-	auto iter = dataList->begin();
-	for (int i = 0; i < nFrom; ++i) {
-		iter++;
-	}
-
-	size_t nCols = iter->size();
-	for (long i = nFrom; i < nTo + 1; ++i) {
-		const auto& rowItem = *iter;
-		for (size_t j = 0; j < nCols; ++j) {
-			std::pair<uint32_t, uint32_t> pair(i, j);
-			cachData[pair] = rowItem.at(j).c_str();
-		}
-		iter++;
-	}
-}
-
 void QListView::OnListItemChecked(wxListEvent& event)
 {
 	Select(event.GetIndex(), true);
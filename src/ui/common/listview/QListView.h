@@ -19,28 +19,23 @@
 #pragma once
 #include <wx/listctrl.h>
 #include <wx/itemattr.h>
-#include <utility>
-#include <unordered_map>
 
 #include "core/entity/Entity.h"
+#include "core/common/buffer/QResultBuffer.h"
 
-struct pair_hash
-{
-	template <class T1, class T2>
-	std::size_t operator() (const std::pair<T1, T2>& pair) const {
-		return std::hash<T1>()(pair.first) ^ std::hash<T2>()(pair.second);
-	}
-};
-
+/**
+ * QListView - With wxLC_VIRTUAL style, the item texts are read from the QResultBuffer by (row, col) when they are painted,
+ * so the control holds no copy of the rows.
+ */
 class QListView : public wxListView
 {
 public:
     QListView();
-    void SetDataList(const DataList* dataList);
+    // virtual mode: set the buffer and the item count, call it again after the rows of buffer changed
+    void SetDataList(const QResultBuffer* dataList);
 private:
     
-    const DataList* dataList;
-    std::unordered_map<std::pair<uint32_t, uint32_t>, const char *, pair_hash> cachData;
+    const QResultBuffer* dataList = nullptr;
     wxColour rowBkgColor1, rowBkgColor2;
     wxColour textColor;
     wxColour colBkgColor;
@@ -52,7 +47,6 @@ private:
     virtual int OnGetItemImage(long item) const;
     virtual int  OnGetItemColumnImage(long item, long column) const;
 
-    void OnListCacheHint(wxListEvent& event);
     void OnListItemChecked(wxListEvent& event);
     void OnListItemUnChecked(wxListEvent& event);
 };
@@ -129,7 +129,7 @@ void QProgressBar::OnPaint(wxPaintEvent& event)
 	// draw status text
 	std::string statusText;
 	if (err.empty()) {
-		statusText = percent < 100 ? "Waiting..." : "Done";
+		statusText = !status.empty() && percent < 100 ? status.ToStdString() : (percent < 100 ? "Waiting..." : "Done");
 	} else {
 		statusText = err;
 		dc.SetTextForeground(errorColor);
@@ -156,7 +156,35 @@ void QProgressBar::run(int percent /*= 0*/)
 	if (percent <= 5) {
 		err.clear();
 	}
-	
+	status.clear();
+	Refresh();
+}
+
+/**
+ * Show the progress of a long running job, such as "12.5 MB/s, ETA 00:03:20".
+ * 
+ * @param percent
+ * @param bytesPerSecond
+ * @param etaSeconds - -1 if unknown
+ * @param detail - the tooltip
+ */
+void QProgressBar::run(int percent, double bytesPerSecond, int64_t etaSeconds, const wxString & detail)
+{
+	this->percent = percent <= 100 ? percent : 100;
+	if (percent <= 5) {
+		err.clear();
+	}
+	status.clear();
+	if (bytesPerSecond >= 1024.0 * 1024.0) {
+		status = wxString::Format("%.1f MB/s", bytesPerSecond / 1024.0 / 1024.0);
+	} else if (bytesPerSecond > 0) {
+		status = wxString::Format("%.1f KB/s", bytesPerSecond / 1024.0);
+	}
+	if (etaSeconds >= 0) {
+		status.Append(status.empty() ? "" : ", ")
+			.Append(wxString::Format("ETA %02lld:%02lld:%02lld", etaSeconds / 3600, etaSeconds / 60 % 60, etaSeconds % 60));
+	}
+	SetToolTip(detail);
 	Refresh();
 }
 
@@ -170,6 +198,8 @@ void QProgressBar::reset()
 {
 	this->percent = 0;
 	this->err.clear();
+	this->status.clear();
+	UnsetToolTip();
 	Refresh();
 }
 
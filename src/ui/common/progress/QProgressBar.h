@@ -45,11 +45,14 @@ public:
 		const wxValidator& validator = wxDefaultValidator);
 
 	void run(int percent = 0);
+	// show the throughput and ETA as the status, the detail is the tooltip, such as the status of the tables
+	void run(int percent, double bytesPerSecond, int64_t etaSeconds, const wxString & detail = wxEmptyString);
 	void error(const wxString& err);
 	void reset();
 private:
 	int percent;
 	wxString err;
+	wxString status; // empty - "Waiting..." or "Done"
 	
 	const wxColour bkgColor;
 	const wxColour processColor;
@@ -34,6 +34,7 @@ BEGIN_EVENT_TABLE(LeftTreeView, wxPanel)
 	EVT_SIZE(LeftTreeView::OnSize)
 	EVT_PAINT(LeftTreeView::OnPaint)
 	EVT_TREE_ITEM_EXPANDED(Config::DATABASE_TREEVIEW_ID, OnTreeItemExpended)
+	EVT_TREE_ITEM_COLLAPSED(Config::DATABASE_TREEVIEW_ID, OnTreeItemCollapsed)
 	EVT_TREE_SEL_CHANGED(Config::DATABASE_TREEVIEW_ID, OnTreeItemSelChanged)
 	EVT_TREE_ITEM_RIGHT_CLICK(Config::DATABASE_TREEVIEW_ID, OnTreeItemRightClicked)
 	EVT_BUTTON(Config::DATABASE_CONNECT_BUTTON_ID, OnClickConnectButton)
@@ -46,6 +47,7 @@ BEGIN_EVENT_TABLE(LeftTreeView, wxPanel)
 	EVT_NOTITY_MESSAGE_HANDLE(Config::MSG_CONNECTION_CONNECTED_ID, OnHandleConnectionConnected)
 	EVT_NOTITY_MESSAGE_HANDLE(Config::MSG_ADD_DATABASE_ID, OnHandleAddDatabase)
 	EVT_NOTITY_MESSAGE_HANDLE(Config::MSG_NEW_OBJECT_ID, OnHandleNewObject)
+	EVT_NOTITY_MESSAGE_HANDLE(Config::MSG_LEFTVIEW_REFRESH_DATABASE_ID, OnHandleRefreshDatabase)
 
 	//Connection Menu
 	EVT_MENU(Config::CONNECTION_REFRESH_MENU_ID,  OnClickConnectionRefreshMenu)
@@ -56,6 +58,11 @@ BEGIN_EVENT_TABLE(LeftTreeView, wxPanel)
 
 	// Database Menu
 	EVT_MENU(Config::DATABASE_OPEN_MENU_ID,  OnClickDatabaseOpenMenu)
+
+	// Export as sql Menu
+	EVT_MENU(Config::CONNECTION_EXPORT_AS_SQL_MENU_ID,  OnClickExportAsSqlMenu)
+	EVT_MENU(Config::DATABASE_EXPORT_AS_SQL_MENU_ID,  OnClickExportAsSqlMenu)
+	EVT_MENU(Config::TABLE_EXPORT_MENU_ID,  OnClickExportAsSqlMenu)
 END_EVENT_TABLE()
 
 LeftTreeView::LeftTreeView():QPanel()
@@ -64,6 +71,7 @@ LeftTreeView::LeftTreeView():QPanel()
 	AppContext::getInstance()->subscribe(this, Config::MSG_ADD_DATABASE_ID);
 	AppContext::getInstance()->subscribe(this, Config::MSG_NEW_TABLE_ID);
 	AppContext::getInstance()->subscribe(this, Config::MSG_NEW_OBJECT_ID);
+	AppContext::getInstance()->subscribe(this, Config::MSG_LEFTVIEW_REFRESH_DATABASE_ID);
 
 	leftTreeDelegate = LeftTreeDelegate::getInstance(this);
 	leftTopbarDelegate = LeftTopbarDelegate::getInstance(this);
@@ -78,6 +86,7 @@ LeftTreeView::~LeftTreeView()
 	AppContext::getInstance()->unsubscribe(this, Config::MSG_ADD_DATABASE_ID);
 	AppContext::getInstance()->unsubscribe(this, Config::MSG_NEW_TABLE_ID);
 	AppContext::getInstance()->unsubscribe(this, Config::MSG_NEW_OBJECT_ID);
+	AppContext::getInstance()->unsubscribe(this, Config::MSG_LEFTVIEW_REFRESH_DATABASE_ID);
 	
 	LeftTreeDelegate::destroyInstance();
 	leftTreeDelegate = nullptr;	
@@ -274,6 +283,13 @@ void LeftTreeView::OnTreeItemExpended(wxTreeEvent& event)
 	}
 }
 
+void LeftTreeView::OnTreeItemCollapsed(wxTreeEvent& event)
+{
+	auto itemId = event.GetItem();
+	// cancel the background loads of the item
+	leftTreeDelegate->collapsedForLeftTree(treeView, itemId);
+}
+
 void LeftTreeView::OnTreeItemSelChanged(wxTreeEvent& event)
 {
 	auto selItemId = event.GetItem();
@@ -454,6 +470,22 @@ void LeftTreeView::OnHandleNewObject(MsgDispatcherEvent& event)
 	leftTreeDelegate->refreshDbItemsForLeftTree(treeView, supplier->handleUserDb.connectId, supplier->handleUserDb.name, findSelData);
 }
 
+/**
+ * The sql statements are executed in the query page, only the changed items of the selected database are refreshed.
+ * 
+ * @param event
+ */
+void LeftTreeView::OnHandleRefreshDatabase(MsgDispatcherEvent& event)
+{
+	if (supplier->runtimeUserDb == nullptr) {
+		return;
+	}
+	// copy them, the selected item may be deleted by the refresh
+	uint64_t connectId = supplier->runtimeUserDb->connectId;
+	std::string schema = supplier->runtimeUserDb->name;
+	leftTreeDelegate->refreshChangedItemsForLeftTree(treeView, connectId, schema);
+}
+
 
 void LeftTreeView::OnClickConnectButton(wxCommandEvent& event)
 {
@@ -598,7 +630,7 @@ void LeftTreeView::OnClickConnectionRefreshMenu(wxCommandEvent& event)
 	if (!supplier->runtimeUserConnect || !supplier->runtimeUserConnect->id) {
 		return;
 	}
-	leftTreeDelegate->loadForLeftTree(treeView, supplier->runtimeUserConnect->id);
+	leftTreeDelegate->refreshConnectionForLeftTree(treeView, supplier->runtimeUserConnect->id);
 }
 
 void LeftTreeView::OnClickConnectionManageMenu(wxCommandEvent& event)
@@ -616,3 +648,13 @@ void LeftTreeView::OnClickDatabaseOpenMenu(wxCommandEvent& event)
 {
 	AppContext::getInstance()->dispatch(Config::MSG_OPEN_DATABASE_ID);
 }
+
+void LeftTreeView::OnClickExportAsSqlMenu(wxCommandEvent& event)
+{
+	auto selItemId = treeView->GetSelection();
+	if (!selItemId.IsOk() || selItemId == treeView->GetRootItem()) {
+		QAnimateBox::notice(S("not-choose-treeitem"));
+		return;
+	}
+	leftTreeDelegate->exportAsSqlForLeftTree(treeView);
+}
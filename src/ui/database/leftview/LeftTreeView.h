@@ -69,12 +69,14 @@ private:
 	void OnSize(wxSizeEvent& event);
 	void OnPaint(wxPaintEvent& event);
 	void OnTreeItemExpended(wxTreeEvent& event);
+	void OnTreeItemCollapsed(wxTreeEvent& event);
 	void OnTreeItemSelChanged(wxTreeEvent& event);
 	void OnTreeItemRightClicked(wxTreeEvent& event);
 	// handle message event
 	void OnHandleConnectionConnected(MsgDispatcherEvent& event);
 	void OnHandleAddDatabase(MsgDispatcherEvent& event);
 	void OnHandleNewObject(MsgDispatcherEvent& event);
+	void OnHandleRefreshDatabase(MsgDispatcherEvent& event);
 
 	// button id
 	void OnClickConnectButton(wxCommandEvent & event);
@@ -92,5 +94,7 @@ private:
 
 	// Click Database menu
 	void OnClickDatabaseOpenMenu(wxCommandEvent & event);
+	// Click Export as sql menu of connection, database and table
+	void OnClickExportAsSqlMenu(wxCommandEvent & event);
 };
 
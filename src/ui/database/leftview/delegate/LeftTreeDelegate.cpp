@@ -17,7 +17,9 @@
  * @date   2024-11-23
  *********************************************************************/
 #include "LeftTreeDelegate.h"
+#include <algorithm>
 #include <wx/msgdlg.h>
+#include <wx/wupdlock.h>
 #include "common/AppContext.h"
 #include "utils/ResourceUtil.h"
 #include "core/common/Lang.h"
@@ -30,6 +32,7 @@
 #include "ui/dialog/duplicate/database/DuplicateDatabaseDialog.h"
 #include "ui/dialog/duplicate/table/DuplicateTableDialog.h"
 #include "ui/dialog/duplicate/object/DuplicateObjectDialog.h"
+#include "ui/dialog/export/sql/ExportSqlDialog.h"
 
 const std::unordered_map<std::string, TreeObjectType> LeftTreeDelegate::objectTypeMap{
 	{"DATABASE", TreeObjectType::SCHEMA},
@@ -40,8 +43,23 @@ const std::unordered_map<std::string, TreeObjectType> LeftTreeDelegate::objectTy
 	{"TRIGGER", TreeObjectType::TRIGGER},
 	{"EVENT", TreeObjectType::EVENT}
 };
+
+const std::unordered_map<std::string, TreeObjectType> LeftTreeDelegate::listFolderTypeMap{
+	{"tables", TreeObjectType::TABLES_FOLDER},
+	{"views", TreeObjectType::VIEWS_FOLDER},
+	{"procedures", TreeObjectType::STORE_PROCEDURES_FOLDER},
+	{"functions", TreeObjectType::FUNCTIONS_FOLDER},
+	{"triggers", TreeObjectType::TRIGGERS_FOLDER},
+	{"events", TreeObjectType::EVENTS_FOLDER}
+};
 LeftTreeDelegate::~LeftTreeDelegate()
 {
+	// the callbacks of the running loads are still called after the delegate is destroyed
+	for (auto& item : pendingLoads) {
+		*item.second.canceled = true;
+	}
+	pendingLoads.clear();
+
 	ConnectService::destroyInstance();
 	connectService = nullptr;
 
@@ -148,54 +166,79 @@ void LeftTreeDelegate::expendedForLeftTree(wxTreeCtrl* treeView, wxTreeItemId& i
 		auto data = (QTreeItemData<UserConnect>*)treeView->GetItemData(itemId);
 		auto connectId = data->getDataPtr()->id;
 		expendedConnectionItem(treeView, itemId, connectId);
-	}else if (nImage == 4) { // 4 - table
+	} else if (nImage == 2) { // 2 - database, the folders of the database are loaded concurrently
+		auto data = (QTreeItemData<UserDb>*)treeView->GetItemData(itemId);
+		auto userDbPtr = data->getDataPtr();
+		for (auto& item : listFolderTypeMap) {
+			auto folderItemId = findFolderItemFromDbItem(treeView, itemId, item.second);
+			if (folderItemId.IsOk() && !isLoadedItem(treeView, folderItemId)) {
+				loadFolderAsync(treeView, userDbPtr->connectId, userDbPtr->name, item.second);
+			}
+		}
+	} else if (nImage == 4) { // 4 - table
 		auto data = (QTreeItemData<UserTable>*)treeView->GetItemData(itemId);
 		auto connectId = data->getDataId();
 		auto userTable = data->getDataPtr();
 		expendedTableItem(treeView, itemId, connectId, userTable);
 	} else if (nImage == 3) { // 3 - objects folder
-		wxTreeItemIdValue cookie;
-		auto firstChildId = treeView->GetFirstChild(itemId, cookie);
-
-		int nFirstImage = treeView->GetItemImage(firstChildId);
-		if (nFirstImage != 10) { // 10 - loading
+		if (isLoadedItem(treeView, itemId)) {
 			return;
 		}
-		// delete loading item
-		treeView->Delete(firstChildId);
 
 		auto data = (QTreeItemData<long> *)treeView->GetItemData(itemId);
-		if (data->getType() == TreeObjectType::TABLES_FOLDER) { // TABLE folder
-			auto userDbData = (QTreeItemData<UserDb> *)data;
-			auto connectId = userDbData->getDataId();
-			auto userDbPtr = userDbData->getDataPtr();
-			loadTablesForDatabase(treeView, itemId, connectId, userDbPtr->name);
-		} else if (data->getType() == TreeObjectType::VIEWS_FOLDER) { // VIEW folder
-			auto userDbData = (QTreeItemData<UserDb> *)data;
-			auto connectId = userDbData->getDataId();
-			auto userDbPtr = userDbData->getDataPtr();
-			loadViewsForDatabase(treeView, itemId, connectId, userDbPtr->name);
-		} else if (data->getType() == TreeObjectType::STORE_PROCEDURES_FOLDER) { // STORE PROCEDURE folder
-			auto userDbData = (QTreeItemData<UserDb> *)data;
-			auto connectId = userDbData->getDataId();
-			auto userDbPtr = userDbData->getDataPtr();
-			loadProceduresForDatabase(treeView, itemId, connectId, userDbPtr->name);
-		} else if (data->getType() == TreeObjectType::FUNCTIONS_FOLDER) { // FUNCTION folder
-			auto userDbData = (QTreeItemData<UserDb> *)data;
-			auto connectId = userDbData->getDataId();
-			auto userDbPtr = userDbData->getDataPtr();
-			loadFunctionsForDatabase(treeView, itemId, connectId, userDbPtr->name);
-		} else if (data->getType() == TreeObjectType::TRIGGERS_FOLDER) { // TRIGGER folder
-			auto userDbData = (QTreeItemData<UserDb> *)data;
-			auto connectId = userDbData->getDataId();
-			auto userDbPtr = userDbData->getDataPtr();
-			loadTriggersForDatabase(treeView, itemId, connectId, userDbPtr->name);
-		} else if (data->getType() == TreeObjectType::EVENTS_FOLDER) { // EVENTS folder
-			auto userDbData = (QTreeItemData<UserDb> *)data;
-			auto connectId = userDbData->getDataId();
-			auto userDbPtr = userDbData->getDataPtr();
-			loadEventsForDatabase(treeView, itemId, connectId, userDbPtr->name);
-		} 
+		if (data->getType() == TreeObjectType::TABLE_COLUMNS_FOLDER 
+			|| data->getType() == TreeObjectType::TABLE_INDEXES_FOLDER) { // the folders of the table
+			auto userTableData = (QTreeItemData<UserTable> *)data;
+			auto userTablePtr = userTableData->getDataPtr();
+			loadTableAsync(treeView, userTableData->getDataId(), userTablePtr->schema, userTablePtr->tblName);
+		} else { // TABLE/VIEW/STORE PROCEDURE/FUNCTION/TRIGGER/EVENTS folder
+			auto userDbPtr = ((QTreeItemData<UserDb> *)data)->getDataPtr();
+			loadFolderAsync(treeView, userDbPtr->connectId, userDbPtr->name, (TreeObjectType)data->getType());
+		}
+	}
+}
+
+/**
+ * Cancel the loads of the collapsed item and its children, the loading items are kept, they are loaded again when expanded.
+ * 
+ * @param treeView
+ * @param itemId
+ */
+void LeftTreeDelegate::collapsedForLeftTree(wxTreeCtrl* treeView, wxTreeItemId& itemId)
+{
+	if (!itemId.IsOk() || pendingLoads.empty()) {
+		return;
+	}
+	auto data = (QTreeItemData<long> *)treeView->GetItemData(itemId);
+	if (data == nullptr || data->getDataPtr() == nullptr) {
+		return;
+	}
+
+	auto type = (TreeObjectType)data->getType();
+	if (type == TreeObjectType::CONNECTION) {
+		auto userConnectData = (QTreeItemData<UserConnect> *)data;
+		cancelLoads(std::to_string(userConnectData->getDataPtr()->id).append("\n"));
+	} else if (type == TreeObjectType::SCHEMA) {
+		auto userDbPtr = ((QTreeItemData<UserDb> *)data)->getDataPtr();
+		cancelLoads(std::to_string(userDbPtr->connectId).append("\n").append(userDbPtr->name).append("\n"));
+	} else if (type == TreeObjectType::TABLE 
+		|| type == TreeObjectType::TABLE_COLUMNS_FOLDER 
+		|| type == TreeObjectType::TABLE_INDEXES_FOLDER) {
+		auto userTableData = (QTreeItemData<UserTable> *)data;
+		auto userTablePtr = userTableData->getDataPtr();
+		cancelLoads(getLoadPath(userTableData->getDataId(), userTablePtr->schema, TreeObjectType::TABLE, userTablePtr->tblName));
+	} else if (type == TreeObjectType::TABLES_FOLDER 
+		|| type == TreeObjectType::VIEWS_FOLDER
+		|| type == TreeObjectType::STORE_PROCEDURES_FOLDER
+		|| type == TreeObjectType::FUNCTIONS_FOLDER
+		|| type == TreeObjectType::TRIGGERS_FOLDER
+		|| type == TreeObjectType::EVENTS_FOLDER) {
+		auto userDbPtr = ((QTreeItemData<UserDb> *)data)->getDataPtr();
+		cancelLoads(getLoadPath(userDbPtr->connectId, userDbPtr->name, type));
+		if (type == TreeObjectType::TABLES_FOLDER) {
+			// the columns and indexes of the expanded tables
+			cancelLoads(getLoadPath(userDbPtr->connectId, userDbPtr->name, TreeObjectType::TABLE));
+		}
 	}
 }
 
@@ -464,6 +507,78 @@ bool LeftTreeDelegate::duplicateForLeftTree(wxTreeCtrl* treeView)
 	return false;
 }
 
+/**
+ * Export the selected connection (all user databases), database or table as a sql file.
+ * 
+ * @param treeView
+ * @return 
+ */
+bool LeftTreeDelegate::exportAsSqlForLeftTree(wxTreeCtrl* treeView)
+{
+	if (!treeView) {
+		return false;
+	}
+	auto selItemId = treeView->GetSelection();
+	if (!selItemId.IsOk() || selItemId == treeView->GetRootItem()) {
+		return false;
+	}
+	auto data = (QTreeItemData<int> *) treeView->GetItemData(selItemId);
+	auto userConnect = getSelectedConnectItemData(treeView);
+	if (!data || !userConnect) {
+		return false;
+	}
+
+	SqlExportParams params;
+	params.connectId = userConnect->id;
+	std::string title;
+	try {
+		if (data->getType() == TreeObjectType::CONNECTION) {
+			for (auto & userDb : databaseService->getAllUserDbs(params.connectId)) {
+				if (!isSystemSchema(userDb.name)) {
+					params.schemas.push_back(userDb.name);
+				}
+			}
+			params.createDatabase = true;
+			title = S("connection-export-as-sql");
+		} else if (data->getType() == TreeObjectType::TABLE) {
+			auto userTable = getSelectedTableItemData(treeView);
+			if (!userTable) {
+				return false;
+			}
+			params.schemas.push_back(userTable->schema);
+			params.tables.push_back(userTable->name);
+			title = S("table-export");
+		} else {
+			auto userDb = getSelectedDbItemData(treeView);
+			if (!userDb) {
+				return false;
+			}
+			params.schemas.push_back(userDb->name);
+			title = S("database-export-as-sql");
+		}
+	} catch (QRuntimeException& ex) {
+		QAnimateBox::error(ex);
+		return false;
+	}
+
+	if (params.schemas.empty() || (params.schemas.size() == 1 && isSystemSchema(params.schemas.front()))) {
+		QAnimateBox::error(S("system-schema-cannot-export"));
+		return false;
+	}
+
+	ExportSqlDialog dialog(params);
+	dialog.Create(AppContext::getInstance()->getMainFrmWindow(), wxID_ANY, title, wxDefaultPosition, wxDefaultSize);
+	return dialog.ShowModal() == wxID_OK;
+}
+
+bool LeftTreeDelegate::isSystemSchema(const std::string & schema)
+{
+	return schema == "information_schema"
+		|| schema == "mysql"
+		|| schema == "performance_schema"
+		|| schema == "sys";
+}
+
 /**
  * Prepare handleUserDb and handleUserObject data for refresh.
  * 
@@ -482,6 +597,8 @@ void LeftTreeDelegate::beforeFreshForLeftTree(wxTreeCtrl* treeView)
 		return;
 	}
 	supplier->handleUserDb = *supplier->runtimeUserDb;
+	// the refreshed items are loaded from the server, not from the metadata cache
+	metadataService->invalidateCache(supplier->handleUserDb.connectId, supplier->handleUserDb.name);
 	if (data->getType() == TreeObjectType::SCHEMA) {		
 		supplier->handleUserObject = UserObject();
 	} else if (data->getType() == TreeObjectType::TABLE 
@@ -539,6 +656,7 @@ void LeftTreeDelegate::beforeFreshForLeftTree(wxTreeCtrl* treeView)
 
 void LeftTreeDelegate::refreshConnectItemsForLeftTree(wxTreeCtrl* treeView, uint64_t connectId, const std::string& schema)
 {
+	metadataService->invalidateCache(connectId, schema);
 	// 1.Find the connection item
 	auto connectItemId = findConnectItemFromRootItem(treeView, connectId);
 	if (!connectItemId.IsOk()) {
@@ -560,7 +678,20 @@ void LeftTreeDelegate::refreshConnectItemsForLeftTree(wxTreeCtrl* treeView, uint
 }
 
 /**
- * .
+ * Reload the databases of the connection, the cached metadata of the connection is removed.
+ * 
+ * @param treeView
+ * @param connectId
+ */
+void LeftTreeDelegate::refreshConnectionForLeftTree(wxTreeCtrl* treeView, uint64_t connectId)
+{
+	metadataService->invalidateCache(connectId);
+	loadForLeftTree(treeView, connectId);
+}
+
+/**
+ * Refresh the changed items of the database and select the object item, 
+ * the loaded items are patched by the changed lists, see refreshChangedItemsForLeftTree(...).
  * 
  * @param treeView
  * @param connectId
@@ -579,20 +710,175 @@ void LeftTreeDelegate::refreshDbItemsForLeftTree(wxTreeCtrl* treeView, uint64_t
 	// 2.Expend the connection item and load databases for the connectItemId
 	expendedConnectionItem(treeView, connectItemId, connectId);
 
-	// 3.Find the database item and load object
+	// 3.Patch the changed items of the database, the following steps run after the changed lists are loaded,
+	//   findSelData is owned by the caller, so its type and name are copied
+	auto selType = (TreeObjectType)findSelData.getType();
+	std::string selName = findSelData.getDataPtr() ? *findSelData.getDataPtr() : "";
+	refreshChangedItemsForLeftTree(treeView, connectId, schema, [this, connectId, schema, selType, selName](wxTreeCtrl* refreshedTreeView) {
+		// 4.Find the database item and load object
+		// the items may be reloaded or removed while loading, so the database item is found again
+		auto connectItemId = findConnectItemFromRootItem(refreshedTreeView, connectId);
+		auto dbItemId = findDbItemFromConnectionItem(refreshedTreeView, connectItemId, schema);
+		if (!dbItemId.IsOk()) {
+			return;
+		}
+
+		// 5.Expend database item, the folder that has been loaded is patched above
+		auto folderType = objectTypeToFolderType(selType);
+		auto folderItemId = findFolderItemFromDbItem(refreshedTreeView, dbItemId, folderType);
+		if (!isLoadedItem(refreshedTreeView, folderItemId)) {
+			folderItemId = expendedDbItem(refreshedTreeView, dbItemId, folderType);
+		}
+
+		// 6.select object item
+		QTreeItemData<std::string> findSelData(connectId, new std::string(selName), selType);
+		selectDbObjectItemFromFolder(refreshedTreeView, folderItemId, findSelData);
+	});
+}
+
+/**
+ * Refresh the tree items of the schema incrementally, the fingerprint of the schema is compared with the last one, 
+ * only the changed lists are loaded again in the background and patched into the loaded items, so the expanded items are kept.
+ * The items that are not loaded yet (with the loading item) read the lists when they are expanded.
+ * 
+ * @param treeView
+ * @param connectId
+ * @param schema
+ * @param afterRefreshed - called in the ui thread after the items are patched if the delegate is alive
+ */
+void LeftTreeDelegate::refreshChangedItemsForLeftTree(wxTreeCtrl* treeView, uint64_t connectId, const std::string& schema, 
+	std::function<void (wxTreeCtrl*)> afterRefreshed)
+{
+	auto connectItemId = findConnectItemFromRootItem(treeView, connectId);
+	if (!connectItemId.IsOk() || !isLoadedItem(treeView, connectItemId) || schema.empty()) {
+		if (afterRefreshed) {
+			afterRefreshed(treeView);
+		}
+		return;
+	}
+
+	// the tree is destroyed after the delegate, see LeftTreeView::~LeftTreeView()
+	QAliveFlag alive = aliveToken.flag();
+	metadataService->loadChangedListsAsync(connectId, schema, 
+		[this, alive, treeView, connectId, schema, afterRefreshed](const std::vector<std::string> & changedLists) {
+		if (!*alive) {
+			return;
+		}
+		patchChangedItemsForLeftTree(treeView, connectId, schema, changedLists);
+		if (afterRefreshed) {
+			afterRefreshed(treeView);
+		}
+	});
+}
+
+/**
+ * Patch the loaded items of the schema by the changed lists, the lists are read from the metadata cache.
+ * 
+ * @param treeView
+ * @param connectId
+ * @param schema
+ * @param changedLists - see MetadataService::getChangedLists(...)
+ */
+void LeftTreeDelegate::patchChangedItemsForLeftTree(wxTreeCtrl* treeView, uint64_t connectId, const std::string& schema, const std::vector<std::string>& changedLists)
+{
+	auto connectItemId = findConnectItemFromRootItem(treeView, connectId);
+	if (!connectItemId.IsOk() || !isLoadedItem(treeView, connectItemId) || changedLists.empty()) {
+		return;
+	}
+
+	// redraw the tree once after all items are patched
+	wxWindowUpdateLocker locker(treeView);
+	if (std::find(changedLists.begin(), changedLists.end(), "databases") != changedLists.end()) {
+		patchDbsForConnection(treeView, connectItemId, connectId);
+	}
 	auto dbItemId = findDbItemFromConnectionItem(treeView, connectItemId, schema);
-	
 	if (!dbItemId.IsOk()) {
 		return;
 	}
-	
-	// 4.Expend database item
-	auto folderType = objectTypeToFolderType((TreeObjectType)findSelData.getType());
 
-	// 5.select object item
-	auto folderItemId = expendedDbItem(treeView, dbItemId, folderType);	
-	selectDbObjectItemFromFolder(treeView, folderItemId, findSelData);
-	return ;
+	bool isTableMetaChanged = false;
+	for (auto& object : changedLists) {
+		if (object == "columns" || object == "indexes") {
+			isTableMetaChanged = true;
+			continue;
+		}
+		auto iter = listFolderTypeMap.find(object);
+		if (iter == listFolderTypeMap.end()) {
+			continue;
+		}
+		auto folderItemId = findFolderItemFromDbItem(treeView, dbItemId, iter->second);
+		if (isLoadedItem(treeView, folderItemId)) {
+			patchFolderForDatabase(treeView, folderItemId, iter->second, connectId, schema);
+		}
+	}
+
+	// the columns and indexes of the expanded tables
+	if (isTableMetaChanged) {
+		auto tblsFolderItemId = findFolderItemFromDbItem(treeView, dbItemId, TreeObjectType::TABLES_FOLDER);
+		if (isLoadedItem(treeView, tblsFolderItemId)) {
+			patchColumnsAndIndexesForTables(treeView, tblsFolderItemId, connectId, schema);
+		}
+	}
+}
+
+/**
+ * Reconcile the snapshot of the connection against the server in the background, 
+ * the changed lists are loaded into the tree again when the server responds.
+ * 
+ * @param treeView
+ * @param connectId
+ */
+void LeftTreeDelegate::reconcileSnapshotForLeftTree(wxTreeCtrl* treeView, uint64_t connectId)
+{
+	// the tree is destroyed after the delegate, see LeftTreeView::~LeftTreeView()
+	QAliveFlag alive = aliveToken.flag();
+	metadataService->reconcileSnapshotAsync(connectId, [this, alive, treeView, connectId](const std::vector<MetadataListKey> & changedLists) {
+		if (!*alive) {
+			return;
+		}
+		reloadChangedListsForLeftTree(treeView, connectId, changedLists);
+	});
+}
+
+/**
+ * Load the changed lists into the items that have been loaded, the items that are not loaded yet 
+ * (with the loading item) read the reconciled lists when they are expanded.
+ * 
+ * @param treeView
+ * @param connectId
+ * @param changedLists - (schema, object) of the changed lists, ("", "databases") for the databases
+ */
+void LeftTreeDelegate::reloadChangedListsForLeftTree(wxTreeCtrl* treeView, uint64_t connectId, const std::vector<MetadataListKey>& changedLists)
+{
+	auto connectItemId = findConnectItemFromRootItem(treeView, connectId);
+	if (!connectItemId.IsOk()) {
+		return;
+	}
+	wxTreeItemIdValue cookie;
+	auto firstChildId = treeView->GetFirstChild(connectItemId, cookie);
+	if (!firstChildId.IsOk() || treeView->GetItemImage(firstChildId) == 10) { // image: 10 - loading
+		return;
+	}
+
+	// redraw the tree once after all items are patched
+	wxWindowUpdateLocker locker(treeView);
+	for (auto & key : changedLists) {
+		if (key.first.empty()) {
+			// the databases are changed, the removed databases are deleted and the new databases are loaded lazily
+			patchDbsForConnection(treeView, connectItemId, connectId);
+			continue;
+		}
+		auto iter = listFolderTypeMap.find(key.second);
+		if (iter == listFolderTypeMap.end()) {
+			continue;
+		}
+		auto dbItemId = findDbItemFromConnectionItem(treeView, connectItemId, key.first);
+		auto folderItemId = findFolderItemFromDbItem(treeView, dbItemId, iter->second);
+		if (!isLoadedItem(treeView, folderItemId)) {
+			continue;
+		}
+		patchFolderForDatabase(treeView, folderItemId, iter->second, connectId, key.first);
+	}
 }
 
 void LeftTreeDelegate::expendedConnectionItem(wxTreeCtrl* treeView, wxTreeItemId& itemId, uint64_t connectId)
@@ -634,19 +920,7 @@ wxTreeItemId LeftTreeDelegate::expendedDbItem(wxTreeCtrl* treeView, wxTreeItemId
 	treeView->DeleteChildren(folderItem);
 
 	auto data = reinterpret_cast<QTreeItemData<UserDb>*>(treeView->GetItemData(itemId));
-	if (findFolderType == TreeObjectType::TABLES_FOLDER) {
-		loadTablesForDatabase(treeView, folderItem, data->getDataPtr()->connectId, data->getDataPtr()->name);
-	} else if (findFolderType == TreeObjectType::VIEWS_FOLDER) {
-		loadViewsForDatabase(treeView, folderItem, data->getDataPtr()->connectId, data->getDataPtr()->name);
-	} else if (findFolderType == TreeObjectType::STORE_PROCEDURES_FOLDER) {
-		loadProceduresForDatabase(treeView, folderItem, data->getDataPtr()->connectId, data->getDataPtr()->name);
-	} else if (findFolderType == TreeObjectType::FUNCTIONS_FOLDER) {
-		loadFunctionsForDatabase(treeView, folderItem, data->getDataPtr()->connectId, data->getDataPtr()->name);
-	} else if (findFolderType == TreeObjectType::TRIGGERS_FOLDER) {
-		loadTriggersForDatabase(treeView, folderItem, data->getDataPtr()->connectId, data->getDataPtr()->name);
-	} else if (findFolderType == TreeObjectType::EVENTS_FOLDER) {
-		loadEventsForDatabase(treeView, folderItem, data->getDataPtr()->connectId, data->getDataPtr()->name);
-	}
+	loadFolderForDatabase(treeView, folderItem, findFolderType, data->getDataPtr()->connectId, data->getDataPtr()->name);
 	
 	return folderItem;
 }
@@ -658,6 +932,13 @@ void LeftTreeDelegate::expendedTableItem(wxTreeCtrl* treeView, wxTreeItemId& ite
 
 	int nImage = treeView->GetItemImage(firstChildId);
 	if (nImage != 10) { // image: 10 - loading
+		// the load of the folders may be canceled by collapsing the table
+		for (auto folderItemId = firstChildId; folderItemId.IsOk(); folderItemId = treeView->GetNextChild(itemId, cookie)) {
+			if (!isLoadedItem(treeView, folderItemId)) {
+				loadTableAsync(treeView, connectId, userTable->schema, userTable->tblName);
+				break;
+			}
+		}
 		return;
 	}
 	treeView->Delete(firstChildId);
@@ -670,9 +951,155 @@ void LeftTreeDelegate::expendedTableItem(wxTreeCtrl* treeView, wxTreeItemId& ite
 	auto indexesFolderItemId = treeView->AppendItem(itemId, S("indexes"), 3, 3, indexesFolderData);
 
 	
-	// Table - folder - loading
-	loadColomnsForTable(treeView, columnsFolderItemId, connectId, userTable->schema, userTable->tblName);
-	loadIndexesForTable(treeView, indexesFolderItemId, connectId, userTable->schema, userTable->tblName);
+	// Table - folder - loading, the columns and indexes are loaded in the background
+	loadingForFolder(treeView, columnsFolderItemId, connectId);
+	loadingForFolder(treeView, indexesFolderItemId, connectId);
+	loadTableAsync(treeView, connectId, userTable->schema, userTable->tblName);
+}
+
+/**
+ * Load the objects of the database folder in the background, the loading item of the folder is replaced when the list arrives.
+ * 
+ * @param treeView
+ * @param connectId
+ * @param schema
+ * @param folderType - TreeObjectType::TABLES_FOLDER/VIEWS_FOLDER/STORE_PROCEDURES_FOLDER/FUNCTIONS_FOLDER/TRIGGERS_FOLDER/EVENTS_FOLDER
+ */
+void LeftTreeDelegate::loadFolderAsync(wxTreeCtrl* treeView, uint64_t connectId, const std::string& schema, const TreeObjectType& folderType)
+{
+	auto iter = std::find_if(listFolderTypeMap.begin(), listFolderTypeMap.end(), 
+		[&folderType](const std::pair<const std::string, TreeObjectType>& item) { return item.second == folderType; });
+	if (iter == listFolderTypeMap.end()) {
+		return;
+	}
+	auto path = getLoadPath(connectId, schema, folderType);
+	loadItemAsync(treeView, path, connectId, schema, iter->first, [this, connectId, schema, folderType](wxTreeCtrl* loadedTreeView) {
+		// the items may be reloaded or removed while loading, so the folder item is found again
+		auto connectItemId = findConnectItemFromRootItem(loadedTreeView, connectId);
+		auto dbItemId = findDbItemFromConnectionItem(loadedTreeView, connectItemId, schema);
+		auto folderItemId = findFolderItemFromDbItem(loadedTreeView, dbItemId, folderType);
+		if (!folderItemId.IsOk() || isLoadedItem(loadedTreeView, folderItemId)) {
+			return;
+		}
+		loadedTreeView->DeleteChildren(folderItemId);
+		loadFolderForDatabase(loadedTreeView, folderItemId, folderType, connectId, schema);
+	});
+}
+
+/**
+ * Load the columns and indexes of the table in the background, the loading items of the column and index folders are replaced.
+ * 
+ * @param treeView
+ * @param connectId
+ * @param schema
+ * @param tblName
+ */
+void LeftTreeDelegate::loadTableAsync(wxTreeCtrl* treeView, uint64_t connectId, const std::string& schema, const std::string& tblName)
+{
+	auto path = getLoadPath(connectId, schema, TreeObjectType::TABLE, tblName);
+	loadItemAsync(treeView, path, connectId, schema, "columns:" + tblName, [this, connectId, schema, tblName](wxTreeCtrl* loadedTreeView) {
+		auto connectItemId = findConnectItemFromRootItem(loadedTreeView, connectId);
+		auto dbItemId = findDbItemFromConnectionItem(loadedTreeView, connectItemId, schema);
+		auto tblsFolderItemId = findFolderItemFromDbItem(loadedTreeView, dbItemId, TreeObjectType::TABLES_FOLDER);
+		auto tableItemId = findTableItemFromFolderItem(loadedTreeView, tblsFolderItemId, tblName);
+		if (!tableItemId.IsOk()) {
+			return;
+		}
+		wxTreeItemIdValue cookie;
+		for (auto folderItemId = loadedTreeView->GetFirstChild(tableItemId, cookie); folderItemId.IsOk(); 
+			folderItemId = loadedTreeView->GetNextChild(tableItemId, cookie)) {
+			if (isLoadedItem(loadedTreeView, folderItemId)) {
+				continue;
+			}
+			auto folderData = reinterpret_cast<QTreeItemData<UserTable>*>(loadedTreeView->GetItemData(folderItemId));
+			loadedTreeView->DeleteChildren(folderItemId);
+			if (folderData->getType() == TreeObjectType::TABLE_COLUMNS_FOLDER) {
+				loadColomnsForTable(loadedTreeView, folderItemId, connectId, schema, tblName);
+			} else if (folderData->getType() == TreeObjectType::TABLE_INDEXES_FOLDER) {
+				loadIndexesForTable(loadedTreeView, folderItemId, connectId, schema, tblName);
+			}
+		}
+	});
+}
+
+/**
+ * Load the object list into the metadata cache in the background, then afterLoaded appends the items from the cache in the ui thread.
+ * The item is not loaded twice at the same time, and the load is dropped if it is canceled by collapsing the item.
+ * 
+ * @param treeView
+ * @param path - the path of the loading item, see getLoadPath(...)
+ * @param connectId
+ * @param schema
+ * @param object - see MetadataService::loadListAsync(...)
+ * @param afterLoaded - called in the ui thread if the delegate is alive
+ */
+void LeftTreeDelegate::loadItemAsync(wxTreeCtrl* treeView, const std::string& path, uint64_t connectId, const std::string& schema, const std::string& object, 
+	std::function<void (wxTreeCtrl*)> afterLoaded)
+{
+	if (pendingLoads.find(path) != pendingLoads.end()) {
+		return;
+	}
+
+	// the tree is destroyed after the delegate, see LeftTreeView::~LeftTreeView()
+	QAliveFlag alive = aliveToken.flag();
+	auto canceled = std::make_shared<bool>(false);
+	std::string errorScope = std::to_string(connectId) + "\n" + schema + "\n";
+	auto loadId = metadataService->loadListAsync(connectId, schema, object, 
+		[this, alive, treeView, canceled, path, errorScope, afterLoaded](bool isSuccess, const std::string& code, const std::string& msg) {
+		if (!*alive || *canceled) {
+			return;
+		}
+		pendingLoads.erase(path);
+		if (!isSuccess) {
+			// the loading item is kept, the item is loaded again when it is expanded again.
+			// the folders of a database are loaded together, so their errors share one message box
+			if (!errorScopes.insert(errorScope).second) {
+				return;
+			}
+			wxMessageDialog msgbox(view, S("connect-fail").append(",Error:").append(msg), S("error-notice"), wxOK|wxCENTRE|wxICON_ERROR);
+			msgbox.ShowModal();
+			if (*alive) {
+				errorScopes.erase(errorScope);
+			}
+			return;
+		}
+		wxWindowUpdateLocker locker(treeView);
+		afterLoaded(treeView);
+	});
+
+	TreeItemLoad load;
+	load.loadId = loadId;
+	load.canceled = canceled;
+	pendingLoads[path] = load;
+}
+
+void LeftTreeDelegate::cancelLoads(const std::string& pathPrefix)
+{
+	for (auto iter = pendingLoads.begin(); iter != pendingLoads.end(); ) {
+		if (iter->first.compare(0, pathPrefix.size(), pathPrefix) != 0) {
+			++iter;
+			continue;
+		}
+		*iter->second.canceled = true;
+		metadataService->cancelLoadAsync(iter->second.loadId);
+		iter = pendingLoads.erase(iter);
+	}
+}
+
+/**
+ * The path of the loading item, "connectId\nschema\nfolderType\n" or "connectId\nschema\nTABLE\ntblName\n",
+ * the path of a parent item is the prefix of it.
+ */
+std::string LeftTreeDelegate::getLoadPath(uint64_t connectId, const std::string& schema, const TreeObjectType& type, const std::string& tblName)
+{
+	std::string path = std::to_string(connectId);
+	path.append("\n").append(schema)
+		.append("\n").append(std::to_string((int)type))
+		.append("\n");
+	if (!tblName.empty()) {
+		path.append(tblName).append("\n");
+	}
+	return path;
 }
 
 void LeftTreeDelegate::loadingForItem(wxTreeCtrl* treeView, const wxTreeItemId& itemId)
@@ -724,38 +1151,15 @@ void LeftTreeDelegate::loadDbsForConnection(wxTreeCtrl* treeView, const wxTreeIt
 		return;
 	}
 
+	// the snapshot of the last session is shown at once, then it is reconciled against the server in the background
+	bool isRestored = metadataService->restoreSnapshot(connectId);
 	try {
-		UserDbList userDbList = databaseService->getAllUserDbs(connectId);
+		UserDbList userDbList = metadataService->getUserDbs(connectId);
 		wxTreeItemId selDbItemId;
 		for (auto& item : userDbList) {
 			QTreeItemData<UserDb>* data = new QTreeItemData<UserDb>(connectId, new UserDb(item), TreeObjectType::SCHEMA);
 			auto dbItemId = treeView->AppendItem(connectItemId, item.name, 2, 2, data);
-			
-			auto tblsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(item), TreeObjectType::TABLES_FOLDER);
-			auto tblsFolderItemId = treeView->AppendItem(dbItemId, S("tables"), 3, 3, tblsFolderData);
-
-			auto viewsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(item), TreeObjectType::VIEWS_FOLDER);
-			auto viewsFolderItemId = treeView->AppendItem(dbItemId, S("views"), 3, 3, viewsFolderData);
-
-			auto storeProcsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(item), TreeObjectType::STORE_PROCEDURES_FOLDER);
-			auto storeProcsFolderItemId = treeView->AppendItem(dbItemId, S("store-procedures"), 3, 3, storeProcsFolderData);
-
-			auto funsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(item), TreeObjectType::FUNCTIONS_FOLDER);
-			auto funsFolderItemId = treeView->AppendItem(dbItemId, S("functions"), 3, 3, funsFolderData);
-
-			auto triggersFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(item), TreeObjectType::TRIGGERS_FOLDER);
-			auto triggersFolderItemId = treeView->AppendItem(dbItemId, S("triggers"), 3, 3, triggersFolderData);
-
-			auto eventsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(item), TreeObjectType::EVENTS_FOLDER);
-			auto eventsFolderItemId = treeView->AppendItem(dbItemId, S("events"), 3, 3, eventsFolderData);
-
-			// Add a loading... child item for folder.
-			loadingForFolder(treeView, tblsFolderItemId, connectId);
-			loadingForFolder(treeView, viewsFolderItemId, connectId);
-			loadingForFolder(treeView, storeProcsFolderItemId, connectId);
-			loadingForFolder(treeView, funsFolderItemId, connectId);
-			loadingForFolder(treeView, triggersFolderItemId, connectId);
-			loadingForFolder(treeView, eventsFolderItemId, connectId);
+			appendFoldersForDb(treeView, dbItemId, connectId, item);
 
 			if (!schema.empty() && schema == item.name) {
 				selDbItemId = dbItemId;
@@ -769,7 +1173,64 @@ void LeftTreeDelegate::loadDbsForConnection(wxTreeCtrl* treeView, const wxTreeIt
 		msgbox.ShowModal();
 		return;
 	}
-	
+
+	if (isRestored) {
+		reconcileSnapshotForLeftTree(treeView, connectId);
+	}
+}
+
+/**
+ * The object folders of the database item, the objects of the folders are loaded lazily.
+ * 
+ * @param treeView
+ * @param dbItemId
+ * @param connectId
+ * @param userDb
+ */
+void LeftTreeDelegate::appendFoldersForDb(wxTreeCtrl* treeView, const wxTreeItemId& dbItemId, uint64_t connectId, const UserDb& userDb)
+{
+	auto tblsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(userDb), TreeObjectType::TABLES_FOLDER);
+	auto tblsFolderItemId = treeView->AppendItem(dbItemId, S("tables"), 3, 3, tblsFolderData);
+
+	auto viewsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(userDb), TreeObjectType::VIEWS_FOLDER);
+	auto viewsFolderItemId = treeView->AppendItem(dbItemId, S("views"), 3, 3, viewsFolderData);
+
+	auto storeProcsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(userDb), TreeObjectType::STORE_PROCEDURES_FOLDER);
+	auto storeProcsFolderItemId = treeView->AppendItem(dbItemId, S("store-procedures"), 3, 3, storeProcsFolderData);
+
+	auto funsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(userDb), TreeObjectType::FUNCTIONS_FOLDER);
+	auto funsFolderItemId = treeView->AppendItem(dbItemId, S("functions"), 3, 3, funsFolderData);
+
+	auto triggersFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(userDb), TreeObjectType::TRIGGERS_FOLDER);
+	auto triggersFolderItemId = treeView->AppendItem(dbItemId, S("triggers"), 3, 3, triggersFolderData);
+
+	auto eventsFolderData = new QTreeItemData<UserDb>(connectId, new UserDb(userDb), TreeObjectType::EVENTS_FOLDER);
+	auto eventsFolderItemId = treeView->AppendItem(dbItemId, S("events"), 3, 3, eventsFolderData);
+
+	// Add a loading... child item for folder.
+	loadingForFolder(treeView, tblsFolderItemId, connectId);
+	loadingForFolder(treeView, viewsFolderItemId, connectId);
+	loadingForFolder(treeView, storeProcsFolderItemId, connectId);
+	loadingForFolder(treeView, funsFolderItemId, connectId);
+	loadingForFolder(treeView, triggersFolderItemId, connectId);
+	loadingForFolder(treeView, eventsFolderItemId, connectId);
+}
+
+void LeftTreeDelegate::loadFolderForDatabase(wxTreeCtrl* treeView, const wxTreeItemId& folderItemId, const TreeObjectType& folderType, uint64_t connectId, const std::string& schema)
+{
+	if (folderType == TreeObjectType::TABLES_FOLDER) {
+		loadTablesForDatabase(treeView, folderItemId, connectId, schema);
+	} else if (folderType == TreeObjectType::VIEWS_FOLDER) {
+		loadViewsForDatabase(treeView, folderItemId, connectId, schema);
+	} else if (folderType == TreeObjectType::STORE_PROCEDURES_FOLDER) {
+		loadProceduresForDatabase(treeView, folderItemId, connectId, schema);
+	} else if (folderType == TreeObjectType::FUNCTIONS_FOLDER) {
+		loadFunctionsForDatabase(treeView, folderItemId, connectId, schema);
+	} else if (folderType == TreeObjectType::TRIGGERS_FOLDER) {
+		loadTriggersForDatabase(treeView, folderItemId, connectId, schema);
+	} else if (folderType == TreeObjectType::EVENTS_FOLDER) {
+		loadEventsForDatabase(treeView, folderItemId, connectId, schema);
+	}
 }
 
 void LeftTreeDelegate::loadTablesForDatabase(wxTreeCtrl* treeView, const wxTreeItemId& folderItemId, uint64_t connectId, const std::string& schema)
@@ -898,18 +1359,12 @@ void LeftTreeDelegate::loadColomnsForTable(wxTreeCtrl* treeView, const wxTreeIte
 	}
 	
 	try {
+		// the first expanded table loads the columns and indexes of all tables in the database
+		metadataService->loadTableMetadataOfSchema(connectId, schema);
 		ColumnInfoList list = metadataService->getColumnsOfUserTable(connectId, schema, tableName);
 		for (auto& item : list) {
 			QTreeItemData<ColumnInfo>* data = new QTreeItemData<ColumnInfo>(connectId, new ColumnInfo(item), TreeObjectType::TABLE_COLUMN);
-			std::string columnName = item.name;
-			columnName.append(" [")
-				.append(item.type)
-				.append(item.size ? "(" + std::to_string(item.size) +")" : "")
-				.append(item.un ? " UNSIGNED" : "")
-				.append(", ")
-				.append(item.isNullable ? "NULL" : "NOT NULL")
-				.append("]");
-			treeView->AppendItem(folderItemId, columnName, 11, 11, data);
+			treeView->AppendItem(folderItemId, getColumnItemText(item), 11, 11, data);
 		}
 		if (!list.empty()) {
 			treeView->Expand(folderItemId);
@@ -928,16 +1383,12 @@ void LeftTreeDelegate::loadIndexesForTable(wxTreeCtrl* treeView, const wxTreeIte
 	}
 	
 	try {
+		metadataService->loadTableMetadataOfSchema(connectId, schema);
 		auto list = metadataService->getIndexesOfUserTable(connectId, schema, tableName); 
 		for (auto& item : list) {
 			auto data = new QTreeItemData<IndexInfo>(connectId, new IndexInfo(item), TreeObjectType::TABLE_INDEX);
-			std::string indexName = item.name;
-			indexName.append(" (").append(item.columns).append(")");
-			if (item.name != "PRIMARY" && item.un) {
-				indexName.append(", ").append("UNIQUE");
-			}
 			int nImage = item.pk ? 13 : 12;
-			treeView->AppendItem(folderItemId, indexName, nImage, nImage, data);
+			treeView->AppendItem(folderItemId, getIndexItemText(item), nImage, nImage, data);
 		}
 		if (!list.empty()) {
 			treeView->Expand(folderItemId);
@@ -949,6 +1400,223 @@ void LeftTreeDelegate::loadIndexesForTable(wxTreeCtrl* treeView, const wxTreeIte
 	}
 }
 
+/**
+ * The item has been loaded, it has no loading item.
+ * 
+ * @param treeView
+ * @param itemId
+ * @return false if the item is not ok or it is not loaded yet
+ */
+bool LeftTreeDelegate::isLoadedItem(wxTreeCtrl* treeView, const wxTreeItemId& itemId)
+{
+	if (!itemId.IsOk()) {
+		return false;
+	}
+	wxTreeItemIdValue cookie;
+	auto firstChildId = treeView->GetFirstChild(itemId, cookie);
+	return !firstChildId.IsOk() || treeView->GetItemImage(firstChildId) != 10; // image: 10 - loading
+}
+
+void LeftTreeDelegate::patchDbsForConnection(wxTreeCtrl* treeView, const wxTreeItemId& connectItemId, uint64_t connectId)
+{
+	try {
+		UserDbList list = metadataService->getUserDbs(connectId);
+		patchChildItems<UserDb>(treeView, connectItemId, connectId, list, TreeObjectType::SCHEMA,
+			[](const UserDb& item) { return item.name; },
+			[](const UserDb& item) { return 2; },
+			[this, treeView, connectId](const wxTreeItemId& itemId, const UserDb& item) {
+				appendFoldersForDb(treeView, itemId, connectId, item);
+			});
+	} catch (QRuntimeException& ex) {
+		wxMessageDialog msgbox(view, S("connect-fail").append(",Error:").append(ex.getMsg()), S("error-notice"), wxOK|wxCENTRE|wxICON_ERROR);
+		msgbox.ShowModal();
+		return;
+	}
+}
+
+/**
+ * Patch the loaded folder of the database by the object list.
+ * 
+ * @param treeView
+ * @param folderItemId
+ * @param folderType - TreeObjectType::TABLES_FOLDER/VIEWS_FOLDER/STORE_PROCEDURES_FOLDER/FUNCTIONS_FOLDER/TRIGGERS_FOLDER/EVENTS_FOLDER
+ * @param connectId
+ * @param schema
+ */
+void LeftTreeDelegate::patchFolderForDatabase(wxTreeCtrl* treeView, const wxTreeItemId& folderItemId, const TreeObjectType& folderType, uint64_t connectId, const std::string& schema)
+{
+	auto getName = [](const UserRoutine& item) { return item.name; };
+	try {
+		if (folderType == TreeObjectType::TABLES_FOLDER) {
+			auto list = metadataService->getUserTables(connectId, schema);
+			patchChildItems<UserTable>(treeView, folderItemId, connectId, list, TreeObjectType::TABLE,
+				[](const UserTable& item) { return item.name; },
+				[](const UserTable& item) { return 4; },
+				[this, treeView](const wxTreeItemId& itemId, const UserTable& item) {
+					// lazy load table
+					loadingForItem(treeView, itemId);
+				});
+		} else if (folderType == TreeObjectType::VIEWS_FOLDER) {
+			auto list = metadataService->getUserViews(connectId, schema);
+			patchChildItems<UserView>(treeView, folderItemId, connectId, list, TreeObjectType::VIEW,
+				[](const UserView& item) { return item.name; },
+				[](const UserView& item) { return 5; });
+		} else if (folderType == TreeObjectType::STORE_PROCEDURES_FOLDER) {
+			auto list = metadataService->getUserProcedures(connectId, schema);
+			patchChildItems<UserProcedure>(treeView, folderItemId, connectId, list, TreeObjectType::STORE_PROCEDURE,
+				getName, [](const UserProcedure& item) { return 6; });
+		} else if (folderType == TreeObjectType::FUNCTIONS_FOLDER) {
+			auto list = metadataService->getUserFunctions(connectId, schema);
+			patchChildItems<UserFunction>(treeView, folderItemId, connectId, list, TreeObjectType::FUNCTION,
+				getName, [](const UserFunction& item) { return 7; });
+		} else if (folderType == TreeObjectType::TRIGGERS_FOLDER) {
+			auto list = metadataService->getUserTriggers(connectId, schema);
+			patchChildItems<UserTrigger>(treeView, folderItemId, connectId, list, TreeObjectType::TRIGGER,
+				getName, [](const UserTrigger& item) { return 8; });
+		} else if (folderType == TreeObjectType::EVENTS_FOLDER) {
+			auto list = metadataService->getUserEvents(connectId, schema);
+			patchChildItems<UserEvent>(treeView, folderItemId, connectId, list, TreeObjectType::EVENT,
+				[](const UserEvent& item) { return item.name; },
+				[](const UserEvent& item) { return 9; });
+		}
+	} catch (QRuntimeException& ex) {
+		wxMessageDialog msgbox(view, S("connect-fail").append(",Error:").append(ex.getMsg()), S("error-notice"), wxOK|wxCENTRE|wxICON_ERROR);
+		msgbox.ShowModal();
+		return;
+	}
+}
+
+/**
+ * Patch the columns and indexes folders of the expanded table items.
+ * 
+ * @param treeView
+ * @param tblsFolderItemId
+ * @param connectId
+ * @param schema
+ */
+void LeftTreeDelegate::patchColumnsAndIndexesForTables(wxTreeCtrl* treeView, const wxTreeItemId& tblsFolderItemId, uint64_t connectId, const std::string& schema)
+{
+	try {
+		metadataService->loadTableMetadataOfSchema(connectId, schema);
+		wxTreeItemIdValue cookie;
+		for (auto tableItemId = treeView->GetFirstChild(tblsFolderItemId, cookie); tableItemId.IsOk(); 
+			tableItemId = treeView->GetNextChild(tblsFolderItemId, cookie)) {
+			if (!isLoadedItem(treeView, tableItemId)) {
+				continue;
+			}
+			auto tableData = reinterpret_cast<QTreeItemData<UserTable>*>(treeView->GetItemData(tableItemId));
+			const std::string tableName = tableData->getDataPtr()->name;
+			wxTreeItemIdValue folderCookie;
+			for (auto folderItemId = treeView->GetFirstChild(tableItemId, folderCookie); folderItemId.IsOk();
+				folderItemId = treeView->GetNextChild(tableItemId, folderCookie)) {
+				auto folderData = reinterpret_cast<QTreeItemData<UserTable>*>(treeView->GetItemData(folderItemId));
+				if (folderData->getType() == TreeObjectType::TABLE_COLUMNS_FOLDER) {
+					auto list = metadataService->getColumnsOfUserTable(connectId, schema, tableName);
+					patchChildItems<ColumnInfo>(treeView, folderItemId, connectId, list, TreeObjectType::TABLE_COLUMN,
+						getColumnItemText, [](const ColumnInfo& item) { return 11; });
+				} else if (folderData->getType() == TreeObjectType::TABLE_INDEXES_FOLDER) {
+					auto list = metadataService->getIndexesOfUserTable(connectId, schema, tableName);
+					patchChildItems<IndexInfo>(treeView, folderItemId, connectId, list, TreeObjectType::TABLE_INDEX,
+						getIndexItemText, [](const IndexInfo& item) { return item.pk ? 13 : 12; });
+				}
+			}
+		}
+	} catch (QRuntimeException& ex) {
+		wxMessageDialog msgbox(view, S("connect-fail").append(",Error:").append(ex.getMsg()), S("error-notice"), wxOK | wxCENTRE | wxICON_ERROR);
+		msgbox.ShowModal();
+		return;
+	}
+}
+
+/**
+ * Patch the children of the item by the list, the tree is not rebuilt:
+ * the items that are not in the list are deleted, the new items are inserted in the order of the list,
+ * and the data of the kept items is updated in place (the supplier may point to it), their children are kept.
+ * 
+ * @param treeView
+ * @param parentItemId
+ * @param connectId
+ * @param list - the new objects
+ * @param type - the TreeObjectType of the new items
+ * @param getText - the text of the item, the items are matched by the text
+ * @param getImage - the image of the item
+ * @param afterInserted - called after a new item is inserted, such as the loading item is added
+ */
+template <typename T, typename L>
+void LeftTreeDelegate::patchChildItems(wxTreeCtrl* treeView, const wxTreeItemId& parentItemId, uint64_t connectId, const L& list, TreeObjectType type,
+	const std::function<std::string (const T &)> & getText, const std::function<int (const T &)> & getImage,
+	const std::function<void (const wxTreeItemId &, const T &)> & afterInserted)
+{
+	std::unordered_map<std::string, int> texts;
+	for (auto& item : list) {
+		texts[getText(item)]++;
+	}
+
+	// 1.Delete the items that are not in the list
+	std::unordered_map<std::string, wxTreeItemId> keptItems;
+	std::vector<wxTreeItemId> deletedItems;
+	wxTreeItemIdValue cookie;
+	for (auto childItemId = treeView->GetFirstChild(parentItemId, cookie); childItemId.IsOk(); 
+		childItemId = treeView->GetNextChild(parentItemId, cookie)) {
+		std::string text = treeView->GetItemText(childItemId).ToStdString();
+		if (texts.find(text) != texts.end() && keptItems.find(text) == keptItems.end()) {
+			keptItems[text] = childItemId;
+		} else {
+			deletedItems.push_back(childItemId);
+		}
+	}
+	for (auto& itemId : deletedItems) {
+		treeView->Delete(itemId);
+	}
+
+	// 2.Update the kept items and insert the new items after the previous item
+	wxTreeItemId prevItemId;
+	for (auto& item : list) {
+		auto text = getText(item);
+		int nImage = getImage(item);
+		auto iter = keptItems.find(text);
+		if (iter != keptItems.end()) {
+			auto data = reinterpret_cast<QTreeItemData<T>*>(treeView->GetItemData(iter->second));
+			*data->getDataPtr() = item;
+			if (treeView->GetItemImage(iter->second) != nImage) {
+				treeView->SetItemImage(iter->second, nImage);
+				treeView->SetItemImage(iter->second, nImage, wxTreeItemIcon_Selected);
+			}
+			prevItemId = iter->second;
+			keptItems.erase(iter);
+			continue;
+		}
+		auto data = new QTreeItemData<T>(connectId, new T(item), type);
+		prevItemId = prevItemId.IsOk() ? treeView->InsertItem(parentItemId, prevItemId, text, nImage, nImage, data)
+			: treeView->PrependItem(parentItemId, text, nImage, nImage, data);
+		if (afterInserted) {
+			afterInserted(prevItemId, item);
+		}
+	}
+}
+
+std::string LeftTreeDelegate::getColumnItemText(const ColumnInfo& columnInfo)
+{
+	std::string columnName = columnInfo.name;
+	columnName.append(" [")
+		.append(columnInfo.type)
+		.append(columnInfo.size ? "(" + std::to_string(columnInfo.size) +")" : "")
+		.append(columnInfo.un ? " UNSIGNED" : "")
+		.append(", ")
+		.append(columnInfo.isNullable ? "NULL" : "NOT NULL")
+		.append("]");
+	return columnName;
+}
+
+std::string LeftTreeDelegate::getIndexItemText(const IndexInfo& indexInfo)
+{
+	std::string indexName = indexInfo.name;
+	indexName.append(" (").append(indexInfo.columns).append(")");
+	if (indexInfo.name != "PRIMARY" && indexInfo.un) {
+		indexName.append(", ").append("UNIQUE");
+	}
+	return indexName;
+}
 
 bool LeftTreeDelegate::removeConnectionItem(wxTreeCtrl* treeView, const wxTreeItemId& itemId)
 {
@@ -1428,6 +2096,32 @@ wxTreeItemId LeftTreeDelegate::findFolderItemFromDbItem(wxTreeCtrl* treeView, co
 	return follderItemId;
 }
 
+/**
+ * Find children table item from tables folder item.
+ * 
+ * @param treeView
+ * @param tblsFolderItemId
+ * @param tblName
+ * @return 
+ */
+wxTreeItemId LeftTreeDelegate::findTableItemFromFolderItem(wxTreeCtrl* treeView, const wxTreeItemId& tblsFolderItemId, const std::string& tblName)
+{
+	if (!isLoadedItem(treeView, tblsFolderItemId)) {
+		return wxTreeItemId();
+	}
+	wxTreeItemIdValue cookie;
+	auto tableItemId = treeView->GetFirstChild(tblsFolderItemId, cookie);
+	while (tableItemId.IsOk()) {
+		auto data = reinterpret_cast<QTreeItemData<UserTable>*>(treeView->GetItemData(tableItemId));
+		// found
+		if (data && data->getDataPtr() && data->getDataPtr()->tblName == tblName) {
+			break;
+		}
+		tableItemId = treeView->GetNextSibling(tableItemId);
+	}
+	return tableItemId;
+}
+
 TreeObjectType LeftTreeDelegate::objectTypeToFolderType(const TreeObjectType objectType)
 {
 	auto folderType = TreeObjectType::TABLES_FOLDER;
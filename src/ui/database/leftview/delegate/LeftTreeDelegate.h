@@ -17,7 +17,10 @@
  * @date   2024-11-23
  *********************************************************************/
 #pragma once
+#include <functional>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <wx/treectrl.h>
 #include "ui/common/delegate/QDelegate.h"
 #include "ui/database/supplier/DatabaseSupplier.h"
@@ -25,6 +28,7 @@
 #include "core/service/db/DatabaseService.h"
 #include "core/service/db/MetadataService.h"
 #include "ui/common/data/QTreeItemData.h"
+#include "common/QAliveToken.h"
 
 class LeftTreeDelegate :  public QDelegate<LeftTreeDelegate, DatabaseSupplier>
 {
@@ -35,6 +39,7 @@ public:
 	void loadForLeftTree(wxTreeCtrl * treeView, uint64_t connectId = 0, const std::string & schema = "", bool allowSelect = true);
 	void expendedForLeftTree(wxTreeCtrl * treeView, wxTreeItemId &itemId);
 	void expendedConnectionItem(wxTreeCtrl* treeView, wxTreeItemId& itemId, uint64_t connectId);
+	void collapsedForLeftTree(wxTreeCtrl * treeView, wxTreeItemId &itemId);
 
 	UserConnect* getSelectedConnectItemData(wxTreeCtrl* treeView);
 	UserDb* getSelectedDbItemData(wxTreeCtrl* treeView);
@@ -46,20 +51,44 @@ public:
 
 	bool removeForLeftTree(wxTreeCtrl* treeView);
 	bool duplicateForLeftTree(wxTreeCtrl* treeView);
+	bool exportAsSqlForLeftTree(wxTreeCtrl* treeView);
 
 	// refresh
 	void beforeFreshForLeftTree(wxTreeCtrl * treeView);// before fresh 
 	void refreshConnectItemsForLeftTree(wxTreeCtrl * treeView, uint64_t connectId, const std::string& schema);
+	void refreshConnectionForLeftTree(wxTreeCtrl * treeView, uint64_t connectId);
 	void refreshDbItemsForLeftTree(wxTreeCtrl * treeView, uint64_t connectId, const std::string& schema, const QTreeItemData<std::string> & findSelData);
+	void refreshChangedItemsForLeftTree(wxTreeCtrl * treeView, uint64_t connectId, const std::string& schema, 
+		std::function<void (wxTreeCtrl *)> afterRefreshed = nullptr);
+
+	// snapshot
+	void reconcileSnapshotForLeftTree(wxTreeCtrl * treeView, uint64_t connectId);
+	void reloadChangedListsForLeftTree(wxTreeCtrl * treeView, uint64_t connectId, const std::vector<MetadataListKey> & changedLists);
 
 	
 private:
+	// the cached object list => the folder type of the database item
+	const static std::unordered_map<std::string, TreeObjectType> listFolderTypeMap;
+
+	// The object list of the item that is loaded in the background
+	typedef struct _TreeItemLoad {
+		uint64_t loadId = 0;
+		std::shared_ptr<bool> canceled; // collapsed or the delegate is destroyed
+	} TreeItemLoad;
+	// the path of the loading item (see getLoadPath(...)) => the load, used in the ui thread only
+	std::unordered_map<std::string, TreeItemLoad> pendingLoads;
+	// "connectId\nschema\n" of the load errors that are being shown, the other errors of the same scope are not shown
+	std::unordered_set<std::string> errorScopes;
+	// the callbacks of MetadataService are dropped after the delegate is destroyed
+	QAliveToken aliveToken;
+
 	ConnectService * connectService = ConnectService::getInstance();
 	DatabaseService * databaseService = DatabaseService::getInstance();
 	MetadataService * metadataService = MetadataService::getInstance();
 
 	// For Connection
 	void loadDbsForConnection(wxTreeCtrl * treeView, const wxTreeItemId & connectItemId, uint64_t connectId, const std::string & schema = "");
+	void appendFoldersForDb(wxTreeCtrl * treeView, const wxTreeItemId & dbItemId, uint64_t connectId, const UserDb & userDb);
 	// For Database
 	void loadTablesForDatabase(wxTreeCtrl * treeView, const wxTreeItemId & folderItemId, uint64_t connectId, const std::string & schema);
 	void loadViewsForDatabase(wxTreeCtrl * treeView, const wxTreeItemId & folderItemId, uint64_t connectId, const std::string & schema);
@@ -72,12 +101,36 @@ private:
 	void loadColomnsForTable(wxTreeCtrl* treeView, const wxTreeItemId& folderItemId, uint64_t connectId, const std::string& schema, const std::string tableName);
 	void loadIndexesForTable(wxTreeCtrl* treeView, const wxTreeItemId& folderItemId, uint64_t connectId, const std::string& schema, const std::string tableName);
 
+	void loadFolderForDatabase(wxTreeCtrl * treeView, const wxTreeItemId & folderItemId, const TreeObjectType & folderType, uint64_t connectId, const std::string & schema);
+
 	wxTreeItemId expendedDbItem(wxTreeCtrl* treeView, wxTreeItemId& itemId, const TreeObjectType &findFolderData);
 	void expendedTableItem(wxTreeCtrl* treeView, wxTreeItemId& itemId, uint64_t connectId, UserTable * userTable);
 
+	// load in the background, the loading item is replaced when the list arrives
+	void loadFolderAsync(wxTreeCtrl * treeView, uint64_t connectId, const std::string & schema, const TreeObjectType & folderType);
+	void loadTableAsync(wxTreeCtrl * treeView, uint64_t connectId, const std::string & schema, const std::string & tblName);
+	void loadItemAsync(wxTreeCtrl * treeView, const std::string & path, uint64_t connectId, const std::string & schema, const std::string & object,
+		std::function<void (wxTreeCtrl *)> afterLoaded);
+	void cancelLoads(const std::string & pathPrefix);
+	static std::string getLoadPath(uint64_t connectId, const std::string & schema, const TreeObjectType & type, const std::string & tblName = "");
+
 	// loading for lazy load
 	void loadingForItem(wxTreeCtrl * treeView, const wxTreeItemId & itemId);
 	void loadingForFolder(wxTreeCtrl* treeView, const wxTreeItemId& folderItemId, uint64_t connectId);
+	bool isLoadedItem(wxTreeCtrl * treeView, const wxTreeItemId & itemId);
+
+	// patch the loaded items by the changed lists, the unchanged items and their children are kept
+	void patchChangedItemsForLeftTree(wxTreeCtrl * treeView, uint64_t connectId, const std::string& schema, const std::vector<std::string> & changedLists);
+	void patchDbsForConnection(wxTreeCtrl * treeView, const wxTreeItemId & connectItemId, uint64_t connectId);
+	void patchFolderForDatabase(wxTreeCtrl * treeView, const wxTreeItemId & folderItemId, const TreeObjectType & folderType, uint64_t connectId, const std::string & schema);
+	void patchColumnsAndIndexesForTables(wxTreeCtrl * treeView, const wxTreeItemId & tblsFolderItemId, uint64_t connectId, const std::string & schema);
+	template <typename T, typename L>
+	void patchChildItems(wxTreeCtrl * treeView, const wxTreeItemId & parentItemId, uint64_t connectId, const L & list, TreeObjectType type,
+		const std::function<std::string (const T &)> & getText, const std::function<int (const T &)> & getImage,
+		const std::function<void (const wxTreeItemId &, const T &)> & afterInserted = nullptr);
+
+	static std::string getColumnItemText(const ColumnInfo & columnInfo);
+	static std::string getIndexItemText(const IndexInfo & indexInfo);
 
 	// remove item
 	bool removeConnectionItem(wxTreeCtrl * treeView, const wxTreeItemId & itemId);
@@ -104,10 +157,13 @@ private:
 	bool duplicateTableIndexItem(wxTreeCtrl* treeView, const wxTreeItemId& itemId);
 	bool duplicateObjectItem(wxTreeCtrl* treeView, const wxTreeItemId& itemId, DuplicateObjectType type);
 
+	bool isSystemSchema(const std::string & schema);
+
 	// Found item
 	wxTreeItemId findConnectItemFromRootItem(wxTreeCtrl* treeView, uint64_t connectId);
 	wxTreeItemId findDbItemFromConnectionItem(wxTreeCtrl* treeView, const wxTreeItemId& connectItemId, const std::string & schema);
 	wxTreeItemId findFolderItemFromDbItem(wxTreeCtrl* treeView, const wxTreeItemId& dbItemId, const TreeObjectType folderType);
+	wxTreeItemId findTableItemFromFolderItem(wxTreeCtrl* treeView, const wxTreeItemId& tblsFolderItemId, const std::string & tblName);
 
 	TreeObjectType objectTypeToFolderType(const TreeObjectType objectType);
 
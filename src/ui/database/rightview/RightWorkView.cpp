@@ -50,6 +50,7 @@
 
 BEGIN_EVENT_TABLE(RightWorkView, wxPanel)
 	EVT_BUTTON(Config::DATABASE_EXEC_SQL_BUTTON_ID, OnClickExecSqlButton)
+	EVT_BUTTON(Config::DATABASE_CANCEL_SQL_BUTTON_ID, OnClickCancelSqlButton)
 
 	// HANDLE MESSAGE 
 	EVT_NOTITY_MESSAGE_HANDLE(Config::MSG_OPEN_DATABASE_ID, OnHandleOpenDatabase)
@@ -148,6 +149,19 @@ void RightWorkView::createExecButtons()
 	explainSqlButton->SetBitmapFocus(pressedBitmap);
 	explainSqlButton->SetToolTip(SNT("explain-select-sql"));
 	buttonsHoriLayout->Add(explainSqlButton, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
+
+	buttonsHoriLayout->AddSpacer(10);
+
+	// kill the running statement of the active query page
+	wxString listImgdir = ResourceUtil::getProductImagesDir() + "/database/list/button/";
+	normalBitmap = wxBitmap(listImgdir + "cancel-button-normal.png", wxBITMAP_TYPE_PNG);
+	pressedBitmap = wxBitmap(listImgdir + "cancel-button-pressed.png", wxBITMAP_TYPE_PNG);
+	cancelSqlButton = new wxBitmapButton(this, Config::DATABASE_CANCEL_SQL_BUTTON_ID, wxBitmapBundle(normalBitmap), wxDefaultPosition, {22, 22}, wxCLIP_CHILDREN | wxNO_BORDER);
+	cancelSqlButton->SetBackgroundColour(bkgColor);
+	cancelSqlButton->SetBitmapPressed(pressedBitmap);
+	cancelSqlButton->SetBitmapFocus(pressedBitmap);
+	cancelSqlButton->SetToolTip(SNT("cancel-sql"));
+	buttonsHoriLayout->Add(cancelSqlButton, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
 }
 
 void RightWorkView::createQueryButtons()
@@ -236,6 +250,11 @@ void RightWorkView::OnClickExecSqlButton(wxCommandEvent& event)
 	delegate->execSelectedSql();
 }
 
+void RightWorkView::OnClickCancelSqlButton(wxCommandEvent& event)
+{
+	delegate->cancelSql();
+}
+
 void RightWorkView::OnHandleOpenDatabase(MsgDispatcherEvent& event)
 {
 	delegate->openObjectsPage(TreeObjectType::SCHEMA);
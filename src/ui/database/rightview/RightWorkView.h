@@ -65,6 +65,7 @@ private:
 	wxBitmapButton * execSqlButton;
 	wxBitmapButton * execAllButton;
 	wxBitmapButton * explainSqlButton;
+	wxBitmapButton * cancelSqlButton;
 
 	// query, history and objects buttons
 	wxBitmapButton * queryButton;
@@ -95,6 +96,7 @@ private:
 
 	// tool bar button
 	void OnClickExecSqlButton(wxCommandEvent& event);
+	void OnClickCancelSqlButton(wxCommandEvent& event);
 
 	// handle notify message event
 	void OnHandleOpenDatabase(MsgDispatcherEvent& event);
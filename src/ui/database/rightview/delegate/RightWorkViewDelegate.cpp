@@ -67,6 +67,21 @@ void RightWorkViewDelegate::execSelectedSql()
 	}
 }
 
+void RightWorkViewDelegate::cancelSql()
+{
+	int nPage = tabView->GetSelection();
+	if (nPage < 0) {
+		return;
+	}
+
+	wxWindow * activeWindow = tabView->GetPage(nPage);
+	for (auto pagePtr : *queryPagePtrs) {
+		if (pagePtr && activeWindow == pagePtr) {
+			pagePtr->cancelExec();
+		}
+	}
+}
+
 void RightWorkViewDelegate::openObjectsPage(TreeObjectType treeObjectType)
 {
 	// find the objects page in the tabView
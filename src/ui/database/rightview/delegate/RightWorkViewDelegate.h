@@ -21,6 +21,7 @@ public:
 
 	// execute sql statement
 	void execSelectedSql();
+	void cancelSql();
 	void execAllSql();
 	void explainSelectedSql();
 private:
@@ -18,10 +18,13 @@
  *********************************************************************/
 
 #include "QueryPage.h"
+#include <wx/weakref.h>
 #include "common/Config.h"
 #include "core/common/Lang.h"
 #include "utils/SqlUtil.h"
 #include "common/AppContext.h"
+#include "core/common/exception/QSqlExecuteException.h"
+#include "core/service/system/SettingService.h"
 
 QueryPage::QueryPage(PageOperateType operateType, const std::string& content, const std::string& tplPath)
 	: QTabPage<EmptySupplier>()
@@ -32,11 +35,12 @@ QueryPage::QueryPage(PageOperateType operateType, const std::string& content, co
 
 QueryPage::~QueryPage()
 {
+	// ExecutorService is shared by all the query pages, only close the session of this page
+	executorService->closeSession(mysupplier->getRuntimeUserConnectId(), mysupplier->getRuntimeSessionKey());
+	executorService = nullptr;
+
 	delete mysupplier;
 	mysupplier = nullptr;
-
-	ExecutorService::destroyInstance();
-	executorService = nullptr;
 }
 
 void QueryPage::setup(PageOperateType operateType, const std::string& content, const std::string& tplPath)
@@ -52,6 +56,8 @@ void QueryPage::setup(PageOperateType operateType, const std::string& content, c
 	} else {
 		supplier->setRuntimeTblName("");
 	}
+	// the table data of the runtime table is read by the keyset pagination, see ResultListPageDelegate
+	mysupplier->setRuntimeTblName(supplier->getRuntimeTblName());
 	
 	this->tplPath = tplPath;
 	this->content = content;
@@ -80,39 +86,42 @@ void QueryPage::execAndShow(bool select)
 		queryEditor->SetFocus();
 		return;
 	}
+	if (executorService->isSessionBusy(mysupplier->getRuntimeSessionKey())) {
+		QAnimateBox::warning(S("sql-is-executing"));
+		return;
+	}
 	resultTabView->clearMessage();
+	uint64_t connectId = mysupplier->getRuntimeUserConnectId();
+	std::string schema = mysupplier->getRuntimeSchema();
+	uint64_t sessionKey = mysupplier->getRuntimeSessionKey();
+	// the callbacks are copied in the worker thread, they capture the alive flags instead of wxWeakRef
+	QAliveFlag alive = aliveToken.flag();
 	if (mysupplier->getOperateType() == QUERY_DATA || mysupplier->getOperateType() == TABLE_DATA) {
 		mysupplier->splitToSqlVector(sqls);
 		std::vector<std::string>& sqlVector = mysupplier->sqlVector;
 		int n = static_cast<int>(sqlVector.size());
 		int nSelectSqlCount = 0, nNotSelectSqlCount = 0;
 
-		// BEGIN a save point 
-		std::string spSql;
-		bool hasBeginTransaction = StringUtil::startWith(sqls, "BEGIN;", true);
-		if (!hasBeginTransaction) {
-			spSql = "BEGIN;";
-			executorService->executeSql(
-				mysupplier->getRuntimeUserConnectId(), 
-				mysupplier->getRuntimeSchema(), 
-				spSql);
-		}
-
-		bool hasError = false;
+		// The statements run in the worker thread one by one, the rows of queries are streamed to the result list pages,
+		// the consecutive non-query statements are pipelined in one round trip unless the setting query-pipeline is "false"
+		bool pipelined = SettingService::getInstance()->getSysInit("query-pipeline") != "false";
+		// the session status deltas of the statements are captured if the setting query-session-status is "true", see the editor toolbar
+		bool captureStatus = SettingService::getInstance()->getSysInit("query-session-status") == "true";
+		ExecuteStatementList statements;
+		std::vector<std::pair<ResultListPage *, QAliveFlag>> listPages(n);
 		for (int i = 0; i < n; i++) {
 			auto sql = sqlVector.at(i);
 			if (SqlUtil::isSelectSql(sql) || SqlUtil::isPragmaStmt(sql, true)) {
-				resultTabView->addResultToListPage(sql, nSelectSqlCount + 1);
+				ResultListPage * listPage = resultTabView->addResultToListPage(sql, nSelectSqlCount + 1);
+				listPages[i] = { listPage, listPage->getAliveFlag() };
+				statements.push_back({ listPage->prepareListView(), true, listPage->getFetchSize(), false, captureStatus });
 				nSelectSqlCount++;
 			} else {
+				// CALL returns more than one result, it is executed alone
+				std::string trimSql = sql;
+				StringUtil::trim(trimSql);
+				statements.push_back({ sql, false, 0, pipelined && !StringUtil::startWith(trimSql, "CALL", true), captureStatus });
 				nNotSelectSqlCount++;
-				bool ret = resultTabView->execSqlToInfoPage(sql);
-				if (!ret) {
-					hasError = true;
-					spSql = "ROLLBACK;"; // ROLLBACK
-					executorService->executeSql(mysupplier->getRuntimeUserConnectId(), mysupplier->getRuntimeSchema(), spSql);
-					break;
-				}
 			}
 		}
 
@@ -124,33 +133,91 @@ void QueryPage::execAndShow(bool select)
 		else if (nNotSelectSqlCount) {
 			resultTabView->activeResultInfoPage();
 		}
-		if (!hasError) {
-			bool hasCommitTransaction = StringUtil::endWith(sqls, "COMMIT;", true);
-			if (!hasCommitTransaction) {
-				spSql = "COMMIT;"; // COMMIT TRANSACTION
-				executorService->executeSql(mysupplier->getRuntimeUserConnectId(), mysupplier->getRuntimeSchema(), spSql);
-			}
 
-			if (!nSelectSqlCount || nNotSelectSqlCount) {
+		// BEGIN a save point, ROLLBACK if a statement fails or COMMIT all
+		bool inTransaction = !StringUtil::startWith(sqls, "BEGIN;", true) 
+			&& !StringUtil::endWith(sqls, "COMMIT;", true);
+		bool showSuccess = !nSelectSqlCount || nNotSelectSqlCount;
+		executorService->executeSqlsAsync(connectId, schema, statements, sessionKey, inTransaction, 
+			[this, alive, listPages](ExecuteResult & result) {
+			if (!*alive) {
+				return;
+			}
+			if (result.isQuery) {
+				auto & listPage = listPages[result.index];
+				if (listPage.first && *listPage.second) {
+					listPage.first->loadListView(result);
+				}
+				return;
+			}
+			resultTabView->addResultToInfoPage(result);
+			if (result.status == EXECUTE_FAILED) {
+				QAnimateBox::error(QSqlExecuteException(result.code, result.msg, result.sql));
+			}
+		}, [alive, showSuccess](bool hasError) {
+			if (*alive && !hasError && showSuccess) {
 				QAnimateBox::success(S("execute-sql-success"));
 			}
-		}
+		}, [alive, listPages](ExecuteRowBatch & batch) {
+			// the rows of the query are streamed to its result list page
+			auto & listPage = listPages[batch.index];
+			if (*alive && listPage.first && *listPage.second) {
+				listPage.first->loadRuntimeBatch(batch);
+			}
+		});
 	}
 	else {
-		bool ret = resultTabView->execSqlToInfoPage(sqls);
-		if (ret) {
-			QAnimateBox::success(S("execute-sql-success"));
-			if (mysupplier->getOperateType() != QUERY_DATA && mysupplier->getOperateType() != TABLE_DATA) {
-				//Send message to refresh database when creating a table or altering a table , wParam = NULL, lParam=NULL 
-				AppContext::getInstance()->dispatch(Config::MSG_LEFTVIEW_REFRESH_DATABASE_ID);
+		executorService->executeSqlAsync(connectId, schema, sqls, sessionKey, [this, alive](ExecuteResult & result) {
+			if (!*alive) {
+				return;
 			}
-		}
+			resultTabView->addResultToInfoPage(result);
+			if (result.status != EXECUTE_SUCCESS) {
+				QAnimateBox::error(QSqlExecuteException(result.code, result.msg, result.sql));
+				return;
+			}
+			QAnimateBox::success(S("execute-sql-success"));
+			//Send message to refresh database when creating a table or altering a table , wParam = NULL, lParam=NULL 
+			AppContext::getInstance()->dispatch(Config::MSG_LEFTVIEW_REFRESH_DATABASE_ID);
+		});
 	}
 }
 
 void QueryPage::init()
 {
 	mysupplier = new QueryPageSupplier();
+	// the pipelined statements and the status probes of the page are sent in one packet
+	mysupplier->setRuntimeSessionKey(executorService->openSession(true));
+	// the default timeout of the query pages, setting key: query-timeout (seconds), it is changed per page in the editor toolbar
+	std::string timeout = SettingService::getInstance()->getSysInit("query-timeout");
+	if (StringUtil::isDigit(timeout) && timeout.size() < 7) {
+		setQueryTimeout(static_cast<uint32_t>(std::stoul(timeout)));
+	}
+}
+
+/**
+ * Cancel the pending statements and kill the running statement of this page, 
+ * the rows that have been fetched are kept.
+ */
+void QueryPage::cancelExec()
+{
+	if (!executorService->isSessionBusy(mysupplier->getRuntimeSessionKey())) {
+		return;
+	}
+	executorService->cancelQuery(mysupplier->getRuntimeUserConnectId(), mysupplier->getRuntimeSessionKey());
+	QAnimateBox::warning(S("sql-is-canceled"));
+}
+
+/**
+ * The timeout is applied as max_execution_time of the mysql session of this page before the next execution, 
+ * the server interrupts the SELECT statements that run longer than it.
+ * 
+ * @param seconds - 0 - no timeout
+ */
+void QueryPage::setQueryTimeout(uint32_t seconds)
+{
+	mysupplier->setRuntimeTimeout(seconds);
+	executorService->setSessionTimeout(mysupplier->getRuntimeSessionKey(), seconds);
 }
 
 void QueryPage::createControls()
@@ -173,6 +240,8 @@ void QueryPage::createQueryEditor()
 {
 	queryEditor = new QueryPageEditor(mysupplier);
 	queryEditor->Create(splitter, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxNO_BORDER | wxCLIP_CHILDREN);
+	// the timeout edit is in the toolbar of the editor, the timeout belongs to the session of this page
+	queryEditor->Bind(wxEVT_TEXT, &QueryPage::OnChangeTimeoutEdit, this, Config::QUERY_PAGE_TIMEOUT_EDIT_ID);
 }
 
 void QueryPage::createResultTabView()
@@ -180,3 +249,21 @@ void QueryPage::createResultTabView()
 	resultTabView = new ResultTabView(mysupplier);
 	resultTabView->Create(splitter, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxNO_BORDER | wxCLIP_CHILDREN);
 }
+
+/**
+ * The timeout edit of the editor toolbar is changed, an invalid value is ignored until it is corrected.
+ * 
+ * @param event
+ */
+void QueryPage::OnChangeTimeoutEdit(wxCommandEvent& event)
+{
+	std::string timeout = event.GetString().ToStdString();
+	if (timeout.empty()) {
+		setQueryTimeout(0);
+		return;
+	}
+	if (!StringUtil::isDigit(timeout) || timeout.size() >= 7) {
+		return;
+	}
+	setQueryTimeout(static_cast<uint32_t>(std::stoul(timeout)));
+}
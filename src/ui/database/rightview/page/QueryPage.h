@@ -25,6 +25,7 @@
 #include "ui/database/rightview/page/editor/QueryPageEditor.h"
 #include "ui/database/rightview/page/result/ResultTabView.h"
 #include "core/service/db/ExecutorService.h"
+#include "common/QAliveToken.h"
 
 class QueryPage : public QTabPage<EmptySupplier>
 {
@@ -34,6 +35,10 @@ public:
 	void setup(PageOperateType operateType, const std::string & content = std::string(), const std::string & tplPath = std::string());
 
 	void execAndShow(bool select = false);
+	// cancel the executing statements of this page
+	void cancelExec();
+	// the timeout of the statements of this page, seconds, 0 - no timeout
+	void setQueryTimeout(uint32_t seconds);
 private:
 	std::string viewName;
 	std::string tplPath;
@@ -45,6 +50,7 @@ private:
 	QueryPageEditor* queryEditor;
 	ResultTabView* resultTabView;
 	wxSplitterWindow * splitter;
+	QAliveToken aliveToken;
 
 	ExecutorService* executorService = ExecutorService::getInstance();
 	virtual void init();
@@ -52,5 +58,7 @@ private:
 	void createSplitter();
 	void createQueryEditor();
 	void createResultTabView();
+
+	void OnChangeTimeoutEdit(wxCommandEvent& event);
 };
 
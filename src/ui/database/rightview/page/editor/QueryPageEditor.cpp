@@ -19,6 +19,8 @@
 #include "QueryPageEditor.h"
 #include "common/Config.h"
 #include "core/common/Lang.h"
+#include "core/service/system/SettingService.h"
+#include "utils/StringUtil.h"
 
 BEGIN_EVENT_TABLE(QueryPageEditor, wxPanel)
 	EVT_STC_ZOOM(Config::DATABASE_QUERY_EDITOR_ID, OnStcZoom) //ŴС
@@ -32,6 +34,8 @@ BEGIN_EVENT_TABLE(QueryPageEditor, wxPanel)
 	EVT_STC_AUTOCOMP_SELECTION(Config::DATABASE_QUERY_EDITOR_ID, OnAutoCSelection) // ʾѡ
 	EVT_COMBOBOX(Config::QUERY_PAGE_CONNECT_COMBOBOX_ID, OnSelChangeConnectCombobox)
 	EVT_COMBOBOX(Config::QUERY_PAGE_DATABASE_COMBOBOX_ID, OnSelChangeDatabaseCombobox)
+	EVT_TEXT(Config::QUERY_PAGE_FETCH_SIZE_EDIT_ID, OnChangeFetchSizeEdit)
+	EVT_CHECKBOX(Config::QUERY_PAGE_SESSION_STATUS_CHECKBOX_ID, OnClickSessionStatusCheckBox)
 END_EVENT_TABLE()
 QueryPageEditor::QueryPageEditor(QueryPageSupplier* queryPageSupplier) : QPanel<DatabaseSupplier>()
 {
@@ -96,6 +100,30 @@ void QueryPageEditor::createToolbarInputs()
 	databaseComboBox = new wxBitmapComboBox(this, Config::QUERY_PAGE_DATABASE_COMBOBOX_ID, wxEmptyString, wxDefaultPosition,
 		{ 180, -1 }, wxArrayString(), wxNO_BORDER | wxCLIP_CHILDREN | wxCB_READONLY);
 	toolbarHoriLayout->Add(databaseComboBox, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
+
+	toolbarHoriLayout->AddSpacer(10);
+	timeoutLabel = new wxStaticText(this, wxID_ANY, S("query-timeout").append(":"), wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxCLIP_CHILDREN | wxCLIP_SIBLINGS | wxNO_BORDER);
+	timeoutLabel->SetForegroundColour(textColor);
+	toolbarHoriLayout->Add(timeoutLabel, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
+	toolbarHoriLayout->AddSpacer(5);
+	timeoutEdit = new wxTextCtrl(this, Config::QUERY_PAGE_TIMEOUT_EDIT_ID, "0", wxDefaultPosition, { 48, 20 }, wxCLIP_CHILDREN | wxCLIP_SIBLINGS | wxNO_BORDER);
+	timeoutEdit->SetToolTip(S("query-timeout-tips"));
+	toolbarHoriLayout->Add(timeoutEdit, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
+
+	toolbarHoriLayout->AddSpacer(10);
+	fetchSizeLabel = new wxStaticText(this, wxID_ANY, S("fetch-size").append(":"), wxDefaultPosition, wxDefaultSize, wxALIGN_RIGHT | wxCLIP_CHILDREN | wxCLIP_SIBLINGS | wxNO_BORDER);
+	fetchSizeLabel->SetForegroundColour(textColor);
+	toolbarHoriLayout->Add(fetchSizeLabel, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
+	toolbarHoriLayout->AddSpacer(5);
+	fetchSizeEdit = new wxTextCtrl(this, Config::QUERY_PAGE_FETCH_SIZE_EDIT_ID, "1000", wxDefaultPosition, { 60, 20 }, wxCLIP_CHILDREN | wxCLIP_SIBLINGS | wxNO_BORDER);
+	fetchSizeEdit->SetToolTip(S("fetch-size-tips"));
+	toolbarHoriLayout->Add(fetchSizeEdit, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
+
+	toolbarHoriLayout->AddSpacer(10);
+	sessionStatusCheckBox = new wxCheckBox(this, Config::QUERY_PAGE_SESSION_STATUS_CHECKBOX_ID, S("session-status"), wxDefaultPosition, { -1, 22 }, wxCLIP_CHILDREN | wxCLIP_SIBLINGS | wxNO_BORDER);
+	sessionStatusCheckBox->SetForegroundColour(textColor);
+	sessionStatusCheckBox->SetToolTip(S("session-status-tips"));
+	toolbarHoriLayout->Add(sessionStatusCheckBox, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
 }
 
 void QueryPageEditor::createEditor()
@@ -112,6 +140,11 @@ void QueryPageEditor::loadControls()
 {
 	delegate->loadForConnectComboBox(connectComboBox, mysupplier->getRuntimeUserConnectId());
 	delegate->loadForSchemaComboBox(databaseComboBox, mysupplier->getRuntimeUserConnectId());
+	// ChangeValue: no wxEVT_TEXT for the initial value
+	timeoutEdit->ChangeValue(std::to_string(mysupplier->getRuntimeTimeout()));
+	std::string fetchSize = SettingService::getInstance()->getSysInit("query-fetch-size");
+	fetchSizeEdit->ChangeValue(fetchSize.empty() ? "1000" : fetchSize);
+	sessionStatusCheckBox->SetValue(SettingService::getInstance()->getSysInit("query-session-status") == "true");
 }
 
 void QueryPageEditor::OnStcZoom(wxStyledTextEvent& event)
@@ -217,3 +250,29 @@ void QueryPageEditor::doLoadRuntimeDbAndTblName()
 	mysupplier->setRuntimeSchema(dbData->getDataPtr()->name);
 	mysupplier->setRuntimeTblName("");
 }
+
+/**
+ * The fetch size edit is changed, the rows count of one batch of the result pages in all query pages,
+ * an invalid value is not saved, see ResultListPageDelegate::getFetchSize().
+ *
+ * @param event
+ */
+void QueryPageEditor::OnChangeFetchSizeEdit(wxCommandEvent& event)
+{
+	std::string fetchSize = event.GetString().ToStdString();
+	if (!StringUtil::isDigit(fetchSize) || fetchSize.size() > 7 || std::stoi(fetchSize) <= 0) {
+		return;
+	}
+	SettingService::getInstance()->setSysInit("query-fetch-size", fetchSize);
+}
+
+/**
+ * The session status deltas of the statements are captured in all query pages if it is checked,
+ * see QueryPage::execAndShow(...) and ResultListPage::loadListView().
+ *
+ * @param event
+ */
+void QueryPageEditor::OnClickSessionStatusCheckBox(wxCommandEvent& event)
+{
+	SettingService::getInstance()->setSysInit("query-session-status", sessionStatusCheckBox->GetValue() ? "true" : "false");
+}
@@ -18,6 +18,7 @@
  *********************************************************************/
 #pragma once
 #include <wx/bmpcbox.h>
+#include <wx/checkbox.h>
 #include "ui/common/panel/QPanel.h"
 #include "ui/common/editor/QSqlEditor.h"
 #include "ui/database/supplier/DatabaseSupplier.h"
@@ -39,6 +40,11 @@ private:
 	//toolbar controls
 	wxBitmapComboBox*	connectComboBox;
 	wxBitmapComboBox*	databaseComboBox;
+	wxStaticText*		timeoutLabel;
+	wxTextCtrl*			timeoutEdit; // the timeout of this page, handled by QueryPage
+	wxStaticText*		fetchSizeLabel;
+	wxTextCtrl*			fetchSizeEdit; // setting query-fetch-size of all query pages
+	wxCheckBox*			sessionStatusCheckBox; // setting query-session-status of all query pages
 
 	QSqlEditor* editor;
 
@@ -65,6 +71,8 @@ private:
 	// combobox changed events
 	void OnSelChangeConnectCombobox(wxCommandEvent& event);
 	void OnSelChangeDatabaseCombobox(wxCommandEvent& event);
+	void OnChangeFetchSizeEdit(wxCommandEvent& event);
+	void OnClickSessionStatusCheckBox(wxCommandEvent& event);
 
 	void doLoadRuntimeDbAndTblName();
 };
@@ -57,15 +57,16 @@ std::vector<std::string> QueryPageEditorDelegate::getTags(const std::string & li
 	return selTags;
 }
 
-std::vector<std::string>& QueryPageEditorDelegate::getCacheUserTableStrings(uint64_t connectId, const std::string & schema)
+/**
+ * The table names are cached by MetadataService, it is shared by all pages and removed after the DDL.
+ * 
+ * @param connectId
+ * @param schema
+ * @return 
+ */
+std::vector<std::string> QueryPageEditorDelegate::getCacheUserTableStrings(uint64_t connectId, const std::string & schema)
 {
-	auto & tblStrs = mysupplier->getCacheUserTableStrings(connectId, schema);
-	if (tblStrs.empty()) {
-		// Cache to mysupplier
-		tblStrs = metadataService->getUserTableStrings(connectId, schema);
-		// mysupplier->setCacheUserTableStrings(userDbId, tblStrs);
-	}
-	return tblStrs;
+	return metadataService->getUserTableStrings(connectId, schema);
 }
 
 
@@ -225,12 +226,9 @@ std::vector<std::string> QueryPageEditorDelegate::getUpdateTags(const std::strin
 	return selTags;
 }
 
-Columns& QueryPageEditorDelegate::getCacheTableColumns(uint64_t connectId, const std::string& schema , const std::string& tblName)
+Columns QueryPageEditorDelegate::getCacheTableColumns(uint64_t connectId, const std::string& schema , const std::string& tblName)
 {
-	auto & columns = mysupplier->getCacheTableColumns(connectId, schema, tblName);
-	if (columns.empty()) {
-		columns = metadataService->getUserColumnStrings(connectId, schema, tblName);
-		// mysupplier->setCacheTableColumns(userDbId, tblName, tags);
-	}
-	return columns;
+	// the columns of all tables in the schema are cached by the first completion
+	metadataService->loadTableMetadataOfSchema(connectId, schema);
+	return metadataService->getUserColumnStrings(connectId, schema, tblName);
 }
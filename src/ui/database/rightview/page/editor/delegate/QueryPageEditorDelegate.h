@@ -28,7 +28,7 @@ public:
 	QueryPageEditorDelegate(wxWindow * editor, QueryPageSupplier * supplier);
 
 	virtual std::vector<std::string> getTags(const std::string& line, const std::string& preline, const std::string& word, size_t curPosInLine);
-	virtual std::vector<std::string>& getCacheUserTableStrings(uint64_t connectId, const std::string & schema);
+	virtual std::vector<std::string> getCacheUserTableStrings(uint64_t connectId, const std::string & schema);
 	
 private:
 	QueryPageSupplier* mysupplier;
@@ -40,6 +40,6 @@ private:
 	std::vector<std::string> getSelectTags(const std::string& upline, const std::string& upPreline, const std::string& upword, size_t curPosInLine);
 
 	std::vector<std::string> getUpdateTags(const std::string& upline, const std::string& upPreline, const std::string& upword, size_t curPosInLine);
-	Columns& getCacheTableColumns(uint64_t connectId, const std::string & schema, const std::string& tblName);
+	Columns getCacheTableColumns(uint64_t connectId, const std::string & schema, const std::string& tblName);
 };
 
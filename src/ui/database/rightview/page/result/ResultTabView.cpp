@@ -22,6 +22,8 @@
 #include "ui/common/notebook/QAuiDefaultTabArt.h"
 #include "ui/database/rightview/common/QTabPage.h"
 #include "core/common/Lang.h"
+#include "common/AppContext.h"
+#include "utils/PerformUtil.h"
 
 ResultTabView::ResultTabView(QueryPageSupplier * supplier) : QPanel(), imageList(16, 16, true, 1)
 {
@@ -34,6 +36,13 @@ void ResultTabView::clearMessage()
 	// to do...
 }
 
+/**
+ * Create or reuse the result list page for the query statement, the caller loads it by ResultListPage::loadListView(...).
+ * 
+ * @param sql - query statement
+ * @param tabNo - begin with 1
+ * @return 
+ */
 ResultListPage * ResultTabView::addResultToListPage(const std::string& sql, int tabNo)
 {
 	ResultListPage * resultListPagePtr = nullptr;
@@ -41,7 +50,6 @@ ResultListPage * ResultTabView::addResultToListPage(const std::string& sql, int
 	if (tabNo-1 < n) {
 		resultListPagePtr = resultListPagePtrs.at(tabNo -1);
 		resultListPagePtr->setup(mysupplier, sql);
-		resultListPagePtr->loadListView();
 	} else {
 		resultListPagePtr = new ResultListPage(mysupplier, sql);
 		resultListPagePtr->Create(this, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxCLIP_CHILDREN | wxNO_BORDER );
@@ -63,6 +71,28 @@ bool ResultTabView::execSqlToInfoPage(const std::string& sql)
 	return false;
 }
 
+/**
+ * Send the execution result of the non-query statement to the subscribers, such as the sql log.
+ * 
+ * @param result - the result of ExecutorService async execution
+ */
+void ResultTabView::addResultToInfoPage(ExecuteResult & result)
+{
+	ResultInfo resultInfo;
+	resultInfo.connectId = result.connectId;
+	resultInfo.schema = result.schema;
+	resultInfo.sql = result.sql;
+	resultInfo.effectRows = static_cast<int>(result.effectRows);
+	resultInfo.code = std::atoi(result.code.c_str());
+	resultInfo.msg = result.msg;
+	// the pipelined statements share the trace, the execute span is the time of the round trip
+	resultInfo.execTime = result.trace ? PerformUtil::elapsedMs(result.trace->getPerfTime(QExecTrace::EXECUTE)) : "0ms";
+	resultInfo.transferTime = "0ms";
+	resultInfo.totalTime = resultInfo.execTime;
+	resultInfo.statusDeltas = result.statusDeltas;
+	AppContext::getInstance()->dispatch(Config::MSG_EXEC_SQL_RESULT_MESSAGE_ID, NULL, (uint64_t)&resultInfo);
+}
+
 void ResultTabView::removeResultListPageFrom(int nQueryPage)
 {
 
@@ -31,6 +31,7 @@ public:
 	ResultListPage * addResultToListPage(const std::string & sql, int tabNo);
 	void setActivePage(int nQueryPage);
 	bool execSqlToInfoPage(const std::string & sql);
+	void addResultToInfoPage(ExecuteResult & result);
 	void removeResultListPageFrom(int nQueryPage);
 	void activeResultInfoPage();
 private:
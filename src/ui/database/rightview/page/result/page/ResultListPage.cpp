@@ -1,16 +1,23 @@
 #include "ResultListPage.h"
+#include <wx/weakref.h>
+#include <wx/filedlg.h>
 #include "common/Config.h"
 #include "utils/ResourceUtil.h"
 #include "utils/PerformUtil.h"
+#include "utils/StringUtil.h"
 #include "core/entity/Entity.h"
 #include "core/common/Lang.h"
 #include "ui/common/msgbox/QAnimateBox.h"
 #include "core/common/exception/QSqlExecuteException.h"
+#include "core/service/system/SettingService.h"
 
 BEGIN_EVENT_TABLE(ResultListPage, wxPanel)
 	EVT_CHECKBOX(Config::SELECT_ALL_BUTTON_ID, OnClickCheckBox)
 	EVT_BUTTON(Config::LISTVIEW_EXPORT_BUTTON_ID, OnClickExportButton)
 	EVT_BUTTON(Config::LISTVIEW_COPY_BUTTON_ID, OnClickCopyButton)
+	EVT_BUTTON(Config::LISTVIEW_STOP_BUTTON_ID, OnClickStopButton)
+	EVT_BUTTON(Config::LISTVIEW_PREV_PAGE_BUTTON_ID, OnClickPrevPageButton)
+	EVT_BUTTON(Config::LISTVIEW_NEXT_PAGE_BUTTON_ID, OnClickNextPageButton)
 END_EVENT_TABLE()
 
 ResultListPage::ResultListPage(QueryPageSupplier* supplier, const std::string& sql) 
@@ -42,19 +49,89 @@ void ResultListPage::loadListView()
 		return;
 	}
 	
-	auto _begin = PerformUtil::begin();
+	std::string runtimeSql = prepareListView();
+	if (runtimeSql.empty()) {
+		return;
+	}
+	// the next keyset page has been prefetched in the background
+	auto prefetchedResult = delegate->takePrefetchedPage(runtimeSql);
+	if (prefetchedResult) {
+		loadListView(*prefetchedResult);
+		return;
+	}
+	QAliveFlag alive = aliveToken.flag();
+	// capture the session status deltas of the query if the setting query-session-status is "true", see the editor toolbar
+	bool captureStatus = SettingService::getInstance()->getSysInit("query-session-status") == "true";
+	ExecutorService::getInstance()->executeQueryStreamAsync(connectId, schema, runtimeSql, mysupplier->getRuntimeSessionKey(), getFetchSize(),
+		[this, alive](ExecuteRowBatch & batch) {
+		if (*alive) {
+			loadRuntimeBatch(batch);
+		}
+	}, [this, alive](ExecuteResult & result) {
+		if (*alive) {
+			loadListView(result);
+		}
+	}, captureStatus);
+}
+
+/**
+ * Clear the list view and show the executing status, the list view will be loaded by loadListView(result).
+ * 
+ * @return the runtime sql for execution
+ */
+std::string ResultListPage::prepareListView()
+{
+	loadBeginAt = PerformUtil::begin();
+	rowCount = 0;
+	std::string runtimeSql = delegate->resetListView(mysupplier->getRuntimeUserConnectId(), 
+		mysupplier->getRuntimeSchema(), mysupplier->getCacheUseSql());
+	statusBar->SetStatusText(S("executing"), 0);
+	for (int i = 1; i < statusBar->GetFieldsCount(); i++) {
+		statusBar->SetStatusText("", i);
+	}
+	stopButton->Enable(!runtimeSql.empty());
+	displayPageButtons();
+	return runtimeSql;
+}
+
+/**
+ * Append the batch of rows of the streaming query, and display the fetched rows in the status bar.
+ * 
+ * @param batch
+ */
+void ResultListPage::loadRuntimeBatch(ExecuteRowBatch & batch)
+{
+	rowCount = delegate->loadRuntimeBatch(batch);
+	statusBar->SetStatusText(wxString::Format("%s %d rows", S("fetching").c_str(), rowCount), 2);
+}
+
+uint32_t ResultListPage::getFetchSize()
+{
+	return delegate->getFetchSize();
+}
+
+void ResultListPage::loadListView(ExecuteResult & result)
+{
+	stopButton->Disable();
 	try {
-		rowCount = delegate->loadListView(connectId, schema, mysupplier->getCacheUseSql());
+		rowCount = delegate->loadListView(result);
 	} catch (QSqlExecuteException &ex) {
 		QAnimateBox::error(ex);
 		rowCount = 0;
 	}
 	
 	ResultInfo & resultInfo = delegate->getRuntimeResultInfo();
-	resultInfo.totalTime = PerformUtil::end(_begin);
+	resultInfo.totalTime = PerformUtil::end(loadBeginAt);
+
+	// keyset pagination: remember the last key of the page and prefetch the next page
+	delegate->endKeysetPage(result);
+	displayPageButtons();
 
 	// display status bar panels 
 	displayStatusBarPanels(resultInfo);
+	if (result.isStopped) {
+		statusBar->SetStatusText(wxString::Format("%d rows (%s)", rowCount, S("fetch-stopped").c_str()), 2);
+	}
 	/*
 	int checkedFormView = formViewCheckBox.GetCheck();
 	if (checkedFormView) {
@@ -75,7 +152,8 @@ void ResultListPage::createControls()
 	createListView();
 	createStatusBar();
 
-	delegate = new ResultListPageDelegate(this, listView, mysupplier, QUERY_SQL_RESULT);
+	delegate = new ResultListPageDelegate(this, listView, mysupplier, 
+		mysupplier->getOperateType() == TABLE_DATA ? QUERY_TABLE_DATA : QUERY_SQL_RESULT);
 }
 
 void ResultListPage::createLayouts()
@@ -164,6 +242,17 @@ void ResultListPage::createToobarRightButtons()
 	refreshButton->SetToolTip(S("refresh"));
 	toolbarHoriRightLayout->Add(refreshButton, 0, wxALIGN_TOP | wxALIGN_LEFT);
 
+	normalBitmap = wxBitmap(imgdir + "cancel-button-normal.png", wxBITMAP_TYPE_PNG);
+	pressedBitmap = wxBitmap(imgdir + "cancel-button-pressed.png", wxBITMAP_TYPE_PNG);
+	stopButton = new wxBitmapButton(this, Config::LISTVIEW_STOP_BUTTON_ID, wxBitmapBundle(normalBitmap), wxDefaultPosition, { 22, 22 }, wxCLIP_CHILDREN | wxNO_BORDER);
+	stopButton->SetBackgroundColour(bkgColor);
+	stopButton->SetBitmapPressed(pressedBitmap);
+	stopButton->SetBitmapFocus(pressedBitmap);
+	stopButton->SetBitmapDisabled(wxBitmap(imgdir + "cancel-button-disabled.png", wxBITMAP_TYPE_PNG));
+	stopButton->SetToolTip(S("stop-fetch"));
+	stopButton->Disable();
+	toolbarHoriRightLayout->Add(stopButton, 0, wxALIGN_TOP | wxALIGN_LEFT);
+
 	auto splitButton = createToolSplit();
 	toolbarHoriRightLayout->Add(splitButton, 0, wxALIGN_TOP | wxALIGN_LEFT);
 
@@ -188,6 +277,21 @@ void ResultListPage::createToobarRightButtons()
 	rowsEdit = new wxTextCtrl(this, Config::LISTVIEW_LIMIT_EDIT_ID, "1000", wxDefaultPosition, { 36, 20 }, wxCLIP_CHILDREN | wxCLIP_SIBLINGS | wxNO_BORDER);
 	toolbarHoriRightLayout->Add(rowsEdit, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT);
 
+	// the keyset pages of the table data
+	toolbarHoriRightLayout->AddSpacer(5);
+	prevPageButton = new wxButton(this, Config::LISTVIEW_PREV_PAGE_BUTTON_ID, "<", wxDefaultPosition, { 22, 22 }, wxCLIP_CHILDREN | wxNO_BORDER);
+	prevPageButton->SetBackgroundColour(bkgColor);
+	prevPageButton->SetForegroundColour(textColor);
+	prevPageButton->SetToolTip(S("prev-page"));
+	prevPageButton->Hide();
+	toolbarHoriRightLayout->Add(prevPageButton, 0, wxALIGN_TOP | wxALIGN_LEFT);
+	nextPageButton = new wxButton(this, Config::LISTVIEW_NEXT_PAGE_BUTTON_ID, ">", wxDefaultPosition, { 22, 22 }, wxCLIP_CHILDREN | wxNO_BORDER);
+	nextPageButton->SetBackgroundColour(bkgColor);
+	nextPageButton->SetForegroundColour(textColor);
+	nextPageButton->SetToolTip(S("next-page"));
+	nextPageButton->Hide();
+	toolbarHoriRightLayout->Add(nextPageButton, 0, wxALIGN_TOP | wxALIGN_LEFT);
+
 	toolbarHoriRightLayout->AddSpacer(5);
 }
 
@@ -195,9 +299,9 @@ void ResultListPage::createListView()
 {
 	listView = new QListView();	
 
-	// virtual style: wxLC_VIRTUAL
+	// virtual style: wxLC_VIRTUAL, the rows are read from the result buffer of delegate
 	listView->Create(this, Config::DATABASE_QUERY_LISTVIEW_ID, wxDefaultPosition, wxDefaultSize, 
-		wxCLIP_CHILDREN | wxNO_BORDER | wxLC_REPORT | wxLC_ALIGN_LEFT );
+		wxCLIP_CHILDREN | wxNO_BORDER | wxLC_REPORT | wxLC_ALIGN_LEFT | wxLC_VIRTUAL);
 	listView->SetBackgroundColour(bkgColor);
 	listView->SetTextColour(textColor);
 	listView->EnableCheckBoxes(true);
@@ -210,9 +314,11 @@ void ResultListPage::createStatusBar()
 {
 	statusBar = new wxStatusBar();
 	statusBar->Create(this, Config::DATABASE_QUERY_STATUSBAR_ID, wxCLIP_CHILDREN | wxNO_BORDER | wxSTB_SIZEGRIP|wxSTB_SHOW_TIPS|wxSTB_ELLIPSIZE_END|wxFULL_REPAINT_ON_RESIZE);
-	const int widths[4]{ -1, -1, -1, 100};
-	statusBar->SetFieldsCount(4, widths);
-	statusBar->SetStatusWidths(4, widths);
+	const int widths[5]{ -2, -1, -1, -3, -2};
+	statusBar->SetFieldsCount(5, widths);
+	statusBar->SetStatusWidths(5, widths);
+	// double click the status bar to export the trace of the execution
+	statusBar->Bind(wxEVT_LEFT_DCLICK, &ResultListPage::OnDbClickStatusBar, this);
 	//statusBar->SetBackgroundColour(bkgColor);
 	//statusBar->SetForegroundColour(textColor);
 	topSizer->Add(statusBar, 0, wxALIGN_TOP | wxEXPAND);
@@ -230,6 +336,7 @@ void ResultListPage::displayStatusBarPanels(ResultInfo& resultInfo)
 	displayDatabase(); 
 	displayResultRows();
 	displayExecTime(resultInfo);
+	displayStatusDeltas(resultInfo);
 }
 
 void ResultListPage::displayRuntimeSql()
@@ -245,6 +352,9 @@ void ResultListPage::displayDatabase()
 void ResultListPage::displayResultRows()
 {
 	wxString resultRows = wxString::Format("%d rows", rowCount);
+	if (delegate->isKeysetPagination()) {
+		resultRows = wxString::Format("%s %d, %d rows", S("page").c_str(), delegate->getKeysetPage() + 1, rowCount);
+	}
 	statusBar->SetStatusText(resultRows, 2);
 }
 
@@ -252,16 +362,76 @@ void ResultListPage::displayExecTime(ResultInfo & resultInfo)
 {
 	wxString execTime = wxString::Format("Exec:%s Transfer:%s Total:%s", 
 		resultInfo.execTime.c_str(), resultInfo.transferTime.c_str(), resultInfo.totalTime.c_str());
+	auto trace = delegate->getRuntimeTrace();
+	if (trace) {
+		// the spans of the execution, such as "checkout:0.2ms schema:0.4ms execute:12ms first row:3.1ms fetch:80ms ..."
+		execTime = wxString::Format("%s Total:%s", trace->toSummary().c_str(), resultInfo.totalTime.c_str());
+	}
 	statusBar->SetStatusText(execTime, 3);
 }
 
+/**
+ * Display the session status deltas of the query, the rows read is the sum of Handler_read_*,
+ * such as "Rows read:10240 Sort_rows:100 Created_tmp_tables:1".
+ * 
+ * @param resultInfo
+ */
+void ResultListPage::displayStatusDeltas(ResultInfo & resultInfo)
+{
+	if (resultInfo.statusDeltas.empty()) {
+		statusBar->SetStatusText("", 4);
+		return;
+	}
+	int64_t rowsRead = 0;
+	wxString others;
+	for (auto & statusDelta : resultInfo.statusDeltas) {
+		if (StringUtil::startWith(statusDelta.name, "Handler_read_", true)) {
+			rowsRead += statusDelta.delta;
+			continue;
+		}
+		others.Append(wxString::Format(" %s:%lld", statusDelta.name.c_str(), static_cast<long long>(statusDelta.delta)));
+	}
+	wxString text = wxString::Format("Rows read:%lld", static_cast<long long>(rowsRead));
+	text.Append(others);
+	statusBar->SetStatusText(text, 4);
+}
+
+void ResultListPage::displayPageButtons()
+{
+	bool isKeyset = delegate->isKeysetPagination();
+	if (prevPageButton->IsShown() != isKeyset) {
+		prevPageButton->Show(isKeyset);
+		nextPageButton->Show(isKeyset);
+		toolbarHoriRightLayout->Layout();
+	}
+	prevPageButton->Enable(delegate->hasPrevKeysetPage());
+	nextPageButton->Enable(delegate->hasNextKeysetPage());
+}
+
+void ResultListPage::OnDbClickStatusBar(wxMouseEvent& event)
+{
+	if (!delegate->getRuntimeTrace()) {
+		event.Skip();
+		return;
+	}
+	wxFileDialog saveFileDialog(this, S("export-trace"), "", "trace.json",
+		"JSON files (*.json)|*.json", wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+	if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+		return;
+	}
+	if (delegate->exportRuntimeTrace(saveFileDialog.GetPath().ToStdString())) {
+		QAnimateBox::success(S("export-trace-success"));
+	} else {
+		QAnimateBox::error(S("export-trace-failed"));
+	}
+}
+
 void ResultListPage::OnClickCheckBox(wxCommandEvent& WXUNUSED(event))
 {
 	bool checked = selAllCheckBox->GetValue();
-	int rows = listView->GetItemCount();
-	for (int i = 0; i < rows; ++i) {
-		listView->CheckItem(i, checked);
-	}
+	// the checked items are the selected items in virtual mode, item -1 means all items
+	listView->SetItemState(-1, checked ? wxLIST_STATE_SELECTED : 0, wxLIST_STATE_SELECTED);
+	listView->Refresh();
 }
 
 void ResultListPage::OnClickExportButton(wxCommandEvent& event)
@@ -273,3 +443,24 @@ void ResultListPage::OnClickCopyButton(wxCommandEvent& event)
 {
 	event.Skip();
 }
+
+void ResultListPage::OnClickStopButton(wxCommandEvent& WXUNUSED(event))
+{
+	// stop the fetch and kill the running query, the fetched rows are kept
+	ExecutorService::getInstance()->cancelQuery(mysupplier->getRuntimeUserConnectId(), mysupplier->getRuntimeSessionKey());
+	stopButton->Disable();
+}
+
+void ResultListPage::OnClickPrevPageButton(wxCommandEvent& WXUNUSED(event))
+{
+	if (delegate->moveKeysetPage(-1)) {
+		loadListView();
+	}
+}
+
+void ResultListPage::OnClickNextPageButton(wxCommandEvent& WXUNUSED(event))
+{
+	if (delegate->moveKeysetPage(1)) {
+		loadListView();
+	}
+}
@@ -17,11 +17,13 @@
  * @date   2024-12-22
  *********************************************************************/
 #pragma once
+#include <chrono>
 #include "ui/common/panel/QPanel.h"
 #include "ui/common/listview/QListView.h"
 #include "ui/database/supplier/DatabaseSupplier.h"
 #include "ui/database/rightview/page/supplier/QueryPageSupplier.h"
 #include "ui/database/rightview/page/result/page/delegate/ResultListPageDelegate.h"
+#include "common/QAliveToken.h"
 
 class ResultListPage : public QPanel<DatabaseSupplier>
 {
@@ -32,8 +34,16 @@ public:
 	void setup(QueryPageSupplier * supplier, const std::string & sql);
 	void loadListView();
 
+	// async load: prepareListView() before execution, loadListView(result) when the result is delivered in the UI thread
+	std::string prepareListView();
+	void loadListView(ExecuteResult & result);
+	void loadRuntimeBatch(ExecuteRowBatch & batch);
+	uint32_t getFetchSize();
+	// false after the page is destroyed, captured by the async callbacks
+	QAliveFlag getAliveFlag() const { return aliveToken.flag(); }
 private:
 	int rowCount;
+	std::chrono::steady_clock::time_point loadBeginAt;
 
 	wxString imgdir;
 	wxBoxSizer* toolbarHoriLayout;
@@ -47,17 +57,21 @@ private:
 	wxCheckBox * formViewCheckBox;
 	wxBitmapButton* filterButton;
 	wxBitmapButton* refreshButton;
+	wxBitmapButton* stopButton;
 	wxCheckBox * limitCheckBox;
 	wxStaticText* offsetLabel;
 	wxTextCtrl* offsetEdit;
 	wxStaticText* rowsLabel;
 	wxTextCtrl* rowsEdit;
+	wxButton* prevPageButton;
+	wxButton* nextPageButton;
 
 	QListView * listView;
 	wxStatusBar* statusBar;
 
 	QueryPageSupplier* mysupplier;
 	ResultListPageDelegate* delegate;
+	QAliveToken aliveToken;
 
 	virtual void init();
 	virtual void createControls();
@@ -76,9 +90,15 @@ private:
 	void displayDatabase();
 	void displayResultRows();
 	void displayExecTime(ResultInfo & resultInfo);
+	void displayStatusDeltas(ResultInfo & resultInfo);
+	void displayPageButtons();
 
 	void OnClickCheckBox(wxCommandEvent& event); 
 	void OnClickExportButton(wxCommandEvent& event); 
 	void OnClickCopyButton(wxCommandEvent& event); 
+	void OnClickStopButton(wxCommandEvent& event); 
+	void OnClickPrevPageButton(wxCommandEvent& event); 
+	void OnClickNextPageButton(wxCommandEvent& event); 
+	void OnDbClickStatusBar(wxMouseEvent& event);
 };
 
@@ -18,11 +18,14 @@
  *********************************************************************/
 #include "ResultListPageDelegate.h"
 #include <algorithm>
+#include <fstream>
+#include <wx/weakref.h>
 #include <Strsafe.h>
 #include <CommCtrl.h>
 #include "common/AppContext.h"
 #include "core/common/Lang.h"
 #include "core/common/exception/QSqlExecuteException.h"
+#include "core/common/exception/QRuntimeException.h"
 #include "core/service/system/SettingService.h"
 #include "ui/common/msgbox/QAnimateBox.h"
 #include "ui/common/msgbox/QConfirmBox.h"
@@ -49,6 +52,50 @@ ResultListPageDelegate::~ResultListPageDelegate()
 }
 
 int ResultListPageDelegate::loadListView(uint64_t connectId, const std::string & schema, std::string & sql)
+{
+	if (resetListView(connectId, schema, sql).empty()) {
+		return 0;
+	}
+	auto bt = PerformUtil::begin();
+	runtimeTrace = std::make_shared<QExecTrace>(runtimeSql);
+	try {		
+		std::unique_ptr<sql::ResultSet> resultSet(executorService->executeQuerySql(connectId, schema, runtimeSql, runtimeTrace.get()));
+		runtimeResultInfo.execTime = PerformUtil::elapsedMs(runtimeTrace->getPerfTime(QExecTrace::EXECUTE));
+		loadRuntimeTables(connectId, schema, runtimeSql); 
+		loadRuntimeHeader(resultSet.get());
+		auto bt2 = PerformUtil::begin();
+		QTraceScope convertScope(runtimeTrace.get(), QExecTrace::CONVERT);
+		int effectRows = loadRuntimeData(resultSet.get());
+		convertScope.end();
+		
+		runtimeResultInfo.effectRows = effectRows;	
+		runtimeResultInfo.transferTime = PerformUtil::end(bt2);
+		QTraceScope renderScope(runtimeTrace.get(), QExecTrace::RENDER);
+		displayRuntimeData();
+		//view->changeAllItemsCheckState();
+		return runtimeResultInfo.effectRows;
+	} catch (sql::SQLException &ex) {
+		std::string _err = ex.what();
+		Q_ERROR("query db has error:{}, msg:{}", ex.getErrorCode(), _err);		
+		runtimeResultInfo.code = ex.getErrorCode();
+		runtimeResultInfo.msg = _err;
+		runtimeResultInfo.execTime = PerformUtil::end(bt);
+		runtimeResultInfo.transferTime = PerformUtil::end(bt);
+		throw QSqlExecuteException(std::to_string(ex.getErrorCode()), _err, runtimeSql);
+	}
+	
+	return 0;
+}
+
+/**
+ * Clear the list view and the runtime variables, build the runtime sql with the limit params.
+ * 
+ * @param connectId
+ * @param schema
+ * @param sql - the origin sql
+ * @return runtime sql, empty if the origin sql is empty
+ */
+std::string ResultListPageDelegate::resetListView(uint64_t connectId, const std::string & schema, const std::string & sql)
 {
 	view->DeleteAllColumns();
 	view->DeleteAllItems();
@@ -57,6 +104,7 @@ int ResultListPageDelegate::loadListView(uint64_t connectId, const std::string &
 	runtimeColumns.clear();
 	runtimeFilters.clear();
 	runtimeNewRows.clear();
+	runtimeTrace.reset();
 	resetRuntimeResultInfo();
 
 	runtimeUserConnectId = connectId;
@@ -64,12 +112,15 @@ int ResultListPageDelegate::loadListView(uint64_t connectId, const std::string &
 	runtimeSql = sql;
 
 	if (sql.empty()) {
-		return 0;
+		return runtimeSql;
 	}
 
-	if (!SqlUtil::isPragmaStmt(originSql, false) && !SqlUtil::hasLimitClause(originSql)) {
-		LimitParams limitParams;
-		loadLimitParams(limitParams);
+	LimitParams limitParams;
+	loadLimitParams(limitParams);
+	if (resetKeysetPagination(connectId, schema, limitParams)) {
+		// every page is an index range read no matter how deep it is
+		runtimeSql = SqlUtil::makeKeysetSelectSql(schema, keysetTable, keysetColumns, keysetPageKeys.at(keysetPage), keysetPageRows);
+	} else if (!SqlUtil::isPragmaStmt(originSql, false) && !SqlUtil::hasLimitClause(originSql)) {
 		if (limitParams.checked) {
 			runtimeSql.append(" LIMIT ")
 				.append(std::to_string(limitParams.offset))
@@ -80,33 +131,91 @@ int ResultListPageDelegate::loadListView(uint64_t connectId, const std::string &
 	runtimeResultInfo.connectId = connectId;
 	runtimeResultInfo.schema = schema;
 	runtimeResultInfo.sql = runtimeSql;
-	auto bt = PerformUtil::begin();
-	try {		
-		std::unique_ptr<sql::ResultSet> resultSet(executorService->executeQuerySql(connectId, schema, runtimeSql));
-		runtimeResultInfo.execTime = PerformUtil::elapsedMs(executorService->getPerfTime());
-		loadRuntimeTables(connectId, schema, runtimeSql); 
-		loadRuntimeHeader(resultSet.get());
-		auto bt2 = PerformUtil::begin();
-		int effectRows = loadRuntimeData(resultSet.get());
-		
-		runtimeResultInfo.effectRows = effectRows;	
-		runtimeResultInfo.transferTime = PerformUtil::end(bt2);
+	runtimeResultInfo.statusDeltas.clear();
+	return runtimeSql;
+}
+
+/**
+ * Load the list view from the result of ExecutorService async execution, call it in the UI thread.
+ * 
+ * @param result - the result of runtime sql that returned by resetListView(...)
+ * @return the rows count
+ */
+int ResultListPageDelegate::loadListView(ExecuteResult & result)
+{
+	runtimeTrace = result.trace;
+	runtimeResultInfo.statusDeltas = result.statusDeltas;
+	runtimeResultInfo.execTime = runtimeTrace ? PerformUtil::elapsedMs(runtimeTrace->getPerfTime(QExecTrace::EXECUTE)) : "0ms";
+	if (result.status == EXECUTE_SUCCESS && !result.resultSet) {
+		// streaming query, the rows have been appended by loadRuntimeBatch(...)
+		runtimeResultInfo.effectRows = static_cast<int>(runtimeDatas.getRowCount());
+		runtimeResultInfo.transferTime = PerformUtil::end(transferBeginAt);
+		return runtimeResultInfo.effectRows;
+	}
+	if (result.status != EXECUTE_SUCCESS) {
+		std::string code = result.status == EXECUTE_SKIPPED ? "" : result.code;
+		std::string msg = result.status == EXECUTE_SKIPPED ? S("execute-sql-skipped") : result.msg;
+		Q_ERROR("query db has error:{}, msg:{}", code, msg);
+		runtimeResultInfo.code = std::atoi(code.c_str());
+		runtimeResultInfo.msg = msg;
+		runtimeResultInfo.transferTime = "0ms";
+		throw QSqlExecuteException(code, msg, result.sql);
+	}
+	try {
+		loadRuntimeTables(result.connectId, result.schema, runtimeSql);
+		loadRuntimeHeader(result.resultSet.get());
+		auto bt = PerformUtil::begin();
+		QTraceScope convertScope(runtimeTrace.get(), QExecTrace::CONVERT);
+		runtimeResultInfo.effectRows = loadRuntimeData(result.resultSet.get());
+		convertScope.end();
+		runtimeResultInfo.transferTime = PerformUtil::end(bt);
+		QTraceScope renderScope(runtimeTrace.get(), QExecTrace::RENDER);
 		displayRuntimeData();
-		//view->changeAllItemsCheckState();
 		return runtimeResultInfo.effectRows;
 	} catch (sql::SQLException &ex) {
 		std::string _err = ex.what();
 		Q_ERROR("query db has error:{}, msg:{}", ex.getErrorCode(), _err);		
 		runtimeResultInfo.code = ex.getErrorCode();
 		runtimeResultInfo.msg = _err;
-		runtimeResultInfo.execTime = PerformUtil::end(bt);
-		runtimeResultInfo.transferTime = PerformUtil::end(bt);
 		throw QSqlExecuteException(std::to_string(ex.getErrorCode()), _err, runtimeSql);
 	}
-	
 	return 0;
 }
 
+/**
+ * Append a batch of rows of the streaming query to the list view, call it in the UI thread.
+ * 
+ * @param batch - the first batch has the column names
+ * @return the rows count of the list view
+ */
+int ResultListPageDelegate::loadRuntimeBatch(ExecuteRowBatch & batch)
+{
+	// the time of the list view updating in the UI thread
+	QTraceScope renderScope(batch.trace.get(), QExecTrace::RENDER);
+	if (batch.isFirst) {
+		runtimeTrace = batch.trace;
+		transferBeginAt = PerformUtil::begin();
+		loadRuntimeTables(runtimeUserConnectId, runtimeResultInfo.schema, runtimeSql);
+		loadRuntimeHeader(batch.columns, batch.rows.getColumnTypes());
+	}
+	appendRuntimeData(batch.rows);
+	return static_cast<int>(runtimeDatas.getRowCount());
+}
+
+/**
+ * The rows count of one batch for the streaming query, setting key: query-fetch-size, default 1000, see the query editor toolbar.
+ * 
+ * @return 
+ */
+uint32_t ResultListPageDelegate::getFetchSize()
+{
+	std::string fetchSize = SettingService::getInstance()->getSysInit("query-fetch-size");
+	if (!StringUtil::isDigit(fetchSize) || fetchSize.size() > 7 || std::stoi(fetchSize) <= 0) {
+		return 1000;
+	}
+	return static_cast<uint32_t>(std::stoi(fetchSize));
+}
+
 //int ResultListPageDelegate::loadFilterListView()
 //{
 //	view->DeleteAllItems();
@@ -261,11 +370,30 @@ void ResultListPageDelegate::loadRuntimeTables(uint64_t connectId, const std::st
 }
 
 void ResultListPageDelegate::loadRuntimeHeader(sql::ResultSet * query)
+{
+	Columns columns;
+	QCellTypes types;
+	auto metaData = query->getMetaData();
+	int n = metaData->getColumnCount();
+	for (int i = 0; i < n; i++) {
+		columns.push_back(metaData->getColumnName(i+1).asStdString());
+		types.push_back(QResultBuffer::toCellType(metaData->getColumnType(i + 1), metaData->isSigned(i + 1)));
+	}
+	loadRuntimeHeader(columns, types);
+}
+
+/**
+ * Create the list view columns and reset runtimeDatas.
+ * 
+ * @param columns
+ * @param types - the cell types of columns, all columns are CELL_TEXT if it is empty
+ */
+void ResultListPageDelegate::loadRuntimeHeader(const Columns & columns, const QCellTypes & types)
 {
 	view->DeleteAllColumns();
-	int n = query->getMetaData()->getColumnCount();
+	int n = static_cast<int>(columns.size());
 	for (int i = 0; i < n; i++) {
-		std::string columnName = query->getMetaData()->getColumnName(i+1);
+		const std::string & columnName = columns.at(i);
 		if (!columnName.empty() && columnName != "_ct_sqlite_rowid") {
 			int colIdx = view->GetColumnCount();
 			wxListItem item;
@@ -279,6 +407,7 @@ void ResultListPageDelegate::loadRuntimeHeader(sql::ResultSet * query)
 		
 		runtimeColumns.push_back(columnName);
 	}
+	runtimeDatas.reset(runtimeColumns, types);
 }
 
 /**
@@ -310,19 +439,11 @@ void ResultListPageDelegate::loadRuntimeHeader(sql::ResultSet * query)
 
 int ResultListPageDelegate::loadRuntimeData(sql::ResultSet * resultSet)
 {
-	int n = static_cast<int>(runtimeColumns.size());
 	while (resultSet->next()) {
-		RowItem rowItem;
-		for (int i = 0; i < n; i++) {
-			std::string columnVal = resultSet->isNull(i + 1) ? "< NULL >" : 
-				StringUtil::converFromUtf8( resultSet->getString(i + 1).asStdString());
-
-			//std::string columnVal = resultSet->isNull(i + 1) ? "< NULL >" : resultSet->getString(i + 1).asStdString();
-			rowItem.push_back(columnVal);
-		}
-		runtimeDatas.push_back(rowItem);
+		// the text cells keep the UTF-8 bytes, they are converted when they are drawn or copied
+		runtimeDatas.appendRow(resultSet);
 	}
-	int nRow = static_cast<int>(runtimeDatas.size());
+	int nRow = static_cast<int>(runtimeDatas.getRowCount());
 	// trigger CListViewCtrl message LVN_GETDISPINFO to parent HWND, it will call this->fillListViewItemData(NMLVDISPINFO * pLvdi)
 	//view->SetDataList(&runtimeDatas);
 	
@@ -331,65 +452,25 @@ int ResultListPageDelegate::loadRuntimeData(sql::ResultSet * resultSet)
 
 void ResultListPageDelegate::displayRuntimeData()
 {
-	int nRows = static_cast<int>(runtimeDatas.size());
-	int nCols = static_cast<int>(runtimeColumns.size());
+	// wxLC_VIRTUAL: the list view reads the item texts from runtimeDatas when they are painted
+	view->SetDataList(&runtimeDatas);
+}
 
-	
-	int row = 0;
-	for (auto iter = runtimeDatas.begin(); iter != runtimeDatas.end(); iter++) {
-		RowItem & rowItem = *iter;
-		for (int i = 0; i < nCols; i++) {
-			std::string columnVal = rowItem.at(i);
-			if (i == 0) {
-				wxListItem listItem;
-				listItem.SetColumn(i);
-				listItem.SetId(row);
-				listItem.SetText(columnVal);
-				listItem.SetAlign(wxLIST_FORMAT_LEFT);
-				listItem.SetBackgroundColour(row % 2 ? rowBkgColor1 : rowBkgColor2);
-				listItem.SetTextColour(textColor);
-				view->InsertItem(listItem);
-			} else {
-				view->SetItem(row, i, columnVal);
-			}
-		}
-		++row;
-	}
+/**
+ * Move the rows to runtimeDatas (the cell bytes are not copied) and update the item count of the list view.
+ * 
+ * @param rows
+ */
+void ResultListPageDelegate::appendRuntimeData(QResultBuffer & rows)
+{
+	runtimeDatas.append(rows);
+	view->SetDataList(&runtimeDatas);
 }
 
 int ResultListPageDelegate::loadRuntimeDataToList(sql::ResultSet* resultSet)
 {
-	int n = static_cast<int>(runtimeColumns.size());
-	int row = 0;
-	while (resultSet->next()) {
-		RowItem rowItem;	
-		
-		for (int i = 0; i < n; i++) {
-			std::string columnVal = resultSet->isNull(i + 1) ? "< NULL >" : 
-				StringUtil::converFromUtf8( resultSet->getString(i + 1).asStdString());
-			rowItem.push_back(columnVal);
-
-			if (i == 0) {
-				wxListItem listItem;
-				listItem.SetColumn(i);
-				listItem.SetId(runtimeDatas.size());
-				listItem.SetText(columnVal);
-				listItem.SetAlign(wxLIST_FORMAT_LEFT);
-				listItem.SetBackgroundColour(row % 2 ? rowBkgColor1 : rowBkgColor2);
-				listItem.SetTextColour(textColor);
-				view->InsertItem(listItem);
-			} else {
-				view->SetItem(runtimeDatas.size(), i, columnVal);
-			}
-		}
-		++row;
-		runtimeDatas.push_back(rowItem);
-	}
-	int nRow = static_cast<int>(runtimeDatas.size());
-	// trigger CListViewCtrl message LVN_GETDISPINFO to parent HWND, it will call this->fillListViewItemData(NMLVDISPINFO * pLvdi)
-	// virtual controls for listView lazy load the data
-	// view->SetItemCount(nRow);
-	
+	int nRow = loadRuntimeData(resultSet);
+	displayRuntimeData();
 	return nRow;
 }
 
@@ -405,6 +486,185 @@ void ResultListPageDelegate::loadLimitParams(LimitParams & limitParams)
 	limitParams.rows = std::stoi(rows);
 }
 
+/**
+ * Use the keyset pagination if the delegate is QUERY_TABLE_DATA, the limit is checked, the origin sql is "SELECT * FROM tbl" 
+ * of the runtime table and the table has the primary key. The visited pages are kept if the connect, schema, origin sql and page rows are not changed.
+ * 
+ * @param connectId
+ * @param schema
+ * @param limitParams - limitParams.rows is the rows of one page, the offset is not used
+ * @return true if the keyset pagination is used
+ */
+bool ResultListPageDelegate::resetKeysetPagination(uint64_t connectId, const std::string & schema, const LimitParams & limitParams)
+{
+	std::string tblName = supplier->getRuntimeTblName();
+	if (resultType != QUERY_TABLE_DATA || !limitParams.checked || limitParams.rows <= 0 
+		|| !SqlUtil::isSelectAllFromTable(originSql, schema, tblName)) {
+		keysetIdentity.clear();
+		keysetColumns.clear();
+		return false;
+	}
+	std::string identity = std::to_string(connectId) + "|" + schema + "|" + originSql + "|" + std::to_string(limitParams.rows);
+	if (identity == keysetIdentity) {
+		return !keysetColumns.empty();
+	}
+	keysetIdentity = identity;
+	keysetTable = tblName;
+	keysetColumns.clear();
+	keysetPageRows = limitParams.rows;
+	keysetPage = 0;
+	keysetPageKeys.assign(1, RowItem());
+	prefetchSql.clear();
+	prefetchResult.reset();
+	try {
+		// the rows of primary key are in the order of the columns in the key
+		for (auto & indexInfo : metadataService->getIndexesOfUserTable(connectId, schema, tblName)) {
+			if (indexInfo.pk) {
+				keysetColumns.push_back(indexInfo.columns);
+			}
+		}
+	} catch (QRuntimeException & ex) {
+		Q_ERROR("Fail to get the primary key of {}, code:{}, error:{}", tblName, ex.getCode(), ex.getMsg());
+		keysetColumns.clear();
+	}
+	return !keysetColumns.empty();
+}
+
+/**
+ * Move to the previous (step < 0) or next (step > 0) keyset page that has been visited, 
+ * the runtime sql of the page is built by resetListView(...).
+ * 
+ * @param step
+ * @return false if the page does not exist
+ */
+bool ResultListPageDelegate::moveKeysetPage(int step)
+{
+	int page = keysetPage + step;
+	if (keysetColumns.empty() || page < 0 || static_cast<size_t>(page) >= keysetPageKeys.size()) {
+		return false;
+	}
+	keysetPage = page;
+	return true;
+}
+
+/**
+ * Remember the last key of the loaded page as the begin of the next page, and prefetch the next page in the background.
+ * The next page does not exist if the rows of the page are less than the page rows.
+ * 
+ * @param result - the result of the page
+ */
+void ResultListPageDelegate::endKeysetPage(ExecuteResult & result)
+{
+	if (keysetColumns.empty()) {
+		return;
+	}
+	keysetPageKeys.resize(keysetPage + 1);
+	size_t rowCount = runtimeDatas.getRowCount();
+	if (result.status != EXECUTE_SUCCESS || result.isStopped || rowCount < static_cast<size_t>(keysetPageRows)) {
+		return;
+	}
+	RowItem keyValues = getRuntimeKeyValues(rowCount - 1);
+	if (keyValues.empty()) {
+		return;
+	}
+	keysetPageKeys.push_back(keyValues);
+	prefetchNextKeysetPage();
+}
+
+/**
+ * The sql literals of the primary key values of the row, such as 100, 'abc', X'0A1B'.
+ * 
+ * @param row
+ * @return empty if a key column is not in the result
+ */
+RowItem ResultListPageDelegate::getRuntimeKeyValues(size_t row)
+{
+	RowItem keyValues;
+	for (auto & keyColumn : keysetColumns) {
+		auto iter = std::find_if(runtimeColumns.begin(), runtimeColumns.end(), [&keyColumn](const std::string & column) {
+			return StringUtil::toupper(column) == StringUtil::toupper(keyColumn);
+		});
+		if (iter == runtimeColumns.end()) {
+			Q_ERROR("The key column {} is not in the result of {}", keyColumn, runtimeSql);
+			return RowItem();
+		}
+		size_t col = static_cast<size_t>(iter - runtimeColumns.begin());
+		if (runtimeDatas.isNull(row, col)) {
+			keyValues.push_back("NULL");
+			continue;
+		}
+		switch (runtimeDatas.getColumnType(col)) {
+		case CELL_INT:
+		case CELL_UINT:
+		case CELL_DOUBLE:
+		case CELL_DECIMAL:
+			keyValues.push_back(runtimeDatas.getString(row, col));
+			break;
+		case CELL_BLOB: {
+			static const char * hexDigits = "0123456789ABCDEF";
+			size_t len = 0;
+			const char * bytes = runtimeDatas.getBytes(row, col, &len);
+			std::string hex = "X'";
+			for (size_t i = 0; i < len; i++) {
+				unsigned char ch = static_cast<unsigned char>(bytes[i]);
+				hex.push_back(hexDigits[ch >> 4]);
+				hex.push_back(hexDigits[ch & 0x0F]);
+			}
+			keyValues.push_back(hex.append("'"));
+			break;
+		}
+		default:
+			// the sql is sent to the server as utf8, getRuntimeText(...) is the local text for the list view
+			keyValues.push_back(std::string(qua).append(StringUtil::escapeSql(runtimeDatas.getString(row, col))).append(qua));
+			break;
+		}
+	}
+	return keyValues;
+}
+
+/**
+ * Execute the sql of the next keyset page in the session of the page, the result is kept until takePrefetchedPage(...).
+ */
+void ResultListPageDelegate::prefetchNextKeysetPage()
+{
+	if (!hasNextKeysetPage() || !supplier->getRuntimeSessionKey()) {
+		return;
+	}
+	std::string sql = SqlUtil::makeKeysetSelectSql(runtimeResultInfo.schema, keysetTable, keysetColumns, 
+		keysetPageKeys.at(keysetPage + 1), keysetPageRows);
+	if (sql == prefetchSql) {
+		return;
+	}
+	prefetchSql = sql;
+	prefetchResult.reset();
+	// the delegate is deleted with the parent window
+	QAliveFlag alive = aliveToken.flag();
+	executorService->executeQuerySqlAsync(runtimeUserConnectId, runtimeResultInfo.schema, sql, supplier->getRuntimeSessionKey(), 
+		[this, alive, sql](ExecuteResult & result) {
+		if (!*alive || sql != prefetchSql || result.status != EXECUTE_SUCCESS) {
+			return;
+		}
+		prefetchResult = std::make_shared<ExecuteResult>(result);
+	});
+}
+
+/**
+ * Take the prefetched page if its sql is the runtime sql, the page is loaded by loadListView(result) without a round trip.
+ * 
+ * @param sql - the runtime sql
+ * @return nullptr if the page has not been prefetched
+ */
+std::shared_ptr<ExecuteResult> ResultListPageDelegate::takePrefetchedPage(const std::string & sql)
+{
+	if (!prefetchResult || sql != prefetchSql) {
+		return nullptr;
+	}
+	auto result = prefetchResult;
+	prefetchResult.reset();
+	prefetchSql.clear();
+	return result;
+}
+
 /**
  * if the row of index=iItem is selected.
  * 
@@ -510,12 +770,9 @@ RowItem ResultListPageDelegate::getFirstSelectdRowItem()
 	}
 	
 	int nSelItem = -1;
-	if ((nSelItem = view->GetNextItem(nSelItem, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) != -1) {
-		DataList::iterator itor = runtimeDatas.begin();		
-		for (int i = 0; i < nSelItem && itor != runtimeDatas.end(); i++) {
-			itor++;
-		}
-		return *itor;
+	if ((nSelItem = view->GetNextItem(nSelItem, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) != -1 
+		&& nSelItem < static_cast<int>(runtimeDatas.getRowCount())) {
+		return getRuntimeRow(nSelItem);
 	}
 	return RowItem();
 }
@@ -538,14 +795,9 @@ DataList ResultListPageDelegate::getSelectedDatas()
 	DataList result;
 	int nSelItem = -1;
 	while ((nSelItem = view->GetNextItem(nSelItem, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED)) != -1) {
-		DataList::iterator itor = runtimeDatas.begin();
-		for (int i = 0; i < nSelItem && itor != runtimeDatas.end(); i++) {
-			itor++;
-		}
-		if (itor != runtimeDatas.end()) {
-			result.push_back(*itor);
+		if (nSelItem < static_cast<int>(runtimeDatas.getRowCount())) {
+			result.push_back(getRuntimeRow(nSelItem));
 		}
-		
 	}
 	return result;
 }
@@ -580,14 +832,46 @@ void ResultListPageDelegate::setRuntimeColumns(const Columns & columns)
 	runtimeColumns = columns;
 }
 
-const DataList & ResultListPageDelegate::getRuntimeDatas()
+const QResultBuffer & ResultListPageDelegate::getRuntimeDatas()
 {
 	return runtimeDatas;
 }
 
 void ResultListPageDelegate::setRuntimeDatas(const DataList & dataList)
 {
-	runtimeDatas = dataList;
+	runtimeDatas.reset(runtimeColumns);
+	for (auto & rowItem : dataList) {
+		RowItem utf8Row;
+		for (auto & val : rowItem) {
+			utf8Row.push_back(val == QResultBuffer::NULL_TEXT ? val : StringUtil::converToUtf8(val));
+		}
+		runtimeDatas.appendRow(utf8Row);
+	}
+}
+
+/**
+ * The cell text in UI charset, the text cell of runtimeDatas is stored in UTF-8.
+ * 
+ * @param row
+ * @param col
+ * @return 
+ */
+std::string ResultListPageDelegate::getRuntimeText(size_t row, size_t col)
+{
+	if (runtimeDatas.isNull(row, col) || runtimeDatas.getColumnType(col) != CELL_TEXT) {
+		return runtimeDatas.getString(row, col);
+	}
+	return StringUtil::converFromUtf8(runtimeDatas.getString(row, col));
+}
+
+RowItem ResultListPageDelegate::getRuntimeRow(size_t row)
+{
+	RowItem rowItem;
+	size_t n = runtimeDatas.getColumnCount();
+	for (size_t col = 0; col < n; col++) {
+		rowItem.push_back(getRuntimeText(row, col));
+	}
+	return rowItem;
 }
 
 /**
@@ -684,13 +968,11 @@ void ResultListPageDelegate::copyAllRowsToClipboard()
 
 	// 2.write the datas to stringstream
 	n = 0;	
-	for (auto & vals : runtimeDatas) {
-		if (vals.empty()) {
-			continue;
-		}
-		
+	size_t nRows = runtimeDatas.getRowCount(), nCols = runtimeDatas.getColumnCount();
+	for (size_t row = 0; row < nRows; row++) {
 		int i = 0;
-		for (auto & val : vals) {
+		for (size_t col = 0; col < nCols; col++) {
+			std::string val = getRuntimeText(row, col);
 			if (hasRowId && i == 0) {
 				i++;
 				continue;
@@ -782,10 +1064,9 @@ void ResultListPageDelegate::copyAllRowsAsSql()
 	std::ostringstream oss;
 	// 1.write the data to stringstream
 	n = 0;
-	for (auto & vals : runtimeDatas) {
-		if (vals.empty()) {
-			continue;
-		}
+	size_t nRows = runtimeDatas.getRowCount();
+	for (size_t row = 0; row < nRows; row++) {
+		auto vals = getRuntimeRow(row);
 		int i = 0;
 		std::ostringstream dataSql, columnStmt, valuesStmt;
 		dataSql << "INSERT INTO " << tbl << L' ';
@@ -899,15 +1180,9 @@ void ResultListPageDelegate::setSettingPrefix(std::string &prefix)
  */
 void ResultListPageDelegate::changeRuntimeDatasItem(int iItem, int iSubItem, std::string & origText, std::string & newText)
 {
-	ATLASSERT(iItem >= 0 && iSubItem > 0);
-	auto iter = runtimeDatas.begin();
-	
-	for (int i = 0; i < iItem; i++) {
-		iter++;
-	}
-	RowItem & rowItem = *iter;
+	ATLASSERT(iItem >= 0 && iSubItem > 0 && iItem < static_cast<int>(runtimeDatas.getRowCount()));
 	// rowItem.index = listView.row.iSubItem
-	rowItem[iSubItem] = newText;
+	runtimeDatas.setText(iItem, iSubItem, newText == QResultBuffer::NULL_TEXT ? newText : StringUtil::converToUtf8(newText));
 }
 
 //void ResultListPageDelegate::invalidateSubItem(int iItem, int iSubItem)
@@ -1366,6 +1641,26 @@ ResultInfo & ResultListPageDelegate::getRuntimeResultInfo()
 {
 	return runtimeResultInfo;
 }
+
+/**
+ * Save the phase timing of the runtime sql as Chrome trace JSON, open it in chrome://tracing or ui.perfetto.dev.
+ * 
+ * @param path
+ * @return false if there is no trace or fail to write the file
+ */
+bool ResultListPageDelegate::exportRuntimeTrace(const std::string & path)
+{
+	if (!runtimeTrace || path.empty()) {
+		return false;
+	}
+	std::ofstream fout(path.c_str(), std::ios_base::out | std::ios_base::binary);
+	if (!fout.is_open()) {
+		Q_ERROR("Fail to open the trace file:{}", path);
+		return false;
+	}
+	fout << runtimeTrace->toChromeTrace();
+	return fout.good();
+}
 //
 //bool ResultListPageDelegate::cancel()
 //{
@@ -1438,19 +1733,40 @@ void ResultListPageDelegate::resetRuntimeResultInfo()
 
 void ResultListPageDelegate::sortRuntimeDatas(int index, bool isDown)
 {	
-	runtimeDatas.sort([&index, &isDown](const RowItem & item1, const RowItem & item2) {
-		auto val1 = item1.at(index);
-		auto val2 = item2.at(index);
-		val1 = (val1 == "< AUTO >" || val1 == "< NULL >") ? "" : val1;
-		val2 = (val2 == "< AUTO >" || val2 == "< NULL >") ? "" : val2;
-		//Notice : don't verify if val1 and val2 is empty.
-		if (StringUtil::isDecimal(val1) && StringUtil::isDecimal(val2)) {
-			auto v1 = val1.empty() ? 0 : std::stold(val1);
-			auto v2 = val2.empty() ? 0 : std::stold(val2);
-			return isDown ? v1 > v2 : v1 < v2;
+	// the sort keys are parsed once, then the rows of runtimeDatas are reordered by the sorted row indexes
+	size_t nRows = runtimeDatas.getRowCount();
+	std::vector<std::string> texts(nRows);
+	std::vector<bool> decimals(nRows);
+	std::vector<long double> numbers(nRows, 0);
+	bool isNumeric = runtimeDatas.isNumericColumn(index);
+	for (size_t row = 0; row < nRows; row++) {
+		if (isNumeric) {
+			// the numeric column is sorted by the native values, the null cells are the smallest
+			decimals[row] = !runtimeDatas.isNull(row, index);
+			numbers[row] = runtimeDatas.getNumber(row, index);
+			continue;
+		}
+		std::string val = runtimeDatas.isNull(row, index) ? "" : runtimeDatas.getString(row, index);
+		val = val == "< AUTO >" ? "" : val;
+		//Notice : don't verify if val is empty.
+		decimals[row] = StringUtil::isDecimal(val);
+		numbers[row] = decimals[row] && !val.empty() ? std::stold(val) : 0;
+		texts[row] = std::move(val);
+	}
+	std::vector<size_t> order(nRows);
+	for (size_t row = 0; row < nRows; row++) {
+		order[row] = row;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](size_t row1, size_t row2) {
+		if (decimals[row1] && decimals[row2]) {
+			return isDown ? numbers[row1] > numbers[row2] : numbers[row1] < numbers[row2];
+		}
+		if (isNumeric && decimals[row1] != decimals[row2]) {
+			return isDown ? decimals[row1] : decimals[row2];
 		}
-		return isDown ? val1 > val2 : val1 < val2;
+		return isDown ? texts[row1] > texts[row2] : texts[row1] < texts[row2];
 	});
+	runtimeDatas.reorder(order);
 }
 
 
@@ -22,14 +22,17 @@
 #include <string>
 #include <list>
 #include <tuple>
+#include <chrono>
 #include <mysql/jdbc.h>
 #include <wx/listctrl.h>
 #include "ui/common/delegate/QDelegate.h"
 #include "ui/common/listview/QListView.h"
 #include "ui/database/rightview/page/supplier/QueryPageSupplier.h"
 #include "core/service/db/ExecutorService.h"
+#include "core/common/buffer/QResultBuffer.h"
 #include "core/service/db/DatabaseService.h"
 #include "core/service/db/MetadataService.h"
+#include "common/QAliveToken.h"
 
 /**
  * Define FilterTuple and DataFilters
@@ -53,6 +56,21 @@ public:
 	~ResultListPageDelegate();
 
 	int loadListView(uint64_t connectId, const std::string & schema, std::string & sql);
+	// async load: resetListView(...) before ExecutorService::executeQuerySqlAsync(...), loadListView(result) in the callback
+	std::string resetListView(uint64_t connectId, const std::string & schema, const std::string & sql);
+	int loadListView(ExecuteResult & result);
+	// streaming load: the batches of rows are appended before loadListView(result)
+	int loadRuntimeBatch(ExecuteRowBatch & batch);
+	uint32_t getFetchSize();
+
+	// keyset pagination of QUERY_TABLE_DATA, the pages are read by the range of primary key instead of LIMIT offset,rows
+	bool isKeysetPagination() { return !keysetColumns.empty(); }
+	int getKeysetPage() { return keysetPage; }
+	bool hasPrevKeysetPage() { return keysetPage > 0; }
+	bool hasNextKeysetPage() { return keysetPageKeys.size() > static_cast<size_t>(keysetPage) + 1; }
+	bool moveKeysetPage(int step);
+	void endKeysetPage(ExecuteResult & result);
+	std::shared_ptr<ExecuteResult> takePrefetchedPage(const std::string & sql);
 	
 	// Add filters for result list
 	int loadFilterListView();
@@ -74,7 +92,7 @@ public:
 	void setRuntimeTables(const UserTableStrings & val);
 	const Columns & getRuntimeColumns() ;
 	void setRuntimeColumns(const Columns & columns);
-	const DataList & getRuntimeDatas();
+	const QResultBuffer & getRuntimeDatas();
 	void setRuntimeDatas(const DataList & dataList);
 
 	void addListViewChangeVal(SubItemValue &subItemVal);
@@ -114,6 +132,9 @@ public:
 
 	// query result info
 	ResultInfo & getRuntimeResultInfo();
+	// the phase timing of the runtime sql, nullptr before the execution
+	std::shared_ptr<QExecTrace> getRuntimeTrace() { return runtimeTrace; }
+	bool exportRuntimeTrace(const std::string & path);
 	void sendExecSqlMessage(ResultInfo & resultInfo, bool isWait = false);	
 	std::string & getRuntimeSql() { return runtimeSql; }
 private:
@@ -129,9 +150,22 @@ private:
 
 	UserTableStrings runtimeTables;
 	Columns runtimeColumns;
-	DataList runtimeDatas;   // runtime data(s) for showing list view
+	QResultBuffer runtimeDatas;   // runtime data(s) for showing list view, columnar
 	std::vector<int> runtimeNewRows; // runtimeDatas index for create or copy a new row
 	ResultInfo runtimeResultInfo;
+	std::chrono::steady_clock::time_point transferBeginAt;
+	std::shared_ptr<QExecTrace> runtimeTrace;
+
+	// keyset pagination
+	std::string keysetIdentity; // connect id, schema, origin sql and page rows, the visited pages are kept if it is not changed
+	std::string keysetTable;
+	Columns keysetColumns; // the primary key columns of the runtime table, empty - the LIMIT offset,rows is used
+	int keysetPageRows = 0;
+	int keysetPage = 0;
+	std::vector<RowItem> keysetPageKeys; // [i] - the sql literals of the last key before page i, [0] is empty
+	std::string prefetchSql; // the runtime sql of the prefetching page
+	std::shared_ptr<ExecuteResult> prefetchResult; // the prefetched page, nullptr if the prefetch is running or not started
+	QAliveToken aliveToken;
 
 	DataFilters runtimeFilters;
 
@@ -140,11 +174,19 @@ private:
 
 	void loadRuntimeTables(uint64_t connectId, const std::string & schema, const std::string & sql);
 	void loadRuntimeHeader(sql::ResultSet * resultSet);
+	void loadRuntimeHeader(const Columns & columns, const QCellTypes & types = QCellTypes());
 	void clearHeaderSorted(int notSelItem = -1);
 	int loadRuntimeData(sql::ResultSet * resultSet);
 	void displayRuntimeData();
+	void appendRuntimeData(QResultBuffer & rows);
 	int loadRuntimeDataToList(sql::ResultSet * resultSet);	
 	void loadLimitParams(LimitParams & limitParams);
+	bool resetKeysetPagination(uint64_t connectId, const std::string & schema, const LimitParams & limitParams);
+	RowItem getRuntimeKeyValues(size_t row);
+	void prefetchNextKeysetPage();
+
+	std::string getRuntimeText(size_t row, size_t col);
+	RowItem getRuntimeRow(size_t row);
 
 	bool getIsChecked(int iItem);
 
@@ -136,37 +136,6 @@ QueryPageSupplier::~QueryPageSupplier()
 {
 }
 
-UserTableStrings & QueryPageSupplier::getCacheUserTableStrings(uint64_t connectId, const std::string & schema)
-{
-	assert(connectId);
-	std::pair<uint64_t, std::string> pair{connectId, schema};
-	return cacheUserTableMap[pair];
-}
-
-
-void QueryPageSupplier::setCacheUserTableStrings(uint64_t connectId, const std::string & schema, UserTableStrings & tblStrs)
-{
-	assert(connectId && schema.empty() == false);
-	std::pair<uint64_t, std::string> pair{ connectId, schema };
-	cacheUserTableMap[pair] = tblStrs;
-}
-
-
-Columns & QueryPageSupplier::getCacheTableColumns(uint64_t connectId,   const std::string & schema,  const std::string & tblName)
-{
-	assert(connectId && !schema.empty() && !tblName.empty());
-	std::pair<uint64_t, std::string> pair({ connectId, schema + "." + tblName});
-	return cacheTableColumnsMap[pair];
-}
-
-
-void QueryPageSupplier::setCacheTableColumns(uint64_t connectId,   const std::string & schema,  const std::string & tblName, const Columns & columns)
-{
-	assert(connectId && !schema.empty() && !tblName.empty());
-	std::pair<uint64_t, std::string> pair({ connectId, schema + "." + tblName });
-	cacheTableColumnsMap[pair] = columns;
-}
-
 void QueryPageSupplier::splitToSqlVector(std::string sql)
 {
 	sqlVector.clear();
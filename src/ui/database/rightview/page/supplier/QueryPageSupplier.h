@@ -36,14 +36,6 @@ public:
 	// Using semicolons to separate a SQL statement becomes a member variable sqlVector
 	void splitToSqlVector(std::string sql);
 
-	// tables
-	UserTableStrings & getCacheUserTableStrings(uint64_t connectId, const std::string & schema);
-	void setCacheUserTableStrings(uint64_t connectId, const std::string & schema, UserTableStrings & tblStrs);
-
-	// table columns
-	Columns & getCacheTableColumns(uint64_t connectId, const std::string & schema,  const std::string & tblName);
-	void setCacheTableColumns(uint64_t connectId,   const std::string & schema,  const std::string & tblName, const Columns & columns);
-
 	std::string & getCacheUseSql() { return cacheUseSql; }
 	void setCacheUseSql(const std::string & val) { cacheUseSql = val; }
 	void clearCacheUseSql() { cacheUseSql.clear(); }
@@ -51,16 +43,21 @@ public:
 	
 	wxWindow* getActiveResultTabPageHwnd() const { return activeResultTabPageHwnd; }
 	void setActiveResultTabPageHwnd(wxWindow* val) { activeResultTabPageHwnd = val; }
-private:
-	// template params: first - connectid, second - schema , third - table strings 
-	std::map<std::pair<uint64_t, std::string>, UserTableStrings> cacheUserTableMap;
-	
-	// template params:  first - connectId, second - schema.tblName, third - columns strings
-	std::map<std::pair<uint64_t, std::string>, Columns> cacheTableColumnsMap;
 
+	// The session key of ExecutorService async execution, the statements of this page run in the same mysql session
+	uint64_t getRuntimeSessionKey() const { return runtimeSessionKey; }
+	void setRuntimeSessionKey(uint64_t val) { runtimeSessionKey = val; }
+
+	// The server side timeout of the SELECT statements of this page, seconds, 0 - no timeout
+	uint32_t getRuntimeTimeout() const { return runtimeTimeout; }
+	void setRuntimeTimeout(uint32_t val) { runtimeTimeout = val; }
+private:
 	// 
 	std::string cacheUseSql;
 
 	// The HWND of active page in ResultTabView
 	wxWindow * activeResultTabPageHwnd = nullptr;
+
+	uint64_t runtimeSessionKey = 0;
+	uint32_t runtimeTimeout = 0;
 };
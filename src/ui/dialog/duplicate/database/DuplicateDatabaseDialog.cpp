@@ -17,8 +17,7 @@
  * @date   2024-12-05
  *********************************************************************/
 #include "DuplicateDatabaseDialog.h"
-#include <wx/process.h>
-#include <wx/txtstrm.h>
+#include <wx/weakref.h>
 #include <spdlog/fmt/fmt.h>
 #include "common/Config.h"
 #include "common/AppContext.h"
@@ -45,9 +44,6 @@ DuplicateDatabaseDialog::DuplicateDatabaseDialog() : QFormDialog()
 	if (databaseSupplier->runtimeUserDb) {
 		userDb = *databaseSupplier->runtimeUserDb;
 	}	
-
-	exportProcess = nullptr;
-	importProcess = nullptr;
 }
 
 void DuplicateDatabaseDialog::createInputs()
@@ -244,9 +240,6 @@ void DuplicateDatabaseDialog::OnSelChangeConnectCombobox(wxCommandEvent& event)
 void DuplicateDatabaseDialog::OnClickOkButton(wxCommandEvent& event)
 {
 	progressbar->reset();
-	auto tmpdir = ResourceUtil::getStdProductTmpDir();
-	tmpSqlPath = tmpdir + "/duplicate_database_" + DateUtil::getCurrentDateTime("%Y%m%d_%H%M%S") + ".sql";
-	bool isStructOnly = structOnlyCheckBox->GetValue();
 	auto targetSchema = targetDatabaseEdit->GetValue();
 	if (targetSchema.empty()) {
 		QAnimateBox::error(S("no-target-database"));
@@ -264,7 +257,7 @@ void DuplicateDatabaseDialog::OnClickOkButton(wxCommandEvent& event)
 		return;
 	}
 	okButton->Disable();
-	exportDatabaseToTmp(tmpSqlPath);
+	duplicateDatabase();
 }
 
 void DuplicateDatabaseDialog::OnClickSelectAllButton(wxCommandEvent& event)
@@ -322,224 +315,85 @@ void DuplicateDatabaseDialog::OnTreeListItemChecked(wxTreeListEvent& event)
 
 
 /**
- * Export sql statements to specified template file.
+ * Copy the checked objects to the target database in the background, the source and target sessions
+ * are streamed by DatabaseService::copyUserDbAsync(...) without mysqldump.exe, mysql.exe or temp file.
  * 
- * @param tmpSqlPath - expert sql statements to template file path
  * @return 
  */
-bool DuplicateDatabaseDialog::exportDatabaseToTmp(const std::string& tmpSqlPath)
-{
-	std::string productDir = ResourceUtil::getStdProductBinDir();
-	std::string executePath = productDir + "/mysqldump.exe";
-	if (_access(executePath.c_str(), 0) != 0) {
-		Q_ERROR("file not found. Path:{}", executePath);
-		okButton->Enable();
-		return false;
-	}
-
-	
-	std::string cmd(executePath);
-	cmd.append(" -h").append(userConnect.host)
-		.append(" -P").append(std::to_string(userConnect.port))
-		.append(" -u").append(userConnect.userName)
-		.append(" -p").append(userConnect.password)
-		.append(" --default-character-set=utf8")
-		.append(" --databases \"").append(userDb.name).append("\"");
-	
-	std::string ignoreTables = delegate->getIgnoreTablesStringFromTreeListCtrl(treeListCtrl, userDb.name);
-	if (!ignoreTables.empty()) {
-		cmd.append(ignoreTables);
-	}
-	std::string objects = delegate->getObjectsStringFromTreeListCtrl(treeListCtrl);
-	if (!objects.empty()) {
-		cmd.append(objects);
-	}
-
-	bool isStuctOnly = structOnlyCheckBox->GetValue();
-	bool isLockTables = lockTablesCheckBox->GetValue();
-	if (isStuctOnly) {
-		cmd.append(" --no-data");
-	}
-	if (isLockTables) {
-		cmd.append(" --lock-tables");
-	}
-	cmd.append(" --result-file=\"").append(tmpSqlPath).append("\"");
-	exportProcess = new QProcess<DuplicateDatabaseDialog>(this, cmd);
-	progressbar->run(5);
-	if (!exportProcess->open()) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	
-	if (!exportProcess) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	Q_INFO("PID of the new process: {}", exportProcess->GetPid());
-	progressbar->run(10);
-	return true;
-}
-
-bool DuplicateDatabaseDialog::replaceDatabaseNameInTmp()
+bool DuplicateDatabaseDialog::duplicateDatabase()
 {
-	if (_access(tmpSqlPath.c_str(), 0) != 0) {
-		auto err = fmt::format("file not found. Path:{}", tmpSqlPath);
-		Q_ERROR(err);
-		QAnimateBox::error(err);
-		return false;
-	}
-	std::string newTmpPath = tmpSqlPath + ".tmp";
-	std::ifstream fin;
-	std::ofstream fout;
-	fin.open(tmpSqlPath.c_str(), std::ios_base::in);
-	fout.open(newTmpPath.c_str(), std::ios_base::out);
-
-	std::string sourceDbName("`" + userDb.name + "`");
-	std::string targetDbName("`" + targetDatabaseEdit->GetValue().ToStdString() + "`");
-
-	std::string line;
-	while (std::getline(fin, line)) {
-		line = StringUtil::replace(line, sourceDbName, targetDbName);
-		fout << line << std::endl;
-	}
-	fout.close();
-	fin.close();
-
-	// delete original file
-	_unlink(tmpSqlPath.c_str());
-
-	// rename new temp file
-	rename(newTmpPath.c_str(), tmpSqlPath.c_str());
-	Q_INFO("rename file. original:{}, target:{}", newTmpPath, tmpSqlPath);
-
-	return true;
-}
-
-bool DuplicateDatabaseDialog::importDatabaseFromTmp(const std::string& tmpSqlPath)
-{
-	std::string productDir = ResourceUtil::getStdProductBinDir();
-	std::string executePath = productDir + "/mysql.exe";
-	if (_access(executePath.c_str(), 0) != 0) {
-		Q_ERROR("file not found. Path:{}", executePath);
-		okButton->Enable();
-		return false;
-	}
-
 	auto nSelItem = targetConnectComboBox->GetSelection();
 	auto data = reinterpret_cast<QClientData<UserConnect> *>(targetConnectComboBox->GetClientObject(nSelItem));
-	auto userConnect = data->getDataPtr();
-	auto schema = targetDatabaseEdit->GetValue();
-
-	std::string cmd(executePath);
-	cmd.append(" -h").append(userConnect->host)
-		.append(" -P").append(std::to_string(userConnect->port))
-		.append(" -u").append(userConnect->userName)
-		.append(" -p").append(userConnect->password)
-		.append(" --default-character-set=utf8")
-		.append(" -e \"source ").append(tmpSqlPath).append("\"");
-	importProcess = new QProcess<DuplicateDatabaseDialog>(this, cmd);
-	progressbar->run(65);
-	if (!importProcess->open()) {
-		Q_ERROR("Failed to launch the command.");
+	if (!data) {
 		okButton->Enable();
 		return false;
 	}
-	
-	if (!importProcess) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	return true;
-}
 
-DuplicateDatabaseDialog::~DuplicateDatabaseDialog()
-{
-	if (exportProcess) {
-		wxProcess::Kill(exportProcess->GetPid());
-		delete exportProcess;
-		exportProcess = nullptr;
-	}
+	DbCopyParams params;
+	params.fromConnectId = userConnect.id;
+	params.fromSchema = userDb.name;
+	params.toConnectId = data->getDataPtr()->id;
+	params.toSchema = targetDatabaseEdit->GetValue().ToStdString();
+	params.structOnly = structOnlyCheckBox->GetValue();
+	params.lockTables = lockTablesCheckBox->GetValue();
+	delegate->fillDbCopyParamsFromTreeListCtrl(treeListCtrl, params);
 
-	if (importProcess) {
-		wxProcess::Kill(importProcess->GetPid());
-		delete importProcess;
-		importProcess = nullptr;
-	}
-
-	// delete the temp sql file
-	if (!tmpSqlPath.empty() && _access(tmpSqlPath.c_str(), 0) == 0) {
-		_unlink(tmpSqlPath.c_str());
-	}
-}
-
-void DuplicateDatabaseDialog::OnAsyncProcessTermination(QProcess<DuplicateDatabaseDialog>* process)
-{
-	if (exportProcess  && process->GetPid() == exportProcess->GetPid()) {
-		// 1.ending export process
-		progressbar->run(50);
-
-		auto msg = process->getOutputText();
-		if (!msg.empty()) {
-			QAnimateBox::notice(msg);
+	progressbar->run(5);
+	// the dialog may be closed before the copy is finished
+	QAliveFlag alive = aliveToken.flag();
+	copyId = databaseService->copyUserDbAsync(params, [this, alive](bool isSuccess, const std::string & code, const std::string & msg) {
+		if (!*alive) {
+			return;
 		}
-			
-		auto error = process->getOutputError();
-		if (error.empty() == false) {
-			QAnimateBox::error(error);
-			progressbar->error("Dumping failed.");
-			okButton->Enable();
-			delete exportProcess;
-			exportProcess = nullptr;
+		copyId = 0;
+		okButton->Enable();
+		if (!isSuccess) {
+			QAnimateBox::error(QRuntimeException(code, msg));
+			progressbar->error("Duplicate failed.");
 			return;
 		}
-
-		QAnimateBox::success("Export success! Pid:" + std::to_string(process->GetPid()));		
-		
-		delete exportProcess;
-		exportProcess = nullptr;
-		// 2.replace database name in the templace sql file;
-		if (!replaceDatabaseNameInTmp()) {
-			okButton->Enable();
+		progressbar->run(100);
+		QAnimateBox::success(S("duplicate-success"));
+		afterDuplicated();
+	}, [this, alive](const DbCopyProgress & progress) {
+		if (!*alive || !copyId) {
 			return;
 		}
-		progressbar->run(60);
-
-		// 3.import sql file to new database when ending export process
-		importDatabaseFromTmp(tmpSqlPath);
-
-	} else if (importProcess && process->GetPid() == importProcess->GetPid()) {
-		progressbar->run(80);
+		showProgress(progress);
+	});
+	return true;
+}
 
-		auto msg = process->getOutputText();
-		if (!msg.empty()) {
-			QAnimateBox::notice(msg);
+/**
+ * Show the progress of the copy, the tooltip of the progress bar has the tables that are being copied.
+ * 
+ * @param progress
+ */
+void DuplicateDatabaseDialog::showProgress(const DbCopyProgress & progress)
+{
+	wxString detail = wxString::Format("%u/%zu tables, %llu rows", progress.doneTables, progress.tables.size(), 
+		(unsigned long long)progress.copiedRows);
+	for (auto & item : progress.tables) {
+		if (item.status != COPY_TABLE_COPYING) {
+			continue;
 		}
-			
-		auto error = process->getOutputError();
-		if (error.empty() == false) {
-			QAnimateBox::error(error);
-			progressbar->error("Import Failed.");
+		detail.Append("\n").Append(item.name).Append(": ");
+		if (item.estimatedRows) {
+			detail.Append(wxString::Format("%llu / ~%llu rows", (unsigned long long)item.copiedRows, (unsigned long long)item.estimatedRows));
 		} else {
-			QAnimateBox::success("Import success! Pid:" + std::to_string(process->GetPid()));
-			progressbar->run(100);
+			detail.Append(wxString::Format("%llu rows", (unsigned long long)item.copiedRows));
 		}
-		
-		okButton->Enable();
-		delete importProcess;
-		importProcess = nullptr;
-
-		// delete the temp sql file
-		if (_access(tmpSqlPath.c_str(), 0) == 0) {
-			_unlink(tmpSqlPath.c_str());
-		}
-
-		afterDuplicated();
 	}
+	progressbar->run(progress.percent, progress.bytesPerSecond, progress.etaSeconds, detail);
 }
 
+DuplicateDatabaseDialog::~DuplicateDatabaseDialog()
+{
+	if (copyId) {
+		databaseService->cancelCopyUserDb(copyId);
+		copyId = 0;
+	}
+}
 
 void DuplicateDatabaseDialog::afterDuplicated()
 {
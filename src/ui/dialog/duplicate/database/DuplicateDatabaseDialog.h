@@ -25,7 +25,7 @@
 #include "core/service/db/ConnectService.h"
 #include "ui/dialog/duplicate/database/delegate/DuplicateDatabaseDialogDelegate.h"
 #include "ui/common/progress/QProgressBar.h"
-#include "ui/common/process/QProcess.h"
+#include "common/QAliveToken.h"
 
 class DuplicateDatabaseDialog :  public QFormDialog<DuplicateDatabaseDialogDelegate>
 {
@@ -33,9 +33,6 @@ class DuplicateDatabaseDialog :  public QFormDialog<DuplicateDatabaseDialogDeleg
 public:
 	DuplicateDatabaseDialog();
 	~DuplicateDatabaseDialog();
-
-	// handle export process and import process
-	void OnAsyncProcessTermination(QProcess<DuplicateDatabaseDialog>* process);
 private:
 	UserConnect userConnect ;
 	UserDb userDb;
@@ -80,12 +77,12 @@ private:
 	// lock settings
 	wxCheckBox* lockTablesCheckBox;
 
-	std::string tmpSqlPath;
-
 	// process bar 
 	QProgressBar* progressbar;
-	QProcess<DuplicateDatabaseDialog>* exportProcess;
-	QProcess<DuplicateDatabaseDialog>* importProcess;
+	// the running copy of DatabaseService::copyUserDbAsync, 0 - no running copy
+	uint64_t copyId = 0;
+	// the callbacks of DatabaseService are dropped after the dialog is destroyed
+	QAliveToken aliveToken;
 
 	DatabaseSupplier* databaseSupplier;
 	DatabaseService* databaseService = DatabaseService::getInstance();
@@ -106,13 +103,9 @@ private:
 	void OnStructAndDataCheckBoxChecked(wxCommandEvent& event);
 	void OnTreeListItemChecked(wxTreeListEvent& event);
 
-	// export
-	bool exportDatabaseToTmp(const std::string & tmpSqlPath);
-	// replace database name
-	bool replaceDatabaseNameInTmp();
-	// import
-	bool importDatabaseFromTmp(const std::string & tmpSqlPath);
-
+	// copy the database by DatabaseService in the background
+	bool duplicateDatabase();
+	void showProgress(const DbCopyProgress & progress);
 	void afterDuplicated();
 };
 
@@ -93,82 +93,55 @@ void DuplicateDatabaseDialogDelegate::loadForTreeListCtrl(wxTreeListCtrl* treeLi
 }
 
 /**
- * Generate the string of the ignore tables from treeListCtrl.
- * Note:Generate string through unchecked tables
+ * Fill the objects of params from the checked items of treeListCtrl.
  * 
  * @param treeListCtrl
- * @param schema
- * @return ignore table string ,for example, "--ignore-table=schema.table_name1 --ignore-table=schema.table_name2 ..."
+ * @param params [out] - the checked tables and views, and whether to copy routines, triggers and events
  */
-std::string DuplicateDatabaseDialogDelegate::getIgnoreTablesStringFromTreeListCtrl(wxTreeListCtrl* treeListCtrl, const std::string& schema)
+void DuplicateDatabaseDialogDelegate::fillDbCopyParamsFromTreeListCtrl(wxTreeListCtrl* treeListCtrl, DbCopyParams& params)
 {
-	auto rootItem = treeListCtrl->GetRootItem();
-	auto tablesFolderItem = treeListCtrl->GetFirstChild(rootItem);
-	if (!tablesFolderItem.IsOk()) {
-		return "";
-	}
+	params.tables.clear();
+	params.views.clear();
+	params.routines = false;
+	params.triggers = false;
+	params.events = false;
 
-	auto tableItem = treeListCtrl->GetFirstChild(tablesFolderItem);
-	if (!tableItem.IsOk()) {
-		return "";
-	}
-	std::string result;
-	while (tableItem.IsOk()) {
-		if (treeListCtrl->GetCheckedState(tableItem)) {
-			tableItem = treeListCtrl->GetNextSibling(tableItem);
-			continue;
-		}
-		auto data = reinterpret_cast<QClientData<UserTable> *>(treeListCtrl->GetItemData(tableItem));
+	auto rootItem = treeListCtrl->GetRootItem();
+	auto folderItem = treeListCtrl->GetFirstChild(rootItem);
+	while (folderItem.IsOk()) {
+		auto data = reinterpret_cast<QClientData<UserDb> *>(treeListCtrl->GetItemData(folderItem));
 		if (data == nullptr) {
-			tableItem = treeListCtrl->GetNextSibling(tableItem);
+			folderItem = treeListCtrl->GetNextSibling(folderItem);
 			continue;
 		}
-		result.append(" --ignore-table=\"").append(schema).append(".").append(data->getDataPtr()->name).append("\"");
-		tableItem = treeListCtrl->GetNextSibling(tableItem);
-	}
-	
-	return result;
-}
-
-/**
- * Generate the string for objects but exclude tables.
- * 
- * @param treeListCtrl
- * @return 
- */
-std::string DuplicateDatabaseDialogDelegate::getObjectsStringFromTreeListCtrl(wxTreeListCtrl* treeListCtrl)
-{
-	auto rootItem = treeListCtrl->GetRootItem();
-	auto tablesFolderItem = treeListCtrl->GetFirstChild(rootItem);
-	if (!tablesFolderItem.IsOk()) {
-		return "";
-	}
-
-	std::string result;
-	auto objectItem = treeListCtrl->GetNextSibling(tablesFolderItem);
-	while (objectItem.IsOk()) {
-		if (!treeListCtrl->GetCheckedState(objectItem)) {
-			objectItem = treeListCtrl->GetNextSibling(objectItem);
-			continue;
+		bool isChecked = treeListCtrl->GetCheckedState(folderItem) != wxCHK_UNCHECKED;
+		switch (data->getDataId()) {
+		case TreeObjectType::TABLES_FOLDER:
+		case TreeObjectType::VIEWS_FOLDER: {
+			auto & names = data->getDataId() == TreeObjectType::TABLES_FOLDER ? params.tables : params.views;
+			auto objectItem = treeListCtrl->GetFirstChild(folderItem);
+			while (objectItem.IsOk()) {
+				if (treeListCtrl->GetCheckedState(objectItem) == wxCHK_CHECKED) {
+					names.push_back(treeListCtrl->GetItemText(objectItem).ToStdString());
+				}
+				objectItem = treeListCtrl->GetNextSibling(objectItem);
+			}
+			break;
 		}
-		auto data = reinterpret_cast<QClientData<UserDb> *>(treeListCtrl->GetItemData(objectItem));
-		
-		switch(data->getDataId()) {
 		case TreeObjectType::ROUTINES:
-			result.append(" --routines");
+			params.routines = isChecked;
 			break;
 		case TreeObjectType::TRIGGERS_FOLDER:
-			result.append(" --triggers");
+			params.triggers = isChecked;
 			break;
 		case TreeObjectType::EVENTS_FOLDER:
-			result.append(" --events");
+			params.events = isChecked;
 			break;
 		default:
 			break;
 		}
-		objectItem = treeListCtrl->GetNextSibling(objectItem);
+		folderItem = treeListCtrl->GetNextSibling(folderItem);
 	}
-	return result;
 }
 
 void DuplicateDatabaseDialogDelegate::loadTablesForDatabase(wxTreeListCtrl * treeListCtrl, const wxTreeListItem& folderItem, uint64_t connectId, const std::string& schema)
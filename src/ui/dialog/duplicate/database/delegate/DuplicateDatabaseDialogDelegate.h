@@ -18,17 +18,16 @@
  *********************************************************************/
 #pragma once
 #include <wx/treelist.h>
-#include <wx/process.h>
 #include "ui/dialog/delegate/QDialogDelegate.h"
 #include "ui/database/supplier/DatabaseSupplier.h"
+#include "core/entity/Entity.h"
 
 class DuplicateDatabaseDialogDelegate :  public QDialogDelegate<DuplicateDatabaseDialogDelegate>
 {
 public:
 	DuplicateDatabaseDialogDelegate();
 	void loadForTreeListCtrl(wxTreeListCtrl * treeListCtrl);
-	std::string getIgnoreTablesStringFromTreeListCtrl(wxTreeListCtrl * treeListCtrl, const std::string& schema);
-	std::string getObjectsStringFromTreeListCtrl(wxTreeListCtrl * treeListCtrl);
+	void fillDbCopyParamsFromTreeListCtrl(wxTreeListCtrl * treeListCtrl, DbCopyParams & params);
 private:
 	// For Database
 	void loadTablesForDatabase(wxTreeListCtrl * treeListCtrl, const  wxTreeListItem & folderItem, uint64_t connectId, const std::string & schema);
@@ -17,7 +17,7 @@
  * @date   2024-12-05
  *********************************************************************/
 #include "DuplicateObjectDialog.h"
-#include <wx/process.h>
+#include <wx/weakref.h>
 #include <wx/txtstrm.h>
 #include <spdlog/fmt/fmt.h>
 #include "common/Config.h"
@@ -40,8 +40,6 @@ DuplicateObjectDialog::DuplicateObjectDialog(DuplicateObjectType _dupObjectType)
 
 void DuplicateObjectDialog::init()
 {
-	importProcess = nullptr;
-
 	databaseSupplier = DatabaseSupplier::getInstance();
 	databaseService = DatabaseService::getInstance();
 	connectService = ConnectService::getInstance();
@@ -294,9 +292,6 @@ void DuplicateObjectDialog::OnChangeTargetObjectEditText(wxCommandEvent& event)
 void DuplicateObjectDialog::OnClickOkButton(wxCommandEvent& event)
 {
 	progressbar->reset();
-	auto tmpdir = ResourceUtil::getStdProductTmpDir();
-	tmpSqlPath = tmpdir + "/duplicate_table_" + DateUtil::getCurrentDateTime("%Y%m%d_%H%M%S") + ".sql";
-	
 	auto targetSchema = targetDatabaseComboBox->GetValue();
 	auto targetObject = targetObjectEdit->GetValue();
 	if (targetObject.empty()) {
@@ -319,8 +314,7 @@ void DuplicateObjectDialog::OnClickOkButton(wxCommandEvent& event)
 		return;
 	}
 	okButton->Disable();
-	exportObjectToTmp(tmpSqlPath);
-	importObjectFromTmp(tmpSqlPath);
+	importObject();
 }
 
 std::string DuplicateObjectDialog::generateNewDDL(const std::string& orignalDdl)
@@ -337,109 +331,52 @@ std::string DuplicateObjectDialog::generateNewDDL(const std::string& orignalDdl)
 	return newDdl.str();
 }
 /**
- * Export sql statements to specified template file.
+ * Import the DDL of the preview into the target database by DatabaseService in the background, 
+ * the DELIMITER of the preview is handled by the sql splitter, so mysql.exe and the temp file are not needed.
  * 
- * @param tmpSqlPath - expert sql statements to template file path
  * @return 
  */
-bool DuplicateObjectDialog::exportObjectToTmp(const std::string& tmpSqlPath)
+bool DuplicateObjectDialog::importObject()
 {
 	auto newDdl = ddlPreviewEdit->GetText();
 	if (newDdl.empty()) {
-		return false;
-	}
-	std::ofstream fout;
-	fout.open(tmpSqlPath.c_str(), std::ios::out | std::ios::binary);
-	fout << newDdl.ToStdString() << std::endl;
-
-	fout.close();
-	return true;
-}
-
-
-bool DuplicateObjectDialog::importObjectFromTmp(const std::string& tmpSqlPath)
-{
-	std::string productDir = ResourceUtil::getStdProductBinDir();
-	std::string executePath = productDir + "/mysql.exe";
-	if (_access(executePath.c_str(), 0) != 0) {
-		Q_ERROR("file not found. Path:{}", executePath);
 		okButton->Enable();
 		return false;
 	}
-
 	auto nSelItem = targetConnectComboBox->GetSelection();
 	auto data = reinterpret_cast<QClientData<UserConnect> *>(targetConnectComboBox->GetClientObject(nSelItem));
-	auto userConnectPtr = data->getDataPtr();
-	auto schema = targetDatabaseComboBox->GetValue();
-	auto objectName = targetObjectEdit->GetValue();
-
-	std::string cmd(executePath);
-	cmd.append(" -h").append(userConnectPtr->host)
-		.append(" -P").append(std::to_string(userConnectPtr->port))
-		.append(" -u").append(userConnectPtr->userName)
-		.append(" -p").append(userConnectPtr->password)
-		.append(" --default-character-set=utf8")
-		.append(" --database ").append(schema)
-		.append(" -e \"source ").append(tmpSqlPath).append("\"");
-	importProcess = new QProcess<DuplicateObjectDialog>(this, cmd);
+
+	SqlImportParams params;
+	params.connectId = data->getDataPtr()->id;
+	params.schema = targetDatabaseComboBox->GetValue().ToStdString();
+	params.sql = newDdl.ToStdString();
+
 	progressbar->run(65);
-	if (!importProcess->open()) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	
-	if (!importProcess) {
-		Q_ERROR("Failed to launch the command.");
+	// the dialog may be closed before the import is finished
+	QAliveFlag alive = aliveToken.flag();
+	importId = databaseService->importSqlAsync(params, [this, alive](bool isSuccess, const std::string & code, const std::string & msg) {
+		if (!*alive) {
+			return;
+		}
+		importId = 0;
 		okButton->Enable();
-		return false;
-	}
+		if (!isSuccess) {
+			QAnimateBox::error(QRuntimeException(code, msg));
+			progressbar->error("Import Failed.");
+			return;
+		}
+		progressbar->run(100);
+		QAnimateBox::success(S("duplicate-success"));
+		afterDuplicated();
+	});
 	return true;
 }
 
 DuplicateObjectDialog::~DuplicateObjectDialog()
 {
-	if (importProcess) {
-		wxProcess::Kill(importProcess->GetPid());
-		delete importProcess;
-		importProcess = nullptr;
-	}
-
-	// delete the temp sql file
-	if (!tmpSqlPath.empty() && _access(tmpSqlPath.c_str(), 0) == 0) {
-		_unlink(tmpSqlPath.c_str());
-	}
-}
-
-void DuplicateObjectDialog::OnAsyncProcessTermination(QProcess<DuplicateObjectDialog>* process)
-{
-	if (importProcess && process->GetPid() == importProcess->GetPid()) {
-		progressbar->run(80);
-
-		auto msg = process->getOutputText();
-		if (!msg.empty()) {
-			QAnimateBox::notice(msg);
-		}
-			
-		auto error = process->getOutputError();
-		if (error.empty() == false) {
-			QAnimateBox::error(error);
-			progressbar->error("Import Failed.");
-		} else {
-			QAnimateBox::success("Import success! Pid:" + std::to_string(process->GetPid()));
-			progressbar->run(100);
-		}
-		
-		okButton->Enable();
-		delete importProcess;
-		importProcess = nullptr;
-
-		// delete the temp sql file
-		if (_access(tmpSqlPath.c_str(), 0) == 0) {
-			_unlink(tmpSqlPath.c_str());
-		}
-
-		afterDuplicated();
+	if (importId) {
+		databaseService->cancelImportSql(importId);
+		importId = 0;
 	}
 }
 
@@ -26,8 +26,8 @@
 #include "core/service/db/MetadataService.h"
 #include "ui/dialog/duplicate/object/delegate/DuplicateObjectDialogDelegate.h"
 #include "ui/common/progress/QProgressBar.h"
-#include "ui/common/process/QProcess.h"
 #include "ui/common/editor/QSqlEditor.h"
+#include "common/QAliveToken.h"
 
 class DuplicateObjectDialog :  public QFormDialog<DuplicateObjectDialogDelegate>
 {
@@ -35,9 +35,6 @@ class DuplicateObjectDialog :  public QFormDialog<DuplicateObjectDialogDelegate>
 public:
 	DuplicateObjectDialog(DuplicateObjectType _dupObjectType);
 	~DuplicateObjectDialog();
-
-	// handle export process and import process
-	void OnAsyncProcessTermination(QProcess<DuplicateObjectDialog>* process);
 private:
 	DuplicateObjectType dupObjectType;
 	std::string caption;
@@ -86,11 +83,12 @@ private:
 	// lock settings
 	wxCheckBox* lockTablesCheckBox;
 
-	std::string tmpSqlPath;
-
 	// process bar 
 	QProgressBar* progressbar;
-	QProcess<DuplicateObjectDialog>* importProcess;
+	// the running import of DatabaseService::importSqlAsync, 0 - no running import
+	uint64_t importId = 0;
+	// the callbacks of DatabaseService are dropped after the dialog is destroyed
+	QAliveToken aliveToken;
 
 	DatabaseSupplier* databaseSupplier;
 	DatabaseService* databaseService;
@@ -112,12 +110,8 @@ private:
 
 	std::string generateNewDDL(const std::string & orignalDdl);
 
-	// export
-	bool exportObjectToTmp(const std::string & tmpSqlPath);
-	// replace database name
-	bool replaceDatabaseAndTableInTmp();
-	// import
-	bool importObjectFromTmp(const std::string & tmpSqlPath);
+	// import the DDL of the preview
+	bool importObject();
 	void afterDuplicated();
 };
 
@@ -17,13 +17,13 @@
  * @date   2024-12-05
  *********************************************************************/
 #include "DuplicateTableDialog.h"
-#include <wx/process.h>
-#include <wx/txtstrm.h>
+#include <wx/weakref.h>
 #include <spdlog/fmt/fmt.h>
 #include "common/Config.h"
 #include "common/AppContext.h"
 #include "utils/ResourceUtil.h"
 #include "utils/StringUtil.h"
+#include "ui/common/msgbox/QConfirmBox.h"
 
 BEGIN_EVENT_TABLE(DuplicateTableDialog, wxDialog)
 	EVT_BUTTON(wxID_OK, OnClickOkButton)
@@ -44,9 +44,6 @@ DuplicateTableDialog::DuplicateTableDialog() : QFormDialog()
 	if (databaseSupplier->runtimeUserTable) {
 		userTable = *databaseSupplier->runtimeUserTable;
 	}
-	
-	exportProcess = nullptr;
-	importProcess = nullptr;
 }
 
 void DuplicateTableDialog::createInputs()
@@ -248,9 +245,6 @@ void DuplicateTableDialog::OnSelChangeConnectCombobox(wxCommandEvent& event)
 void DuplicateTableDialog::OnClickOkButton(wxCommandEvent& event)
 {
 	progressbar->reset();
-	auto tmpdir = ResourceUtil::getStdProductTmpDir();
-	tmpSqlPath = tmpdir + "/duplicate_table_" + DateUtil::getCurrentDateTime("%Y%m%d_%H%M%S") + ".sql";
-	bool isStructOnly = structOnlyCheckBox->GetValue();
 	auto targetSchema = targetDatabaseComboBox->GetValue();
 	auto targetTable = targetTableEdit->GetValue();
 	if (targetTable.empty()) {
@@ -259,21 +253,44 @@ void DuplicateTableDialog::OnClickOkButton(wxCommandEvent& event)
 		targetTableEdit->SetFocus();
 		return;
 	}
+	auto nSelItem = targetConnectComboBox->GetSelection();
+	auto data = reinterpret_cast<QClientData<UserConnect> *>(targetConnectComboBox->GetClientObject(nSelItem));
+	if (!data) {
+		return;
+	}
+
+	DbCopyParams params;
+	params.fromConnectId = userConnect.id;
+	params.fromSchema = userDb.name;
+	params.toConnectId = data->getDataPtr()->id;
+	params.toSchema = targetSchema.ToStdString();
+	params.toTable = targetTable.ToStdString();
+	params.tables.push_back(userTable.name);
+	params.createDatabase = false;
+	params.routines = false;
+	params.triggers = false;
+	params.events = false;
+	params.structOnly = structOnlyCheckBox->GetValue();
+	params.lockTables = lockTablesCheckBox->GetValue();
 	try {
-		auto nSelItem = targetConnectComboBox->GetSelection();
-		auto data = reinterpret_cast<QClientData<UserConnect> *>(targetConnectComboBox->GetClientObject(nSelItem));
-		if (metadataService->hasUserTable(data->getDataPtr()->id, targetSchema.ToStdString(), targetTable.ToStdString())) {
-			QAnimateBox::error(S("exists-target-table"));
-			targetTableEdit->SelectAll();
-			targetTableEdit->SetFocus();
-			return;
+		if (metadataService->hasUserTable(params.toConnectId, params.toSchema, params.toTable)) {
+			// the target table of an interrupted copy can be resumed
+			if (params.structOnly || !databaseService->hasCopyCheckpoint(params)) {
+				QAnimateBox::error(S("exists-target-table"));
+				targetTableEdit->SelectAll();
+				targetTableEdit->SetFocus();
+				return;
+			}
+			if (QConfirmBox::confirm(S("resume-duplicate-table-confirm")) != wxID_OK) {
+				return;
+			}
 		}
 	} catch (QRuntimeException& ex) {
 		QAnimateBox::error(ex);
 		return;
 	}
 	okButton->Disable();
-	exportTableToTmp(tmpSqlPath);
+	duplicateTable(params);
 }
 
 void DuplicateTableDialog::OnStructAndDataCheckBoxChecked(wxCommandEvent& event)
@@ -290,221 +307,69 @@ void DuplicateTableDialog::OnStructAndDataCheckBoxChecked(wxCommandEvent& event)
 
 
 /**
- * Export sql statements to specified template file.
+ * Copy the table by DatabaseService in the background, the rows are copied by the chunks of the primary key,
+ * so an interrupted copy resumes from the last committed chunk when it starts again.
  * 
- * @param tmpSqlPath - expert sql statements to template file path
+ * @param params
  * @return 
  */
-bool DuplicateTableDialog::exportTableToTmp(const std::string& tmpSqlPath)
+bool DuplicateTableDialog::duplicateTable(const DbCopyParams & params)
 {
-	std::string productDir = ResourceUtil::getStdProductBinDir();
-	std::string executePath = productDir + "/mysqldump.exe";
-	if (_access(executePath.c_str(), 0) != 0) {
-		Q_ERROR("file not found. Path:{}", executePath);
-		okButton->Enable();
-		return false;
-	}
-
-	std::string cmd(executePath);
-	cmd.append(" -h").append(userConnect.host)
-		.append(" -P").append(std::to_string(userConnect.port))
-		.append(" -u").append(userConnect.userName)
-		.append(" -p").append(userConnect.password)
-		.append(" --no-create-db ")
-		.append(" --default-character-set=utf8")
-		.append(" --databases \"").append(userDb.name).append("\"")
-		.append(" --tables \"").append(userTable.name).append("\"");
-	
-	
-
-	bool isStuctOnly = structOnlyCheckBox->GetValue();
-	bool isLockTables = lockTablesCheckBox->GetValue();
-	if (isStuctOnly) {
-		cmd.append(" --no-data");
-	}
-	if (isLockTables) {
-		cmd.append(" --lock-tables");
-	}
-	cmd.append(" --result-file=\"").append(tmpSqlPath).append("\"");
-	exportProcess = new QProcess<DuplicateTableDialog>(this, cmd);
 	progressbar->run(5);
-	if (!exportProcess->open()) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	
-	if (!exportProcess) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	Q_INFO("PID of the new process: {}", exportProcess->GetPid());
-	progressbar->run(10);
-	return true;
-}
-
-bool DuplicateTableDialog::replaceDatabaseAndTableInTmp()
-{
-	if (_access(tmpSqlPath.c_str(), 0) != 0) {
-		auto err = fmt::format("file not found. Path:{}", tmpSqlPath);
-		Q_ERROR(err);
-		QAnimateBox::error(err);
-		return false;
-	}
-	std::string newTmpPath = tmpSqlPath + ".tmp";
-	std::ifstream fin;
-	std::ofstream fout;
-	fin.open(tmpSqlPath.c_str(), std::ios_base::in);
-	fout.open(newTmpPath.c_str(), std::ios_base::out);
-
-	std::string sourceDbName("`" + userDb.name + "`");
-	std::string targetDbName("`" + targetDatabaseComboBox->GetValue().ToStdString() + "`");
-
-	std::string sourceTableName("`" + sourceTableEdit->GetValue().ToStdString() + "`");
-	std::string targetTableName("`" + targetTableEdit->GetValue().ToStdString() + "`");
-
-	std::string line;
-	while (std::getline(fin, line)) {
-		line = StringUtil::replace(line, sourceDbName, targetDbName);
-		line = StringUtil::replace(line, sourceTableName, targetTableName);
-		fout << line << std::endl;
-	}
-	fout.close();
-	fin.close();
-
-	// delete original file
-	_unlink(tmpSqlPath.c_str());
-
-	// rename new temp file
-	rename(newTmpPath.c_str(), tmpSqlPath.c_str());
-	Q_INFO("rename file. original:{}, target:{}", newTmpPath, tmpSqlPath);
-
-	return true;
-}
-
-bool DuplicateTableDialog::importTableFromTmp(const std::string& tmpSqlPath)
-{
-	std::string productDir = ResourceUtil::getStdProductBinDir();
-	std::string executePath = productDir + "/mysql.exe";
-	if (_access(executePath.c_str(), 0) != 0) {
-		Q_ERROR("file not found. Path:{}", executePath);
-		okButton->Enable();
-		return false;
-	}
-
-	auto nSelItem = targetConnectComboBox->GetSelection();
-	auto data = reinterpret_cast<QClientData<UserConnect> *>(targetConnectComboBox->GetClientObject(nSelItem));
-	auto userConnectPtr = data->getDataPtr();
-	auto schema = targetDatabaseComboBox->GetValue();
-	auto table = targetTableEdit->GetValue();
-
-	std::string cmd(executePath);
-	cmd.append(" -h").append(userConnectPtr->host)
-		.append(" -P").append(std::to_string(userConnectPtr->port))
-		.append(" -u").append(userConnectPtr->userName)
-		.append(" -p").append(userConnectPtr->password)
-		.append(" --default-character-set=utf8")
-		.append(" --database ").append(schema)
-		.append(" -e \"source ").append(tmpSqlPath).append("\"");
-	importProcess = new QProcess<DuplicateTableDialog>(this, cmd);
-	progressbar->run(65);
-	if (!importProcess->open()) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	
-	if (!importProcess) {
-		Q_ERROR("Failed to launch the command.");
-		okButton->Enable();
-		return false;
-	}
-	return true;
-}
-
-DuplicateTableDialog::~DuplicateTableDialog()
-{
-	if (exportProcess) {
-		wxProcess::Kill(exportProcess->GetPid());
-		delete exportProcess;
-		exportProcess = nullptr;
-	}
-
-	if (importProcess) {
-		wxProcess::Kill(importProcess->GetPid());
-		delete importProcess;
-		importProcess = nullptr;
-	}
-
-	// delete the temp sql file
-	if (!tmpSqlPath.empty() && _access(tmpSqlPath.c_str(), 0) == 0) {
-		_unlink(tmpSqlPath.c_str());
-	}
-}
-
-void DuplicateTableDialog::OnAsyncProcessTermination(QProcess<DuplicateTableDialog>* process)
-{
-	if (exportProcess  && process->GetPid() == exportProcess->GetPid()) {
-		// 1.ending export process
-		progressbar->run(50);
-
-		auto msg = process->getOutputText();
-		if (!msg.empty()) {
-			QAnimateBox::notice(msg);
+	// the dialog may be closed before the copy is finished
+	QAliveFlag alive = aliveToken.flag();
+	copyId = databaseService->copyUserDbAsync(params, [this, alive](bool isSuccess, const std::string & code, const std::string & msg) {
+		if (!*alive) {
+			return;
 		}
-			
-		auto error = process->getOutputError();
-		if (error.empty() == false) {
-			QAnimateBox::error(error);
-			progressbar->error("Dumping failed.");
-			okButton->Enable();
-			delete exportProcess;
-			exportProcess = nullptr;
+		copyId = 0;
+		okButton->Enable();
+		if (!isSuccess) {
+			QAnimateBox::error(QRuntimeException(code, msg));
+			progressbar->error("Duplicate failed.");
 			return;
 		}
-
-		QAnimateBox::success("Export success! Pid:" + std::to_string(process->GetPid()));		
-		
-		delete exportProcess;
-		exportProcess = nullptr;
-		// 2.replace database name in the templace sql file;
-		if (!replaceDatabaseAndTableInTmp()) {
-			okButton->Enable();
+		progressbar->run(100);
+		QAnimateBox::success(S("duplicate-success"));
+		afterDuplicated();
+	}, [this, alive](const DbCopyProgress & progress) {
+		if (!*alive || !copyId) {
 			return;
 		}
-		progressbar->run(60);
-
-		// 3.import sql file to new table when ending export process
-		importTableFromTmp(tmpSqlPath);
-
-	} else if (importProcess && process->GetPid() == importProcess->GetPid()) {
-		progressbar->run(80);
+		showProgress(progress);
+	});
+	return true;
+}
 
-		auto msg = process->getOutputText();
-		if (!msg.empty()) {
-			QAnimateBox::notice(msg);
+/**
+ * Show the progress of the copy, the tooltip of the progress bar has the tables that are being copied.
+ * 
+ * @param progress
+ */
+void DuplicateTableDialog::showProgress(const DbCopyProgress & progress)
+{
+	wxString detail = wxString::Format("%u/%zu tables, %llu rows", progress.doneTables, progress.tables.size(), 
+		(unsigned long long)progress.copiedRows);
+	for (auto & item : progress.tables) {
+		if (item.status != COPY_TABLE_COPYING) {
+			continue;
 		}
-			
-		auto error = process->getOutputError();
-		if (error.empty() == false) {
-			QAnimateBox::error(error);
-			progressbar->error("Import Failed.");
+		detail.Append("\n").Append(item.name).Append(": ");
+		if (item.estimatedRows) {
+			detail.Append(wxString::Format("%llu / ~%llu rows", (unsigned long long)item.copiedRows, (unsigned long long)item.estimatedRows));
 		} else {
-			QAnimateBox::success("Import success! Pid:" + std::to_string(process->GetPid()));
-			progressbar->run(100);
-		}
-		
-		okButton->Enable();
-		delete importProcess;
-		importProcess = nullptr;
-
-		// delete the temp sql file
-		if (_access(tmpSqlPath.c_str(), 0) == 0) {
-			_unlink(tmpSqlPath.c_str());
+			detail.Append(wxString::Format("%llu rows", (unsigned long long)item.copiedRows));
 		}
+	}
+	progressbar->run(progress.percent, progress.bytesPerSecond, progress.etaSeconds, detail);
+}
 
-		afterDuplicated();
+DuplicateTableDialog::~DuplicateTableDialog()
+{
+	// the copy stops at the next batch, it resumes from the checkpoint next time
+	if (copyId) {
+		databaseService->cancelCopyUserDb(copyId);
+		copyId = 0;
 	}
 }
 
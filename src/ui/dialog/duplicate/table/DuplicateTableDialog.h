@@ -26,7 +26,7 @@
 #include "core/service/db/MetadataService.h"
 #include "ui/dialog/duplicate/table/delegate/DuplicateTableDialogDelegate.h"
 #include "ui/common/progress/QProgressBar.h"
-#include "ui/common/process/QProcess.h"
+#include "common/QAliveToken.h"
 
 class DuplicateTableDialog :  public QFormDialog<DuplicateTableDialogDelegate>
 {
@@ -34,9 +34,6 @@ class DuplicateTableDialog :  public QFormDialog<DuplicateTableDialogDelegate>
 public:
 	DuplicateTableDialog();
 	~DuplicateTableDialog();
-
-	// handle export process and import process
-	void OnAsyncProcessTermination(QProcess<DuplicateTableDialog>* process);
 private:
 	UserConnect userConnect;
 	UserDb userDb;
@@ -80,12 +77,12 @@ private:
 	// lock settings
 	wxCheckBox* lockTablesCheckBox;
 
-	std::string tmpSqlPath;
-
 	// process bar 
 	QProgressBar* progressbar;
-	QProcess<DuplicateTableDialog>* exportProcess;
-	QProcess<DuplicateTableDialog>* importProcess;
+	// the running copy of DatabaseService, 0 - no copy
+	uint64_t copyId = 0;
+	// the callbacks of DatabaseService are dropped after the dialog is destroyed
+	QAliveToken aliveToken;
 
 	DatabaseSupplier* databaseSupplier;
 	DatabaseService* databaseService = DatabaseService::getInstance();
@@ -104,12 +101,9 @@ private:
 	void OnClickOkButton(wxCommandEvent& event);
 	void OnStructAndDataCheckBoxChecked(wxCommandEvent& event);
 
-	// export
-	bool exportTableToTmp(const std::string & tmpSqlPath);
-	// replace database name
-	bool replaceDatabaseAndTableInTmp();
-	// import
-	bool importTableFromTmp(const std::string & tmpSqlPath);
+	// copy the table in the background, resume from the checkpoint if the target table exists
+	bool duplicateTable(const DbCopyParams & params);
+	void showProgress(const DbCopyProgress & progress);
 	void afterDuplicated();
 };
 
@@ -0,0 +1,437 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com) 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @file   ExportSqlDialog.cpp
+ * @brief  
+ * 
+ * @author Xuehan Qin (qinxuehan2018@gmail.com) 
+ * @date   2025-01-05
+ *********************************************************************/
+#include "ExportSqlDialog.h"
+#include <wx/weakref.h>
+#include <wx/filedlg.h>
+#include <wx/filefn.h>
+#include <wx/filename.h>
+#include <wx/stdpaths.h>
+#include <wx/utils.h>
+#include "common/Config.h"
+#include "common/AppContext.h"
+#include "utils/ResourceUtil.h"
+#include "utils/StringUtil.h"
+#include "ui/common/msgbox/QAnimateBox.h"
+#include "ui/common/msgbox/QConfirmBox.h"
+
+BEGIN_EVENT_TABLE(ExportSqlDialog, wxDialog)
+	EVT_BUTTON(wxID_OK, OnClickOkButton)
+	EVT_BUTTON(Config::EXPORT_SQL_BROWSE_BUTTON_ID, OnClickBrowseButton)
+	EVT_COMBOBOX(Config::EXPORT_SQL_COMPRESSION_COMBOBOX_ID, OnSelChangeCompressionCombobox)
+	EVT_COMBOBOX(Config::EXPORT_SQL_FORMAT_COMBOBOX_ID, OnSelChangeFormatCombobox)
+	EVT_CHECKBOX(Config::STRUCTURE_ONLY_CHECKBOX_ID, OnStructAndDataCheckBoxChecked)
+	EVT_CHECKBOX(Config::STRUCTURE_DATA_CHECKBOX_ID, OnStructAndDataCheckBoxChecked)
+END_EVENT_TABLE()
+
+ExportSqlDialog::ExportSqlDialog(const SqlExportParams & params) : QFormDialog(), params(params)
+{
+}
+
+void ExportSqlDialog::createInputs()
+{
+	// top layout
+	topHoriLayout = new wxBoxSizer(wxHORIZONTAL);
+	tLayout->Add(topHoriLayout, 0, wxALIGN_CENTER_HORIZONTAL | wxALIGN_TOP, 5);
+
+	tLayout->AddSpacer(20);
+	// center layout
+	centerVertLayout = new wxBoxSizer(wxVERTICAL);
+	tLayout->Add(centerVertLayout, 0, wxALIGN_CENTER_HORIZONTAL | wxALIGN_TOP, 5);
+
+	tLayout->AddSpacer(20);
+	// bottom
+	bottomHoriLayout = new wxBoxSizer(wxHORIZONTAL);
+	tLayout->Add(bottomHoriLayout, 0, wxALIGN_CENTER_HORIZONTAL | wxALIGN_TOP, 5);
+
+	createTopControls();
+	createCenterInputs();
+	createBottomInputs();
+}
+
+void ExportSqlDialog::createTopControls()
+{
+	topHoriLayout->AddSpacer(20);
+
+	auto imgdir = ResourceUtil::getProductImagesDir();
+	wxString imgpath(imgdir);
+	imgpath.Append("/dialog/duplicate/duplicate.bmp");
+	wxBitmap bitmap(imgpath, wxBITMAP_TYPE_BMP);
+
+	image = new wxStaticBitmap(this, wxID_ANY, wxBitmapBundle(bitmap), wxDefaultPosition, { 32, 32 }, wxNO_BORDER);
+	topHoriLayout->Add(image, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+
+	topHoriLayout->AddSpacer(10);
+	label = new wxStaticText(this, wxID_ANY, S("export-as-sql-text-description"), wxDefaultPosition, {400, -1}, wxALIGN_LEFT);
+	topHoriLayout->Add(label, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+}
+
+void ExportSqlDialog::createCenterInputs()
+{
+	// source connection
+	auto connectLayout = new wxBoxSizer(wxHORIZONTAL);
+	centerVertLayout->Add(connectLayout, 0, wxALIGN_LEFT | wxALIGN_TOP, 5);
+	auto sourceConnectLabel = new wxStaticText(this, wxID_ANY, S("source-connection"), wxDefaultPosition, {120, -1}, wxALIGN_LEFT);
+	connectLayout->Add(sourceConnectLabel, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	sourceConnectEdit = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, { 300, -1 }, wxALIGN_LEFT | wxTE_READONLY);
+	connectLayout->Add(sourceConnectEdit, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	sourceConnectEdit->SetBackgroundColour(disabledColor);
+	sourceConnectEdit->SetForegroundColour(textColor);
+
+	// source database
+	centerVertLayout->AddSpacer(10);
+	auto databaseLayout = new wxBoxSizer(wxHORIZONTAL);
+	centerVertLayout->Add(databaseLayout, 0, wxALIGN_LEFT | wxALIGN_TOP, 5);
+	auto sourceDatabaseLabel = new wxStaticText(this, wxID_ANY, S("source-database"), wxDefaultPosition, {120, -1}, wxALIGN_LEFT);
+	databaseLayout->Add(sourceDatabaseLabel, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	sourceDatabaseEdit = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, { 300, -1 }, wxALIGN_LEFT | wxTE_READONLY);
+	databaseLayout->Add(sourceDatabaseEdit, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	sourceDatabaseEdit->SetBackgroundColour(disabledColor);
+	sourceDatabaseEdit->SetForegroundColour(textColor);
+
+	// save to file
+	centerVertLayout->AddSpacer(10);
+	auto pathLayout = new wxBoxSizer(wxHORIZONTAL);
+	centerVertLayout->Add(pathLayout, 0, wxALIGN_LEFT | wxALIGN_TOP, 5);
+	auto pathLabel = new wxStaticText(this, wxID_ANY, S("save-to-file"), wxDefaultPosition, {120, -1}, wxALIGN_LEFT);
+	pathLayout->Add(pathLabel, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	pathEdit = new wxTextCtrl(this, Config::EXPORT_SQL_PATH_EDIT_ID, wxEmptyString, wxDefaultPosition, { 220, -1 }, wxALIGN_LEFT);
+	pathLayout->Add(pathEdit, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	pathLayout->AddSpacer(5);
+	browseButton = new wxButton(this, Config::EXPORT_SQL_BROWSE_BUTTON_ID, S("browse"), wxDefaultPosition, { 75, -1 });
+	pathLayout->Add(browseButton, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+
+	// compression
+	centerVertLayout->AddSpacer(10);
+	auto compressionLayout = new wxBoxSizer(wxHORIZONTAL);
+	centerVertLayout->Add(compressionLayout, 0, wxALIGN_LEFT | wxALIGN_TOP, 5);
+	auto compressionLabel = new wxStaticText(this, wxID_ANY, S("compression"), wxDefaultPosition, {120, -1}, wxALIGN_LEFT);
+	compressionLayout->Add(compressionLabel, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	compressionComboBox = new wxComboBox(this, Config::EXPORT_SQL_COMPRESSION_COMBOBOX_ID, wxEmptyString, wxDefaultPosition,
+		{ 300, -1 }, wxArrayString(), wxCLIP_CHILDREN | wxCB_READONLY);
+	compressionLayout->Add(compressionComboBox, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+
+	// format, one table can be exported in parallel by the ranges of the primary key
+	if (params.schemas.size() == 1 && params.tables.size() == 1) {
+		centerVertLayout->AddSpacer(10);
+		auto formatLayout = new wxBoxSizer(wxHORIZONTAL);
+		centerVertLayout->Add(formatLayout, 0, wxALIGN_LEFT | wxALIGN_TOP, 5);
+		auto formatLabel = new wxStaticText(this, wxID_ANY, S("export-format"), wxDefaultPosition, {120, -1}, wxALIGN_LEFT);
+		formatLayout->Add(formatLabel, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+		formatComboBox = new wxComboBox(this, Config::EXPORT_SQL_FORMAT_COMBOBOX_ID, wxEmptyString, wxDefaultPosition,
+			{ 300, -1 }, wxArrayString(), wxCLIP_CHILDREN | wxCB_READONLY);
+		formatLayout->Add(formatComboBox, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	}
+
+	// export settings
+	centerVertLayout->AddSpacer(10);
+	auto exportSettingsBox = new wxStaticBox(this, wxID_ANY, S("export-settings"), wxDefaultPosition, {420, -1});
+	exportSettingsHoriLayout = new wxStaticBoxSizer(exportSettingsBox, wxHORIZONTAL);
+	centerVertLayout->Add(exportSettingsHoriLayout, 0, wxALIGN_LEFT | wxALIGN_TOP, 5);
+	structOnlyCheckBox = new wxCheckBox(this, Config::STRUCTURE_ONLY_CHECKBOX_ID, S("structure-only"), wxDefaultPosition, wxDefaultSize);
+	exportSettingsHoriLayout->Add(structOnlyCheckBox, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	exportSettingsHoriLayout->AddSpacer(20);
+	structAndDataCheckBox = new wxCheckBox(this, Config::STRUCTURE_DATA_CHECKBOX_ID, S("structure-and-data"), wxDefaultPosition, wxDefaultSize);
+	exportSettingsHoriLayout->Add(structAndDataCheckBox, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	if (formatComboBox) {
+		exportSettingsHoriLayout->AddSpacer(20);
+		mergePartsCheckBox = new wxCheckBox(this, Config::EXPORT_MERGE_PARTS_CHECKBOX_ID, S("merge-parts"), wxDefaultPosition, wxDefaultSize);
+		exportSettingsHoriLayout->Add(mergePartsCheckBox, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_LEFT, 5);
+	}
+}
+
+void ExportSqlDialog::createBottomInputs()
+{
+	progressbar = new QProgressBar(this, wxID_ANY, wxDefaultPosition, { 420, 20 });
+	bottomHoriLayout->Add(progressbar, 0, wxALIGN_CENTER_VERTICAL | wxALIGN_CENTRE);
+}
+
+void ExportSqlDialog::loadControls()
+{
+	assert(params.connectId && !params.schemas.empty());
+	okButton->SetLabel(S("start"));
+	cancelButton->SetLabel(S("close"));
+
+	UserConnect userConnect = connectService->getUserConnect(params.connectId);
+	wxString connnectName = userConnect.name;
+	connnectName.Append(" [").Append(userConnect.host)
+		.Append(":").Append(std::to_string(userConnect.port)).Append("]");
+	sourceConnectEdit->SetValue(connnectName);
+	sourceDatabaseEdit->SetValue(StringUtil::implode(params.schemas, ", "));
+
+	compressionComboBox->Append(S("compression-gzip"));
+	compressionComboBox->Append(S("compression-none"));
+	compressionComboBox->SetSelection(params.compression == SQL_EXPORT_GZIP ? 0 : 1);
+
+	// <documents>/<connection|database|table>.sql.gz
+	std::string fileName = params.schemas.size() > 1 ? userConnect.name
+		: params.tables.size() == 1 ? params.tables.front() : params.schemas.front();
+	wxString filePath = wxStandardPaths::Get().GetDocumentsDir();
+	filePath.Append(wxFILE_SEP_PATH).Append(wxString::FromUTF8(fileName)).Append(getExtension(params.compression));
+	pathEdit->SetValue(filePath);
+
+	structOnlyCheckBox->SetValue(params.structOnly);
+	structAndDataCheckBox->SetValue(!params.structOnly);
+
+	if (formatComboBox) {
+		formatComboBox->Append(S("export-format-sql-script"));
+		formatComboBox->Append(S("export-format-parallel-sql"));
+		formatComboBox->Append(S("export-format-parallel-csv"));
+		formatComboBox->SetSelection(0);
+		mergePartsCheckBox->SetValue(true);
+		mergePartsCheckBox->Disable();
+	}
+}
+
+void ExportSqlDialog::OnClickOkButton(wxCommandEvent& event)
+{
+	progressbar->reset();
+	wxString filePath = pathEdit->GetValue().Trim().Trim(false);
+	if (filePath.empty()) {
+		QAnimateBox::error(S("export-path-error"));
+		pathEdit->SetFocus();
+		return;
+	}
+	if (wxFileExists(filePath) || (isParallelFormat() 
+		&& wxFileExists(wxString::FromUTF8(QTableExporter::getManifestPath(filePath.ToUTF8().data()))))) {
+		std::string prompt = StringUtil::replace(S("export-file-exists-prompt"), "{export-path}", filePath.ToStdString());
+		if (QConfirmBox::confirm(prompt) != wxID_OK) {
+			return;
+		}
+	}
+	okButton->Disable();
+	if (isParallelFormat()) {
+		exportTable();
+	} else {
+		exportSql();
+	}
+}
+
+void ExportSqlDialog::OnClickBrowseButton(wxCommandEvent& event)
+{
+	wxString extension = getFileExtension();
+	wxString wildcard = extension == ".sql.gz" ? "SQL gzip files (*.sql.gz)|*.sql.gz" 
+		: extension == ".csv" ? "CSV files (*.csv)|*.csv" : "SQL files (*.sql)|*.sql";
+	wxFileName fileName(pathEdit->GetValue());
+	wxFileDialog saveFileDialog(this, S("save-to-file"), fileName.GetPath(), fileName.GetFullName(), wildcard, wxFD_SAVE);
+	if (saveFileDialog.ShowModal() == wxID_CANCEL) {
+		return;
+	}
+	pathEdit->SetValue(saveFileDialog.GetPath());
+}
+
+/**
+ * Change the extension of the file path to the selected compression.
+ * 
+ * @param event
+ */
+void ExportSqlDialog::OnSelChangeCompressionCombobox(wxCommandEvent& event)
+{
+	updateFilePath();
+}
+
+/**
+ * The parallel formats write the plain parts, so the compression and the structure are disabled for them.
+ * 
+ * @param event
+ */
+void ExportSqlDialog::OnSelChangeFormatCombobox(wxCommandEvent& event)
+{
+	bool isParallel = isParallelFormat();
+	compressionComboBox->Enable(!isParallel);
+	structOnlyCheckBox->Enable(!isParallel);
+	structAndDataCheckBox->Enable(!isParallel);
+	mergePartsCheckBox->Enable(isParallel);
+	updateFilePath();
+}
+
+void ExportSqlDialog::OnStructAndDataCheckBoxChecked(wxCommandEvent& event)
+{
+	auto id = event.GetId();
+	auto item = reinterpret_cast<wxCheckBox *>(FindItem(id));
+	bool state = item->GetValue();
+	if (id == Config::STRUCTURE_ONLY_CHECKBOX_ID) {
+		structAndDataCheckBox->SetValue(!state);
+	} else if (id == Config::STRUCTURE_DATA_CHECKBOX_ID) {
+		structOnlyCheckBox->SetValue(!state);
+	}
+}
+
+/**
+ * Export in the background, the sql text is written and compressed by DatabaseService::exportSqlAsync(...)
+ * without mysqldump.exe or temp file.
+ * 
+ * @return 
+ */
+bool ExportSqlDialog::exportSql()
+{
+	params.filePath = pathEdit->GetValue().Trim().Trim(false).ToUTF8().data();
+	params.compression = getCompression();
+	params.structOnly = structOnlyCheckBox->GetValue();
+
+	progressbar->run(2);
+	// the dialog may be closed before the export is finished
+	QAliveFlag alive = aliveToken.flag();
+	exportId = databaseService->exportSqlAsync(params, [this, alive](bool isSuccess, const std::string & code, const std::string & msg) {
+		if (!*alive) {
+			return;
+		}
+		exportId = 0;
+		finishExport(isSuccess, code, msg, wxString::FromUTF8(params.filePath));
+	}, [this, alive](const SqlExportProgress & progress) {
+		if (!*alive || !exportId) {
+			return;
+		}
+		showProgress(progress);
+	});
+	return true;
+}
+
+/**
+ * Export one table in the background, the ranges of the primary key are read by several pooled sessions 
+ * in parallel by DatabaseService::exportTableAsync(...), see QTableExporter.
+ * 
+ * @return 
+ */
+bool ExportSqlDialog::exportTable()
+{
+	TableExportParams tableParams;
+	tableParams.connectId = params.connectId;
+	tableParams.schema = params.schemas.front();
+	tableParams.tblName = params.tables.front();
+	tableParams.format = getTableFormat();
+	tableParams.filePath = pathEdit->GetValue().Trim().Trim(false).ToUTF8().data();
+	tableParams.mergeParts = mergePartsCheckBox->GetValue();
+	tableParams.csvParams.csvFieldTerminatedBy = ",";
+	tableParams.csvParams.csvFieldEnclosedBy = "\"";
+	tableParams.csvParams.csvLineTerminatedBy = "\n";
+	tableParams.csvParams.hasColumnOnTop = true;
+
+	// the merged file is opened, or the folder of the parts
+	wxString openPath = tableParams.mergeParts ? pathEdit->GetValue().Trim().Trim(false) 
+		: wxFileName(pathEdit->GetValue().Trim().Trim(false)).GetPath();
+	progressbar->run(2);
+	// the dialog may be closed before the export is finished
+	QAliveFlag alive = aliveToken.flag();
+	tableExportId = databaseService->exportTableAsync(tableParams, [this, alive, openPath](bool isSuccess, const std::string & code, const std::string & msg) {
+		if (!*alive) {
+			return;
+		}
+		tableExportId = 0;
+		finishExport(isSuccess, code, msg, openPath);
+	}, [this, alive](const TableExportProgress & progress) {
+		if (!*alive || !tableExportId) {
+			return;
+		}
+		showTableProgress(progress);
+	});
+	return true;
+}
+
+void ExportSqlDialog::finishExport(bool isSuccess, const std::string & code, const std::string & msg, const wxString & openPath)
+{
+	okButton->Enable();
+	if (!isSuccess) {
+		QAnimateBox::error(QRuntimeException(code, msg));
+		progressbar->error("Export failed.");
+		return;
+	}
+	progressbar->run(100);
+	if (QConfirmBox::confirm(S("export-as-sql-success-text")) == wxID_OK) {
+		wxLaunchDefaultApplication(openPath);
+	}
+}
+
+/**
+ * Show the progress of the export, the tooltip of the progress bar has the exporting table.
+ * 
+ * @param progress
+ */
+void ExportSqlDialog::showProgress(const SqlExportProgress & progress)
+{
+	wxString detail = wxString::Format("%u/%u tables, %llu rows, %.1f MB -> %.1f MB", progress.doneTables, progress.totalTables, 
+		(unsigned long long)progress.exportedRows, progress.sqlBytes / 1048576.0, progress.fileBytes / 1048576.0);
+	if (!progress.table.empty()) {
+		detail.Append("\n").Append(wxString::FromUTF8(progress.schema + "." + progress.table));
+	}
+	progressbar->run(progress.percent, progress.bytesPerSecond, progress.etaSeconds, detail);
+}
+
+void ExportSqlDialog::showTableProgress(const TableExportProgress & progress)
+{
+	wxString detail = wxString::Format("%u/%u ranges, %llu/%llu rows, %.1f MB", progress.doneRanges, progress.totalRanges, 
+		(unsigned long long)progress.exportedRows, (unsigned long long)progress.estimatedRows, progress.fileBytes / 1048576.0);
+	progressbar->run(progress.percent, progress.bytesPerSecond, progress.etaSeconds, detail);
+}
+
+SqlExportCompression ExportSqlDialog::getCompression()
+{
+	return compressionComboBox->GetSelection() == 1 ? SQL_EXPORT_NONE : SQL_EXPORT_GZIP;
+}
+
+wxString ExportSqlDialog::getExtension(SqlExportCompression compression)
+{
+	return compression == SQL_EXPORT_GZIP ? ".sql.gz" : ".sql";
+}
+
+wxString ExportSqlDialog::getFileExtension()
+{
+	if (!isParallelFormat()) {
+		return getExtension(getCompression());
+	}
+	return getTableFormat() == TABLE_EXPORT_CSV ? ".csv" : ".sql";
+}
+
+bool ExportSqlDialog::isParallelFormat()
+{
+	return formatComboBox && formatComboBox->GetSelection() > 0;
+}
+
+TableExportFormat ExportSqlDialog::getTableFormat()
+{
+	return formatComboBox && formatComboBox->GetSelection() == 2 ? TABLE_EXPORT_CSV : TABLE_EXPORT_SQL;
+}
+
+/**
+ * Change the extension of the file path to the selected format and compression.
+ */
+void ExportSqlDialog::updateFilePath()
+{
+	wxString filePath = pathEdit->GetValue();
+	if (filePath.EndsWith(".sql.gz")) {
+		filePath.RemoveLast(7);
+	} else if (filePath.EndsWith(".sql") || filePath.EndsWith(".csv")) {
+		filePath.RemoveLast(4);
+	}
+	if (filePath.empty()) {
+		return;
+	}
+	pathEdit->SetValue(filePath + getFileExtension());
+}
+
+ExportSqlDialog::~ExportSqlDialog()
+{
+	if (exportId) {
+		databaseService->cancelExportSql(exportId);
+		exportId = 0;
+	}
+	if (tableExportId) {
+		databaseService->cancelExportTable(tableExportId);
+		tableExportId = 0;
+	}
+}
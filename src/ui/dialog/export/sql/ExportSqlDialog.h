@@ -0,0 +1,104 @@
+/*****************************************************************//**
+ * Copyright 2024 Xuehan Qin (qinxuehan2018@gmail.com) 
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ * 
+ * @file   ExportSqlDialog.h
+ * @brief  Export the connection, database or table as a (compressed) sql file by DatabaseService::exportSqlAsync,
+ *         or export one table as CSV/INSERT statements in parallel by DatabaseService::exportTableAsync
+ * 
+ * @author Xuehan Qin (qinxuehan2018@gmail.com) 
+ * @date   2025-01-05
+ *********************************************************************/
+
+#pragma once
+#include <wx/combobox.h>
+#include "ui/common/dialog/QFormDialog.h"
+#include "core/service/db/ConnectService.h"
+#include "core/service/db/DatabaseService.h"
+#include "ui/dialog/delegate/CommonDialogDelegate.h"
+#include "ui/common/progress/QProgressBar.h"
+#include "common/QAliveToken.h"
+
+class ExportSqlDialog :  public QFormDialog<CommonDialogDelegate>
+{
+	DECLARE_EVENT_TABLE()
+public:
+	// params.schemas and params.tables are the exported objects, the path and settings are chosen in the dialog
+	ExportSqlDialog(const SqlExportParams & params);
+	~ExportSqlDialog();
+private:
+	SqlExportParams params;
+
+	// top
+	wxBoxSizer* topHoriLayout;
+	// center
+	wxBoxSizer* centerVertLayout;
+	wxStaticBoxSizer* exportSettingsHoriLayout;
+	// bottom
+	wxBoxSizer* bottomHoriLayout;
+
+	// description for dialog - in top layout
+	wxStaticBitmap* image;
+	wxStaticText* label;
+
+	wxTextCtrl* sourceConnectEdit;
+	wxTextCtrl* sourceDatabaseEdit;
+	wxTextCtrl* pathEdit;
+	wxButton* browseButton;
+	wxComboBox* compressionComboBox;
+	// only for one table, nullptr otherwise
+	wxComboBox* formatComboBox = nullptr;
+
+	// export settings
+	wxCheckBox* structOnlyCheckBox;
+	wxCheckBox* structAndDataCheckBox;
+	// only for one table, nullptr otherwise
+	wxCheckBox* mergePartsCheckBox = nullptr;
+
+	// process bar 
+	QProgressBar* progressbar;
+	// the running export of DatabaseService::exportSqlAsync, 0 - no running export
+	uint64_t exportId = 0;
+	// the running export of DatabaseService::exportTableAsync, 0 - no running export
+	uint64_t tableExportId = 0;
+	// the callbacks of DatabaseService are dropped after the dialog is destroyed
+	QAliveToken aliveToken;
+
+	DatabaseService* databaseService = DatabaseService::getInstance();
+	ConnectService* connectService = ConnectService::getInstance();
+
+	virtual void createInputs();
+	virtual void createTopControls();
+	virtual void createCenterInputs();
+	virtual void createBottomInputs();
+	virtual void loadControls();
+
+	void OnClickOkButton(wxCommandEvent& event);
+	void OnClickBrowseButton(wxCommandEvent& event);
+	void OnSelChangeCompressionCombobox(wxCommandEvent& event);
+	void OnSelChangeFormatCombobox(wxCommandEvent& event);
+	void OnStructAndDataCheckBoxChecked(wxCommandEvent& event);
+
+	// export by DatabaseService in the background
+	bool exportSql();
+	void showProgress(const SqlExportProgress & progress);
+	// export one table by the ranges of the primary key in the background
+	bool exportTable();
+	void showTableProgress(const TableExportProgress & progress);
+	void finishExport(bool isSuccess, const std::string & code, const std::string & msg, const wxString & openPath);
+	SqlExportCompression getCompression();
+	wxString getExtension(SqlExportCompression compression);
+	// the extension of the selected format and compression
+	wxString getFileExtension();
+	bool isParallelFormat();
+	TableExportFormat getTableFormat();
+	void updateFilePath();
+};
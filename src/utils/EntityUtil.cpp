@@ -50,6 +50,7 @@ ResultInfo EntityUtil::copy(const ResultInfo & item)
 	result.execTime = item.execTime;
 	result.transferTime = item.transferTime;
 	result.totalTime = item.totalTime;
+	result.statusDeltas = item.statusDeltas;
 	return result;
 }
 
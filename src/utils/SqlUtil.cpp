@@ -18,6 +18,7 @@
  * @date   2023-05-28
  *********************************************************************/
 #include "SqlUtil.h"
+#include <cctype>
 #include <chrono>
 #include "StringUtil.h"
 
@@ -73,6 +74,38 @@ bool SqlUtil::isPragmaStmt(const std::string & sql, bool excludeEqual)
 	return upsql.find("PRAGMA") == 0;
 }
 
+/**
+ * Whether the statement changes the objects of the database, the cached metadata is removed after it runs.
+ * 
+ * @param sql
+ * @return 
+ */
+bool SqlUtil::isDdlSql(const std::string & sql)
+{
+	size_t pos = 0, len = sql.size();
+	while (pos < len) {
+		if (std::isspace(static_cast<unsigned char>(sql[pos]))) {
+			pos++;
+		} else if (sql.compare(pos, 2, "/*") == 0) {
+			size_t end = sql.find("*/", pos + 2);
+			pos = end == std::string::npos ? len : end + 2;
+		} else if (sql[pos] == '#' || (sql.compare(pos, 2, "--") == 0 
+			&& (pos + 2 == len || std::isspace(static_cast<unsigned char>(sql[pos + 2]))))) {
+			size_t end = sql.find('\n', pos);
+			pos = end == std::string::npos ? len : end + 1;
+		} else {
+			break;
+		}
+	}
+	size_t end = pos;
+	while (end < len && std::isalpha(static_cast<unsigned char>(sql[end]))) {
+		end++;
+	}
+	std::string keyword = StringUtil::toupper(sql.substr(pos, end - pos));
+	return keyword == "CREATE" || keyword == "ALTER" || keyword == "DROP" 
+		|| keyword == "RENAME" || keyword == "TRUNCATE";
+}
+
 bool SqlUtil::hasLimitClause(const std::string & sql)
 {
 	if (sql.empty()) {
@@ -581,6 +614,131 @@ std::string SqlUtil::makeInsertValuesClause(const RowItem & rowItem)
 	return valuesClause;
 }
 
+/**
+ * Whether the sql is "SELECT * FROM tbl", the table name can be quoted by ` and qualified by the schema.
+ * 
+ * @param sql
+ * @param schema
+ * @param tblName
+ * @return 
+ */
+bool SqlUtil::isSelectAllFromTable(const std::string & sql, const std::string & schema, const std::string & tblName)
+{
+	if (sql.empty() || tblName.empty()) {
+		return false;
+	}
+	std::string upsql = StringUtil::toupper(sql);
+	StringUtil::trim(upsql);
+	while (!upsql.empty() && (upsql.back() == ';' || std::isspace(static_cast<unsigned char>(upsql.back())))) {
+		upsql.pop_back();
+	}
+	std::vector<std::string> words;
+	std::string word;
+	for (char ch : upsql) {
+		if (std::isspace(static_cast<unsigned char>(ch))) {
+			if (!word.empty()) {
+				words.push_back(word);
+				word.clear();
+			}
+			continue;
+		}
+		word.push_back(ch);
+	}
+	if (!word.empty()) {
+		words.push_back(word);
+	}
+	if (words.size() != 4 || words.at(0) != "SELECT" || words.at(1) != "*" || words.at(2) != "FROM") {
+		return false;
+	}
+	std::string upTable = StringUtil::toupper(tblName), upSchema = StringUtil::toupper(schema);
+	const std::string & tableClause = words.at(3);
+	return tableClause == upTable || tableClause == "`" + upTable + "`"
+		|| tableClause == upSchema + "." + upTable || tableClause == "`" + upSchema + "`.`" + upTable + "`";
+}
+
+/**
+ * Make the select sql of a keyset page, such as: 
+ * SELECT * FROM `db`.`tbl` WHERE (`id1`, `id2`) > (100, 'abc') ORDER BY `id1`, `id2` LIMIT 1000
+ * The WHERE clause is a range of the primary key, so the deep page is an index range read instead of skipping the offset rows.
+ * 
+ * @param schema
+ * @param tblName
+ * @param keyColumns - the primary key columns
+ * @param afterKeyValues - the sql literals of the last key of previous page, empty for the first page
+ * @param rows - the rows of one page
+ * @return 
+ */
+std::string SqlUtil::makeKeysetSelectSql(const std::string & schema, const std::string & tblName, const Columns & keyColumns, 
+	const RowItem & afterKeyValues, int rows)
+{
+	assert(!tblName.empty() && !keyColumns.empty());
+	std::string keysClause, valuesClause;
+	for (size_t i = 0; i < keyColumns.size(); i++) {
+		if (i > 0) {
+			keysClause.append(", ");
+		}
+		keysClause.append(quoteIdentifier(keyColumns.at(i)));
+	}
+	for (size_t i = 0; i < afterKeyValues.size(); i++) {
+		if (i > 0) {
+			valuesClause.append(", ");
+		}
+		valuesClause.append(afterKeyValues.at(i));
+	}
+
+	std::string sql = "SELECT * FROM ";
+	if (!schema.empty()) {
+		sql.append(quoteIdentifier(schema)).append(".");
+	}
+	sql.append(quoteIdentifier(tblName));
+	if (!afterKeyValues.empty()) {
+		// the row constructor comparison is optimized as the range of the index since MySQL 5.7
+		if (keyColumns.size() == 1) {
+			sql.append(" WHERE ").append(keysClause).append(" > ").append(valuesClause);
+		} else {
+			sql.append(" WHERE (").append(keysClause).append(") > (").append(valuesClause).append(")");
+		}
+	}
+	sql.append(" ORDER BY ").append(keysClause)
+		.append(" LIMIT ").append(std::to_string(rows));
+	return sql;
+}
+
+/**
+ * Quote the identifier by backticks, the backtick in the identifier is escaped as two backticks.
+ * 
+ * @param name - such as the name of database, table or column
+ * @return 
+ */
+std::string SqlUtil::quoteIdentifier(const std::string & name)
+{
+	std::string result = "`";
+	for (char ch : name) {
+		if (ch == '`') {
+			result.push_back('`');
+		}
+		result.push_back(ch);
+	}
+	return result.append("`");
+}
+
+/**
+ * The assignment of SET SESSION that removes NO_BACKSLASH_ESCAPES from the sql_mode and keeps the other modes,
+ * the strings of UserDbRepository::readRowTuples(...) are escaped by the backslash.
+ * 
+ * @param addedMode - appended to the modes, such as NO_AUTO_VALUE_ON_ZERO like mysqldump, empty - nothing is appended
+ * @return SQL_MODE=...
+ */
+std::string SqlUtil::makeSqlModeWithBackslashEscapes(const std::string & addedMode)
+{
+	std::string sqlMode = "TRIM(BOTH ',' FROM REPLACE(CONCAT(',', @@SESSION.SQL_MODE, ','), ',NO_BACKSLASH_ESCAPES,', ','))";
+	if (addedMode.empty()) {
+		return "SQL_MODE=" + sqlMode;
+	}
+	// CONCAT_WS skips NULL, so there is no leading comma if the sql_mode is empty
+	return "SQL_MODE=CONCAT_WS(',', NULLIF(" + sqlMode + ", ''), '" + addedMode + "')";
+}
+
 std::string SqlUtil::makeTmpTableName(const std::string & tblName, int number,  const std::string & prefix /*= std::string("ctsqlite_tmp_")*/)
 {
 	std::string result = prefix;
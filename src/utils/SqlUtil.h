@@ -79,6 +79,8 @@ public:
 	// parse sql 
 	static bool isSelectSql(const std::string & sql);
 	static bool isPragmaStmt(const std::string & sql, bool excludeEqual);
+	// CREATE, ALTER, DROP, RENAME or TRUNCATE statement, the leading comments are skipped
+	static bool isDdlSql(const std::string & sql);
 	static bool hasLimitClause(const std::string & sql);
 	static std::string getColumnName(const std::string & str);
 	static std::vector<std::string> getTablesFromSelectSql(const std::string & sql, const std::vector<std::string> & allTables);
@@ -100,6 +102,15 @@ public:
 	static std::string makeInsertColumsClause(const Columns & columns); 
 	static std::string makeInsertValuesClause(const RowItem & rowItem);
 
+	// keyset pagination, the page is read by the range of primary key
+	static bool isSelectAllFromTable(const std::string & sql, const std::string & schema, const std::string & tblName);
+	static std::string makeKeysetSelectSql(const std::string & schema, const std::string & tblName, const Columns & keyColumns, 
+		const RowItem & afterKeyValues, int rows);
+	// `name`, the backticks in the name are doubled
+	static std::string quoteIdentifier(const std::string & name);
+	// SQL_MODE=the sql_mode of the session without NO_BACKSLASH_ESCAPES and with addedMode, for the sessions that parse the quoted tuples
+	static std::string makeSqlModeWithBackslashEscapes(const std::string & addedMode = std::string());
+
 	// make table name
 	static std::string makeTmpTableName(const std::string & tblName, int number = 1, const std::string & prefix = std::string("ctsqlite_tmp_"));
 	
@@ -761,3 +761,8 @@ wxString StringUtil::converFromUtf8(const wxString& str)
 {
 	return wxString(wxConvUTF8.cMB2WC(str.c_str()), *wxConvCurrent);
 }
+
+std::string StringUtil::converToUtf8(const std::string& str)
+{
+	return std::string(wxString(str.c_str(), *wxConvCurrent).utf8_str());
+}
@@ -237,6 +237,8 @@ public:
 	//convert utf8 to UI charset of local used
 	static std::string converFromUtf8(const std::string &str);
 	static wxString converFromUtf8(const wxString &str);
+	//convert UI charset of local used to utf8
+	static std::string converToUtf8(const std::string &str);
 };
 
 